@@ -33,6 +33,7 @@
 #include "audio/audio_function.h"
 #include "audio/automation_function.h"
 #include "audio/midi_function.h"
+#include "audio/midi_note_columns.h"
 #include "audio/position.h"
 #include "audio/quantize_options.h"
 #include "gui/backend/audio_selections.h"
@@ -256,6 +257,18 @@ typedef struct ArrangerSelectionsAction
   /** QuantizeOptions clone, if quantizing. */
   QuantizeOptions *    opts;
 
+  /**
+   * MIDI note attributes before/after the change.
+   *
+   * Used instead of the selection clones for bulk
+   * MIDI note edits (MIDI functions and MIDI
+   * quantization). \ref
+   * ArrangerSelectionsAction.sel is NULL in this
+   * case.
+   */
+  MidiNoteColumns *    notes_before;
+  MidiNoteColumns *    notes_after;
+
   /* --- below for serialization only --- */
   ChordSelections *    chord_sel;
   ChordSelections *    chord_sel_after;
@@ -318,6 +331,12 @@ static const cyaml_schema_field_t
   YAML_FIELD_MAPPING_PTR_OPTIONAL (
     ArrangerSelectionsAction, opts,
     quantize_options_fields_schema),
+  YAML_FIELD_MAPPING_PTR_OPTIONAL (
+    ArrangerSelectionsAction, notes_before,
+    midi_note_columns_fields_schema),
+  YAML_FIELD_MAPPING_PTR_OPTIONAL (
+    ArrangerSelectionsAction, notes_after,
+    midi_note_columns_fields_schema),
   CYAML_FIELD_MAPPING_PTR (
     "chord_sel",
     CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
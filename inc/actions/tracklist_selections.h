@@ -474,6 +474,24 @@ tracklist_selections_action_new (
     TRACK_TYPE_MIDI, NULL, NULL, track_pos, \
     NULL, num_tracks, -1, err)
 
+/**
+ * Creates a new TracklistSelectionsAction for an
+ * audio track with a region for a clip that is
+ * already in the pool (eg, decoded by a
+ * FileImport).
+ *
+ * @param file_basename File name to name the
+ *   track after.
+ */
+WARN_UNUSED_RESULT
+UndoableAction *
+tracklist_selections_action_new_create_from_pool_clip (
+  int              pool_id,
+  const char *     file_basename,
+  int              track_pos,
+  const Position * pos,
+  GError **        error);
+
 /**
  * Creates a new TracklistSelectionsAction for a
  * folder track.
@@ -1115,6 +1133,24 @@ tracklist_selections_action_perform_set_direct_out (
   Track *                  direct_out,
   GError **                error);
 
+/**
+ * Creates and performs a TracklistSelectionsAction
+ * for an audio track with a region for a clip that
+ * is already in the pool.
+ *
+ * @see
+ *   tracklist_selections_action_new_create_from_pool_clip().
+ *
+ * @return Whether successful.
+ */
+bool
+tracklist_selections_action_perform_create_from_pool_clip (
+  int              pool_id,
+  const char *     file_basename,
+  int              track_pos,
+  const Position * pos,
+  GError **        error);
+
 int
 tracklist_selections_action_do (
   TracklistSelectionsAction * self,
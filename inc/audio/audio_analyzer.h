@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Background analysis of audio clips.
+ */
+
+#ifndef __AUDIO_AUDIO_ANALYZER_H__
+#define __AUDIO_AUDIO_ANALYZER_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioClip AudioClip;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+#define AUDIO_ANALYZER (ZRYTHM->audio_analyzer)
+
+/** Version of the cached analysis files. Bump
+ * when the analysis changes to invalidate old
+ * results. */
+#define AUDIO_ANALYSIS_VERSION 1
+
+/** Loudness reported for silent clips (the
+ * absolute gate of ITU-R BS.1770). */
+#define AUDIO_ANALYSIS_MIN_LUFS -70.f
+
+/** Amplitude under which audio is considered
+ * silent (-60 dBFS). */
+#define AUDIO_ANALYSIS_SILENCE_THRESHOLD 0.001f
+
+/** Minimum length of a silence range in
+ * milliseconds. */
+#define AUDIO_ANALYSIS_MIN_SILENCE_MS 100
+
+/**
+ * Analysis results for a clip.
+ *
+ * Positions are in frames at
+ * AudioAnalysis.samplerate.
+ */
+typedef struct AudioAnalysis
+{
+  /** Content hash of the analyzed clip. */
+  char *        hash;
+
+  /** Sample rate of the analyzed frames. */
+  int           samplerate;
+
+  /** Estimated BPM, or 0 if not found. */
+  float         bpm;
+
+  /** Other BPM candidates. */
+  float *       bpm_candidates;
+  int           num_bpm_candidates;
+
+  /** Onset positions. */
+  long *        onsets;
+  int           num_onsets;
+
+  /** Absolute peak amplitude. */
+  float         peak;
+
+  /** RMS amplitude. */
+  float         rms;
+
+  /** Integrated loudness in LUFS. */
+  float         lufs;
+
+  /**
+   * Silence ranges as (start, end) pairs, ie,
+   * silence_ranges[i * 2] is the start of range
+   * @a i and silence_ranges[i * 2 + 1] its end
+   * (exclusive).
+   */
+  long *        silence_ranges;
+  int           num_silence_ranges;
+} AudioAnalysis;
+
+/**
+ * Called on the GTK thread when an analysis
+ * finishes.
+ *
+ * @param analysis The result, owned by the caller
+ *   of the callback.
+ */
+typedef void (*AudioAnalysisCallback) (
+  const AudioAnalysis * analysis,
+  void *                user_data);
+
+/**
+ * Analyzes clips on a thread pool and caches the
+ * results in memory and in the project's analysis
+ * directory, keyed by the content hash of each
+ * clip.
+ */
+typedef struct AudioAnalyzer
+{
+  /** Pool running the queued jobs. */
+  GThreadPool * thread_pool;
+
+  /** Analyses by clip hash. */
+  GHashTable *  cache;
+
+  /** Queued or running jobs by ID. */
+  GHashTable *  jobs;
+
+  /** ID of the next job. */
+  unsigned int  next_job_id;
+
+  /** Protects the members above. */
+  GMutex        mutex;
+
+  /** Whether to analyze clips imported by the
+   * user in the background (off when testing,
+   * unless a test opts in). */
+  bool          analyze_imports;
+
+  /** Signalled when a job finishes. */
+  GCond         job_finished_cond;
+} AudioAnalyzer;
+
+/**
+ * Analyzes the given planar frames.
+ *
+ * This is what the analyzer runs for each job and
+ * can be called from any thread.
+ *
+ * @param cancelled Optional flag checked
+ *   periodically to stop early, in which case NULL
+ *   is returned.
+ */
+NONNULL_ARGS (1)
+AudioAnalysis *
+audio_analysis_new_from_frames (
+  float **       ch_frames,
+  channels_t     channels,
+  size_t         num_frames,
+  int            samplerate,
+  volatile gint * cancelled);
+
+NONNULL
+AudioAnalysis *
+audio_analysis_clone (
+  const AudioAnalysis * src);
+
+NONNULL
+void
+audio_analysis_free (
+  AudioAnalysis * self);
+
+AudioAnalyzer *
+audio_analyzer_new (void);
+
+/**
+ * Returns the content hash used to identify the
+ * clip's analysis.
+ */
+NONNULL
+char *
+audio_analyzer_get_clip_hash (
+  AudioClip * clip);
+
+/**
+ * Returns a copy of the cached analysis of the
+ * clip, or NULL if the clip was not analyzed yet.
+ *
+ * Results saved in the project are loaded on
+ * demand.
+ *
+ * The returned analysis must be free'd with
+ * audio_analysis_free().
+ */
+NONNULL
+AudioAnalysis *
+audio_analyzer_get_cached (
+  AudioAnalyzer * self,
+  AudioClip *     clip);
+
+/**
+ * Queues the analysis of the clip.
+ *
+ * If the clip is already analyzed, the callback
+ * is still called asynchronously.
+ *
+ * The frames are copied in the calling thread,
+ * which may be any thread that owns the clip.
+ *
+ * @param callback Optional callback to call on
+ *   the GTK thread when done.
+ *
+ * @return The job ID, to be used with
+ *   audio_analyzer_cancel().
+ */
+NONNULL_ARGS (1, 2)
+unsigned int
+audio_analyzer_queue (
+  AudioAnalyzer *       self,
+  AudioClip *           clip,
+  AudioAnalysisCallback callback,
+  void *                user_data);
+
+/**
+ * Cancels the given job if still queued or
+ * running.
+ *
+ * Its callback will not be called.
+ */
+NONNULL
+void
+audio_analyzer_cancel (
+  AudioAnalyzer * self,
+  unsigned int    job_id);
+
+/**
+ * Waits for all queued jobs to finish.
+ */
+NONNULL
+void
+audio_analyzer_wait (
+  AudioAnalyzer * self);
+
+/**
+ * Cancels all jobs and frees the analyzer.
+ */
+NONNULL
+void
+audio_analyzer_free (
+  AudioAnalyzer * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -34,6 +34,7 @@
 #include "audio/port.h"
 #include "audio/position.h"
 #include "audio/region.h"
+#include "audio/region_index.h"
 
 typedef struct Port Port;
 typedef struct _AutomationTrackWidget
@@ -185,6 +186,14 @@ typedef struct AutomationTrack
 
   /** Cache used during DSP. */
   Port *               port;
+
+  /**
+   * Interval index of @ref regions used for
+   * lookups during processing.
+   *
+   * @see automation_track_refresh_region_index().
+   */
+  RegionIndex          region_index;
 } AutomationTrack;
 
 static const cyaml_schema_field_t
@@ -455,6 +464,16 @@ void
 automation_track_unselect_all (
   AutomationTrack * self);
 
+/**
+ * Brings the region index up to date.
+ *
+ * To be called from the GTK thread.
+ */
+NONNULL
+void
+automation_track_refresh_region_index (
+  AutomationTrack * self);
+
 /**
  * Removes a region from the automation track.
  */
@@ -388,6 +388,18 @@ NONNULL
 void
 channel_prepare_process (Channel * channel);
 
+/**
+ * Prepares the parts of the channel before the
+ * prefader for processing.
+ *
+ * Called by channel_prepare_process(), or by the
+ * Prerenderer when the track is rendered ahead.
+ */
+NONNULL
+void
+channel_prepare_process_pre_fader (
+  Channel * self);
+
 /**
  * Creates a channel of the given type with the
  * given label.
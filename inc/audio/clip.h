@@ -40,6 +40,13 @@
 
 #define AUDIO_CLIP_SCHEMA_VERSION 1
 
+/**
+ * Number of frames summarized by each peak in
+ * \ref AudioClip.peaks_min and
+ * \ref AudioClip.peaks_max.
+ */
+#define AUDIO_CLIP_PEAK_BLOCK_SIZE 256
+
 /**
  * Audio clips for the pool.
  *
@@ -112,6 +119,22 @@ typedef struct AudioClip
    * @see AudioClip.frames_written.
    */
   gint64        last_write;
+
+  /**
+   * Minimum and maximum sample value (across all
+   * channels) of each block of
+   * \ref AUDIO_CLIP_PEAK_BLOCK_SIZE frames.
+   *
+   * Used for drawing waveforms without scanning
+   * every frame. Updated along with the channel
+   * caches, so appending frames (eg, while
+   * recording) only updates the new blocks.
+   */
+  float *       peaks_min;
+  float *       peaks_max;
+
+  /** Number of peaks. */
+  size_t        num_peaks;
 } AudioClip;
 
 static const cyaml_schema_field_t
@@ -195,9 +218,10 @@ audio_clip_new_recording (
   const char *     name);
 
 /**
- * Updates the channel caches.
+ * Updates the channel caches and the peaks.
  *
- * See @ref AudioClip.ch_frames.
+ * See @ref AudioClip.ch_frames and
+ * @ref AudioClip.peaks_min.
  *
  * @param start_from Frames to start from (per
  *   channel. The previous frames will be kept.
@@ -208,6 +232,25 @@ audio_clip_update_channel_caches (
   AudioClip * self,
   size_t      start_from);
 
+/**
+ * Gets the minimum and maximum sample value
+ * (across all channels) in the given frame range.
+ *
+ * Uses the peaks for whole blocks, so the cost
+ * does not grow with the length of the range.
+ *
+ * @param start_frame First frame (inclusive).
+ * @param end_frame Last frame (exclusive).
+ */
+NONNULL
+void
+audio_clip_get_min_max (
+  const AudioClip * self,
+  long              start_frame,
+  long              end_frame,
+  float *           min,
+  float *           max);
+
 /**
  * Shows a dialog with info on how to edit a file,
  * with an option to open an app launcher.
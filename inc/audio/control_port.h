@@ -37,8 +37,10 @@ typedef struct Port Port;
  * Used for queueing changes to be applied during
  * processing.
  *
- * Used only for non-plugin ports such as BPM and
- * time signature.
+ * BPM and time signature changes are identified by
+ * their flags. Other changes are applied to the
+ * port identified by
+ * \ref ControlPortChange.port_id.
  */
 typedef struct ControlPortChange
 {
@@ -65,8 +67,64 @@ typedef struct ControlPortChange
 
   BeatUnit      beat_unit;
 
+  /**
+   * Identifier of the port to set
+   * \ref ControlPortChange.real_val to, if no
+   * flag is set.
+   *
+   * The port is looked up when the change is
+   * applied and the change is dropped if it no
+   * longer exists. The strings are not kept.
+   *
+   * @see control_port_change_set_port().
+   */
+  PortIdentifier port_id;
+
+  /** Whether \ref ControlPortChange.port_id is
+   * set. */
+  bool          has_port_id;
+
+  /** Whether to forward the change to the plugin
+   * UI (see port_set_control_value()). */
+  bool          forward_event;
+
 } ControlPortChange;
 
+/** Max number of changes in a batch. */
+#define CONTROL_PORT_CHANGE_BATCH_MAX_CHANGES 1024
+
+/**
+ * Header written to the queue before the changes
+ * of a batch.
+ */
+typedef struct ControlPortChangeBatchHeader
+{
+  /** Number of changes following the header. */
+  int           num_changes;
+
+  /** Monotonic time (in usec) the batch was
+   * created, set as the ports' last change time
+   * when applied. */
+  gint64        timestamp;
+} ControlPortChangeBatchHeader;
+
+/**
+ * A group of changes that are applied together at
+ * the start of a processing cycle.
+ *
+ * Multiple changes to the same port are coalesced
+ * so that only the last value is applied.
+ *
+ * @see router_queue_control_port_changes().
+ */
+typedef struct ControlPortChangeBatch
+{
+  ControlPortChangeBatchHeader header;
+
+  ControlPortChange changes[
+    CONTROL_PORT_CHANGE_BATCH_MAX_CHANGES];
+} ControlPortChangeBatch;
+
 /**
  * @addtogroup audio
  *
@@ -196,6 +254,23 @@ control_port_set_real_val_w_events (
   Port * self,
   float  val);
 
+/**
+ * Sets the real value of the control from the GTK
+ * thread.
+ *
+ * If the engine is running, the change is queued
+ * and applied at the start of the next processing
+ * cycle, otherwise it is applied immediately.
+ *
+ * @see router_queue_control_port_change().
+ */
+NONNULL
+void
+control_port_queue_real_val (
+  Port * self,
+  float  val,
+  bool   forward_event);
+
 /**
  * Wrapper over port_set_control_value() for toggles.
  */
@@ -225,6 +300,75 @@ control_port_set_val_from_normalized (
   float  val,
   bool   automating);
 
+/**
+ * Sets the port the change is for.
+ */
+NONNULL
+void
+control_port_change_set_port (
+  ControlPortChange * self,
+  const Port *        port);
+
+/**
+ * Creates a new empty batch of control port
+ * changes.
+ */
+ControlPortChangeBatch *
+control_port_change_batch_new (void);
+
+/**
+ * Adds a change to the batch, replacing the value
+ * of any previous change for the same port.
+ *
+ * @return Whether the change was added (false if
+ *   the batch is full).
+ */
+NONNULL
+bool
+control_port_change_batch_add (
+  ControlPortChangeBatch *  self,
+  const ControlPortChange * change);
+
+/**
+ * Convenience wrapper over
+ * control_port_change_batch_add() for setting the
+ * real value of a port.
+ */
+NONNULL
+bool
+control_port_change_batch_add_port_val (
+  ControlPortChangeBatch * self,
+  Port *                   port,
+  float                    real_val,
+  bool                     forward_event);
+
+/**
+ * Removes all changes from the batch.
+ */
+NONNULL
+void
+control_port_change_batch_clear (
+  ControlPortChangeBatch * self);
+
+/**
+ * Applies the given change.
+ *
+ * To be called at the start of a processing cycle
+ * (or while the engine is not running).
+ *
+ * @param timestamp Time of the change, see
+ *   ControlPortChangeBatchHeader.timestamp.
+ */
+NONNULL
+void
+control_port_change_apply (
+  const ControlPortChange * change,
+  gint64                    timestamp);
+
+void
+control_port_change_batch_free (
+  ControlPortChangeBatch * self);
+
 /**
  * @}
  */
@@ -30,6 +30,8 @@
 
 #include "zrythm-config.h"
 #include <audec/audec.h>
+#include <samplerate.h>
+#include <sndfile.h>
 
 /**
  * @addtogroup audio
@@ -97,6 +99,119 @@ void
 audio_encoder_free (
   AudioEncoder * self);
 
+/**
+ * Default number of frames per chunk returned by
+ * audio_encoder_stream_read().
+ */
+#define AUDIO_ENCODER_STREAM_DEFAULT_CHUNK_SIZE 65536
+
+/**
+ * Streaming decoder that returns a file's frames
+ * in fixed-size planar chunks, resampled to the
+ * requested sample rate.
+ *
+ * Unlike AudioEncoder, the whole file is never
+ * held in memory, so memory use is bounded by the
+ * chunk size.
+ */
+typedef struct AudioEncoderStream
+{
+  /** Filename. */
+  char *        file;
+
+  SNDFILE *     sndfile;
+  SF_INFO       sfinfo;
+
+  /** Number of channels. */
+  unsigned int  channels;
+
+  /** Bit depth of the file, or 0 if unknown. */
+  int           bit_depth;
+
+  /** Resampler, or NULL if the file is already at
+   * the requested sample rate. */
+  SRC_STATE *   src_state;
+
+  /** Output/input sample rate ratio. */
+  double        src_ratio;
+
+  /** Output frames per chunk. */
+  size_t        chunk_size;
+
+  /** Input frames read per call. */
+  size_t        in_chunk_size;
+
+  /** Interleaved input frames. */
+  float *       in_buf;
+
+  /** First unused frame in @ref in_buf. */
+  size_t        in_buf_pos;
+
+  /** Number of unused frames in @ref in_buf. */
+  size_t        in_buf_frames;
+
+  /** Interleaved output frames. */
+  float *       out_buf;
+
+  /** Planar output chunk. */
+  float *       ch_bufs[16];
+
+  /** Whether the whole file was read. */
+  bool          input_done;
+
+  /** Whether all frames were returned. */
+  bool          finished;
+} AudioEncoderStream;
+
+/**
+ * Opens the given file for streaming decoding.
+ *
+ * @param samplerate Sample rate to resample to.
+ * @param chunk_size Number of frames per chunk.
+ *
+ * @return The stream, or NULL if the file cannot
+ *   be streamed, in which case AudioEncoder should
+ *   be used instead.
+ */
+NONNULL
+AudioEncoderStream *
+audio_encoder_stream_new (
+  const char * filepath,
+  int          samplerate,
+  size_t       chunk_size);
+
+/**
+ * Returns the estimated number of frames per
+ * channel the stream will return.
+ */
+NONNULL
+size_t
+audio_encoder_stream_get_num_frames_estimate (
+  AudioEncoderStream * self);
+
+/**
+ * Decodes and resamples the next chunk.
+ *
+ * @param[out] ch_frames Set to an array of
+ *   AudioEncoderStream.channels planar buffers
+ *   holding the chunk. They remain valid until the
+ *   next call.
+ *
+ * @return The number of frames per channel in the
+ *   chunk, 0 at the end of the file or -1 if an
+ *   error occurred.
+ */
+NONNULL
+ssize_t
+audio_encoder_stream_read (
+  AudioEncoderStream * self,
+  float ***            ch_frames);
+
+NONNULL
+void
+audio_encoder_stream_free (
+  AudioEncoderStream * self);
+
 /**
  * @}
  */
@@ -78,6 +78,7 @@ typedef struct Project Project;
 typedef struct HardwareProcessor HardwareProcessor;
 typedef struct ObjectPool ObjectPool;
 typedef struct MPMCQueue MPMCQueue;
+typedef struct RtArena RtArena;
 
 /**
  * @addtogroup audio Audio
@@ -802,6 +803,20 @@ typedef struct AudioEngine
    */
   ObjectPool *      ev_pool;
 
+  /**
+   * Locked memory for allocations needed during
+   * processing, or NULL if disabled.
+   */
+  RtArena *         rt_arena;
+
+  /**
+   * Whether tracks not monitoring live input are
+   * rendered ahead of the playhead.
+   *
+   * Applied when the graph is rebuilt.
+   */
+  bool              anticipative_rendering;
+
   /** ID of the event processing source func. */
   guint             process_source_id;
 
@@ -819,6 +834,18 @@ typedef struct AudioEngine
   /** Whether the cycle is currently running. */
   volatile gint     cycle_running;
 
+  /**
+   * CPUs to pin the backend's processing thread
+   * to on the first cycle after activation, or
+   * NULL.
+   */
+  GArray *          audio_thread_cpus;
+
+  /** Whether the processing thread was pinned to
+   * AudioEngine.audio_thread_cpus (if any) and had
+   * its stack pre-faulted. */
+  volatile gint     audio_thread_prepared;
+
   /** Whether the engine is already pre-set up. */
   bool              pre_setup;
 
@@ -975,6 +1002,44 @@ engine_activate (
   AudioEngine * self,
   bool          activate);
 
+/**
+ * Returns the frame offset of MIDI input that
+ * arrived at the given monotonic time (in
+ * microseconds), relative to the given period
+ * start.
+ *
+ * Hardware MIDI input is played back one period
+ * after it arrived, at the same offset, so that
+ * events keep their relative timing instead of
+ * being quantized to the start of the cycle they
+ * were received in.
+ *
+ * @param period_start Monotonic time of the
+ *   start of the period the event arrived in.
+ * @param nframes Number of frames in the cycle
+ *   the event is played in. The result is clamped
+ *   to it.
+ */
+HOT
+NONNULL
+midi_time_t
+engine_get_input_frame_offset (
+  const AudioEngine * self,
+  gint64              period_start,
+  gint64              timestamp,
+  nframes_t           nframes);
+
+/**
+ * Returns the monotonic time at the start of the
+ * period before the current cycle, to be used with
+ * engine_get_input_frame_offset() for input
+ * received until the start of the current cycle.
+ */
+NONNULL
+gint64
+engine_get_previous_period_start (
+  const AudioEngine * self);
+
 /**
  * Updates frames per tick based on the time sig,
  * the BPM, and the sample rate
@@ -99,6 +99,19 @@ bounce_step_to_str (
   return bounce_step_str[bounce_step];
 }
 
+typedef struct ExportSettings ExportSettings;
+
+/**
+ * Called by the exporter after each processed
+ * block, from the exporting thread.
+ *
+ * Set ExportSettings.progress_info.cancelled to
+ * stop the export.
+ */
+typedef void (*ExportProgressCallback) (
+  ExportSettings * settings,
+  void *           user_data);
+
 /**
  * Export settings to be passed to the exporter
  * to use.
@@ -153,6 +166,20 @@ typedef struct ExportSettings
    * for progress calculation. */
   int               num_files;
 
+  /**
+   * Maximum number of frames to process per cycle,
+   * or 0 to use the engine's block length.
+   *
+   * Capped at the engine's block length, which
+   * plugins are instantiated with.
+   */
+  nframes_t         block_length;
+
+  /** Optional callback to call after each
+   * processed block. */
+  ExportProgressCallback progress_cb;
+  void *            progress_cb_user_data;
+
   GenericProgressInfo progress_info;
 } ExportSettings;
 
@@ -223,6 +250,17 @@ exporter_stringize_audio_format (
   AudioFormat format,
   bool        extension);
 
+/**
+ * Returns the audio format for the given file
+ * extension (case insensitive), or
+ * NUM_AUDIO_FORMATS if unknown.
+ *
+ * "ogg" is parsed as Vorbis and "opus" as Opus.
+ */
+AudioFormat
+exporter_get_audio_format_from_extension (
+  const char * extension);
+
 /**
  * Exports an audio file based on the given
  * settings.
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Bulk file import.
+ */
+
+#ifndef __AUDIO_FILE_IMPORT_H__
+#define __AUDIO_FILE_IMPORT_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioClip AudioClip;
+typedef struct FileImport FileImport;
+typedef struct _GtkWidget GtkWidget;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Called on the GTK thread when an asynchronous
+ * import finishes.
+ *
+ * The callback may free the import.
+ *
+ * @param cancelled Whether the import was
+ *   cancelled.
+ */
+typedef void (*FileImportCallback) (
+  FileImport * self,
+  bool         cancelled,
+  void *       user_data);
+
+/**
+ * Decodes the audio files of a bulk import (such
+ * as a file drop) concurrently before the
+ * regions/tracks are created.
+ *
+ * Each audio file is decoded and resampled to the
+ * engine's sample rate on a worker thread, and
+ * then encoded to a temporary file in the project
+ * pool so that adding the clip to the pool only
+ * needs a rename.
+ *
+ * The regions/tracks are then created on the GTK
+ * thread, passing the import to
+ * file_import_add_clip_to_pool() to use the
+ * already decoded clips.
+ */
+typedef struct FileImport
+{
+  /** Absolute paths of the files. */
+  char **             paths;
+
+  /**
+   * Decoded clip of each file, or NULL if the file
+   * is not an audio file, was not decoded or was
+   * already moved to the pool.
+   */
+  AudioClip **        clips;
+
+  /**
+   * Temporary file in FileImport.tmp_dir each clip
+   * was encoded to, or NULL.
+   */
+  char **             tmp_paths;
+
+  /** Whether each file is an audio file. */
+  bool *              is_audio;
+
+  int                 num_files;
+
+  /** Number of audio files to decode. */
+  int                 num_jobs;
+
+  /** Number of files finished decoding. */
+  volatile gint       num_done;
+
+  /** Set to stop decoding the remaining files. */
+  volatile gint       cancelled;
+
+  /**
+   * Directory to encode the clips to, next to the
+   * project pool, or NULL if the project has no
+   * pool yet.
+   */
+  char *              tmp_dir;
+
+  /** Whether to queue the analysis of each
+   * decoded clip (see
+   * AudioAnalyzer.analyze_imports). */
+  bool                analyze;
+
+  /** Pool running the decoding jobs. */
+  GThreadPool *       thread_pool;
+
+  /** Callback of an asynchronous run. */
+  FileImportCallback  callback;
+  void *              user_data;
+
+  /** Idle source calling @ref callback. */
+  guint               done_source_id;
+
+  /** Protects @ref done_source_id. */
+  GMutex              mutex;
+
+  /**
+   * Progress shown in @ref progress_dialog.
+   *
+   * Only accessed from the GTK thread, see
+   * @ref progress_source_id.
+   */
+  GenericProgressInfo progress_info;
+
+  /** Timeout syncing @ref progress_info with the
+   * decoding jobs. */
+  guint               progress_source_id;
+
+  /** Non-modal progress dialog, if shown. */
+  GtkWidget *         progress_dialog;
+} FileImport;
+
+/**
+ * Creates a new import for the given
+ * SupportedFile's.
+ */
+NONNULL
+FileImport *
+file_import_new (
+  GPtrArray * files);
+
+/**
+ * Decodes all audio files on a thread pool and
+ * waits for them to finish.
+ *
+ * To be used when there is no UI to keep
+ * responsive.
+ */
+NONNULL
+void
+file_import_run (
+  FileImport * self);
+
+/**
+ * Starts decoding all audio files on a thread
+ * pool and returns immediately.
+ *
+ * Must be called from the GTK thread.
+ *
+ * @param show_progress Whether to show a
+ *   non-modal, cancelable progress dialog.
+ * @param callback Callback to call on the GTK
+ *   thread when all files are decoded or the
+ *   import is cancelled.
+ */
+NONNULL_ARGS (1, 3)
+void
+file_import_run_async (
+  FileImport *       self,
+  bool               show_progress,
+  FileImportCallback callback,
+  void *             user_data);
+
+/**
+ * Adds the clip decoded by the import for the
+ * given file to the pool.
+ *
+ * The encoded file is moved into place in the
+ * pool, so the clip is not written again.
+ *
+ * @return The pool ID of the clip, or -1 if the
+ *   import has no clip for the file.
+ */
+NONNULL
+int
+file_import_add_clip_to_pool (
+  FileImport * self,
+  const char * abs_path);
+
+/**
+ * Cancels any running jobs and frees the import.
+ */
+NONNULL
+void
+file_import_free (
+  FileImport * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -57,6 +57,7 @@ typedef struct MPMCQueue MPMCQueue;
 typedef struct Port Port;
 typedef struct Fader Fader;
 typedef struct Track Track;
+typedef struct TrackLane TrackLane;
 typedef struct SampleProcessor SampleProcessor;
 typedef struct Plugin Plugin;
 typedef struct Position Position;
@@ -64,6 +65,9 @@ typedef struct GraphThread GraphThread;
 typedef struct Router Router;
 typedef struct ModulatorMacroProcessor
   ModulatorMacroProcessor;
+typedef struct ModulationMatrix ModulationMatrix;
+typedef struct GraphBufferPool GraphBufferPool;
+typedef struct Prerenderer Prerenderer;
 
 /**
  * @addtogroup audio
@@ -79,6 +83,65 @@ typedef struct ModulatorMacroProcessor
 
 #define MAX_GRAPH_THREADS 128
 
+/**
+ * Default minimum number of lanes a track needs
+ * before its lanes are processed in their own
+ * graph nodes.
+ */
+#define GRAPH_DEFAULT_LANE_PARALLELISM_THRESHOLD 8
+
+/**
+ * Number of consecutive cycles the adaptive thread
+ * policy must want fewer workers before parking
+ * one.
+ */
+#define GRAPH_THREAD_SHRINK_DELAY_CYCLES 256
+
+/**
+ * Policy for the number of active worker threads.
+ */
+typedef enum GraphThreadPolicy
+{
+  /** All worker threads are always active. */
+  GRAPH_THREAD_POLICY_FIXED,
+
+  /** Workers are parked or woken up between
+   * cycles based on the measured parallelism of
+   * the graph. */
+  GRAPH_THREAD_POLICY_ADAPTIVE,
+} GraphThreadPolicy;
+
+/**
+ * Worker thread metrics of the graph.
+ */
+typedef struct GraphThreadStats
+{
+  /** Smoothed ratio of the total processing work
+   * to the critical path. */
+  float        parallelism;
+
+  /** Length of the critical path in the last
+   * cycle, in nanoseconds. */
+  gint64       critical_path_ns;
+
+  /** Total processing work in the last cycle, in
+   * nanoseconds. */
+  gint64       work_ns;
+
+  /** Number of worker threads not parked. */
+  int          num_active_threads;
+
+  /** Number of worker threads (excluding the main
+   * thread). */
+  int          num_threads;
+
+  /** Number of times a worker was parked. */
+  gint64       num_parks;
+
+  /** Number of times a worker was woken up. */
+  gint64       num_unparks;
+} GraphThreadStats;
+
 /**
  * Graph.
  */
@@ -161,6 +224,55 @@ typedef struct Graph
   GraphThread *        main_thread;
   gint                 num_threads;
 
+  /** CPUs to pin worker threads to (one CPU per
+   * thread, round-robin), or NULL. */
+  GArray *             graph_thread_cpus;
+
+  /** CPUs to pin the main thread to, or NULL. */
+  GArray *             audio_thread_cpus;
+
+  /** Policy for the number of active workers. */
+  GraphThreadPolicy    thread_policy;
+
+  /** Minimum number of active workers for the
+   * adaptive policy. */
+  int                  min_active_threads;
+
+  /** Whether nodes measure their processing time,
+   * used by the adaptive policy. */
+  bool                 measure_parallelism;
+
+  /**
+   * Number of active workers.
+   *
+   * Workers with an ID at or above this park on
+   * their GraphThread.park_sem.
+   */
+  volatile gint        num_active_threads;
+
+  /** Number of parked workers (also counted in
+   * Graph.idle_thread_cnt). */
+  volatile gint        parked_thread_cnt;
+
+  /** Total processing work of the current cycle,
+   * in nanoseconds. */
+  volatile gint        cycle_work_ns;
+
+  /** Consecutive cycles that wanted fewer
+   * workers. */
+  int                  shrink_cycles;
+
+  /** Metrics, updated at the end of each cycle. */
+  GraphThreadStats     thread_stats;
+
+  /** Buffers shared by ports of the current
+   * nodes, or NULL. */
+  GraphBufferPool *    buffer_pool;
+
+  /** Renders tracks ahead of the playhead, or
+   * NULL. */
+  Prerenderer *        prerenderer;
+
   /**
    * An array of pointers to ports that are exposed
    * to the backend and are outputs.
@@ -170,6 +282,14 @@ typedef struct Graph
    */
   GPtrArray *          external_out_ports;
 
+  /**
+   * CV to control port routes of the current
+   * graph, processed at the end of each cycle.
+   *
+   * Rebuilt by graph_setup() when rechaining.
+   */
+  ModulationMatrix *   mod_matrix;
+
 } Graph;
 
 void
@@ -196,6 +316,15 @@ graph_find_node_from_track (
   const Track * track,
   bool          use_setup_nodes);
 
+/**
+ * Returns the node of the given lane from the setup
+ * nodes, if the lane is processed in its own node.
+ */
+GraphNode *
+graph_find_node_from_track_lane (
+  const Graph *     self,
+  const TrackLane * lane);
+
 GraphNode *
 graph_find_node_from_fader (
   const Graph * self,
@@ -316,6 +445,27 @@ int
 graph_start (
   Graph * graph);
 
+/**
+ * Logs the thread ID, allowed CPUs and number of
+ * CPU migrations of each graph thread.
+ */
+NONNULL
+void
+graph_print_thread_placement (
+  Graph * self);
+
+/**
+ * Returns the worker thread metrics.
+ *
+ * The metrics are updated from the realtime
+ * thread so they may be slightly inconsistent.
+ */
+NONNULL
+void
+graph_get_thread_stats (
+  Graph *            self,
+  GraphThreadStats * stats);
+
 /**
  * Returns a new graph.
  */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Pool of port buffers shared by ports whose
+ * buffers are never live at the same time.
+ */
+
+#ifndef __AUDIO_GRAPH_BUFFER_POOL_H__
+#define __AUDIO_GRAPH_BUFFER_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Graph Graph;
+typedef struct Port Port;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/** Alignment of pooled buffers in bytes. */
+#define GRAPH_BUFFER_POOL_ALIGNMENT 64
+
+/**
+ * Buffers shared by ports of the graph.
+ *
+ * The lifetime of a port's buffer spans from the
+ * start of the nodes writing to it to the end of
+ * the nodes reading from it. Ports whose lifetimes
+ * are ordered by the graph (every reader of one
+ * finishes before any writer of the other starts,
+ * regardless of how nodes are scheduled on the
+ * threads) share a buffer.
+ */
+typedef struct GraphBufferPool
+{
+  /** Cache line aligned buffers. */
+  float **     bufs;
+  int          num_bufs;
+
+  /** Size of each buffer in samples. */
+  size_t       buf_size;
+
+  /**
+   * Memory backing each buffer, either a block of
+   * the engine's RtArena or (if it had no room)
+   * heap memory.
+   */
+  void **      mems;
+
+  /**
+   * Ports that were given a pooled buffer.
+   *
+   * Entries are set to NULL when the port goes
+   * back to its own buffer.
+   */
+  Port **      ports;
+
+  /** Number of ports given a pooled buffer. */
+  int          num_ports;
+} GraphBufferPool;
+
+/**
+ * Computes the buffer lifetimes of the ports in
+ * the graph's current nodes and makes the ports
+ * that can share buffers use pooled buffers.
+ *
+ * Must be called while the graph is not running,
+ * after all ports were released with
+ * port_release_pooled_buf().
+ */
+GraphBufferPool *
+graph_buffer_pool_new (
+  Graph * graph);
+
+/**
+ * Frees the pool.
+ *
+ * Ports still using its buffers (eg, ports that
+ * were removed from the graph) go back to their
+ * own buffers.
+ */
+void
+graph_buffer_pool_free (
+  GraphBufferPool * self);
+
+/**
+ * @}
+ */
+
+#endif
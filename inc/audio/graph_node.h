@@ -57,6 +57,7 @@ typedef struct PassthroughProcessor
 typedef struct Port Port;
 typedef struct Fader Fader;
 typedef struct Track Track;
+typedef struct TrackLane TrackLane;
 typedef struct SampleProcessor SampleProcessor;
 typedef struct Plugin Plugin;
 typedef struct HardwareProcessor HardwareProcessor;
@@ -64,6 +65,8 @@ typedef struct ModulatorMacroProcessor
   ModulatorMacroProcessor;
 typedef struct EngineProcessTimeInfo
   EngineProcessTimeInfo;
+typedef struct PrerenderTrack PrerenderTrack;
+typedef struct RegionIndexCursor RegionIndexCursor;
 
 /**
  * @addtogroup audio
@@ -108,6 +111,14 @@ typedef enum GraphNodeType
 
   /** Channel send. */
   ROUTE_NODE_TYPE_CHANNEL_SEND,
+
+  /**
+   * Track lane, when the lanes of a track are
+   * processed in parallel.
+   *
+   * Feeds the track processor node.
+   */
+  ROUTE_NODE_TYPE_TRACK_LANE,
 } GraphNodeType;
 
 /**
@@ -148,6 +159,37 @@ typedef struct GraphNode
 
   Track *       track;
 
+  /**
+   * Lane index in @ref GraphNode.track, if track
+   * lane.
+   *
+   * The index is stored instead of the lane because
+   * lanes may be removed without recreating the
+   * graph.
+   */
+  int           lane_pos;
+
+  /**
+   * Cursors into the region indices of the lanes
+   * processed by this node (all the track's lanes
+   * for track nodes, or the single lane for lane
+   * nodes), used when processing live.
+   *
+   * Lanes added after the node was created are
+   * processed without a cursor.
+   */
+  RegionIndexCursor * region_cursors;
+
+  /** Cursors used when processing ahead, so that
+   * the prerenderer does not disturb the live
+   * cursors. */
+  RegionIndexCursor * ahead_region_cursors;
+
+  /** Number of cursors in each of
+   * @ref region_cursors and
+   * @ref ahead_region_cursors. */
+  int           num_region_cursors;
+
   /** Pre-Fader, if prefader node. */
   Fader *       prefader;
 
@@ -172,6 +214,25 @@ typedef struct GraphNode
   /** The route's playback latency so far. */
   nframes_t     route_playback_latency;
 
+  /**
+   * Length in nanoseconds of the longest chain of
+   * processing work ending at this node in the
+   * last cycle.
+   *
+   * Only measured when the graph measures its
+   * parallelism.
+   */
+  gint          path_end_ns;
+
+  /** Track this node is rendered ahead for, if
+   * part of a PrerenderTrack. */
+  PrerenderTrack * prerender_track;
+
+  /** Track whose rendered audio this node
+   * receives, if a prefader input of a
+   * PrerenderTrack. */
+  PrerenderTrack * prerender_output;
+
   GraphNodeType type;
 } GraphNode;
 
@@ -207,6 +268,19 @@ graph_node_process (
   GraphNode *           node,
   EngineProcessTimeInfo time_nfo);
 
+/**
+ * Processes the GraphNode outside of a graph
+ * cycle at the given (already latency
+ * compensated) time.
+ *
+ * The node's children are not triggered.
+ */
+HOT
+void
+graph_node_process_ahead (
+  GraphNode *           node,
+  EngineProcessTimeInfo time_nfo);
+
 /**
  * Returns the latency of only the given port,
  * without adding the previous/next latencies.
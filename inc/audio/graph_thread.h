@@ -50,6 +50,7 @@
 #include <pthread.h>
 
 #include "utils/types.h"
+#include "zix/sem.h"
 
 #include <gtk/gtk.h>
 
@@ -87,6 +88,17 @@ typedef struct GraphThread
   /** Pointer back to the graph. */
   Graph *           graph;
 
+  /** OS thread ID, set when the thread starts. */
+  long              tid;
+
+  /** CPUs the thread is allowed to run on, set
+   * when the thread starts. */
+  char              allowed_cpus[256];
+
+  /** Posted to wake up the thread when it is
+   * parked by the adaptive thread policy. */
+  ZixSem            park_sem;
+
 #ifdef HAVE_LSP_DSP
   /** LSP DSP context. */
   lsp_dsp_context_t lsp_ctx;
@@ -106,6 +118,14 @@ graph_thread_new (
   const bool is_main,
   Graph *    graph);
 
+/**
+ * Frees the thread after it was joined.
+ */
+NONNULL
+void
+graph_thread_free (
+  GraphThread * self);
+
 /**
  * @}
  */
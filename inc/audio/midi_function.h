@@ -31,6 +31,7 @@
 #include "utils/yaml.h"
 
 typedef struct ArrangerSelections ArrangerSelections;
+typedef struct MidiNoteColumns MidiNoteColumns;
 
 /**
  * @addtogroup audio
@@ -40,13 +41,33 @@ typedef struct ArrangerSelections ArrangerSelections;
 
 typedef enum MidiFunctionType
 {
+  /** Ramps the velocities of the notes in each
+   * region from half the loudest velocity up to
+   * the loudest velocity. */
   MIDI_FUNCTION_CRESCENDO,
+
+  /** Not supported yet (needs new notes). */
   MIDI_FUNCTION_FLAM,
+
+  /** Mirrors the notes of each region in time. */
   MIDI_FUNCTION_FLIP_HORIZONTAL,
+
+  /** Mirrors the pitches around the middle of the
+   * pitch range. */
   MIDI_FUNCTION_FLIP_VERTICAL,
+
+  /** Extends each note to the start of the next
+   * note. */
   MIDI_FUNCTION_LEGATO,
+
+  /** Shortens the notes to 3/4 of their length. */
   MIDI_FUNCTION_PORTATO,
+
+  /** Shortens the notes to half their length. */
   MIDI_FUNCTION_STACCATO,
+
+  /** Delays each note of a chord by a 64th note
+   * per note below it. */
   MIDI_FUNCTION_STRUM,
 } MidiFunctionType;
 
@@ -70,6 +91,22 @@ midi_function_type_to_string (
   return midi_function_type_strings[type].str;
 }
 
+/**
+ * Applies the given function to all the notes in
+ * the given columns in one pass.
+ *
+ * This only edits the columns. The result can be
+ * written to the notes with
+ * midi_note_columns_apply().
+ *
+ * @return Non-zero if failed.
+ */
+int
+midi_function_apply_to_columns (
+  MidiNoteColumns *    cols,
+  MidiFunctionType     type,
+  GError **            error);
+
 /**
  * Applies the given action to the given selections.
  *
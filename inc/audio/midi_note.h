@@ -92,9 +92,6 @@ typedef struct MidiNote
   int             pos;
 
   int             magic;
-
-  /** Cache layout for drawing the name. */
-  PangoLayout *   layout;
 } MidiNote;
 
 static const cyaml_schema_field_t
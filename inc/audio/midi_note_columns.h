@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Attributes of a set of MIDI notes stored as
+ * columns (one array per attribute).
+ *
+ * Used for bulk edits (MIDI functions,
+ * quantization) that operate on all notes in one
+ * pass, and as a compact representation of the
+ * notes before/after an edit in undoable actions.
+ */
+
+#ifndef __AUDIO_MIDI_NOTE_COLUMNS_H__
+#define __AUDIO_MIDI_NOTE_COLUMNS_H__
+
+#include <stdint.h>
+
+#include "audio/region_identifier.h"
+#include "utils/yaml.h"
+
+typedef struct MidiArrangerSelections
+  MidiArrangerSelections;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+#define MIDI_NOTE_COLUMNS_SCHEMA_VERSION 1
+
+/**
+ * Attributes of MIDI notes, one array per
+ * attribute.
+ *
+ * Note \p i lives in region
+ * \ref MidiNoteColumns.region_ids[region_indices[i]]
+ * at index \ref MidiNoteColumns.note_indices[i].
+ *
+ * Positions are in ticks relative to the start of
+ * the region, like MidiNote positions.
+ */
+typedef struct MidiNoteColumns
+{
+  int                schema_version;
+
+  /** Unique identifiers of the regions the notes
+   * belong to. */
+  RegionIdentifier * region_ids;
+  int                num_region_ids;
+
+  /** Index in \ref MidiNoteColumns.region_ids,
+   * per note. */
+  int *              region_indices;
+
+  /** Index of the note in its region. */
+  int *              note_indices;
+
+  double *           start_ticks;
+  double *           end_ticks;
+  uint8_t *          pitches;
+  uint8_t *          velocities;
+  uint8_t *          muted;
+
+  /** Number of notes (length of each per-note
+   * array). */
+  int                num_notes;
+} MidiNoteColumns;
+
+static const cyaml_schema_field_t
+  midi_note_columns_fields_schema[] =
+{
+  YAML_FIELD_INT (
+    MidiNoteColumns, schema_version),
+  YAML_FIELD_DYN_ARRAY_VAR_COUNT (
+    MidiNoteColumns, region_ids,
+    region_identifier_schema_default),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "region_indices",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, region_indices, num_notes,
+    &int_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "note_indices",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, note_indices, num_notes,
+    &int_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "start_ticks",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, start_ticks, num_notes,
+    &double_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "end_ticks",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, end_ticks, num_notes,
+    &double_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "pitches",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, pitches, num_notes,
+    &uint8_t_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "velocities",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, velocities, num_notes,
+    &uint8_t_schema, 0, CYAML_UNLIMITED),
+  CYAML_FIELD_SEQUENCE_COUNT (
+    "muted",
+    CYAML_FLAG_POINTER | CYAML_FLAG_OPTIONAL,
+    MidiNoteColumns, muted, num_notes,
+    &uint8_t_schema, 0, CYAML_UNLIMITED),
+
+  CYAML_FIELD_END
+};
+
+static const cyaml_schema_value_t
+  midi_note_columns_schema =
+{
+  YAML_VALUE_PTR (
+    MidiNoteColumns,
+    midi_note_columns_fields_schema),
+};
+
+/**
+ * Creates columns from the MIDI notes in the
+ * given selections (project selections or a
+ * clone).
+ */
+NONNULL
+MidiNoteColumns *
+midi_note_columns_new_from_selections (
+  MidiArrangerSelections * sel);
+
+NONNULL
+MidiNoteColumns *
+midi_note_columns_clone (
+  const MidiNoteColumns * src);
+
+/**
+ * Writes the attributes to the corresponding MIDI
+ * notes in the project.
+ *
+ * Each region is looked up once and no events are
+ * published; the caller is expected to publish a
+ * single event for the whole change.
+ *
+ * @return Non-zero if failed.
+ */
+NONNULL_ARGS (1)
+int
+midi_note_columns_apply (
+  const MidiNoteColumns * self,
+  GError **               error);
+
+/**
+ * Writes the attributes to the MIDI notes in the
+ * given selections, which must be the selections
+ * (or a clone of the selections) the columns were
+ * created from.
+ *
+ * This is meant for non-project notes and only
+ * sets the values.
+ */
+NONNULL
+void
+midi_note_columns_apply_to_selections (
+  const MidiNoteColumns *  self,
+  MidiArrangerSelections * sel);
+
+NONNULL
+void
+midi_note_columns_free (
+  MidiNoteColumns * self);
+
+/**
+ * @}
+ */
+
+#endif
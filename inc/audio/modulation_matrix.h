@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Control-rate modulation matrix.
+ */
+
+#ifndef __AUDIO_MODULATION_MATRIX_H__
+#define __AUDIO_MODULATION_MATRIX_H__
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct Port Port;
+typedef struct PortConnection PortConnection;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Default control rate of the modulation matrix
+ * in Hz.
+ *
+ * 0 means once per processing cycle.
+ */
+#define MODULATION_MATRIX_DEFAULT_CONTROL_RATE 0
+
+/**
+ * Flat (source, destination, depth) routes from
+ * CV ports to control ports.
+ *
+ * The modulation offset of every destination is
+ * calculated in a single pass over the routes at
+ * the end of each processing cycle (or less often,
+ * depending on the control rate) and stored in
+ * Port.modulation_offset. Destination control
+ * ports then apply the offset to their base value
+ * when processed in the next cycle.
+ *
+ * Routes are grouped by destination, so the
+ * routes of destination @a d are
+ * [dest_route_starts[d], dest_route_starts[d + 1]).
+ *
+ * The matrix is rebuilt by graph_setup() and is
+ * only used by the processing thread. When it is
+ * rebuilt, ports that are no longer destinations
+ * get their modulation offset cleared and their
+ * base value restored.
+ */
+typedef struct ModulationMatrix
+{
+  /** Source CV port of each route. */
+  Port **                  src_ports;
+
+  /** Connection of each route (for the depth and
+   * enabled status, which can change without
+   * rebuilding the graph). */
+  const PortConnection **  conns;
+
+  /** Scratch buffer for the CV value of each
+   * route. */
+  float *                  cv_vals;
+
+  /** Scratch buffer for the depth of each route. */
+  float *                  depths;
+
+  int                      num_routes;
+
+  /** Destination control ports. */
+  Port **                  dest_ports;
+
+  /** Half of each destination's range. */
+  float *                  depth_ranges;
+
+  /** First route of each destination (plus one
+   * past the last route at the end). */
+  int *                    dest_route_starts;
+
+  int                      num_dests;
+
+  /**
+   * Frames between updates, or 0 to update every
+   * cycle.
+   */
+  nframes_t                control_period;
+
+  /** Frames processed since the last update. */
+  nframes_t                frames_since_update;
+} ModulationMatrix;
+
+/**
+ * Creates a modulation matrix from the CV
+ * connections of the given control ports.
+ *
+ * Port.srcs of the ports must be up to date.
+ * Control ports without CV sources get their
+ * modulation offset reset.
+ *
+ * @param ports Ports to consider (ports that are
+ *   not control inputs with CV sources or that are
+ *   being deleted are ignored).
+ * @param control_rate Control rate in Hz, or 0 to
+ *   update every cycle.
+ */
+NONNULL
+ModulationMatrix *
+modulation_matrix_new (
+  GPtrArray *    ports,
+  unsigned int   control_rate,
+  sample_rate_t  sample_rate);
+
+/**
+ * Calculates the modulation offset of each
+ * destination if due.
+ *
+ * To be called by the processing thread after
+ * the graph finished processing the given range.
+ *
+ * @param last_frame Index of the last processed
+ *   frame in the CV buffers.
+ * @param nframes Number of frames processed.
+ */
+HOT
+NONNULL
+void
+modulation_matrix_process (
+  ModulationMatrix * self,
+  nframes_t          last_frame,
+  nframes_t          nframes);
+
+NONNULL
+void
+modulation_matrix_free (
+  ModulationMatrix * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -68,6 +68,7 @@ typedef struct AutomationTrack AutomationTrack;
 typedef struct TruePeakDsp TruePeakDsp;
 typedef struct ExtPort ExtPort;
 typedef struct AudioClip AudioClip;
+typedef struct GraphBufferPool GraphBufferPool;
 typedef struct ChannelSend ChannelSend;
 typedef struct Transport Transport;
 typedef struct PluginGtkController
@@ -423,6 +424,13 @@ typedef struct Port
    */
   float               base_value;
 
+  /**
+   * For control ports with CV sources, the offset
+   * to apply to \ref Port.base_value, calculated by
+   * the ModulationMatrix.
+   */
+  float               modulation_offset;
+
   /**
    * Capture latency.
    *
@@ -586,6 +594,30 @@ typedef struct Port
   /** Last allocated buffer size (used for audio
    * ports). */
   size_t              last_buf_sz;
+
+  /**
+   * Buffer owned by the port while @ref Port.buf
+   * points to a buffer of the graph's buffer
+   * pool, otherwise NULL.
+   */
+  float *             own_buf;
+
+  /** Pool owning the buffer @ref Port.buf points
+   * to, or NULL if not pooled. */
+  GraphBufferPool *   buffer_pool;
+
+  /** Index of the port in the pool's list of
+   * ports. */
+  int                 buffer_pool_idx;
+
+  /**
+   * Whether a meter was created for the port.
+   *
+   * Metered ports don't use pooled buffers since
+   * the GUI reads them outside the processing
+   * cycle.
+   */
+  bool                metered;
 } Port;
 
 static const cyaml_schema_field_t
@@ -726,6 +758,46 @@ void
 port_allocate_bufs (
   Port * self);
 
+/**
+ * Returns whether the port's buffer may be shared
+ * with other ports whose buffers are never live at
+ * the same time.
+ *
+ * Only audio ports of plugins qualify, since
+ * their buffers are only accessed by graph nodes
+ * connected to the port's node.
+ */
+NONNULL
+bool
+port_can_use_pooled_buf (
+  const Port * self);
+
+/**
+ * Makes the port use the given buffer of @p pool
+ * instead of its own.
+ *
+ * Must only be called while the graph is not
+ * running.
+ */
+NONNULL
+void
+port_use_pooled_buf (
+  Port *            self,
+  GraphBufferPool * pool,
+  float *           buf);
+
+/**
+ * Makes the port use its own buffer again if it
+ * was using a pooled buffer.
+ *
+ * Must only be called while the graph is not
+ * running.
+ */
+NONNULL
+void
+port_release_pooled_buf (
+  Port * self);
+
 /**
  * Frees buffers.
  *
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Anticipative rendering of tracks that don't
+ * depend on live input.
+ */
+
+#ifndef __AUDIO_PRERENDERER_H__
+#define __AUDIO_PRERENDERER_H__
+
+#include "zrythm-config.h"
+
+#include <stdbool.h>
+
+#include "audio/position.h"
+#include "utils/types.h"
+#include "zix/sem.h"
+
+#include <glib.h>
+
+typedef struct Graph Graph;
+typedef struct GraphNode GraphNode;
+typedef struct Track Track;
+typedef struct Port Port;
+typedef struct PortIdentifier PortIdentifier;
+typedef struct EngineProcessTimeInfo
+  EngineProcessTimeInfo;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/** Maximum number of threads rendering ahead. */
+#define PRERENDERER_MAX_THREADS 16
+
+/**
+ * Number of consecutive eligible cycles before a
+ * track is handed over to the prerenderer again.
+ *
+ * Also used as the time a track stays live after
+ * it was invalidated, eg, while the user turns a
+ * knob.
+ */
+#define PRERENDERER_HOLD_CYCLES 64
+
+/**
+ * Number of chunks rendered by the engine before
+ * a track is handed over to the rendering
+ * threads.
+ */
+#define PRERENDERER_PREFILL_CHUNKS 4
+
+/**
+ * Part of the cycle (in percent) after which the
+ * engine stops rendering chunks ahead for tracks
+ * being handed over.
+ */
+#define PRERENDERER_PREFILL_BUDGET_PERCENT 50
+
+/**
+ * Who processes the nodes of a PrerenderTrack.
+ *
+ * Transitions away from
+ * PRERENDER_TRACK_STATE_RENDERING are only done
+ * by the rendering thread, so the live graph may
+ * take a track back only while it is idle.
+ */
+typedef enum PrerenderTrackState
+{
+  /** Processed by the live graph. */
+  PRERENDER_TRACK_STATE_LIVE,
+
+  /** Rendered ahead by the engine until enough
+   * chunks are ready to hand it over. */
+  PRERENDER_TRACK_STATE_PREFILL,
+
+  /** Owned by the prerenderer, not rendering. */
+  PRERENDER_TRACK_STATE_IDLE,
+
+  /** Owned by the prerenderer, rendering. */
+  PRERENDER_TRACK_STATE_RENDERING,
+} PrerenderTrackState;
+
+/**
+ * A block rendered ahead of time.
+ */
+typedef struct PrerenderChunk
+{
+  /** Position of the first frame, as seen by the
+   * prefader. */
+  Position     pos;
+
+  float *      l;
+  float *      r;
+} PrerenderChunk;
+
+/**
+ * A track whose nodes up to the prefader can be
+ * rendered ahead of time.
+ *
+ * The chunks form a single-producer
+ * single-consumer ring buffer between the
+ * rendering thread and the live graph.
+ */
+typedef struct PrerenderTrack
+{
+  Track *          track;
+
+  /** Nodes feeding the prefader, in topological
+   * order. */
+  GraphNode **     nodes;
+  int              num_nodes;
+
+  /** Prefader input ports receiving the rendered
+   * audio. */
+  Port *           out_l;
+  Port *           out_r;
+
+  PrerenderChunk * chunks;
+  int              num_chunks;
+
+  /** Frames per chunk. */
+  nframes_t        chunk_length;
+
+  /** Number of chunks written so far. */
+  volatile gint    write_idx;
+
+  /** Number of chunks consumed so far. */
+  volatile gint    read_idx;
+
+  /** Frames consumed from the chunk at
+   * @ref PrerenderTrack.read_idx. */
+  nframes_t        read_offset;
+
+  /** Position to render the next chunk at. */
+  Position         render_pos;
+
+  /** A PrerenderTrackState. */
+  volatile gint    state;
+
+  /** Set to stop rendering and go back to live
+   * processing. */
+  volatile gint    invalidated;
+
+  /**
+   * Whether the live graph skips the nodes of the
+   * track in the current cycle.
+   *
+   * Decided by prerenderer_prepare_cycle().
+   */
+  bool             skip_nodes;
+
+  /** Whether rendered audio is available for the
+   * current cycle. */
+  bool             consuming;
+
+  /** Consecutive cycles the track could have been
+   * rendered ahead. */
+  int              eligible_cycles;
+
+  /** Average time to render a chunk, in
+   * nanoseconds. */
+  gint64           render_ns;
+
+  /** Number of cycles that had to be silenced
+   * because the rendered audio was not ready. */
+  volatile gint    num_underruns;
+} PrerenderTrack;
+
+/**
+ * Renders tracks that are not monitoring live
+ * input ahead of the playhead on background
+ * threads.
+ *
+ * The live graph then only mixes in the rendered
+ * audio, so only armed or monitored tracks (and
+ * everything after the prefaders) have to finish
+ * within the hardware period.
+ *
+ * Tracks go back to live processing whenever they
+ * can't be rendered ahead (eg, when armed, when
+ * the transport stops or jumps, or when the user
+ * edits or touches their parameters).
+ */
+typedef struct Prerenderer
+{
+  Graph *           graph;
+
+  PrerenderTrack ** tracks;
+  int               num_tracks;
+
+  /** Frames per chunk. */
+  nframes_t         block_length;
+
+  /** Monotonic time the current cycle started, in
+   * nanoseconds. */
+  gint64            cycle_start_ns;
+
+  GThread *         threads[PRERENDERER_MAX_THREADS];
+  int               num_threads;
+
+  /** Posted when there may be work to do. */
+  ZixSem            work_sem;
+
+  volatile gint     stop;
+} Prerenderer;
+
+/**
+ * Finds the tracks of the graph's current nodes
+ * that can be rendered ahead and starts the
+ * rendering threads.
+ *
+ * Must be called after the graph is rechained and
+ * before its ports are pooled.
+ *
+ * @return The prerenderer, or NULL if no tracks
+ *   can be rendered ahead.
+ */
+NONNULL
+Prerenderer *
+prerenderer_new (
+  Graph * graph);
+
+/**
+ * Decides which tracks use rendered audio in the
+ * cycle about to start.
+ *
+ * To be called by the engine before preparing the
+ * channels.
+ */
+HOT
+NONNULL
+void
+prerenderer_prepare_cycle (
+  Prerenderer * self,
+  nframes_t     nframes);
+
+/**
+ * Consumes the rendered audio used in the cycle
+ * that just finished and hands eligible tracks
+ * over to the rendering threads.
+ *
+ * To be called by the engine after the playhead
+ * was moved.
+ */
+HOT
+NONNULL
+void
+prerenderer_finish_cycle (
+  Prerenderer * self,
+  nframes_t     nframes);
+
+/**
+ * Writes the rendered audio for the given part of
+ * the cycle to the given prefader input port (or
+ * silence if not available).
+ *
+ * Realtime safe.
+ */
+HOT
+NONNULL
+void
+prerender_track_read (
+  PrerenderTrack *                    self,
+  Port *                              port,
+  const EngineProcessTimeInfo * const time_nfo);
+
+/**
+ * Makes the track go back to live processing and
+ * discards what was rendered.
+ *
+ * Can be called from any thread.
+ */
+NONNULL
+void
+prerenderer_invalidate_track (
+  Prerenderer * self,
+  Track *       track);
+
+/**
+ * Invalidates the owner track of the given
+ * control port after a user change.
+ */
+NONNULL
+void
+prerenderer_invalidate_port (
+  Prerenderer *          self,
+  const PortIdentifier * id);
+
+/**
+ * Invalidates all tracks, eg, after an edit.
+ */
+NONNULL
+void
+prerenderer_invalidate_all (
+  Prerenderer * self);
+
+/**
+ * Waits until all tracks are back to live
+ * processing.
+ *
+ * The engine must not be running.
+ */
+NONNULL
+void
+prerenderer_release_all (
+  Prerenderer * self);
+
+/**
+ * Stops the rendering threads and frees the
+ * prerenderer.
+ */
+NONNULL
+void
+prerenderer_free (
+  Prerenderer * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -184,6 +184,26 @@ quantize_options_quantize_position (
   QuantizeOptions * self,
   Position *              pos);
 
+/**
+ * Quantizes the given ticks (eg, a column of
+ * MidiNoteColumns) in one pass.
+ *
+ * This is the bulk version of
+ * quantize_options_quantize_position(). Values
+ * outside the quantize points are left as is.
+ *
+ * @param diffs Array to store the amount of ticks
+ *   each value was moved by (negative for
+ *   backwards), or NULL.
+ */
+NONNULL_ARGS (1, 2)
+void
+quantize_options_quantize_ticks (
+  QuantizeOptions * self,
+  double *          ticks,
+  double *          diffs,
+  size_t            num_ticks);
+
 /**
  * Clones the QuantizeOptions.
  */
@@ -45,6 +45,7 @@ typedef struct _AudioClipWidget AudioClipWidget;
 typedef struct RegionLinkGroup RegionLinkGroup;
 typedef struct Stretcher Stretcher;
 typedef struct AudioClip AudioClip;
+typedef struct RegionThumbnail RegionThumbnail;
 
 /**
  * @addtogroup audio
@@ -296,6 +297,20 @@ typedef struct ZRegion
    * are used). */
   ArrangerObject     last_positions_obj;
 
+  /** Cached thumbnails of the contents of
+   * non-audio regions, for the main and lane
+   * counterparts. */
+  RegionThumbnail *  thumbnails[2];
+
+  /**
+   * Version of the contents drawn in the
+   * thumbnails, bumped whenever a child object is
+   * added, removed or changed.
+   *
+   * @see arranger_object_bump_region_content_version().
+   */
+  guint              content_version;
+
   /* --- drawing caches end --- */
 
   int                magic;
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Interval index of regions.
+ */
+
+#ifndef __AUDIO_REGION_INDEX_H__
+#define __AUDIO_REGION_INDEX_H__
+
+#include <stdbool.h>
+
+#include <glib.h>
+
+typedef struct ZRegion ZRegion;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Interval index over the regions of a TrackLane
+ * or AutomationTrack.
+ *
+ * The regions are kept sorted by start frame along
+ * with a running maximum of their end frames, so
+ * the regions overlapping a range can be found with
+ * two binary searches followed by a scan over the
+ * candidates only.
+ *
+ * The index is only a cache: the owner's region
+ * array remains the source of truth (region
+ * identifiers depend on its order). The index is
+ * rebuilt from the GTK thread and read from the
+ * realtime thread. Readers must call
+ * region_index_acquire() and fall back to a linear
+ * scan if it returns false.
+ */
+typedef struct RegionIndex
+{
+  /** Regions sorted by start frame. */
+  ZRegion **    regions;
+
+  /** Start frames of @ref regions at build time. */
+  long *        starts;
+
+  /** End frames of @ref regions at build time. */
+  long *        ends;
+
+  /**
+   * Running maximum of @ref ends, ie, max_ends[i]
+   * is the latest end of regions 0 to i.
+   */
+  long *        max_ends;
+
+  /** Index of the region that has max_ends[i]. */
+  int *         max_end_idxs;
+
+  int           num_regions;
+  size_t        size;
+
+  /**
+   * Unique number of the current build, so that
+   * cursors can tell when their cached indices are
+   * stale (or belong to another index).
+   */
+  volatile gint generation;
+
+  /**
+   * Incremented when the position of one of the
+   * owner's regions changes.
+   *
+   * @see region_index_mark_positions_changed().
+   */
+  volatile gint version;
+
+  /** @ref version at build time. */
+  volatile gint built_version;
+
+  /** Whether the index can be used. */
+  volatile gint valid;
+
+  /** Number of readers currently using the index. */
+  volatile gint num_readers;
+} RegionIndex;
+
+/**
+ * Playback cursor for a RegionIndex.
+ *
+ * Caches the last candidate range so that
+ * consecutive queries moving forward in time
+ * (as during playback) only advance the range
+ * instead of searching again.
+ *
+ * Cursors are owned by the caller (eg, the graph
+ * node processing the lane) and must not be
+ * shared between threads.
+ */
+typedef struct RegionIndexCursor
+{
+  /** Generation of the index the cursor is for. */
+  int           generation;
+
+  /** Last queried start frame. */
+  long          start;
+
+  /** Last queried end frame. */
+  long          end;
+
+  /** First candidate index. */
+  int           lo;
+
+  /** One past the last candidate index. */
+  int           hi;
+} RegionIndexCursor;
+
+/**
+ * Marks the index as stale.
+ *
+ * To be called whenever the position of one of
+ * the owner's regions changes. Stale indices are
+ * not used until region_index_refresh() is called
+ * on them.
+ */
+NONNULL
+void
+region_index_mark_positions_changed (
+  RegionIndex * self);
+
+/**
+ * Marks the index as unusable and waits for any
+ * current readers to finish.
+ *
+ * Must be called before a region is removed from
+ * the owner's array.
+ */
+NONNULL
+void
+region_index_invalidate (
+  RegionIndex * self);
+
+/**
+ * Rebuilds the index from the given regions.
+ *
+ * To be called from the GTK thread.
+ */
+NONNULL_ARGS (1)
+void
+region_index_rebuild (
+  RegionIndex * self,
+  ZRegion **    regions,
+  int           num_regions);
+
+/**
+ * Rebuilds the index if it is invalid or if any of
+ * the given regions moved since it was built,
+ * otherwise marks it up to date.
+ *
+ * To be called periodically from the GTK thread.
+ */
+NONNULL_ARGS (1)
+void
+region_index_refresh (
+  RegionIndex * self,
+  ZRegion **    regions,
+  int           num_regions);
+
+/**
+ * Starts reading the index.
+ *
+ * @return Whether the index can be used. If true,
+ *   region_index_release() must be called when
+ *   done.
+ */
+HOT
+NONNULL
+bool
+region_index_acquire (
+  const RegionIndex * self);
+
+/**
+ * Stops reading the index.
+ */
+HOT
+NONNULL
+void
+region_index_release (
+  const RegionIndex * self);
+
+/**
+ * Returns the range of candidate regions in
+ * RegionIndex.regions that may overlap the given
+ * range (inclusive).
+ *
+ * The candidates must still be checked with
+ * region_is_hit_by_range() or similar.
+ *
+ * Must be called between region_index_acquire()
+ * and region_index_release().
+ *
+ * @param cursor Optional playback cursor.
+ * @param[out] lo First candidate index.
+ * @param[out] hi One past the last candidate
+ *   index.
+ */
+HOT
+NONNULL_ARGS (1, 5, 6)
+void
+region_index_get_candidates (
+  const RegionIndex * self,
+  RegionIndexCursor * cursor,
+  long                start,
+  long                end,
+  int *               lo,
+  int *               hi);
+
+/**
+ * Returns the region starting at or before
+ * \ref frames that ends last, or NULL.
+ *
+ * Must be called between region_index_acquire()
+ * and region_index_release().
+ */
+HOT
+NONNULL
+ZRegion *
+region_index_get_latest_ending_before (
+  const RegionIndex * self,
+  long                frames);
+
+/**
+ * Frees the members of the index.
+ */
+NONNULL
+void
+region_index_free_members (
+  RegionIndex * self);
+
+/**
+ * @}
+ */
+
+#endif
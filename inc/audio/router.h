@@ -67,6 +67,8 @@ typedef struct Track Track;
 typedef struct Plugin Plugin;
 typedef struct Position Position;
 typedef struct ControlPortChange ControlPortChange;
+typedef struct ControlPortChangeBatch
+  ControlPortChangeBatch;
 typedef struct EngineProcessTimeInfo
   EngineProcessTimeInfo;
 
@@ -105,10 +107,28 @@ typedef struct Router
   /** Thread that calls kicks off the cycle. */
   GThread *             process_kickoff_thread;
 
-  /** Message queue for control port changes, used
-   * for BPM/time signature changes. */
+  /**
+   * Message queue for control port changes.
+   *
+   * Contains batches of changes, each consisting
+   * of a ControlPortChangeBatchHeader followed by
+   * its changes. Only complete batches are
+   * applied.
+   */
   ZixRing *             ctrl_port_change_queue;
 
+  /** Lock for writing to
+   * \ref Router.ctrl_port_change_queue. */
+  ZixSem                ctrl_port_change_write_lock;
+
+  /** Number of changes dropped because the queue
+   * was full. */
+  volatile gint         num_dropped_ctrl_port_changes;
+
+  /** Number of times the graph was rebuilt (not
+   * counting soft recalculations). */
+  int                   num_graph_rebuilds;
+
 } Router;
 
 Router *
@@ -169,15 +189,29 @@ router_is_processing_kickoff_thread (
  * Queues a control port change to be applied
  * when processing starts.
  *
- * Currently only applies to BPM/time signature
- * changes.
+ * @return Whether the change was queued (false if
+ *   the queue is full).
  */
 NONNULL
-void
+bool
 router_queue_control_port_change (
   Router *                  self,
   const ControlPortChange * change);
 
+/**
+ * Queues a batch of control port changes to be
+ * applied together when processing starts.
+ *
+ * @return Whether the batch was queued (false if
+ *   the queue is full, in which case the whole
+ *   batch is dropped).
+ */
+NONNULL
+bool
+router_queue_control_port_changes (
+  Router *                       self,
+  const ControlPortChangeBatch * batch);
+
 void
 router_free (
   Router * self);
@@ -75,17 +75,21 @@ typedef struct RtMidiDevice
   /** Associated port. */
   Port *        port;
 
-  /** MIDI event ring buffer. */
+  /**
+   * MIDI event ring buffer.
+   *
+   * Single producer (the RtMidi callback) and
+   * single consumer (the processing cycle).
+   * Each event is a MidiEventHeader with the
+   * monotonic time of arrival followed by the
+   * raw MIDI data.
+   */
   ZixRing *     midi_ring;
 
   /** Events enqueued at the beginning of each
    * processing cycle from the ring. */
   MidiEvents *  events;
 
-  /** Semaphore for blocking writing events while
-   * events are being read. */
-  ZixSem        midi_ring_sem;
-
 } RtMidiDevice;
 
 /**
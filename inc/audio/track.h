@@ -62,6 +62,7 @@ typedef struct Marker Marker;
 typedef struct PluginDescriptor PluginDescriptor;
 typedef struct Tracklist Tracklist;
 typedef struct SupportedFile SupportedFile;
+typedef struct PrerenderTrack PrerenderTrack;
 typedef struct TracklistSelections
   TracklistSelections;
 typedef enum PassthroughProcessorType
@@ -299,6 +300,17 @@ typedef struct Track
   int                 num_lanes;
   size_t              lanes_size;
 
+  /**
+   * Number of lanes (starting from the first) that
+   * are processed in their own graph nodes.
+   *
+   * Set by the graph when it is rechained. The
+   * events of these lanes are filled in parallel
+   * into each lane's scratch events and merged by
+   * track_fill_events().
+   */
+  int                 num_lanes_in_graph;
+
   /** MIDI channel (MIDI/Instrument track only). */
   uint8_t             midi_ch;
 
@@ -520,6 +532,10 @@ typedef struct Track
   /** Whether currently disconnecting. */
   bool                disconnecting;
 
+  /** Set while the track can be rendered ahead
+   * (runtime only). */
+  PrerenderTrack *    prerender;
+
   /** Pointer to owner tracklist, if any. */
   Tracklist *         tracklist;
 
@@ -1013,19 +1029,64 @@ track_remove_region (
  * to fill in MidiEvents or StereoPorts from the
  * timeline data.
  *
+ * If the lanes of the track are processed in
+ * parallel by the graph, their events are merged
+ * instead.
+ *
  * @note The engine splits the cycle so transport
  *   loop related logic is not needed.
  *
  * @param stereo_ports StereoPorts to fill.
  * @param midi_events MidiEvents to fill (from
  *   Piano Roll Port for example).
+ * @param cursors Caller's cursors into the region
+ *   indices of the lanes (one per lane), or NULL.
+ * @param num_cursors Number of cursors. Lanes
+ *   without a cursor are searched without one.
  */
 void
 track_fill_events (
   const Track *                       self,
   const EngineProcessTimeInfo * const time_nfo,
   MidiEvents *                        midi_events,
-  StereoPorts *                       stereo_ports);
+  StereoPorts *                       stereo_ports,
+  RegionIndexCursor *                 cursors,
+  int                                 num_cursors);
+
+/**
+ * Returns whether the lanes of the track should be
+ * processed in separate graph nodes.
+ *
+ * @param threshold Minimum number of lanes, or 0 to
+ *   disable.
+ */
+NONNULL
+bool
+track_should_process_lanes_in_parallel (
+  const Track * self,
+  const int     threshold);
+
+/**
+ * Fills the scratch events of the lane at the
+ * given position from its regions.
+ *
+ * To be called by the lane's graph node when the
+ * lanes of the track are processed in parallel.
+ * The events are then merged by
+ * track_fill_events().
+ *
+ * @param lane_pos Lane index.
+ * @param cursor Caller's cursor into the lane's
+ *   region index, or NULL.
+ */
+HOT
+NONNULL_ARGS (1, 3)
+void
+track_fill_lane_events (
+  Track *                             self,
+  const int                           lane_pos,
+  const EngineProcessTimeInfo * const time_nfo,
+  RegionIndexCursor *                 cursor);
 
 /**
  * Verifies the identifiers on a live Track
@@ -1066,6 +1127,17 @@ void
 track_remove_from_folder_parents (
   Track * self);
 
+/**
+ * Brings the region indices of the track's lanes
+ * and automation tracks up to date.
+ *
+ * To be called periodically from the GTK thread.
+ */
+NONNULL
+void
+track_refresh_region_indices (
+  Track * self);
+
 /**
  * Returns the region at the given position, or
  * NULL.
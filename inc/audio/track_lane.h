@@ -27,6 +27,7 @@
 #define __AUDIO_TRACK_LANE_H__
 
 #include "audio/region.h"
+#include "audio/region_index.h"
 #include "utils/yaml.h"
 
 typedef struct _TrackLaneWidget TrackLaneWidget;
@@ -34,6 +35,7 @@ typedef struct Tracklist Tracklist;
 typedef struct CustomButtonWidget
   CustomButtonWidget;
 typedef void MIDI_FILE;
+typedef struct MidiEvents MidiEvents;
 
 /**
  * @addtogroup audio
@@ -103,6 +105,24 @@ typedef struct TrackLane
   /** Owner track. */
   Track *             track;
 
+  /**
+   * Scratch events filled by the lane's graph node
+   * when the lanes of the owner track are
+   * processed in parallel.
+   *
+   * Allocated during graph setup with
+   * track_lane_allocate_bufs().
+   */
+  MidiEvents *        midi_events;
+
+  /**
+   * Interval index of @ref regions used for
+   * lookups during processing.
+   *
+   * @see track_lane_refresh_region_index().
+   */
+  RegionIndex         region_index;
+
 } TrackLane;
 
 static const cyaml_schema_field_t
@@ -187,6 +207,16 @@ void
 track_lane_unselect_all (
   TrackLane * self);
 
+/**
+ * Brings the region index up to date.
+ *
+ * To be called from the GTK thread.
+ */
+NONNULL
+void
+track_lane_refresh_region_index (
+  TrackLane * self);
+
 /**
  * Removes all objects recursively from the track
  * lane.
@@ -267,6 +297,17 @@ Track *
 track_lane_get_track (
   TrackLane * self);
 
+/**
+ * Allocates the scratch buffers used when the lane
+ * is processed in its own graph node.
+ *
+ * To be called during graph setup.
+ */
+NONNULL
+void
+track_lane_allocate_bufs (
+  TrackLane * self);
+
 /**
  * Frees the TrackLane.
  */
@@ -28,6 +28,7 @@
 
 #include "audio/midi.h"
 #include "audio/port.h"
+#include "audio/region_index.h"
 #include "utils/types.h"
 #include "utils/yaml.h"
 
@@ -300,11 +301,16 @@ track_processor_get_track (
  * @param g_start_frames The global start frames.
  * @param local_offset The local start frames.
  * @param nframes The number of frames to process.
+ * @param cursors Caller's cursors into the region
+ *   indices of the track's lanes, or NULL.
+ * @param num_cursors Number of cursors.
  */
 void
 track_processor_process (
   const TrackProcessor *              self,
-  const EngineProcessTimeInfo * const time_nfo);
+  const EngineProcessTimeInfo * const time_nfo,
+  RegionIndexCursor *                 cursors,
+  int                                 num_cursors);
 
 /**
  * Disconnect the TrackProcessor's stereo out ports
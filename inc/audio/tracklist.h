@@ -146,6 +146,24 @@ typedef struct Tracklist
 
   /** Pointer to owner project, if any. */
   Project *           project;
+
+  /**
+   * Nesting level of tracklist_begin_batch()
+   * calls.
+   *
+   * While non-zero, graph recalculations and UI
+   * event processing are deferred until
+   * tracklist_end_batch().
+   */
+  int                 batch_depth;
+
+  /** Whether a full/soft graph recalculation was
+   * requested during the batch. */
+  bool                batch_recalc_graph;
+  bool                batch_recalc_graph_soft;
+
+  /** Engine state before the batch started. */
+  EngineState         batch_engine_state;
 } Tracklist;
 
 static const cyaml_schema_field_t
@@ -603,6 +621,42 @@ Tracklist *
 tracklist_clone (
   Tracklist * src);
 
+/**
+ * Starts a batch of tracklist mutations (eg,
+ * creating or deleting many tracks with separate
+ * actions).
+ *
+ * The engine is paused for the whole batch, and
+ * graph recalculations and UI event processing
+ * are deferred until the matching
+ * tracklist_end_batch() call. Batches can be
+ * nested.
+ */
+NONNULL
+void
+tracklist_begin_batch (
+  Tracklist * self);
+
+/**
+ * Ends a batch started with
+ * tracklist_begin_batch().
+ *
+ * When the outermost batch ends, the graph is
+ * recalculated once (if requested during the
+ * batch), the engine is resumed and the queued UI
+ * events are processed.
+ */
+NONNULL
+void
+tracklist_end_batch (
+  Tracklist * self);
+
+/**
+ * Returns whether a batch is in progress.
+ */
+#define tracklist_is_batching(self) \
+  ((self)->batch_depth > 0)
+
 void
 tracklist_free (
   Tracklist * self);
@@ -455,6 +455,20 @@ void
 arranger_object_set_magic (
   ArrangerObject * self);
 
+/**
+ * Bumps the content version of the region the
+ * object belongs to, if it is a child of a region
+ * in the project.
+ *
+ * To be called whenever something drawn in region
+ * thumbnails changes. Clones of child objects are
+ * ignored.
+ */
+NONNULL
+void
+arranger_object_bump_region_content_version (
+  ArrangerObject * self);
+
 /**
  * If the object is part of a ZRegion, returns it,
  * otherwise returns NULL.
@@ -132,6 +132,34 @@ ArrangerSelections *
 clipboard_get_selections (
   Clipboard * self);
 
+/**
+ * Offers the clipboard on the given system
+ * clipboard, taking ownership of it.
+ *
+ * The clipboard is only serialized when its
+ * contents are requested (eg, by another
+ * instance). It is free'd when the system
+ * clipboard is set by someone else.
+ */
+NONNULL
+void
+clipboard_offer (
+  Clipboard *    self,
+  GtkClipboard * gtk_clipboard);
+
+/**
+ * Returns the clipboard offered with
+ * clipboard_offer() if it is still the contents of
+ * the given system clipboard, or NULL.
+ *
+ * This allows pasting within this instance without
+ * serializing and deserializing the contents.
+ */
+NONNULL
+Clipboard *
+clipboard_get_offered (
+  GtkClipboard * gtk_clipboard);
+
 /**
  * Frees the clipboard and all associated data.
  */
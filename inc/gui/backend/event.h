@@ -220,6 +220,13 @@ typedef enum EventType
 
   ET_PLUGIN_COLLETIONS_CHANGED,
 
+  /** Scanned plugins were added to the plugin
+   * manager. */
+  ET_PLUGIN_DESCRIPTORS_CHANGED,
+
+  /** Files in the file browser were (re)loaded. */
+  ET_FILE_BROWSER_FILES_CHANGED,
+
   ET_SNAP_GRID_OPTIONS_CHANGED,
 
   ET_TRANSPORT_RECORDING_ON_OFF_CHANGED,
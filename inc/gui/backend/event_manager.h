@@ -65,6 +65,13 @@ typedef struct EventManager
    * is pending. */
   bool               pending_soft_recalc;
 
+  /** The mixer and tracklist need a hard refresh
+   * after the current events are processed.
+   *
+   * Used to refresh them once when many tracks
+   * are added or removed. */
+  bool               pending_track_widgets_refresh;
+
   /** Events array to use during processing. */
   GPtrArray *        events_arr;
 } EventManager;
@@ -22,6 +22,10 @@
 
 #include <stdbool.h>
 
+#include "utils/types.h"
+
+#include <glib.h>
+
 typedef struct SupportedFile SupportedFile;
 
 /**
@@ -109,13 +113,27 @@ typedef struct FileManager
    */
   FileBrowserLocation *    selection;
 
+  /** Thread loading the files in the background,
+   * if any. */
+  GThread *                load_thread;
+
+  /** Idle source finishing the background load,
+   * if pending. */
+  guint                    load_source_id;
+
 } FileManager;
 
 /**
  * Creates the file manager.
+ *
+ * @param load_files Whether to load the files of
+ *   the initial selection. If false, they must be
+ *   loaded later, eg, with
+ *   file_manager_begin_load_files().
  */
 FileManager *
-file_manager_new (void);
+file_manager_new (
+  bool load_files);
 
 /**
  * Loads the files under the current selection.
@@ -123,6 +141,25 @@ file_manager_new (void);
 void
 file_manager_load_files (FileManager * self);
 
+/**
+ * Loads the files under the current selection in
+ * a background thread.
+ *
+ * The files are swapped in and the file browser
+ * is refreshed in the GTK thread once loaded.
+ *
+ * @param on_finished Callback to call in the GTK
+ *   thread when loading finished, or NULL. It is
+ *   always called from the main loop, even if
+ *   there is nothing to load.
+ */
+NONNULL_ARGS (1)
+void
+file_manager_begin_load_files (
+  FileManager *   self,
+  GenericCallback on_finished,
+  void *          user_data);
+
 /**
  * @param save_to_settings Whether to save this
  *   location to GSettings.
@@ -53,6 +53,7 @@ typedef struct ArrangerSelections ArrangerSelections;
 typedef struct EditorSettings EditorSettings;
 typedef struct ObjectPool ObjectPool;
 typedef struct _RulerWidget RulerWidget;
+typedef struct Track Track;
 typedef enum ArrangerObjectType ArrangerObjectType;
 typedef enum TransportDisplay TransportDisplay;
 
@@ -120,6 +121,21 @@ typedef enum ArrangerWidgetHoverType
 } ArrangerWidgetHoverType;
 #endif
 
+/**
+ * Cached vertical geometry of a track in a
+ * timeline arranger.
+ */
+typedef struct ArrangerTrackGeometry
+{
+  Track *        track;
+
+  /** Y offset of the track in the arranger. */
+  int            y;
+
+  /** Allocated height of the track widget. */
+  int            height;
+} ArrangerTrackGeometry;
+
 /**
  * The arranger widget is a canvas that draws all
  * the arranger objects it contains.
@@ -408,6 +424,29 @@ typedef struct _ArrangerWidget
    */
   PangoLayout *  ap_layout;
 
+  /**
+   * Geometry of the visible tracks in this
+   * (timeline) arranger, sorted by y.
+   *
+   * The y offsets are prefix sums of the track
+   * heights, rebuilt lazily after
+   * timeline_arranger_widget_invalidate_track_geometry()
+   * so that object rectangles and hit tests don't
+   * need to query GTK for each object.
+   */
+  ArrangerTrackGeometry * track_geometries;
+  int            num_track_geometries;
+
+  /** Index in \ref
+   * ArrangerWidget.track_geometries for each track
+   * position, or -1 if the track is not visible in
+   * this arranger. */
+  int *          track_geometry_indices;
+  int            num_track_geometry_indices;
+
+  /** Whether the track geometry is up to date. */
+  bool           track_geometries_valid;
+
   /**
    * Layout for drawing audio editor text.
    */
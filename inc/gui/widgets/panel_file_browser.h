@@ -75,6 +75,14 @@ typedef struct _PanelFileBrowserWidget
   bool                 first_draw;
 } PanelFileBrowserWidget;
 
+/**
+ * Refreshes the file list after the files of the
+ * file manager were reloaded.
+ */
+void
+panel_file_browser_refresh_files (
+  PanelFileBrowserWidget * self);
+
 PanelFileBrowserWidget *
 panel_file_browser_widget_new (void);
 
@@ -192,6 +192,14 @@ void
 plugin_browser_widget_refresh_collections (
   PluginBrowserWidget * self);
 
+/**
+ * Refreshes the plugin, author and category lists
+ * after plugins were added to the plugin manager.
+ */
+void
+plugin_browser_widget_refresh_plugins (
+  PluginBrowserWidget * self);
+
 /**
  * @}
  */
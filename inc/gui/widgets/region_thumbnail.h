@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Cached thumbnails of the contents of MIDI,
+ * automation and chord regions.
+ *
+ * The contents of the first pass (from the clip
+ * start) and of the loop body are rendered
+ * separately in the background, at a zoom level
+ * rounded to a zoom bucket, and loops are drawn by
+ * blitting the loop body.
+ */
+
+#ifndef __GUI_WIDGETS_REGION_THUMBNAIL_H__
+#define __GUI_WIDGETS_REGION_THUMBNAIL_H__
+
+#include <stdbool.h>
+
+#include <gtk/gtk.h>
+
+typedef struct ZRegion ZRegion;
+typedef struct RegionThumbnail RegionThumbnail;
+
+/**
+ * @addtogroup widgets
+ *
+ * @{
+ */
+
+/** Number of zoom buckets per doubling of the
+ * zoom level. */
+#define REGION_THUMBNAIL_ZOOM_BUCKETS_PER_OCTAVE 4
+
+/** Maximum width of a rendered segment in pixels.
+ * Regions whose segments would be wider are drawn
+ * directly. */
+#define REGION_THUMBNAIL_MAX_WIDTH 16384
+
+/**
+ * Returns whether thumbnails are used for the
+ * given region.
+ */
+NONNULL
+bool
+region_thumbnail_supports_region (
+  ZRegion * region);
+
+NONNULL
+RegionThumbnail *
+region_thumbnail_new (
+  ZRegion * region);
+
+/**
+ * Draws the region contents from the cached
+ * thumbnail, queueing a regeneration in the
+ * background if the content or the zoom bucket
+ * changed.
+ *
+ * @param cr Cairo context translated to the full
+ *   rect.
+ *
+ * @return Whether the contents were drawn. If
+ *   false, the caller must draw them directly.
+ */
+NONNULL
+bool
+region_thumbnail_draw (
+  RegionThumbnail * self,
+  cairo_t *         cr,
+  GdkRectangle *    full_rect,
+  GdkRectangle *    draw_rect);
+
+/**
+ * Detaches the thumbnail from its region and
+ * frees it once no background job uses it.
+ */
+NONNULL
+void
+region_thumbnail_free (
+  RegionThumbnail * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -75,6 +75,26 @@ timeline_arranger_widget_get_track_at_y (
   ArrangerWidget * self,
   double y);
 
+/**
+ * Marks the cached track geometry as outdated.
+ *
+ * To be called when tracks are resized, reordered
+ * or their visibility changes.
+ */
+void
+timeline_arranger_widget_invalidate_track_geometry (
+  ArrangerWidget * self);
+
+/**
+ * Returns the y offset of the given track in the
+ * arranger from the cached track geometry, or -1
+ * if the track is not visible in this arranger.
+ */
+int
+timeline_arranger_widget_get_track_y (
+  ArrangerWidget * self,
+  Track *          track);
+
 void
 timeline_arranger_on_export_as_midi_file_clicked (
   GtkMenuItem * menuitem,
@@ -25,6 +25,8 @@
 #ifndef __GUI_WIDGETS_TIMELINE_MINIMAP_BG_H__
 #define __GUI_WIDGETS_TIMELINE_MINIMAP_BG_H__
 
+#include <stdbool.h>
+
 #include <gtk/gtk.h>
 
 #define TIMELINE_MINIMAP_BG_WIDGET_TYPE \
@@ -35,12 +37,74 @@ G_DECLARE_FINAL_TYPE (TimelineMinimapBgWidget,
                       TIMELINE_MINIMAP_BG_WIDGET,
                       GtkDrawingArea)
 
+typedef struct Track Track;
+
+/**
+ * A track row in the minimap overview.
+ */
+typedef struct TimelineMinimapBgRow
+{
+  Track *                    track;
+
+  /** Allocated height of the track widget when
+   * the row was laid out. */
+  int                        track_height;
+
+  /** Y and height of the row in the overview. */
+  double                     y;
+  double                     height;
+
+  /** Whether the regions of this row need to be
+   * redrawn in the overview. */
+  bool                       dirty;
+} TimelineMinimapBgRow;
+
 typedef struct _TimelineMinimapBgWidget
 {
   GtkDrawingArea             parent_instance;
+
+  /**
+   * Overview image of the regions of all visible
+   * tracks, at the allocated size.
+   *
+   * Only the rows of tracks whose regions changed
+   * are redrawn, and scrolling/zooming only blits
+   * this image, so drawing does not depend on the
+   * number of regions.
+   */
+  cairo_surface_t *          overview;
+
+  /** Total ticks the overview spans. */
+  double                     overview_total_ticks;
+
+  /** Visible tracks, in tracklist order. */
+  TimelineMinimapBgRow *     rows;
+  int                        num_rows;
+
+  /** Whether the rows and the overview need to be
+   * recreated. */
+  bool                       layout_invalid;
 } TimelineMinimapBgWidget;
 
 TimelineMinimapBgWidget *
 timeline_minimap_bg_widget_new (void);
 
+/**
+ * Marks the row of the given track for redrawing
+ * (eg, when one of its regions was created or
+ * changed).
+ */
+void
+timeline_minimap_bg_widget_invalidate_track (
+  TimelineMinimapBgWidget * self,
+  Track *                   track);
+
+/**
+ * Marks the whole overview for recreation (eg,
+ * when tracks are added, removed or moved).
+ */
+void
+timeline_minimap_bg_widget_invalidate (
+  TimelineMinimapBgWidget * self);
+
 #endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Headless offline project renderer.
+ */
+
+#ifndef __GUILE_PROJECT_RENDERER_H__
+#define __GUILE_PROJECT_RENDERER_H__
+
+/**
+ * @addtogroup guile
+ *
+ * @{
+ */
+
+/**
+ * Loads the project at @ref prj_path and renders
+ * it faster than realtime.
+ *
+ * If @ref script_path is given, the script is run
+ * with the loaded project and is expected to do
+ * the rendering using the (audio exporter) module.
+ * Otherwise, the whole song is rendered to
+ * @ref output_path, using the format matching its
+ * extension.
+ *
+ * Zrythm must already be initialized without a UI,
+ * preferably with the dummy backends.
+ *
+ * @return Non-zero if fail.
+ */
+int
+guile_project_renderer_render_from_file (
+  const char * prj_path,
+  const char * script_path,
+  const char * output_path);
+
+/**
+ * @}
+ */
+
+#endif
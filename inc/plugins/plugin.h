@@ -54,6 +54,15 @@ typedef struct MixerSelections MixerSelections;
 #define PLUGIN_SCHEMA_VERSION 1
 
 #define PLUGIN_MAGIC 43198683
+
+/**
+ * Prefix of the names of content-addressed state
+ * dirs, followed by the hash of their contents.
+ *
+ * Snapshots of identical states are shared
+ * regardless of the plugin.
+ */
+#define PLUGIN_STATE_SNAPSHOT_PREFIX "snapshot-"
 #define IS_PLUGIN(x) \
   (((Plugin *) x)->magic == PLUGIN_MAGIC)
 #define IS_PLUGIN_AND_NONNULL(x) \
@@ -213,6 +222,27 @@ typedef struct Plugin
    */
   char *            state_dir;
 
+  /**
+   * Snapshot of the state directory (only
+   * basename) prepared for the next
+   * plugin_clone(), or NULL.
+   *
+   * Not serialized.
+   *
+   * @see plugin_prepare_state_snapshot().
+   */
+  char *            state_snapshot_dir;
+
+  /**
+   * Whether the state may differ from the one in
+   * the state directory.
+   *
+   * Set when a control changes, the UI is used, a
+   * preset is applied or MIDI messages other than
+   * notes are received. Not serialized.
+   */
+  volatile gint     state_changed;
+
   /** Whether the plugin is currently being
    * deleted. */
   bool              deleting;
@@ -621,6 +651,97 @@ plugin_ensure_state_dir (
   Plugin * self,
   bool     is_backup);
 
+/**
+ * Returns whether the given state dir basename
+ * is a content-addressed snapshot.
+ *
+ * Snapshots are shared between plugins (and
+ * between saves) with identical states so they
+ * must never be written to or deleted.
+ */
+PURE
+bool
+plugin_state_dir_is_snapshot (
+  const char * state_dir);
+
+/**
+ * Ensures the plugin has a state dir of its own
+ * that can be written to.
+ *
+ * If the current state dir is a snapshot, the
+ * plugin is moved to a new state dir containing
+ * a copy of the snapshot.
+ *
+ * To be called before saving the state to the
+ * plugin's state dir.
+ */
+NONNULL
+void
+plugin_ensure_writable_state_dir (
+  Plugin * self,
+  bool     is_backup);
+
+/**
+ * Marks the state as changed so that the next
+ * plugin_save_state() saves it.
+ *
+ * Realtime safe.
+ */
+NONNULL
+void
+plugin_set_state_changed (
+  Plugin * self);
+
+/**
+ * Saves the state of the plugin to its state
+ * directory, if instantiated and changed since it
+ * was last saved.
+ */
+NONNULL
+void
+plugin_save_state (
+  Plugin * self,
+  bool     is_backup);
+
+/**
+ * Prepares a snapshot of the plugin's state dir
+ * to be used by the next plugin_clone().
+ *
+ * This does not call into the plugin so it can be
+ * called from any non-realtime thread, as long as
+ * the state was saved beforehand with
+ * plugin_save_state().
+ */
+NONNULL
+void
+plugin_prepare_state_snapshot (
+  Plugin * self,
+  bool     is_backup);
+
+/**
+ * Clears the snapshot prepared with
+ * plugin_prepare_state_snapshot().
+ */
+NONNULL
+void
+plugin_clear_state_snapshot (
+  Plugin * self);
+
+/**
+ * Removes the snapshots in the given plugin states
+ * dir that are not referenced in the given
+ * serialized project.
+ *
+ * Snapshots used in this session are kept since
+ * they may still be referenced elsewhere (eg, by
+ * the clipboard).
+ */
+NONNULL
+void
+plugin_remove_unused_state_snapshots (
+  const char * states_dir,
+  const char * project_yaml);
+
 NONNULL
 Channel *
 plugin_get_channel (
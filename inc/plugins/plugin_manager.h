@@ -29,6 +29,7 @@
 #include "plugins/lv2/lv2_urid.h"
 #include "plugins/plugin_descriptor.h"
 #include "utils/symap.h"
+#include "utils/types.h"
 
 #include "zix/sem.h"
 
@@ -59,6 +60,12 @@ typedef struct PluginCollections PluginCollections;
 
 typedef struct PluginDescriptor PluginDescriptor;
 
+/**
+ * Interval to publish plugins found by the
+ * background scan at.
+ */
+#define PLUGIN_MANAGER_PUBLISH_INTERVAL_MS 250
+
 /**
  * The PluginManager is responsible for scanning
  * and keeping track of available Plugin's.
@@ -105,6 +112,39 @@ typedef struct PluginManager
    * already. */
   bool                   setup;
 
+  /**
+   * Descriptors found by the background scan that
+   * are not yet published to
+   * \ref PluginManager.plugin_descriptors.
+   *
+   * Protected by \ref PluginManager.pending_lock.
+   */
+  GPtrArray *            pending_descriptors;
+  GMutex                 pending_lock;
+
+  /** Background scan thread, if any.
+   *
+   * Only used with carla, since LV2 plugins are
+   * always scanned synchronously. */
+  GThread *              scan_thread;
+
+  /** Whether the background scan thread is still
+   * running (atomic). */
+  volatile gint          scanning;
+
+  /** Set to stop the background scan early
+   * (atomic). */
+  volatile gint          cancel_scan;
+
+  /** Source publishing the pending descriptors in
+   * the GTK thread. */
+  guint                  publish_source_id;
+
+  /** Callback to call when the background scan
+   * finished. */
+  GenericCallback        scan_finished_cb;
+  void *                 scan_finished_cb_data;
+
 } PluginManager;
 
 PluginManager *
@@ -136,6 +176,27 @@ plugin_manager_scan_plugins (
   const double    max_progress,
   double *        progress);
 
+/**
+ * Scans LV2 plugins synchronously and the rest of
+ * the plugins in a background thread.
+ *
+ * Plugins found in the background are published
+ * to \ref PluginManager.plugin_descriptors in
+ * batches in the GTK thread, so the plugin list
+ * must only be accessed from the GTK thread while
+ * scanning.
+ *
+ * @param on_finished Callback to call in the GTK
+ *   thread when scanning finished, or NULL.
+ */
+void
+plugin_manager_begin_scan_plugins (
+  PluginManager * self,
+  const double    max_progress,
+  double *        progress,
+  GenericCallback on_finished,
+  void *          user_data);
+
 /**
  * Returns the PluginDescriptor instance for the
  * given URI.
@@ -80,6 +80,8 @@ typedef struct TracklistSelections
 #define PROJECT_EXPORTS_DIR     "exports"
 #define PROJECT_STEMS_DIR       "stems"
 #define PROJECT_POOL_DIR        "pool"
+#define PROJECT_ANALYSIS_DIR    "analysis"
+#define PROJECT_IMPORT_TMP_DIR  "import-tmp"
 
 typedef enum ProjectPath
 {
@@ -106,6 +108,13 @@ typedef enum ProjectPath
   PROJECT_PATH_EXPORTS_STEMS,
 
   PROJECT_PATH_POOL,
+
+  /** Cached analyses of pool clips. */
+  PROJECT_PATH_ANALYSIS,
+
+  /** Files being imported, before they are moved
+   * to the pool. */
+  PROJECT_PATH_IMPORT_TMP,
 } ProjectPath;
 
 /**
@@ -305,6 +314,17 @@ typedef struct Project
   ZixSem            save_sem;
 
   gint64            last_autosave_time;
+
+  /**
+   * Number unique to this project object in this
+   * session.
+   *
+   * Used by asynchronous jobs to check that the
+   * project they started on is still the current
+   * one, since a new project may be allocated at
+   * the address of a freed one.
+   */
+  unsigned int      generation;
 } Project;
 
 static const cyaml_schema_field_t
@@ -398,6 +418,10 @@ typedef struct ProjectSaveData
   /** Full path to save to. */
   char *    project_file_path;
 
+  /** Full path of the plugin states dir to remove
+   * unused snapshots from after saving, or NULL. */
+  char *    plugin_states_dir;
+
   bool      is_backup;
 
   /** To be set to true when the thread finishes. */
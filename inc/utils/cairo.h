@@ -46,6 +46,14 @@ typedef struct CairoCaches
    *   icon name: cairo_surface_t
    */
   Dictionary *  icon_surface_dict;
+
+  /**
+   * Pre-rendered labels:
+   *   label key: cairo_surface_t
+   *
+   * @see z_cairo_get_surface_for_label().
+   */
+  GHashTable *  label_surfaces;
 } CairoCaches;
 
 #define CAIRO_CACHES (ZRYTHM->cairo_caches)
@@ -193,6 +201,29 @@ z_cairo_get_surface_from_icon_name (
   int          size,
   int          scale);
 
+/**
+ * Returns a cached surface with the given Pango
+ * markup rendered in the default font at the given
+ * size and color, creating it if needed.
+ *
+ * The surface is owned by the cache and is meant
+ * to be blitted wherever the same label is drawn
+ * many times (eg, note names).
+ *
+ * @param markup Pango markup, also used as part of
+ *   the cache key.
+ * @param font_size Font size in points.
+ * @param scale Scale factor of the widget.
+ */
+NONNULL
+cairo_surface_t *
+z_cairo_get_surface_for_label (
+  GtkWidget *     widget,
+  const char *    markup,
+  int             font_size,
+  const GdkRGBA * color,
+  int             scale);
+
 /**
  * Creates a PangoLayout to be cached in widgets
  * based on the given settings.
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * CPU affinity utils.
+ *
+ * Pinning is only supported on Linux. On other
+ * platforms the functions do nothing and report
+ * failure.
+ */
+
+#ifndef __UTILS_CPU_AFFINITY_H__
+#define __UTILS_CPU_AFFINITY_H__
+
+#include <stdbool.h>
+
+#include <glib.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+/**
+ * Parses a CPU list like "0,2-4" (the format used
+ * by isolcpus and taskset) into CPU indices.
+ *
+ * @param cpus Array of int to append to.
+ *
+ * @return Whether the list is valid. An empty list
+ *   is valid.
+ */
+NONNULL
+bool
+cpu_affinity_parse_list (
+  const char * str,
+  GArray *     cpus);
+
+/**
+ * Returns a string representation of the given CPU
+ * indices in the format parsed by
+ * cpu_affinity_parse_list().
+ */
+char *
+cpu_affinity_list_to_string (
+  const int * cpus,
+  size_t      num_cpus);
+
+/**
+ * Restricts the calling thread to the given CPUs.
+ *
+ * Threads created afterwards by this thread
+ * inherit the affinity.
+ *
+ * @return Whether successful.
+ */
+bool
+cpu_affinity_pin_current_thread (
+  const int * cpus,
+  size_t      num_cpus);
+
+/**
+ * Pins the calling thread to the CPUs in the given
+ * setting of the general/engine schema, if not
+ * empty.
+ *
+ * @param thread_name Name to use in messages.
+ *
+ * @return Whether the thread was pinned.
+ */
+NONNULL
+bool
+cpu_affinity_pin_current_thread_from_setting (
+  const char * setting_key,
+  const char * thread_name);
+
+/**
+ * Returns the online CPUs of the system as an
+ * array of int.
+ *
+ * Unlike g_get_num_processors(), this does not
+ * depend on the affinity of the calling thread.
+ */
+GArray *
+cpu_affinity_get_online_cpus (void);
+
+/**
+ * Returns the online CPUs except the given ones
+ * as an array of int.
+ *
+ * If no other CPUs are online, all online CPUs
+ * are returned.
+ */
+GArray *
+cpu_affinity_get_cpus_excluding (
+  const int * excluded,
+  size_t      num_excluded);
+
+/**
+ * Returns the CPUs to use for realtime threads
+ * from the given setting of the general/engine
+ * schema.
+ *
+ * If the setting is empty but housekeeping CPUs
+ * are set, all other online CPUs are returned, so
+ * that realtime threads created by a (pinned)
+ * housekeeping thread don't inherit its affinity.
+ *
+ * @return An array of int, or NULL if the
+ *   affinity should be left alone.
+ */
+NONNULL
+GArray *
+cpu_affinity_get_rt_cpus_from_settings (
+  const char * setting_key);
+
+/**
+ * Returns the CPUs the calling thread is allowed
+ * to run on as a newly allocated string, or NULL
+ * if unknown.
+ */
+char *
+cpu_affinity_get_current_thread_cpus (void);
+
+/**
+ * Returns the CPU the calling thread is running
+ * on, or -1 if unknown.
+ */
+int
+cpu_affinity_get_current_cpu (void);
+
+/**
+ * Returns the OS thread ID of the calling thread,
+ * or -1 if unknown.
+ */
+long
+cpu_affinity_get_current_thread_id (void);
+
+/**
+ * Returns the SMT siblings of the given CPU
+ * (including itself) as an array of int, or NULL
+ * if unknown.
+ */
+GArray *
+cpu_affinity_get_smt_siblings (
+  int cpu);
+
+/**
+ * Returns the number of times the given thread
+ * of this process migrated between CPUs, or -1 if
+ * unknown.
+ */
+long
+cpu_affinity_get_thread_migrations (
+  long thread_id);
+
+/**
+ * @}
+ */
+
+#endif
@@ -45,6 +45,25 @@ hash_get_from_file (
   const char *  filepath,
   HashAlgorithm algo);
 
+/**
+ * Returns a hash of the contents of the given
+ * directory.
+ *
+ * The relative path and contents of each file are
+ * taken into account, so the hash is the same for
+ * identical directories in different locations.
+ *
+ * HASH_ALGORITHM_XXH3_64 uses XXH64 if XXH3 is not
+ * available, so the hash is always 64-bit.
+ *
+ * @return A newly allocated string, or NULL if
+ *   the directory could not be read.
+ */
+char *
+hash_get_from_dir (
+  const char *  dir,
+  HashAlgorithm algo);
+
 void *
 hash_create_state (void);
 
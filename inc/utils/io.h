@@ -171,6 +171,21 @@ io_copy_dir (
   bool         follow_symlinks,
   bool         recursive);
 
+/**
+ * Same as io_copy_dir(), except that files are
+ * first attempted to be reflinked (copy-on-write
+ * clones sharing the data blocks of the source)
+ * and only copied if the filesystem does not
+ * support it.
+ *
+ * Symlinks are not followed.
+ */
+void
+io_reflink_dir (
+  const char * destdir_str,
+  const char * srcdir_str,
+  bool         recursive);
+
 /**
  * Returns a newly allocated path that is either
  * a copy of the original path if the path does
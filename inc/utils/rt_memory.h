@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Memory for realtime threads.
+ */
+
+#ifndef __UTILS_RT_MEMORY_H__
+#define __UTILS_RT_MEMORY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/mpmc_queue.h"
+
+#include <glib.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+/** Smallest block size of an RtArena. */
+#define RT_ARENA_MIN_BLOCK_SIZE 64
+
+/** Number of block sizes of an RtArena (64 bytes
+ * to 64 KiB). */
+#define RT_ARENA_NUM_BLOCK_SIZES 11
+
+/** Amount of stack to pre-fault in realtime
+ * threads. */
+#define RT_MEMORY_STACK_PREFAULT_SIZE (256 * 1024)
+
+/**
+ * Blocks of a single size carved from an RtArena.
+ */
+typedef struct RtArenaPool
+{
+  /** Size of each block in bytes. */
+  size_t       block_size;
+
+  /** First block. */
+  char *       start;
+
+  /** Number of blocks. */
+  size_t       num_blocks;
+
+  /** Free blocks. */
+  MPMCQueue *  free_blocks;
+
+  /** Number of blocks in use. */
+  volatile gint num_used;
+} RtArenaPool;
+
+/**
+ * Preallocated, pre-faulted and (if permitted)
+ * locked memory divided into pools of fixed-size
+ * blocks.
+ *
+ * Allocating and freeing blocks is lock-free and
+ * never calls the system allocator, so it can be
+ * done from realtime threads.
+ */
+typedef struct RtArena
+{
+  /** Memory backing all pools. */
+  void *       mem;
+  size_t       size;
+
+  /** Whether @ref RtArena.mem is locked in RAM. */
+  bool         locked;
+
+  /** Pools in increasing block size. */
+  RtArenaPool  pools[RT_ARENA_NUM_BLOCK_SIZES];
+
+  /** Number of failed allocations. */
+  volatile gint num_failed_allocs;
+} RtArena;
+
+/**
+ * Creates an arena of the given size, split so
+ * that each block size has the same number of
+ * blocks.
+ *
+ * The main consumers are port buffers, whose size
+ * depends on the block length, so every size has
+ * room for as many buffers.
+ *
+ * @param lock Whether to try to lock the memory
+ *   in RAM.
+ */
+RtArena *
+rt_arena_new (
+  size_t size,
+  bool   lock);
+
+/**
+ * Returns a block of at least @p size bytes
+ * aligned to RT_ARENA_MIN_BLOCK_SIZE, or NULL if
+ * no such block is available.
+ *
+ * Realtime safe.
+ */
+HOT
+NONNULL
+void *
+rt_arena_alloc (
+  RtArena * self,
+  size_t    size);
+
+/**
+ * Returns a block obtained with rt_arena_alloc()
+ * to the arena.
+ *
+ * Realtime safe.
+ */
+HOT
+NONNULL
+void
+rt_arena_free (
+  RtArena * self,
+  void *    block);
+
+/**
+ * Returns whether the given memory belongs to the
+ * arena.
+ */
+NONNULL
+bool
+rt_arena_contains (
+  RtArena *    self,
+  const void * mem);
+
+/**
+ * Logs the usage of each pool.
+ */
+NONNULL
+void
+rt_arena_print (
+  RtArena * self);
+
+NONNULL
+void
+rt_arena_free_arena (
+  RtArena * self);
+
+/**
+ * Touches the next @p size bytes of the calling
+ * thread's stack so that later use of it does not
+ * page fault.
+ */
+void
+rt_memory_prefault_stack (
+  size_t size);
+
+/**
+ * Locks all current and future memory of the
+ * process in RAM.
+ *
+ * @return Whether successful.
+ */
+bool
+rt_memory_lock_all (void);
+
+/**
+ * Marks the calling thread as running realtime
+ * code (or not).
+ *
+ * Used to detect allocations from realtime
+ * threads when built with the trap_rt_allocations
+ * option.
+ */
+void
+rt_memory_set_thread_realtime (
+  bool realtime);
+
+/**
+ * Returns whether the calling thread is marked as
+ * running realtime code.
+ */
+bool
+rt_memory_is_thread_realtime (void);
+
+/**
+ * Returns the number of allocations (and frees)
+ * done by threads marked as realtime since the
+ * last reset, or -1 if they are not tracked.
+ *
+ * Allocations are only tracked when built with
+ * the trap_rt_allocations option using glibc. The
+ * first allocation is reported as a critical
+ * error and aborts when testing.
+ */
+int
+rt_memory_get_num_rt_allocations (void);
+
+/**
+ * Resets the number of allocations done by
+ * realtime threads.
+ */
+void
+rt_memory_reset_num_rt_allocations (void);
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Timings of the startup stages.
+ *
+ * Each stage is logged when it ends and the whole
+ * trace is (re)written as JSON to the trace file,
+ * if any, so that startup regressions can be
+ * tracked across versions.
+ */
+
+#ifndef __UTILS_STARTUP_TRACE_H__
+#define __UTILS_STARTUP_TRACE_H__
+
+#include <stdbool.h>
+
+#include <glib.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+/**
+ * Environment variable to override the path of
+ * the trace file with.
+ */
+#define STARTUP_TRACE_FILE_ENV \
+  "ZRYTHM_STARTUP_TRACE_FILE"
+
+/** Default basename of the trace file in the
+ * user log dir. */
+#define STARTUP_TRACE_FILE_BASENAME \
+  "startup_trace.json"
+
+/**
+ * A startup stage or milestone.
+ *
+ * Times are in microseconds since the trace was
+ * created.
+ */
+typedef struct StartupTraceStage
+{
+  char *       name;
+
+  /** Name of the thread the stage ran in. */
+  char *       thread_name;
+
+  gint64       start_time;
+
+  /** End time, or -1 if not ended yet. */
+  gint64       end_time;
+
+  /** Whether this is a milestone (a point in time
+   * rather than a stage). */
+  bool         is_milestone;
+} StartupTraceStage;
+
+typedef struct StartupTrace
+{
+  /** Monotonic time the trace was created at. */
+  gint64       start_time;
+
+  /** Array of StartupTraceStage. */
+  GArray *     stages;
+
+  /** Path to write the JSON trace to, or NULL. */
+  char *       file_path;
+
+  /** Lock for the above, since stages run in
+   * different threads. */
+  GMutex       lock;
+} StartupTrace;
+
+StartupTrace *
+startup_trace_new (void);
+
+/**
+ * Sets the path of the file to write the trace to
+ * and writes the stages traced so far.
+ *
+ * @param file_path Path, or NULL to use the value
+ *   of \ref STARTUP_TRACE_FILE_ENV or the default
+ *   file in the user log dir.
+ */
+NONNULL_ARGS (1)
+void
+startup_trace_set_file_path (
+  StartupTrace * self,
+  const char *   file_path);
+
+/**
+ * Marks the beginning of a stage in the current
+ * thread.
+ *
+ * @return The stage ID to pass to
+ *   startup_trace_end_stage().
+ */
+NONNULL
+int
+startup_trace_begin_stage (
+  StartupTrace * self,
+  const char *   name);
+
+/**
+ * Marks the end of the given stage, logs its
+ * duration and updates the trace file.
+ */
+NONNULL
+void
+startup_trace_end_stage (
+  StartupTrace * self,
+  int            stage_id);
+
+/**
+ * Records a milestone (eg, "ready for project")
+ * at the current time.
+ */
+NONNULL
+void
+startup_trace_add_milestone (
+  StartupTrace * self,
+  const char *   name);
+
+/**
+ * Returns the trace as a newly allocated JSON
+ * string.
+ */
+NONNULL
+char *
+startup_trace_to_json (
+  StartupTrace * self);
+
+NONNULL
+void
+startup_trace_free (
+  StartupTrace * self);
+
+/**
+ * @}
+ */
+
+#endif
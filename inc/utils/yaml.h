@@ -311,6 +311,13 @@ float_schema = {
     typeof (float)),
 };
 
+static const cyaml_schema_value_t
+double_schema = {
+  CYAML_VALUE_FLOAT (
+    CYAML_FLAG_DEFAULT,
+    typeof (double)),
+};
+
 static const cyaml_schema_field_t
 gdk_rgba_fields_schema[] =
 {
@@ -43,6 +43,7 @@ typedef struct Settings Settings;
 typedef struct Log Log;
 typedef struct CairoCaches CairoCaches;
 typedef struct PCGRand PCGRand;
+typedef struct AudioAnalyzer AudioAnalyzer;
 
 /**
  * @addtogroup general
@@ -239,6 +240,9 @@ typedef struct Zrythm
   /** File manager. */
   FileManager *       file_manager;
 
+  /** Background analysis of audio clips. */
+  AudioAnalyzer *     audio_analyzer;
+
   /**
    * String interner for internal things.
    */
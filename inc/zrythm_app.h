@@ -48,6 +48,7 @@ typedef struct _ProjectAssistantWidget
   ProjectAssistantWidget;
 typedef struct Zrythm Zrythm;
 typedef struct UiCaches UiCaches;
+typedef struct StartupTrace StartupTrace;
 
 /**
  * @addtogroup general
@@ -92,9 +93,16 @@ struct _ZrythmApp
   ZixSem             progress_status_lock;
 
   /** Flag to set when initialization has
-   * finished. */
+   * finished.
+   *
+   * This is set as soon as a project can be
+   * opened. Plugin scanning and file loading may
+   * still be running in the background. */
   bool               init_finished;
 
+  /** Timings of the startup stages. */
+  StartupTrace *     startup_trace;
+
   /** Status text to be used in the splash
    * screen. */
   char               status[800];
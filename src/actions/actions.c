@@ -1079,15 +1079,8 @@ activate_copy (
               timeline_selections_set_vis_track_indices (
                 clipboard->timeline_sel);
             }
-          char * serialized =
-            yaml_serialize (
-              clipboard, &clipboard_schema);
-          g_return_if_fail (serialized);
-          gtk_clipboard_set_text (
-            DEFAULT_CLIPBOARD,
-            serialized, -1);
-          clipboard_free (clipboard);
-          g_free (serialized);
+          clipboard_offer (
+            clipboard, DEFAULT_CLIPBOARD);
         }
       else
         {
@@ -1102,15 +1095,8 @@ activate_copy (
           Clipboard * clipboard =
             clipboard_new_for_mixer_selections (
               MIXER_SELECTIONS, F_CLONE);
-          char * serialized =
-            yaml_serialize (
-              clipboard, &clipboard_schema);
-          g_return_if_fail (serialized);
-          gtk_clipboard_set_text (
-            DEFAULT_CLIPBOARD,
-            serialized, -1);
-          clipboard_free (clipboard);
-          g_free (serialized);
+          clipboard_offer (
+            clipboard, DEFAULT_CLIPBOARD);
         }
       break;
     default:
@@ -1119,26 +1105,18 @@ activate_copy (
     }
 }
 
+/**
+ * Pastes the given clipboard.
+ *
+ * @param deserialized Whether the clipboard was
+ *   deserialized (as opposed to being offered by
+ *   this instance).
+ */
 static void
-on_clipboard_received (
-  GtkClipboard *     gtk_clipboard,
-  const char *       text,
-  gpointer           data)
+paste_clipboard (
+  Clipboard * clipboard,
+  bool        deserialized)
 {
-  if (!text)
-    return;
-
-  Clipboard * clipboard =
-    (Clipboard *)
-    yaml_deserialize (text, &clipboard_schema);
-  if (!clipboard)
-    {
-      g_message (
-        "invalid clipboard data received:\n%s",
-        text);
-      return;
-    }
-
   ArrangerSelections * sel = NULL;
   MixerSelections * mixer_sel = NULL;
   switch (clipboard->type)
@@ -1159,7 +1137,8 @@ on_clipboard_received (
   bool incompatible = false;
   if (sel)
     {
-      arranger_selections_post_deserialize (sel);
+      if (deserialized)
+        arranger_selections_post_deserialize (sel);
       if (arranger_selections_can_be_pasted (sel))
         {
           arranger_selections_paste_to_pos (
@@ -1168,8 +1147,7 @@ on_clipboard_received (
       else
         {
           g_message (
-            "can't paste arranger selections:\n%s",
-            text);
+            "can't paste arranger selections");
           incompatible = true;
         }
     }
@@ -1177,7 +1155,9 @@ on_clipboard_received (
     {
       ChannelSlotWidget * slot =
         MW_MIXER->paste_slot;
-      mixer_selections_post_deserialize (mixer_sel);
+      if (deserialized)
+        mixer_selections_post_deserialize (
+          mixer_sel);
       if (mixer_selections_can_be_pasted (
             mixer_sel, slot->track->channel,
             slot->type, slot->slot_index))
@@ -1189,8 +1169,7 @@ on_clipboard_received (
       else
         {
           g_message (
-            "can't paste mixer selections:\n%s",
-            text);
+            "can't paste mixer selections");
           incompatible = true;
         }
     }
@@ -1200,6 +1179,29 @@ on_clipboard_received (
       ui_show_notification (
         _("Can't paste incompatible data"));
     }
+}
+
+static void
+on_clipboard_received (
+  GtkClipboard *     gtk_clipboard,
+  const char *       text,
+  gpointer           data)
+{
+  if (!text)
+    return;
+
+  Clipboard * clipboard =
+    (Clipboard *)
+    yaml_deserialize (text, &clipboard_schema);
+  if (!clipboard)
+    {
+      g_message (
+        "invalid clipboard data received:\n%s",
+        text);
+      return;
+    }
+
+  paste_clipboard (clipboard, true);
 
   clipboard_free (clipboard);
 }
@@ -1211,6 +1213,17 @@ activate_paste (
   gpointer       user_data)
 {
   g_message ("paste");
+
+  /* if the clipboard contents were copied in this
+   * instance, paste them directly */
+  Clipboard * clipboard =
+    clipboard_get_offered (DEFAULT_CLIPBOARD);
+  if (clipboard)
+    {
+      paste_clipboard (clipboard, false);
+      return;
+    }
+
   gtk_clipboard_request_text (
     DEFAULT_CLIPBOARD,
     on_clipboard_received,
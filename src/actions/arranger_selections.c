@@ -265,10 +265,38 @@ _create_action (
   return self;
 }
 
+/**
+ * Creates an action that stores the attributes of
+ * the given MIDI notes as columns instead of
+ * cloning the selections.
+ */
+static ArrangerSelectionsAction *
+_create_midi_notes_action (
+  MidiArrangerSelections * sel)
+{
+  ArrangerSelectionsAction * self =
+    object_new (ArrangerSelectionsAction);
+
+  self->notes_before =
+    midi_note_columns_new_from_selections (sel);
+  self->notes_after =
+    midi_note_columns_clone (self->notes_before);
+  self->first_run = true;
+
+  undoable_action_init (
+    (UndoableAction *) self,
+    UA_ARRANGER_SELECTIONS);
+
+  return self;
+}
+
 static ArrangerSelections *
 get_actual_arranger_selections (
   ArrangerSelectionsAction * self)
 {
+  if (self->notes_before)
+    return (ArrangerSelections *) MA_SELECTIONS;
+
   switch (self->sel->type)
     {
     case ARRANGER_SELECTIONS_TYPE_TIMELINE:
@@ -519,30 +547,39 @@ arranger_selections_action_new_edit_midi_function (
   MidiFunctionType     midi_func_type,
   GError **            error)
 {
-  ArrangerSelections * sel_after =
-    arranger_selections_clone (sel_before);
+  g_return_val_if_fail (
+    sel_before->type ==
+      ARRANGER_SELECTIONS_TYPE_MIDI, NULL);
+
+  ArrangerSelectionsAction * self =
+    _create_midi_notes_action (
+      (MidiArrangerSelections *) sel_before);
+  self->type = AS_ACTION_EDIT;
+  self->edit_type =
+    ARRANGER_SELECTIONS_ACTION_EDIT_EDITOR_FUNCTION;
 
   GError * err = NULL;
   int ret =
-    midi_function_apply (
-      sel_after, midi_func_type, &err);
+    midi_function_apply_to_columns (
+      self->notes_after, midi_func_type, &err);
   if (ret != 0)
     {
       PROPAGATE_PREFIXED_ERROR (
         error, err, "%s",
         _("Failed to apply MIDI function"));
-      arranger_selections_free_full (sel_after);
+      arranger_selections_action_free (self);
       return NULL;
     }
 
-  UndoableAction * ua =
-    arranger_selections_action_new_edit (
-      sel_before, sel_after,
-      ARRANGER_SELECTIONS_ACTION_EDIT_EDITOR_FUNCTION,
-      F_NOT_ALREADY_EDITED, error);
+  /* set last action */
+  g_settings_set_int (
+    S_UI, "midi-function", midi_func_type);
 
-  arranger_selections_free_full (sel_after);
+  EVENTS_PUSH (ET_EDITOR_FUNCTION_APPLIED, NULL);
 
+  self->first_run = false;
+
+  UndoableAction * ua = (UndoableAction *) self;
   return ua;
 }
 
@@ -843,8 +880,45 @@ arranger_selections_action_new_quantize (
   QuantizeOptions *    opts,
   GError **            error)
 {
-  ArrangerSelectionsAction * self =
-    _create_action (sel);
+  ArrangerSelectionsAction * self;
+  if (sel->type == ARRANGER_SELECTIONS_TYPE_MIDI)
+    {
+      /* quantize all the note positions in one
+       * pass */
+      self =
+        _create_midi_notes_action (
+          (MidiArrangerSelections *) sel);
+      self->type = AS_ACTION_QUANTIZE;
+      self->opts = quantize_options_clone (opts);
+
+      MidiNoteColumns * cols = self->notes_after;
+      size_t num_notes = (size_t) cols->num_notes;
+      if (self->opts->adj_start)
+        {
+          double * diffs =
+            g_new (double, MAX (num_notes, 1));
+          quantize_options_quantize_ticks (
+            self->opts, cols->start_ticks, diffs,
+            num_notes);
+          for (size_t i = 0; i < num_notes; i++)
+            {
+              cols->end_ticks[i] += diffs[i];
+            }
+          g_free (diffs);
+        }
+      if (self->opts->adj_end)
+        {
+          quantize_options_quantize_ticks (
+            self->opts, cols->end_ticks, NULL,
+            num_notes);
+        }
+      self->first_run = false;
+
+      UndoableAction * ua = (UndoableAction *) self;
+      return ua;
+    }
+
+  self = _create_action (sel);
   self->type = AS_ACTION_QUANTIZE;
 
   set_selections (self, sel, 1, 1);
@@ -963,6 +1037,12 @@ arranger_selections_action_clone (
   if (src->opts)
     self->opts =
       quantize_options_clone (src->opts);
+  if (src->notes_before)
+    self->notes_before =
+      midi_note_columns_clone (src->notes_before);
+  if (src->notes_after)
+    self->notes_after =
+      midi_note_columns_clone (src->notes_after);
 
   return self;
 }
@@ -2327,18 +2407,59 @@ do_or_undo_record (
 }
 
 /**
- * Does or undoes the action.
+ * Does or undoes a bulk MIDI note edit by writing
+ * the stored attributes, publishing a single event
+ * for all the notes.
  *
  * @param _do 1 to do, 0 to undo.
- * @param create 1 to create, 0 to delete. This just
- *   reverses the actions done by undo/redo.
  */
+static int
+do_or_undo_midi_notes (
+  ArrangerSelectionsAction * self,
+  const int                  _do,
+  GError **                  error)
+{
+  GError * err = NULL;
+  int ret =
+    midi_note_columns_apply (
+      _do ? self->notes_after : self->notes_before,
+      &err);
+  if (ret != 0)
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "%s",
+        _("Failed to edit MIDI notes"));
+      return -1;
+    }
+
+  ArrangerSelections * sel =
+    get_actual_arranger_selections (self);
+  if (self->type == AS_ACTION_QUANTIZE)
+    {
+      EVENTS_PUSH (
+        ET_ARRANGER_SELECTIONS_QUANTIZED, sel);
+    }
+  else
+    {
+      EVENTS_PUSH (
+        ET_ARRANGER_SELECTIONS_CHANGED_REDRAW_EVERYTHING,
+        sel);
+    }
+
+  self->first_run = false;
+
+  return 0;
+}
+
 static int
 do_or_undo_edit (
   ArrangerSelectionsAction * self,
   const int                  _do,
   GError **                  error)
 {
+  if (self->notes_before)
+    return do_or_undo_midi_notes (self, _do, error);
+
   int size = 0;
   ArrangerObject ** objs_before =
     arranger_selections_get_all_objects (
@@ -2933,6 +3054,9 @@ do_or_undo_quantize (
   const int                  _do,
   GError **                  error)
 {
+  if (self->notes_before)
+    return do_or_undo_midi_notes (self, _do, error);
+
   int size = 0;
   ArrangerObject ** objs =
     arranger_selections_get_all_objects (
@@ -3204,6 +3328,10 @@ arranger_selections_action_free (
 {
   object_free_w_func_and_null (
     arranger_selections_free_full, self->sel);
+  object_free_w_func_and_null (
+    midi_note_columns_free, self->notes_before);
+  object_free_w_func_and_null (
+    midi_note_columns_free, self->notes_after);
 
   object_zero_and_free (self);
 }
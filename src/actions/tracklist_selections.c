@@ -710,6 +710,68 @@ tracklist_selections_action_perform (
     error);
 }
 
+/**
+ * Creates a new TracklistSelectionsAction for an
+ * audio track with a region for a clip that is
+ * already in the pool (eg, decoded by a
+ * FileImport).
+ *
+ * @param file_basename File name to name the
+ *   track after.
+ */
+UndoableAction *
+tracklist_selections_action_new_create_from_pool_clip (
+  int              pool_id,
+  const char *     file_basename,
+  int              track_pos,
+  const Position * pos,
+  GError **        error)
+{
+  g_return_val_if_fail (
+    pool_id >= 0 && file_basename, NULL);
+
+  UndoableAction * ua =
+    tracklist_selections_action_new_create (
+      TRACK_TYPE_AUDIO, NULL, NULL, track_pos,
+      pos, 1, -1, error);
+  if (!ua)
+    return NULL;
+
+  /* same as creating from a file, without
+   * decoding it again */
+  TracklistSelectionsAction * self =
+    (TracklistSelectionsAction *) ua;
+  self->is_empty = 0;
+  self->pool_id = pool_id;
+  self->file_basename = g_strdup (file_basename);
+
+  return ua;
+}
+
+/**
+ * Creates and performs a TracklistSelectionsAction
+ * for an audio track with a region for a clip that
+ * is already in the pool.
+ *
+ * @see
+ *   tracklist_selections_action_new_create_from_pool_clip().
+ *
+ * @return Whether successful.
+ */
+bool
+tracklist_selections_action_perform_create_from_pool_clip (
+  int              pool_id,
+  const char *     file_basename,
+  int              track_pos,
+  const Position * pos,
+  GError **        error)
+{
+  UNDO_MANAGER_PERFORM_AND_PROPAGATE_ERR (
+    tracklist_selections_action_new_create_from_pool_clip,
+    error, pool_id, file_basename, track_pos, pos,
+    error);
+}
+
 /**
  * Edit or remove direct out.
  *
@@ -20,6 +20,10 @@
 #include "actions/undoable_action.h"
 #include "actions/undo_stack.h"
 #include "actions/undo_manager.h"
+#include "audio/engine.h"
+#include "audio/graph.h"
+#include "audio/prerenderer.h"
+#include "audio/router.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "gui/widgets/header.h"
@@ -82,6 +86,22 @@ undo_manager_new (void)
   return self;
 }
 
+/**
+ * Makes the tracks rendered ahead go back to live
+ * processing.
+ */
+static void
+invalidate_prerendered_tracks (void)
+{
+  if (PROJECT && AUDIO_ENGINE && ROUTER
+      && ROUTER->graph
+      && ROUTER->graph->prerenderer)
+    {
+      prerenderer_invalidate_all (
+        ROUTER->graph->prerenderer);
+    }
+}
+
 /**
  * Does or undoes the given action.
  *
@@ -115,6 +135,10 @@ do_or_undo_action (
       event_manager_process_now (EVENT_MANAGER);
     }
 
+  /* stop rendering ahead before the project
+   * changes */
+  invalidate_prerendered_tracks ();
+
   int ret = 0;
   if (main_stack == self->undo_stack)
     {
@@ -133,6 +157,10 @@ do_or_undo_action (
       return -1;
     }
 
+  /* the action may have rebuilt the graph, and
+   * chunks may have been rendered meanwhile */
+  invalidate_prerendered_tracks ();
+
   /* if error return */
   if (ret != 0)
     {
@@ -191,6 +219,11 @@ undo_manager_undo (
   const int num_actions = action->num_actions;
   g_return_val_if_fail (num_actions > 0, -1);
 
+  /* batch multiple actions so that the graph is
+   * only recalculated once */
+  if (num_actions > 1)
+    tracklist_begin_batch (TRACKLIST);
+
   int ret = 0;
   for (int i = 0; i < num_actions; i++)
     {
@@ -218,6 +251,9 @@ undo_manager_undo (
         }
     }
 
+  if (num_actions > 1)
+    tracklist_end_batch (TRACKLIST);
+
   if (ZRYTHM_HAVE_UI)
     {
       EVENTS_PUSH (ET_UNDO_REDO_ACTION_DONE, NULL);
@@ -251,6 +287,11 @@ undo_manager_redo (
   const int num_actions = action->num_actions;
   g_return_val_if_fail (num_actions > 0, -1);
 
+  /* batch multiple actions so that the graph is
+   * only recalculated once */
+  if (num_actions > 1)
+    tracklist_begin_batch (TRACKLIST);
+
   int ret = 0;
   for (int i = 0; i < num_actions; i++)
     {
@@ -278,6 +319,9 @@ undo_manager_redo (
         }
     }
 
+  if (num_actions > 1)
+    tracklist_end_batch (TRACKLIST);
+
   if (ZRYTHM_HAVE_UI)
     {
       EVENTS_PUSH (ET_UNDO_REDO_ACTION_DONE, NULL);
@@ -336,8 +380,10 @@ undo_manager_perform (
     {
       EVENTS_PUSH (ET_UNDO_REDO_ACTION_DONE, NULL);
 
-      /* process UI events now */
-      event_manager_process_now (EVENT_MANAGER);
+      /* process UI events now (or at the end of
+       * the batch) */
+      if (!tracklist_is_batching (TRACKLIST))
+        event_manager_process_now (EVENT_MANAGER);
     }
 
   zix_sem_post (&self->action_sem);
@@ -155,6 +155,11 @@ bool
 undoable_action_needs_pause (
   UndoableAction * self)
 {
+  /* the engine is already paused for the whole
+   * batch */
+  if (tracklist_is_batching (TRACKLIST))
+    return false;
+
   switch (self->type)
     {
     case UA_ARRANGER_SELECTIONS:
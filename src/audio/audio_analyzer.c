@@ -0,0 +1,1115 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "audio/audio_analyzer.h"
+#include "audio/clip.h"
+#include "project.h"
+#include "utils/audio.h"
+#include "utils/file.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include <xxhash.h>
+
+/** Frames per analysis hop for onsets and
+ * silence. */
+#define HOP_SIZE 512
+
+/** Number of previous hops the onset detector
+ * compares against. */
+#define ONSET_HISTORY 8
+
+/** Energy ratio over the recent average that
+ * counts as an onset (about +6 dB). */
+#define ONSET_RATIO 4.f
+
+/** Minimum time between onsets in ms. */
+#define ONSET_MIN_DISTANCE_MS 50
+
+typedef struct AudioAnalysisJob
+{
+  unsigned int          id;
+  char *                hash;
+
+  /** Copy of the clip's planar frames. */
+  float *               ch_frames[16];
+  channels_t            channels;
+  size_t                num_frames;
+  int                   samplerate;
+
+  /** File to save the result to, if any. */
+  char *                cache_path;
+
+  AudioAnalysisCallback callback;
+  void *                user_data;
+
+  volatile gint         cancelled;
+} AudioAnalysisJob;
+
+typedef struct AudioAnalysisResult
+{
+  AudioAnalysis *       analysis;
+  AudioAnalysisCallback callback;
+  void *                user_data;
+} AudioAnalysisResult;
+
+/**
+ * Returns a newly allocated copy of the given
+ * array.
+ */
+static void *
+dup_array (
+  const void * src,
+  size_t       size)
+{
+  void * ret = g_malloc (MAX (size, 1));
+  if (size > 0)
+    memcpy (ret, src, size);
+  return ret;
+}
+
+static inline bool
+is_cancelled (
+  volatile gint * cancelled)
+{
+  return cancelled && g_atomic_int_get (cancelled);
+}
+
+/**
+ * Calculates the peak and RMS over all channels.
+ */
+static void
+calc_peak_and_rms (
+  AudioAnalysis * self,
+  float **        ch_frames,
+  channels_t      channels,
+  size_t          num_frames)
+{
+  float peak = 0.f;
+  double sum = 0.0;
+  for (channels_t i = 0; i < channels; i++)
+    {
+      const float * frames = ch_frames[i];
+      for (size_t j = 0; j < num_frames; j++)
+        {
+          float val = frames[j];
+          float abs_val = fabsf (val);
+          if (abs_val > peak)
+            peak = abs_val;
+          sum += (double) val * (double) val;
+        }
+    }
+
+  self->peak = peak;
+  self->rms =
+    (float)
+    sqrt (
+      sum / (double) (num_frames * channels));
+}
+
+typedef struct Biquad
+{
+  double b0, b1, b2, a1, a2;
+  double z1, z2;
+} Biquad;
+
+static inline double
+biquad_process (
+  Biquad * bq,
+  double   in)
+{
+  double out = bq->b0 * in + bq->z1;
+  bq->z1 = bq->b1 * in - bq->a1 * out + bq->z2;
+  bq->z2 = bq->b2 * in - bq->a2 * out;
+  return out;
+}
+
+/**
+ * Sets up the two K-weighting filters of ITU-R
+ * BS.1770 for the given sample rate.
+ */
+static void
+init_k_weighting (
+  Biquad * shelf,
+  Biquad * highpass,
+  int      samplerate)
+{
+  memset (shelf, 0, sizeof (Biquad));
+  memset (highpass, 0, sizeof (Biquad));
+
+  /* high shelf */
+  double f0 = 1681.974450955533;
+  double gain = 3.999843853973347;
+  double q = 0.7071752369554196;
+  double k = tan (M_PI * f0 / samplerate);
+  double vh = pow (10.0, gain / 20.0);
+  double vb = pow (vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  shelf->b0 = (vh + vb * k / q + k * k) / a0;
+  shelf->b1 = 2.0 * (k * k - vh) / a0;
+  shelf->b2 = (vh - vb * k / q + k * k) / a0;
+  shelf->a1 = 2.0 * (k * k - 1.0) / a0;
+  shelf->a2 = (1.0 - k / q + k * k) / a0;
+
+  /* high pass */
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan (M_PI * f0 / samplerate);
+  a0 = 1.0 + k / q + k * k;
+  highpass->b0 = 1.0;
+  highpass->b1 = -2.0;
+  highpass->b2 = 1.0;
+  highpass->a1 = 2.0 * (k * k - 1.0) / a0;
+  highpass->a2 = (1.0 - k / q + k * k) / a0;
+}
+
+/**
+ * Calculates the integrated loudness as per ITU-R
+ * BS.1770 (all channels weighted equally).
+ *
+ * @return Whether finished (not cancelled).
+ */
+static bool
+calc_lufs (
+  AudioAnalysis * self,
+  float **        ch_frames,
+  channels_t      channels,
+  size_t          num_frames,
+  int             samplerate,
+  volatile gint * cancelled)
+{
+  /* 400 ms blocks overlapping by 75%, made of
+   * 100 ms sub-blocks */
+  size_t sub_block_size =
+    (size_t) samplerate / 10;
+  size_t num_sub_blocks =
+    num_frames / sub_block_size;
+  self->lufs = AUDIO_ANALYSIS_MIN_LUFS;
+  if (num_sub_blocks < 4)
+    return true;
+
+  double * sub_block_energies =
+    object_new_n (num_sub_blocks, double);
+  for (channels_t i = 0; i < channels; i++)
+    {
+      if (is_cancelled (cancelled))
+        {
+          free (sub_block_energies);
+          return false;
+        }
+
+      Biquad shelf, highpass;
+      init_k_weighting (
+        &shelf, &highpass, samplerate);
+      const float * frames = ch_frames[i];
+      for (size_t j = 0; j < num_sub_blocks; j++)
+        {
+          double sum = 0.0;
+          size_t offset = j * sub_block_size;
+          for (size_t k = 0; k < sub_block_size;
+               k++)
+            {
+              double val =
+                biquad_process (
+                  &highpass,
+                  biquad_process (
+                    &shelf,
+                    (double) frames[offset + k]));
+              sum += val * val;
+            }
+          sub_block_energies[j] += sum;
+        }
+    }
+
+  size_t num_blocks = num_sub_blocks - 3;
+  double * block_energies =
+    object_new_n (num_blocks, double);
+  double abs_gate_energy =
+    pow (10.0, (-70.0 + 0.691) / 10.0);
+  double gated_sum = 0.0;
+  size_t num_gated = 0;
+  for (size_t i = 0; i < num_blocks; i++)
+    {
+      block_energies[i] =
+        (sub_block_energies[i]
+         + sub_block_energies[i + 1]
+         + sub_block_energies[i + 2]
+         + sub_block_energies[i + 3])
+        / (double) (4 * sub_block_size);
+      if (block_energies[i] > abs_gate_energy)
+        {
+          gated_sum += block_energies[i];
+          num_gated++;
+        }
+    }
+
+  if (num_gated > 0)
+    {
+      /* relative gate 10 LU below the absolute-gated
+       * loudness */
+      double rel_gate_energy =
+        (gated_sum / (double) num_gated) * 0.1;
+      double sum = 0.0;
+      size_t num = 0;
+      for (size_t i = 0; i < num_blocks; i++)
+        {
+          if (block_energies[i] > abs_gate_energy
+              &&
+              block_energies[i] > rel_gate_energy)
+            {
+              sum += block_energies[i];
+              num++;
+            }
+        }
+      if (num > 0)
+        {
+          self->lufs =
+            MAX (
+              (float)
+              (-0.691
+               + 10.0 * log10 (sum / (double) num)),
+              AUDIO_ANALYSIS_MIN_LUFS);
+        }
+    }
+
+  free (block_energies);
+  free (sub_block_energies);
+
+  return true;
+}
+
+/**
+ * Detects onsets from jumps in short-term energy
+ * and silence ranges from short-term peaks.
+ *
+ * @return Whether finished (not cancelled).
+ */
+static bool
+calc_onsets_and_silence (
+  AudioAnalysis * self,
+  float **        ch_frames,
+  channels_t      channels,
+  size_t          num_frames,
+  int             samplerate,
+  volatile gint * cancelled)
+{
+  GArray * onsets =
+    g_array_new (false, false, sizeof (long));
+  GArray * silences =
+    g_array_new (false, false, sizeof (long));
+
+  long min_onset_distance =
+    (long) samplerate * ONSET_MIN_DISTANCE_MS
+    / 1000;
+  long min_silence_len =
+    (long) samplerate
+    * AUDIO_ANALYSIS_MIN_SILENCE_MS / 1000;
+  float silence_energy =
+    AUDIO_ANALYSIS_SILENCE_THRESHOLD
+    * AUDIO_ANALYSIS_SILENCE_THRESHOLD;
+
+  float history[ONSET_HISTORY];
+  memset (history, 0, sizeof (history));
+  int history_len = 0;
+  long last_onset = -min_onset_distance;
+  long silence_start = -1;
+  size_t num_hops =
+    (num_frames + HOP_SIZE - 1) / HOP_SIZE;
+  bool ret = true;
+  for (size_t i = 0; i < num_hops; i++)
+    {
+      if (i % 1024 == 0 && is_cancelled (cancelled))
+        {
+          ret = false;
+          break;
+        }
+
+      size_t start = i * HOP_SIZE;
+      size_t end = MIN (start + HOP_SIZE, num_frames);
+      float peak = 0.f;
+      float energy = 0.f;
+      for (channels_t j = 0; j < channels; j++)
+        {
+          const float * frames = ch_frames[j];
+          for (size_t k = start; k < end; k++)
+            {
+              float abs_val = fabsf (frames[k]);
+              if (abs_val > peak)
+                peak = abs_val;
+              energy += frames[k] * frames[k];
+            }
+        }
+      energy /= (float) ((end - start) * channels);
+
+      /* onsets */
+      float avg = 0.f;
+      for (int j = 0; j < history_len; j++)
+        {
+          avg += history[j];
+        }
+      if (history_len > 0)
+        avg /= (float) history_len;
+      if (energy > silence_energy
+          && energy > avg * ONSET_RATIO
+          && (long) start - last_onset >=
+               min_onset_distance)
+        {
+          long onset = (long) start;
+          g_array_append_val (onsets, onset);
+          last_onset = onset;
+        }
+      history[i % ONSET_HISTORY] = energy;
+      if (history_len < ONSET_HISTORY)
+        history_len++;
+
+      /* silence */
+      if (peak < AUDIO_ANALYSIS_SILENCE_THRESHOLD)
+        {
+          if (silence_start < 0)
+            silence_start = (long) start;
+        }
+      else if (silence_start >= 0)
+        {
+          if ((long) start - silence_start >=
+                min_silence_len)
+            {
+              long range_end = (long) start;
+              g_array_append_val (
+                silences, silence_start);
+              g_array_append_val (
+                silences, range_end);
+            }
+          silence_start = -1;
+        }
+    }
+
+  if (ret && silence_start >= 0
+      && (long) num_frames - silence_start >=
+           min_silence_len)
+    {
+      long range_end = (long) num_frames;
+      g_array_append_val (silences, silence_start);
+      g_array_append_val (silences, range_end);
+    }
+
+  self->num_onsets = (int) onsets->len;
+  self->onsets =
+    (long *) g_array_free (onsets, false);
+  self->num_silence_ranges =
+    (int) silences->len / 2;
+  self->silence_ranges =
+    (long *) g_array_free (silences, false);
+
+  return ret;
+}
+
+/**
+ * Analyzes the given planar frames.
+ *
+ * This is what the analyzer runs for each job and
+ * can be called from any thread.
+ *
+ * @param cancelled Optional flag checked
+ *   periodically to stop early, in which case NULL
+ *   is returned.
+ */
+AudioAnalysis *
+audio_analysis_new_from_frames (
+  float **        ch_frames,
+  channels_t      channels,
+  size_t          num_frames,
+  int             samplerate,
+  volatile gint * cancelled)
+{
+  g_return_val_if_fail (
+    channels > 0 && samplerate > 0, NULL);
+
+  AudioAnalysis * self =
+    object_new (AudioAnalysis);
+  self->samplerate = samplerate;
+  self->lufs = AUDIO_ANALYSIS_MIN_LUFS;
+
+  if (num_frames == 0)
+    return self;
+
+  calc_peak_and_rms (
+    self, ch_frames, channels, num_frames);
+
+  if (!calc_lufs (
+         self, ch_frames, channels, num_frames,
+         samplerate, cancelled)
+      ||
+      !calc_onsets_and_silence (
+         self, ch_frames, channels, num_frames,
+         samplerate, cancelled)
+      || is_cancelled (cancelled))
+    {
+      audio_analysis_free (self);
+      return NULL;
+    }
+
+  GArray * candidates =
+    g_array_new (false, true, sizeof (float));
+  self->bpm =
+    audio_detect_bpm (
+      ch_frames[0], num_frames,
+      (unsigned int) samplerate, candidates);
+  self->num_bpm_candidates = (int) candidates->len;
+  self->bpm_candidates =
+    (float *) g_array_free (candidates, false);
+
+  if (is_cancelled (cancelled))
+    {
+      audio_analysis_free (self);
+      return NULL;
+    }
+
+  return self;
+}
+
+AudioAnalysis *
+audio_analysis_clone (
+  const AudioAnalysis * src)
+{
+  AudioAnalysis * self =
+    object_new (AudioAnalysis);
+  *self = *src;
+  self->hash = g_strdup (src->hash);
+  self->bpm_candidates =
+    dup_array (
+      src->bpm_candidates,
+      (size_t) src->num_bpm_candidates
+      * sizeof (float));
+  self->onsets =
+    dup_array (
+      src->onsets,
+      (size_t) src->num_onsets * sizeof (long));
+  self->silence_ranges =
+    dup_array (
+      src->silence_ranges,
+      (size_t) src->num_silence_ranges * 2
+      * sizeof (long));
+
+  return self;
+}
+
+void
+audio_analysis_free (
+  AudioAnalysis * self)
+{
+  g_free_and_null (self->hash);
+  g_free_and_null (self->bpm_candidates);
+  g_free_and_null (self->onsets);
+  g_free_and_null (self->silence_ranges);
+
+  object_zero_and_free (self);
+}
+
+#define KEY_FILE_GROUP "analysis"
+
+static double *
+longs_to_doubles (
+  const long * arr,
+  int          size)
+{
+  double * ret =
+    object_new_n ((size_t) MAX (size, 1), double);
+  for (int i = 0; i < size; i++)
+    {
+      ret[i] = (double) arr[i];
+    }
+  return ret;
+}
+
+static long *
+doubles_to_longs (
+  const double * arr,
+  size_t         size)
+{
+  long * ret =
+    object_new_n (MAX (size, 1), long);
+  for (size_t i = 0; i < size; i++)
+    {
+      ret[i] = (long) arr[i];
+    }
+  return ret;
+}
+
+/**
+ * Saves the analysis to the given file.
+ */
+static void
+save_to_file (
+  const AudioAnalysis * self,
+  const char *          path)
+{
+  GKeyFile * kf = g_key_file_new ();
+  g_key_file_set_integer (
+    kf, KEY_FILE_GROUP, "version",
+    AUDIO_ANALYSIS_VERSION);
+  g_key_file_set_integer (
+    kf, KEY_FILE_GROUP, "samplerate",
+    self->samplerate);
+  g_key_file_set_double (
+    kf, KEY_FILE_GROUP, "bpm", self->bpm);
+  g_key_file_set_double (
+    kf, KEY_FILE_GROUP, "peak", self->peak);
+  g_key_file_set_double (
+    kf, KEY_FILE_GROUP, "rms", self->rms);
+  g_key_file_set_double (
+    kf, KEY_FILE_GROUP, "lufs", self->lufs);
+
+  double * candidates =
+    object_new_n (
+      (size_t) MAX (self->num_bpm_candidates, 1),
+      double);
+  for (int i = 0; i < self->num_bpm_candidates;
+       i++)
+    {
+      candidates[i] =
+        (double) self->bpm_candidates[i];
+    }
+  g_key_file_set_double_list (
+    kf, KEY_FILE_GROUP, "bpm_candidates",
+    candidates,
+    (gsize) self->num_bpm_candidates);
+  free (candidates);
+
+  double * onsets =
+    longs_to_doubles (
+      self->onsets, self->num_onsets);
+  g_key_file_set_double_list (
+    kf, KEY_FILE_GROUP, "onsets", onsets,
+    (gsize) self->num_onsets);
+  free (onsets);
+
+  double * silence_ranges =
+    longs_to_doubles (
+      self->silence_ranges,
+      self->num_silence_ranges * 2);
+  g_key_file_set_double_list (
+    kf, KEY_FILE_GROUP, "silence_ranges",
+    silence_ranges,
+    (gsize) self->num_silence_ranges * 2);
+  free (silence_ranges);
+
+  GError * err = NULL;
+  if (!g_key_file_save_to_file (kf, path, &err))
+    {
+      g_message (
+        "failed to save analysis to %s: %s",
+        path, err->message);
+      g_error_free (err);
+    }
+  g_key_file_free (kf);
+}
+
+/**
+ * Loads an analysis saved with save_to_file().
+ *
+ * @return The analysis, or NULL if the file does
+ *   not exist or is outdated.
+ */
+static AudioAnalysis *
+load_from_file (
+  const char * path,
+  const char * hash,
+  int          samplerate)
+{
+  if (!file_exists (path))
+    return NULL;
+
+  GKeyFile * kf = g_key_file_new ();
+  GError * err = NULL;
+  if (!g_key_file_load_from_file (
+         kf, path, G_KEY_FILE_NONE, &err))
+    {
+      g_message (
+        "failed to load analysis from %s: %s",
+        path, err->message);
+      g_error_free (err);
+      g_key_file_free (kf);
+      return NULL;
+    }
+
+  AudioAnalysis * self = NULL;
+  int version =
+    g_key_file_get_integer (
+      kf, KEY_FILE_GROUP, "version", NULL);
+  int file_samplerate =
+    g_key_file_get_integer (
+      kf, KEY_FILE_GROUP, "samplerate", NULL);
+  if (version != AUDIO_ANALYSIS_VERSION
+      || file_samplerate != samplerate)
+    {
+      goto free_key_file_and_return;
+    }
+
+  self = object_new (AudioAnalysis);
+  self->hash = g_strdup (hash);
+  self->samplerate = samplerate;
+  self->bpm =
+    (float)
+    g_key_file_get_double (
+      kf, KEY_FILE_GROUP, "bpm", NULL);
+  self->peak =
+    (float)
+    g_key_file_get_double (
+      kf, KEY_FILE_GROUP, "peak", NULL);
+  self->rms =
+    (float)
+    g_key_file_get_double (
+      kf, KEY_FILE_GROUP, "rms", NULL);
+  self->lufs =
+    (float)
+    g_key_file_get_double (
+      kf, KEY_FILE_GROUP, "lufs", NULL);
+
+  gsize size = 0;
+  double * vals =
+    g_key_file_get_double_list (
+      kf, KEY_FILE_GROUP, "bpm_candidates", &size,
+      NULL);
+  self->bpm_candidates =
+    object_new_n (MAX (size, 1), float);
+  for (gsize i = 0; i < size; i++)
+    {
+      self->bpm_candidates[i] = (float) vals[i];
+    }
+  self->num_bpm_candidates = (int) size;
+  g_free (vals);
+
+  size = 0;
+  vals =
+    g_key_file_get_double_list (
+      kf, KEY_FILE_GROUP, "onsets", &size, NULL);
+  self->onsets = doubles_to_longs (vals, size);
+  self->num_onsets = (int) size;
+  g_free (vals);
+
+  size = 0;
+  vals =
+    g_key_file_get_double_list (
+      kf, KEY_FILE_GROUP, "silence_ranges", &size,
+      NULL);
+  self->silence_ranges =
+    doubles_to_longs (vals, size);
+  self->num_silence_ranges = (int) size / 2;
+  g_free (vals);
+
+free_key_file_and_return:
+  g_key_file_free (kf);
+
+  return self;
+}
+
+/**
+ * Returns the path to save the analysis of the
+ * given hash to, or NULL if there is no project
+ * directory.
+ */
+static char *
+get_cache_path (
+  const char * hash)
+{
+  if (!PROJECT || !PROJECT->dir)
+    return NULL;
+
+  char * dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_ANALYSIS, F_NOT_BACKUP);
+  char * basename =
+    g_strdup_printf ("%s.ini", hash);
+  char * path =
+    g_build_filename (dir, basename, NULL);
+  g_free (basename);
+  g_free (dir);
+
+  return path;
+}
+
+static int
+report_result (
+  AudioAnalysisResult * result)
+{
+  result->callback (
+    result->analysis, result->user_data);
+  audio_analysis_free (result->analysis);
+  object_zero_and_free (result);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Calls the job's callback on the GTK thread.
+ */
+static void
+queue_result (
+  AudioAnalysisJob *    job,
+  const AudioAnalysis * analysis)
+{
+  if (!job->callback)
+    return;
+
+  AudioAnalysisResult * result =
+    object_new (AudioAnalysisResult);
+  result->analysis = audio_analysis_clone (analysis);
+  result->callback = job->callback;
+  result->user_data = job->user_data;
+  g_idle_add (
+    (GSourceFunc) report_result, result);
+}
+
+static void
+job_free (
+  AudioAnalysisJob * self)
+{
+  for (channels_t i = 0; i < self->channels; i++)
+    {
+      g_free_and_null (self->ch_frames[i]);
+    }
+  g_free_and_null (self->hash);
+  g_free_and_null (self->cache_path);
+
+  object_zero_and_free (self);
+}
+
+static void
+analysis_thread_func (
+  AudioAnalysisJob * job,
+  AudioAnalyzer *    self)
+{
+  AudioAnalysis * analysis = NULL;
+  if (!g_atomic_int_get (&job->cancelled))
+    {
+      g_debug (
+        "analyzing clip %s (%zu frames)...",
+        job->hash, job->num_frames);
+      analysis =
+        audio_analysis_new_from_frames (
+          job->ch_frames, job->channels,
+          job->num_frames, job->samplerate,
+          &job->cancelled);
+    }
+
+  if (analysis)
+    {
+      analysis->hash = g_strdup (job->hash);
+      if (job->cache_path)
+        {
+          char * dir =
+            io_get_dir (job->cache_path);
+          io_mkdir (dir);
+          g_free (dir);
+          save_to_file (analysis, job->cache_path);
+        }
+    }
+
+  g_mutex_lock (&self->mutex);
+  if (analysis)
+    {
+      if (!g_atomic_int_get (&job->cancelled))
+        {
+          queue_result (job, analysis);
+        }
+      /* callers only get copies so any existing
+       * (eg, other sample rate) result can be
+       * replaced */
+      g_hash_table_replace (
+        self->cache, g_strdup (analysis->hash),
+        analysis);
+    }
+  g_hash_table_remove (
+    self->jobs, GUINT_TO_POINTER (job->id));
+  g_cond_broadcast (&self->job_finished_cond);
+  g_mutex_unlock (&self->mutex);
+}
+
+AudioAnalyzer *
+audio_analyzer_new (void)
+{
+  AudioAnalyzer * self =
+    object_new (AudioAnalyzer);
+
+  self->cache =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) audio_analysis_free);
+  self->jobs =
+    g_hash_table_new_full (
+      g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) job_free);
+  self->next_job_id = 1;
+  self->analyze_imports = !ZRYTHM_TESTING;
+  g_mutex_init (&self->mutex);
+  g_cond_init (&self->job_finished_cond);
+
+  GError * err = NULL;
+  self->thread_pool =
+    g_thread_pool_new (
+      (GFunc) analysis_thread_func, self,
+      MAX ((int) g_get_num_processors () / 2, 1),
+      F_NOT_EXCLUSIVE, &err);
+  if (!self->thread_pool)
+    {
+      g_critical (
+        "failed to create analysis thread pool: %s",
+        err->message);
+      g_error_free (err);
+    }
+
+  return self;
+}
+
+/**
+ * Returns the content hash used to identify the
+ * clip's analysis.
+ */
+char *
+audio_analyzer_get_clip_hash (
+  AudioClip * clip)
+{
+  /* hash the frames instead of using the file
+   * hash so that the key stays the same before
+   * and after the clip is written to the pool */
+  XXH64_hash_t hash =
+    XXH64 (
+      clip->frames,
+      (size_t) clip->num_frames * clip->channels
+      * sizeof (float),
+      0);
+  return
+    g_strdup_printf (
+      "%016" G_GINT64_MODIFIER "x",
+      (guint64) hash);
+}
+
+/**
+ * Returns a copy of the cached analysis of the
+ * clip, or NULL if the clip was not analyzed yet.
+ *
+ * Results saved in the project are loaded on
+ * demand.
+ *
+ * The returned analysis must be free'd with
+ * audio_analysis_free().
+ */
+AudioAnalysis *
+audio_analyzer_get_cached (
+  AudioAnalyzer * self,
+  AudioClip *     clip)
+{
+  char * hash = audio_analyzer_get_clip_hash (clip);
+
+  AudioAnalysis * ret = NULL;
+  g_mutex_lock (&self->mutex);
+  AudioAnalysis * analysis =
+    g_hash_table_lookup (self->cache, hash);
+  if (analysis
+      && analysis->samplerate == clip->samplerate)
+    {
+      /* copy while locked since the entry may be
+       * replaced once unlocked */
+      ret = audio_analysis_clone (analysis);
+    }
+  g_mutex_unlock (&self->mutex);
+
+  if (!ret)
+    {
+      char * path = get_cache_path (hash);
+      if (path)
+        {
+          ret =
+            load_from_file (
+              path, hash, clip->samplerate);
+          g_free (path);
+        }
+      if (ret)
+        {
+          /* replace any stale (other sample rate)
+           * entry */
+          g_mutex_lock (&self->mutex);
+          g_hash_table_replace (
+            self->cache, g_strdup (hash),
+            audio_analysis_clone (ret));
+          g_mutex_unlock (&self->mutex);
+        }
+    }
+  g_free (hash);
+
+  return ret;
+}
+
+/**
+ * Queues the analysis of the clip.
+ *
+ * If the clip is already analyzed, the callback
+ * is still called asynchronously.
+ *
+ * The frames are copied in the calling thread,
+ * which may be any thread that owns the clip.
+ *
+ * @param callback Optional callback to call on
+ *   the GTK thread when done.
+ *
+ * @return The job ID, to be used with
+ *   audio_analyzer_cancel().
+ */
+unsigned int
+audio_analyzer_queue (
+  AudioAnalyzer *       self,
+  AudioClip *           clip,
+  AudioAnalysisCallback callback,
+  void *                user_data)
+{
+  AudioAnalysisJob * job =
+    object_new (AudioAnalysisJob);
+  job->callback = callback;
+  job->user_data = user_data;
+  g_mutex_lock (&self->mutex);
+  job->id = self->next_job_id++;
+  g_mutex_unlock (&self->mutex);
+
+  AudioAnalysis * cached =
+    audio_analyzer_get_cached (self, clip);
+  if (cached)
+    {
+      queue_result (job, cached);
+      audio_analysis_free (cached);
+      unsigned int id = job->id;
+      job_free (job);
+      return id;
+    }
+
+  /* copy the frames since the clip may be removed
+   * while analyzing */
+  job->hash = audio_analyzer_get_clip_hash (clip);
+  job->channels = clip->channels;
+  job->num_frames = (size_t) clip->num_frames;
+  job->samplerate = clip->samplerate;
+  for (channels_t i = 0; i < clip->channels; i++)
+    {
+      job->ch_frames[i] =
+        dup_array (
+          clip->ch_frames[i],
+          job->num_frames * sizeof (float));
+    }
+  job->cache_path = get_cache_path (job->hash);
+
+  g_mutex_lock (&self->mutex);
+  g_hash_table_insert (
+    self->jobs, GUINT_TO_POINTER (job->id), job);
+  g_mutex_unlock (&self->mutex);
+
+  unsigned int id = job->id;
+  GError * err = NULL;
+  if (!self->thread_pool
+      ||
+      !g_thread_pool_push (
+         self->thread_pool, job, &err))
+    {
+      /* fall back to analyzing here */
+      if (err)
+        {
+          g_message (
+            "failed to push analysis job: %s",
+            err->message);
+          g_error_free (err);
+        }
+      analysis_thread_func (job, self);
+    }
+
+  return id;
+}
+
+/**
+ * Cancels the given job if still queued or
+ * running.
+ *
+ * Its callback will not be called.
+ */
+void
+audio_analyzer_cancel (
+  AudioAnalyzer * self,
+  unsigned int    job_id)
+{
+  g_mutex_lock (&self->mutex);
+  AudioAnalysisJob * job =
+    g_hash_table_lookup (
+      self->jobs, GUINT_TO_POINTER (job_id));
+  if (job)
+    {
+      g_atomic_int_set (&job->cancelled, 1);
+    }
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * Waits for all queued jobs to finish.
+ */
+void
+audio_analyzer_wait (
+  AudioAnalyzer * self)
+{
+  g_mutex_lock (&self->mutex);
+  while (g_hash_table_size (self->jobs) > 0)
+    {
+      g_cond_wait (
+        &self->job_finished_cond, &self->mutex);
+    }
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * Cancels all jobs and frees the analyzer.
+ */
+void
+audio_analyzer_free (
+  AudioAnalyzer * self)
+{
+  g_mutex_lock (&self->mutex);
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init (&iter, self->jobs);
+  while (g_hash_table_iter_next (
+           &iter, &key, &value))
+    {
+      AudioAnalysisJob * job = value;
+      g_atomic_int_set (&job->cancelled, 1);
+    }
+  g_mutex_unlock (&self->mutex);
+
+  if (self->thread_pool)
+    {
+      g_thread_pool_free (
+        self->thread_pool, false, true);
+    }
+
+  g_hash_table_destroy (self->jobs);
+  g_hash_table_destroy (self->cache);
+  g_mutex_clear (&self->mutex);
+  g_cond_clear (&self->job_finished_cond);
+
+  object_zero_and_free (self);
+}
@@ -33,6 +33,7 @@
 #include "utils/dsp.h"
 #include "utils/error.h"
 #include "utils/flags.h"
+#include "utils/objects.h"
 #include "utils/string.h"
 #include "zrythm_app.h"
 
@@ -406,10 +407,14 @@ audio_function_apply (
   size_t num_frames =
     (size_t) (end.frames - start.frames);
 
-  /* interleaved frames */
+  /* interleaved frames (allocated on the heap
+   * since the selection can be arbitrarily
+   * long) */
   size_t channels = orig_clip->channels;
-  float src_frames[num_frames * channels];
-  float frames[num_frames * channels];
+  float * src_frames =
+    object_new_n (num_frames * channels, float);
+  float * frames =
+    object_new_n (num_frames * channels, float);
   dsp_copy (
     &frames[0],
     &orig_clip->frames[
@@ -429,7 +434,22 @@ audio_function_apply (
   g_debug (
     "num frames %zu, nudge_frames %ld",
     num_frames, nudge_frames);
-  g_return_val_if_fail (nudge_frames > 0, -1);
+  int ret = 0;
+  AudioClip * clip = NULL;
+  if (nudge_frames <= 0
+      ||
+      ((type == AUDIO_FUNCTION_NUDGE_LEFT
+        || type == AUDIO_FUNCTION_NUDGE_RIGHT)
+       && (long) num_frames <= nudge_frames)
+      || (type == AUDIO_FUNCTION_CUSTOM_PLUGIN
+          && !uri))
+    {
+      g_critical (
+        "cannot apply audio function %s",
+        audio_function_type_to_string (type));
+      ret = -1;
+      goto free_frames_and_return;
+    }
 
   switch (type)
     {
@@ -464,8 +484,6 @@ audio_function_apply (
         &frames[0], num_frames * channels);
       break;
     case AUDIO_FUNCTION_NUDGE_LEFT:
-      g_return_val_if_fail (
-        (long) num_frames > nudge_frames, -1);
       num_frames_excl_nudge =
         num_frames - (size_t) nudge_frames;
       dsp_copy (
@@ -479,8 +497,6 @@ audio_function_apply (
         nudge_frames_all_channels);
       break;
     case AUDIO_FUNCTION_NUDGE_RIGHT:
-      g_return_val_if_fail (
-        (long) num_frames > nudge_frames, -1);
       num_frames_excl_nudge =
         num_frames - (size_t) nudge_frames;
       dsp_copy (
@@ -512,7 +528,10 @@ audio_function_apply (
         tmp_clip =
           audio_clip_edit_in_ext_program (tmp_clip);
         if (!tmp_clip)
-          return -1;
+          {
+            ret = -1;
+            goto free_frames_and_return;
+          }
         dsp_copy (
           &frames[0], &tmp_clip->frames[0],
           MIN (
@@ -532,9 +551,8 @@ audio_function_apply (
       break;
     case AUDIO_FUNCTION_CUSTOM_PLUGIN:
       {
-        g_return_val_if_fail (uri, -1);
         GError * err = NULL;
-        int ret =
+        ret =
           apply_plugin (
             uri, frames, num_frames, channels, &err);
         if (ret != 0)
@@ -542,7 +560,7 @@ audio_function_apply (
             PROPAGATE_PREFIXED_ERROR (
               error, err, "%s",
               _("Failed to apply plugin"));
-            return ret;
+            goto free_frames_and_return;
           }
       }
       break;
@@ -566,7 +584,7 @@ audio_function_apply (
   g_free (tmp);
 #endif
 
-  AudioClip * clip =
+  clip =
     audio_clip_new_from_float_array (
       &frames[0], (long) num_frames,
       channels, BIT_DEPTH_32, orig_clip->name);
@@ -598,5 +616,9 @@ audio_function_apply (
 
   EVENTS_PUSH (ET_EDITOR_FUNCTION_APPLIED, NULL);
 
-  return 0;
+free_frames_and_return:
+  free (src_frames);
+  free (frames);
+
+  return ret;
 }
@@ -232,6 +232,7 @@ automation_point_set_fvalue (
     arranger_object_get_region (
       (ArrangerObject *) self);
   g_return_if_fail (region);
+  region->content_version++;
 
   /* don't set value - wait for engine to process
    * it */
@@ -297,6 +298,8 @@ automation_point_set_curviness (
     return;
 
   self->curve_opts.curviness = curviness;
+  arranger_object_bump_region_content_version (
+    (ArrangerObject *) self);
 }
 
 /**
@@ -148,6 +148,7 @@ automation_region_add_ap (
 
   /* re-sort */
   automation_region_force_sort (self);
+  self->content_version++;
 
   if (pub_events)
     {
@@ -279,6 +280,7 @@ automation_region_remove_ap (
 
   array_delete (
     self->aps, self->num_aps, ap);
+  self->content_version++;
 
   if (!freeing_region)
     {
@@ -75,6 +75,10 @@ automation_track_init_loaded (
       arranger_object_init_loaded (
         (ArrangerObject *) region);
     }
+
+  region_index_rebuild (
+    &self->region_index, self->regions,
+    self->num_regions);
 }
 
 AutomationTrack *
@@ -265,6 +269,8 @@ automation_track_insert_region (
     region->name &&
     region->id.type == REGION_TYPE_AUTOMATION);
 
+  region_index_invalidate (&self->region_index);
+
   array_double_size_if_full (
     self->regions, self->num_regions,
     self->regions_size, ZRegion *);
@@ -307,6 +313,40 @@ automation_track_get_region_before_pos (
   const Position *        pos,
   bool                    ends_after)
 {
+  if (region_index_acquire (&self->region_index))
+    {
+      const RegionIndex * index =
+        &self->region_index;
+      ZRegion * ret = NULL;
+      if (ends_after)
+        {
+          int lo, hi;
+          region_index_get_candidates (
+            index, NULL, pos->frames, pos->frames,
+            &lo, &hi);
+          for (int i = lo; i < hi; i++)
+            {
+              ZRegion * region = index->regions[i];
+              if (!region_is_hit (
+                     region, pos->frames, true))
+                continue;
+
+              /* prefer the last one in the array
+               * like below */
+              if (!ret || region->id.idx > ret->id.idx)
+                ret = region;
+            }
+        }
+      else
+        {
+          ret =
+            region_index_get_latest_ending_before (
+              index, pos->frames);
+        }
+      region_index_release (&self->region_index);
+      return ret;
+    }
+
   if (ends_after)
     {
       for (int i = self->num_regions - 1; i >= 0;
@@ -633,6 +673,20 @@ automation_track_unselect_all (
     }
 }
 
+/**
+ * Brings the region index up to date.
+ *
+ * To be called from the GTK thread.
+ */
+void
+automation_track_refresh_region_index (
+  AutomationTrack * self)
+{
+  region_index_refresh (
+    &self->region_index, self->regions,
+    self->num_regions);
+}
+
 /**
  * Removes a region from the automation track.
  */
@@ -643,6 +697,8 @@ automation_track_remove_region (
 {
   g_return_if_fail (IS_REGION (region));
 
+  region_index_invalidate (&self->region_index);
+
   array_delete (
     self->regions, self->num_regions, region);
 
@@ -968,12 +1024,18 @@ automation_track_clone (
           (ArrangerObject *) src_region);
     }
 
+  region_index_rebuild (
+    &dest->region_index, dest->regions,
+    dest->num_regions);
+
   return dest;
 }
 
 void
 automation_track_free (AutomationTrack * self)
 {
+  region_index_free_members (&self->region_index);
+
   for (int i = 0; i < self->num_regions; i++)
     {
       object_free_w_func_and_null_cast (
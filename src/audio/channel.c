@@ -39,6 +39,7 @@
 #include "audio/router.h"
 #include "audio/pan.h"
 #include "audio/port_connections_manager.h"
+#include "audio/prerenderer.h"
 #include "audio/rtmidi_device.h"
 #include "audio/track.h"
 #include "audio/track_processor.h"
@@ -375,39 +376,24 @@ disconnect_prev_next (
 }
 
 /**
- * Prepares the channel for processing.
+ * Prepares the parts of the channel before the
+ * prefader for processing.
  *
- * To be called before the main cycle each time on
- * all channels.
+ * Called by channel_prepare_process(), or by the
+ * Prerenderer when the track is rendered ahead.
  */
 void
-channel_prepare_process (Channel * self)
+channel_prepare_process_pre_fader (
+  Channel * self)
 {
-  Plugin * plugin;
-  int j;
   Track * tr = channel_get_track (self);
-  PortType out_type = tr->out_signal_type;
 
-  /* clear buffers */
   track_processor_clear_buffers (
     tr->processor);
-  fader_clear_buffers (
-    self->prefader);
-  fader_clear_buffers (self->fader);
 
-  if (out_type == TYPE_AUDIO)
-    {
-      port_clear_buffer (self->stereo_out->l);
-      port_clear_buffer (self->stereo_out->r);
-    }
-  else if (out_type == TYPE_EVENT)
+  for (int j = 0; j < STRIP_SIZE; j++)
     {
-      port_clear_buffer (self->midi_out);
-    }
-
-  for (j = 0; j < STRIP_SIZE; j++)
-    {
-      plugin = self->inserts[j];
+      Plugin * plugin = self->inserts[j];
       if (plugin)
         plugin_prepare_process (plugin);
       plugin = self->midi_fx[j];
@@ -417,11 +403,6 @@ channel_prepare_process (Channel * self)
   if (self->instrument)
     plugin_prepare_process (self->instrument);
 
-  for (int i = 0; i < STRIP_SIZE; i++)
-    {
-      channel_send_prepare_process (self->sends[i]);
-    }
-
   if (tr->in_signal_type == TYPE_EVENT)
     {
 #ifdef HAVE_RTMIDI
@@ -442,6 +423,45 @@ channel_prepare_process (Channel * self)
     }
 }
 
+/**
+ * Prepares the channel for processing.
+ *
+ * To be called before the main cycle each time on
+ * all channels.
+ */
+void
+channel_prepare_process (Channel * self)
+{
+  Track * tr = channel_get_track (self);
+  PortType out_type = tr->out_signal_type;
+
+  /* the rest is prepared by the prerenderer */
+  if (!tr->prerender || !tr->prerender->skip_nodes)
+    {
+      channel_prepare_process_pre_fader (self);
+    }
+
+  /* clear buffers */
+  fader_clear_buffers (
+    self->prefader);
+  fader_clear_buffers (self->fader);
+
+  if (out_type == TYPE_AUDIO)
+    {
+      port_clear_buffer (self->stereo_out->l);
+      port_clear_buffer (self->stereo_out->r);
+    }
+  else if (out_type == TYPE_EVENT)
+    {
+      port_clear_buffer (self->midi_out);
+    }
+
+  for (int i = 0; i < STRIP_SIZE; i++)
+    {
+      channel_send_prepare_process (self->sends[i]);
+    }
+}
+
 void
 channel_init_loaded (
   Channel * self,
@@ -96,6 +96,7 @@ chord_region_insert_chord_object (
       chord_object_set_region_and_index (
         co, self, i);
     }
+  self->content_version++;
 
   if (fire_events)
     {
@@ -162,6 +163,7 @@ chord_region_remove_chord_object (
       chord_object_set_region_and_index (
         self->chord_objects[i], self, i);
     }
+  self->content_version++;
 
   if (free)
     {
@@ -51,9 +51,58 @@ _create ()
 }
 
 /**
- * Updates the channel caches.
+ * Updates the peaks of the blocks starting from
+ * the block containing @p start_from.
+ */
+static void
+update_peaks (
+  AudioClip * self,
+  size_t      start_from)
+{
+  size_t num_frames = (size_t) self->num_frames;
+  size_t num_peaks =
+    (num_frames + AUDIO_CLIP_PEAK_BLOCK_SIZE - 1) /
+      AUDIO_CLIP_PEAK_BLOCK_SIZE;
+  self->peaks_min =
+    g_realloc (
+      self->peaks_min,
+      sizeof (float) * MAX (num_peaks, 1));
+  self->peaks_max =
+    g_realloc (
+      self->peaks_max,
+      sizeof (float) * MAX (num_peaks, 1));
+  self->num_peaks = num_peaks;
+
+  for (size_t i =
+         start_from / AUDIO_CLIP_PEAK_BLOCK_SIZE;
+       i < num_peaks; i++)
+    {
+      size_t block_start =
+        i * AUDIO_CLIP_PEAK_BLOCK_SIZE;
+      size_t block_end =
+        MIN (
+          block_start + AUDIO_CLIP_PEAK_BLOCK_SIZE,
+          num_frames);
+      float min = 0.f, max = 0.f;
+      for (size_t j = block_start * self->channels;
+           j < block_end * self->channels; j++)
+        {
+          float val = self->frames[j];
+          if (val > max)
+            max = val;
+          if (val < min)
+            min = val;
+        }
+      self->peaks_min[i] = min;
+      self->peaks_max[i] = max;
+    }
+}
+
+/**
+ * Updates the channel caches and the peaks.
  *
- * See @ref AudioClip.ch_frames.
+ * See @ref AudioClip.ch_frames and
+ * @ref AudioClip.peaks_min.
  *
  * @param start_from Frames to start from (per
  *   channel. The previous frames will be kept.
@@ -83,6 +132,230 @@ audio_clip_update_channel_caches (
             self->frames[j * self->channels + i];
         }
     }
+
+  update_peaks (self, start_from);
+}
+
+/**
+ * Gets the minimum and maximum sample value
+ * (across all channels) in the given frame range.
+ *
+ * Uses the peaks for whole blocks, so the cost
+ * does not grow with the length of the range.
+ *
+ * @param start_frame First frame (inclusive).
+ * @param end_frame Last frame (exclusive).
+ */
+void
+audio_clip_get_min_max (
+  const AudioClip * self,
+  long              start_frame,
+  long              end_frame,
+  float *           min,
+  float *           max)
+{
+  *min = 0.f;
+  *max = 0.f;
+
+  start_frame = MAX (start_frame, 0);
+  end_frame = MIN (end_frame, self->num_frames);
+
+  long j = start_frame;
+  while (j < end_frame)
+    {
+      /* use the peak if the whole block is in
+       * range */
+      size_t block =
+        (size_t) j / AUDIO_CLIP_PEAK_BLOCK_SIZE;
+      if (j % AUDIO_CLIP_PEAK_BLOCK_SIZE == 0 &&
+          j + AUDIO_CLIP_PEAK_BLOCK_SIZE <= end_frame &&
+          block < self->num_peaks)
+        {
+          *min = MIN (*min, self->peaks_min[block]);
+          *max = MAX (*max, self->peaks_max[block]);
+          j += AUDIO_CLIP_PEAK_BLOCK_SIZE;
+          continue;
+        }
+
+      for (unsigned int k = 0; k < self->channels;
+           k++)
+        {
+          float val =
+            self->frames[
+              j * (long) self->channels + (long) k];
+          if (val > *max)
+            *max = val;
+          if (val < *min)
+            *min = val;
+        }
+      j++;
+    }
+}
+
+/**
+ * Sets the bit depth and whether to use FLAC
+ * based on the bit depth of the source file.
+ */
+static void
+set_bit_depth (
+  AudioClip * self,
+  int         bit_depth)
+{
+  switch (bit_depth)
+    {
+    case 16:
+      self->bit_depth = BIT_DEPTH_16;
+      self->use_flac = true;
+      break;
+    case 24:
+      self->bit_depth = BIT_DEPTH_24;
+      self->use_flac = true;
+      break;
+    case 32:
+      self->bit_depth = BIT_DEPTH_32;
+      self->use_flac = false;
+      break;
+    default:
+      g_debug (
+        "unknown bit depth: %d", bit_depth);
+      self->bit_depth = BIT_DEPTH_32;
+      self->use_flac = false;
+    }
+}
+
+/**
+ * Decodes the file chunk by chunk directly into
+ * the clip's buffers, avoiding intermediate
+ * copies of the whole file.
+ *
+ * @return Whether successful. If false, the file
+ *   must be decoded with an AudioEncoder instead.
+ */
+static bool
+init_from_stream (
+  AudioClip *  self,
+  const char * full_path)
+{
+  AudioEncoderStream * stream =
+    audio_encoder_stream_new (
+      full_path, self->samplerate,
+      AUDIO_ENCODER_STREAM_DEFAULT_CHUNK_SIZE);
+  if (!stream)
+    return false;
+
+  const channels_t channels = stream->channels;
+  size_t size =
+    MAX (
+      audio_encoder_stream_get_num_frames_estimate (
+        stream), 1);
+  sample_t * frames =
+    g_malloc_n (size * channels, sizeof (sample_t));
+  sample_t * ch_frames[16];
+  for (channels_t i = 0; i < channels; i++)
+    {
+      ch_frames[i] =
+        g_malloc_n (size, sizeof (sample_t));
+    }
+
+  size_t num_frames = 0;
+  float ** chunk;
+  ssize_t chunk_frames;
+  while ((chunk_frames =
+            audio_encoder_stream_read (
+              stream, &chunk)) > 0)
+    {
+      size_t new_num_frames =
+        num_frames + (size_t) chunk_frames;
+      if (new_num_frames > size)
+        {
+          /* the estimate may be slightly off after
+           * resampling */
+          size =
+            MAX (new_num_frames, size + size / 8);
+          frames =
+            g_realloc_n (
+              frames, size * channels,
+              sizeof (sample_t));
+          for (channels_t i = 0; i < channels; i++)
+            {
+              ch_frames[i] =
+                g_realloc_n (
+                  ch_frames[i], size,
+                  sizeof (sample_t));
+            }
+        }
+
+      for (channels_t i = 0; i < channels; i++)
+        {
+          dsp_copy (
+            &ch_frames[i][num_frames], chunk[i],
+            (size_t) chunk_frames);
+          for (size_t j = 0;
+               j < (size_t) chunk_frames; j++)
+            {
+              frames[(num_frames + j) * channels + i] =
+                chunk[i][j];
+            }
+        }
+      num_frames = new_num_frames;
+    }
+
+  if (chunk_frames < 0 || num_frames == 0)
+    {
+      g_message (
+        "failed to stream %s, falling back to "
+        "decoding the whole file", full_path);
+      g_free (frames);
+      for (channels_t i = 0; i < channels; i++)
+        {
+          g_free (ch_frames[i]);
+        }
+      audio_encoder_stream_free (stream);
+      return false;
+    }
+
+  if (size > num_frames)
+    {
+      frames =
+        g_realloc_n (
+          frames, num_frames * channels,
+          sizeof (sample_t));
+      for (channels_t i = 0; i < channels; i++)
+        {
+          ch_frames[i] =
+            g_realloc_n (
+              ch_frames[i], num_frames,
+              sizeof (sample_t));
+        }
+    }
+
+  g_free (self->frames);
+  self->frames = frames;
+  self->num_frames = (long) num_frames;
+  for (channels_t i = 0; i < self->channels; i++)
+    {
+      g_free_and_null (self->ch_frames[i]);
+    }
+  for (channels_t i = 0; i < channels; i++)
+    {
+      self->ch_frames[i] = ch_frames[i];
+    }
+  self->channels = channels;
+  g_free_and_null (self->name);
+  char * basename = g_path_get_basename (full_path);
+  self->name = io_file_strip_ext (basename);
+  g_free (basename);
+  self->bpm =
+    tempo_track_get_current_bpm (P_TEMPO_TRACK);
+  set_bit_depth (self, stream->bit_depth);
+
+  /* the channel caches were filled while
+   * decoding */
+  update_peaks (self, 0);
+
+  audio_encoder_stream_free (stream);
+
+  return true;
 }
 
 static void
@@ -96,6 +369,9 @@ audio_clip_init_from_file (
     (int) AUDIO_ENGINE->sample_rate;
   g_return_if_fail (self->samplerate > 0);
 
+  if (init_from_stream (self, full_path))
+    return;
+
   AudioEncoder * enc =
     audio_encoder_new_from_file (full_path);
   audio_encoder_decode (
@@ -117,26 +393,7 @@ audio_clip_init_from_file (
   self->channels = enc->nfo.channels;
   self->bpm =
     tempo_track_get_current_bpm (P_TEMPO_TRACK);
-  switch (enc->nfo.bit_depth)
-    {
-    case 16:
-      self->bit_depth = BIT_DEPTH_16;
-      self->use_flac = true;
-      break;
-    case 24:
-      self->bit_depth = BIT_DEPTH_24;
-      self->use_flac = true;
-      break;
-    case 32:
-      self->bit_depth = BIT_DEPTH_32;
-      self->use_flac = false;
-      break;
-    default:
-      g_debug (
-        "unknown bit depth: %d", enc->nfo.bit_depth);
-      self->bit_depth = BIT_DEPTH_32;
-      self->use_flac = false;
-    }
+  set_bit_depth (self, enc->nfo.bit_depth);
   /*g_message (*/
     /*"\n\n num frames %ld \n\n", self->num_frames);*/
   audio_clip_update_channel_caches (self, 0);
@@ -414,7 +671,7 @@ audio_clip_write_to_pool (
             path_in_main_project, new_path);
 
           if (file_reflink (
-                path_in_main_project, new_path) != 0)
+                new_path, path_in_main_project) != 0)
             {
               g_message (
                 "failed to reflink, copying "
@@ -445,6 +702,10 @@ audio_clip_write_to_pool (
                     err->message);
                 }
             } /* endif reflink fail */
+          else
+            {
+              need_new_write = false;
+            }
         }
     }
 
@@ -793,6 +1054,10 @@ audio_clip_free (
       object_zero_and_free_if_nonnull (
         self->ch_frames[i]);
     }
+  object_zero_and_free_if_nonnull (
+    self->peaks_min);
+  object_zero_and_free_if_nonnull (
+    self->peaks_max);
   g_free_and_null (self->name);
   g_free_and_null (self->file_hash);
 
@@ -22,13 +22,18 @@
 #include "audio/control_port.h"
 #include "audio/engine.h"
 #include "audio/port.h"
+#include "audio/router.h"
+#include "audio/sample_processor.h"
+#include "audio/tempo_track.h"
 #include "audio/track.h"
+#include "audio/tracklist.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "plugins/plugin.h"
 #include "project.h"
 #include "utils/flags.h"
 #include "utils/math.h"
+#include "utils/objects.h"
 #include "zrythm.h"
 #include "zrythm_app.h"
 
@@ -104,6 +109,42 @@ control_port_set_real_val_w_events (
     F_PUBLISH_EVENTS);
 }
 
+/**
+ * Sets the real value of the control from the GTK
+ * thread.
+ *
+ * If the engine is running, the change is queued
+ * and applied at the start of the next processing
+ * cycle, otherwise it is applied immediately.
+ */
+void
+control_port_queue_real_val (
+  Port * self,
+  float  val,
+  bool   forward_event)
+{
+  g_return_if_fail (IS_PORT (self));
+
+  if (!port_is_in_active_project (self)
+      || !engine_get_run (AUDIO_ENGINE))
+    {
+      port_set_control_value (
+        self, val, F_NOT_NORMALIZED,
+        forward_event);
+      return;
+    }
+
+  ControlPortChange change = { 0 };
+  control_port_change_set_port (&change, self);
+  change.real_val = val;
+  change.forward_event = forward_event;
+
+  /* dropped changes are accounted for by the
+   * router */
+  router_queue_control_port_change (
+    ROUTER, &change);
+}
+
 void
 control_port_set_toggled (
   Port * self,
@@ -437,3 +478,297 @@ control_port_set_val_from_normalized (
       g_return_if_reached ();
     }
 }
+
+/**
+ * Sets the port the change is for.
+ */
+void
+control_port_change_set_port (
+  ControlPortChange * self,
+  const Port *        port)
+{
+  /* shallow copy without the strings, which may
+   * be freed with the port */
+  self->port_id = port->id;
+  self->port_id.label = NULL;
+  self->port_id.sym = NULL;
+  self->port_id.uri = NULL;
+  self->port_id.comment = NULL;
+  self->port_id.port_group = NULL;
+  self->port_id.ext_port_id = NULL;
+  self->has_port_id = true;
+}
+
+/**
+ * Creates a new empty batch of control port
+ * changes.
+ */
+ControlPortChangeBatch *
+control_port_change_batch_new (void)
+{
+  ControlPortChangeBatch * self =
+    object_new (ControlPortChangeBatch);
+
+  return self;
+}
+
+/**
+ * Returns whether the 2 changes are for the same
+ * port.
+ */
+static bool
+changes_have_same_target (
+  const ControlPortChange * a,
+  const ControlPortChange * b)
+{
+  if (a->has_port_id || b->has_port_id)
+    {
+      if (!a->has_port_id || !b->has_port_id)
+        return false;
+
+      const PortIdentifier * id_a = &a->port_id;
+      const PortIdentifier * id_b = &b->port_id;
+      return
+        id_a->owner_type == id_b->owner_type
+        && id_a->type == id_b->type
+        && id_a->flow == id_b->flow
+        && id_a->flags == id_b->flags
+        && id_a->flags2 == id_b->flags2
+        && id_a->track_name_hash ==
+             id_b->track_name_hash
+        && id_a->port_index == id_b->port_index
+        && (id_a->owner_type !=
+              PORT_OWNER_TYPE_PLUGIN
+            || plugin_identifier_is_equal (
+                 &id_a->plugin_id,
+                 &id_b->plugin_id));
+    }
+
+  return
+    a->flag1 == b->flag1 && a->flag2 == b->flag2;
+}
+
+/**
+ * Adds a change to the batch, replacing the value
+ * of any previous change for the same port.
+ *
+ * @return Whether the change was added (false if
+ *   the batch is full).
+ */
+bool
+control_port_change_batch_add (
+  ControlPortChangeBatch *  self,
+  const ControlPortChange * change)
+{
+  if (self->header.num_changes == 0)
+    {
+      self->header.timestamp =
+        g_get_monotonic_time ();
+    }
+
+  /* coalesce */
+  for (int i = 0; i < self->header.num_changes;
+       i++)
+    {
+      ControlPortChange * existing =
+        &self->changes[i];
+      if (changes_have_same_target (
+            existing, change))
+        {
+          *existing = *change;
+          return true;
+        }
+    }
+
+  if (self->header.num_changes ==
+        CONTROL_PORT_CHANGE_BATCH_MAX_CHANGES)
+    {
+      return false;
+    }
+
+  self->changes[self->header.num_changes++] =
+    *change;
+
+  return true;
+}
+
+/**
+ * Convenience wrapper over
+ * control_port_change_batch_add() for setting the
+ * real value of a port.
+ */
+bool
+control_port_change_batch_add_port_val (
+  ControlPortChangeBatch * self,
+  Port *                   port,
+  float                    real_val,
+  bool                     forward_event)
+{
+  ControlPortChange change = { 0 };
+  control_port_change_set_port (&change, port);
+  change.real_val = real_val;
+  change.forward_event = forward_event;
+
+  return
+    control_port_change_batch_add (self, &change);
+}
+
+/**
+ * Removes all changes from the batch.
+ */
+void
+control_port_change_batch_clear (
+  ControlPortChangeBatch * self)
+{
+  self->header.num_changes = 0;
+  self->header.timestamp = 0;
+}
+
+/**
+ * Returns the control port with the given
+ * identifier, or NULL if it was removed after the
+ * change was queued.
+ *
+ * Unlike port_find_from_identifier(), this does
+ * not log anything if the owner is missing.
+ */
+static Port *
+find_port (
+  const PortIdentifier * id)
+{
+  switch (id->owner_type)
+    {
+    case PORT_OWNER_TYPE_AUDIO_ENGINE:
+    case PORT_OWNER_TYPE_HW:
+    case PORT_OWNER_TYPE_TRANSPORT:
+      break;
+    case PORT_OWNER_TYPE_FADER:
+      if (id->flags2 &
+            (PORT_FLAG2_MONITOR_FADER
+             | PORT_FLAG2_SAMPLE_PROCESSOR_FADER))
+        break;
+      /* fallthrough */
+    default:
+      {
+        Track * tr =
+          tracklist_find_track_by_name_hash (
+            TRACKLIST, id->track_name_hash);
+        if (!tr)
+          {
+            tr =
+              tracklist_find_track_by_name_hash (
+                SAMPLE_PROCESSOR->tracklist,
+                id->track_name_hash);
+          }
+        if (!tr)
+          return NULL;
+
+        if (id->owner_type ==
+              PORT_OWNER_TYPE_PLUGIN)
+          {
+            const PluginIdentifier * pl_id =
+              &id->plugin_id;
+            Plugin * pl = NULL;
+            switch (pl_id->slot_type)
+              {
+              case PLUGIN_SLOT_MIDI_FX:
+                pl =
+                  tr->channel ?
+                    tr->channel->midi_fx[
+                      pl_id->slot] : NULL;
+                break;
+              case PLUGIN_SLOT_INSTRUMENT:
+                pl =
+                  tr->channel ?
+                    tr->channel->instrument : NULL;
+                break;
+              case PLUGIN_SLOT_INSERT:
+                pl =
+                  tr->channel ?
+                    tr->channel->inserts[
+                      pl_id->slot] : NULL;
+                break;
+              case PLUGIN_SLOT_MODULATOR:
+                pl =
+                  pl_id->slot < tr->num_modulators ?
+                    tr->modulators[pl_id->slot] :
+                    NULL;
+                break;
+              default:
+                break;
+              }
+            if (!pl
+                || id->flow != FLOW_INPUT
+                || id->port_index < 0
+                || id->port_index >= pl->num_in_ports)
+              return NULL;
+          }
+      }
+      break;
+    }
+
+  Port * port = port_find_from_identifier (id);
+  if (!port || port->id.type != TYPE_CONTROL)
+    return NULL;
+
+  return port;
+}
+
+/**
+ * Applies the given change.
+ *
+ * To be called at the start of a processing cycle
+ * (or while the engine is not running).
+ *
+ * @param timestamp Time of the change, see
+ *   ControlPortChangeBatchHeader.timestamp.
+ */
+void
+control_port_change_apply (
+  const ControlPortChange * change,
+  gint64                    timestamp)
+{
+  if (change->flag1 & PORT_FLAG_BPM)
+    {
+      tempo_track_set_bpm (
+        P_TEMPO_TRACK, change->real_val, 0.f,
+        true, F_PUBLISH_EVENTS);
+    }
+  else if (change->flag2 &
+             PORT_FLAG2_BEATS_PER_BAR)
+    {
+      tempo_track_set_beats_per_bar (
+        P_TEMPO_TRACK, change->ival);
+    }
+  else if (change->flag2 & PORT_FLAG2_BEAT_UNIT)
+    {
+      tempo_track_set_beat_unit_from_enum (
+        P_TEMPO_TRACK, change->beat_unit);
+    }
+  else if (change->has_port_id)
+    {
+      Port * port = find_port (&change->port_id);
+      if (!port)
+        return;
+
+      gint64 prev_last_change = port->last_change;
+      port_set_control_value (
+        port, change->real_val, F_NOT_NORMALIZED,
+        change->forward_event);
+
+      /* use the time the change was made instead
+       * of the time it was applied */
+      if (timestamp > 0
+          && port->last_change != prev_last_change)
+        {
+          port->last_change = timestamp;
+        }
+    }
+}
+
+void
+control_port_change_batch_free (
+  ControlPortChangeBatch * self)
+{
+  object_zero_and_free (self);
+}
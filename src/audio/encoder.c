@@ -19,6 +19,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "zrythm-config.h"
 #include "audio/encoder.h"
@@ -116,3 +117,303 @@ audio_encoder_free (
 
   free (self);
 }
+
+/**
+ * Opens the given file for streaming decoding.
+ *
+ * @param samplerate Sample rate to resample to.
+ * @param chunk_size Number of frames per chunk.
+ *
+ * @return The stream, or NULL if the file cannot
+ *   be streamed, in which case AudioEncoder should
+ *   be used instead.
+ */
+AudioEncoderStream *
+audio_encoder_stream_new (
+  const char * filepath,
+  int          samplerate,
+  size_t       chunk_size)
+{
+  g_return_val_if_fail (
+    samplerate > 0 && chunk_size > 0, NULL);
+
+  SF_INFO sfinfo;
+  memset (&sfinfo, 0, sizeof (SF_INFO));
+  SNDFILE * sndfile =
+    sf_open (filepath, SFM_READ, &sfinfo);
+  if (!sndfile)
+    {
+      g_debug (
+        "cannot stream %s: %s", filepath,
+        sf_strerror (NULL));
+      return NULL;
+    }
+
+  int major_format =
+    sfinfo.format & SF_FORMAT_TYPEMASK;
+  if (sfinfo.channels <= 0
+      || sfinfo.channels > 16
+      || sfinfo.samplerate <= 0
+#ifdef SF_FORMAT_MPEG
+      /* leave compressed formats with encoder
+       * delay handling to audec so that the
+       * number of frames stays the same */
+      || major_format == SF_FORMAT_MPEG
+#endif
+      || sfinfo.frames <= 0)
+    {
+      g_debug (
+        "cannot stream %s (format 0x%x)",
+        filepath, major_format);
+      sf_close (sndfile);
+      return NULL;
+    }
+
+  AudioEncoderStream * self =
+    object_new (AudioEncoderStream);
+  self->file = g_strdup (filepath);
+  self->sndfile = sndfile;
+  self->sfinfo = sfinfo;
+  self->channels = (unsigned int) sfinfo.channels;
+  self->chunk_size = chunk_size;
+
+  switch (sfinfo.format & SF_FORMAT_SUBMASK)
+    {
+    case SF_FORMAT_PCM_16:
+      self->bit_depth = 16;
+      break;
+    case SF_FORMAT_PCM_24:
+      self->bit_depth = 24;
+      break;
+    case SF_FORMAT_PCM_32:
+    case SF_FORMAT_FLOAT:
+      self->bit_depth = 32;
+      break;
+    default:
+      self->bit_depth = 0;
+      break;
+    }
+
+  self->src_ratio =
+    (double) samplerate /
+    (double) sfinfo.samplerate;
+  if (sfinfo.samplerate != samplerate)
+    {
+      int err = 0;
+      self->src_state =
+        src_new (
+          SRC_SINC_BEST_QUALITY,
+          sfinfo.channels, &err);
+      if (!self->src_state)
+        {
+          g_message (
+            "failed to create resampler: %s",
+            src_strerror (err));
+          audio_encoder_stream_free (self);
+          return NULL;
+        }
+
+      /* read enough input to fill about one
+       * output chunk */
+      self->in_chunk_size =
+        MAX (
+          (size_t)
+          ceil (
+            (double) chunk_size /
+            self->src_ratio),
+          1);
+    }
+  else
+    {
+      self->in_chunk_size = chunk_size;
+    }
+
+  self->in_buf =
+    object_new_n (
+      self->in_chunk_size * self->channels,
+      float);
+  self->out_buf =
+    object_new_n (
+      chunk_size * self->channels, float);
+  for (unsigned int i = 0; i < self->channels; i++)
+    {
+      self->ch_bufs[i] =
+        object_new_n (chunk_size, float);
+    }
+
+  return self;
+}
+
+/**
+ * Returns the estimated number of frames per
+ * channel the stream will return.
+ */
+size_t
+audio_encoder_stream_get_num_frames_estimate (
+  AudioEncoderStream * self)
+{
+  return
+    (size_t)
+    ceil (
+      (double) self->sfinfo.frames *
+      self->src_ratio);
+}
+
+/**
+ * Reads the next input chunk into the input
+ * buffer if it is empty.
+ *
+ * @return Whether successful.
+ */
+static bool
+fill_input (
+  AudioEncoderStream * self)
+{
+  if (self->in_buf_frames > 0 || self->input_done)
+    return true;
+
+  sf_count_t read =
+    sf_readf_float (
+      self->sndfile, self->in_buf,
+      (sf_count_t) self->in_chunk_size);
+  if (read < 0)
+    {
+      g_message (
+        "error reading %s: %s", self->file,
+        sf_strerror (self->sndfile));
+      return false;
+    }
+
+  self->in_buf_pos = 0;
+  self->in_buf_frames = (size_t) read;
+  if ((size_t) read < self->in_chunk_size)
+    {
+      self->input_done = true;
+    }
+
+  return true;
+}
+
+/**
+ * Decodes and resamples the next chunk.
+ *
+ * @param[out] ch_frames Set to an array of
+ *   AudioEncoderStream.channels planar buffers
+ *   holding the chunk. They remain valid until the
+ *   next call.
+ *
+ * @return The number of frames per channel in the
+ *   chunk, 0 at the end of the file or -1 if an
+ *   error occurred.
+ */
+ssize_t
+audio_encoder_stream_read (
+  AudioEncoderStream * self,
+  float ***            ch_frames)
+{
+  const unsigned int channels = self->channels;
+  size_t out_frames = 0;
+  while (out_frames < self->chunk_size
+         && !self->finished)
+    {
+      if (!fill_input (self))
+        return -1;
+
+      if (!self->src_state)
+        {
+          /* no resampling needed */
+          size_t to_copy =
+            MIN (
+              self->in_buf_frames,
+              self->chunk_size - out_frames);
+          memcpy (
+            &self->out_buf[out_frames * channels],
+            &self->in_buf[
+              self->in_buf_pos * channels],
+            to_copy * channels * sizeof (float));
+          self->in_buf_pos += to_copy;
+          self->in_buf_frames -= to_copy;
+          out_frames += to_copy;
+          if (self->input_done
+              && self->in_buf_frames == 0)
+            {
+              self->finished = true;
+            }
+          continue;
+        }
+
+      SRC_DATA data = {
+        .data_in =
+          &self->in_buf[
+            self->in_buf_pos * channels],
+        .input_frames =
+          (long) self->in_buf_frames,
+        .data_out =
+          &self->out_buf[out_frames * channels],
+        .output_frames =
+          (long) (self->chunk_size - out_frames),
+        .end_of_input = self->input_done,
+        .src_ratio = self->src_ratio,
+      };
+      int err =
+        src_process (self->src_state, &data);
+      if (err)
+        {
+          g_message (
+            "error resampling %s: %s", self->file,
+            src_strerror (err));
+          return -1;
+        }
+
+      self->in_buf_pos +=
+        (size_t) data.input_frames_used;
+      self->in_buf_frames -=
+        (size_t) data.input_frames_used;
+      out_frames +=
+        (size_t) data.output_frames_gen;
+
+      /* the resampler is flushed once it stops
+       * generating frames after the end of the
+       * input */
+      if (self->input_done
+          && self->in_buf_frames == 0
+          && data.output_frames_gen == 0)
+        {
+          self->finished = true;
+        }
+    }
+
+  /* deinterleave */
+  for (unsigned int i = 0; i < channels; i++)
+    {
+      float * ch_buf = self->ch_bufs[i];
+      for (size_t j = 0; j < out_frames; j++)
+        {
+          ch_buf[j] =
+            self->out_buf[j * channels + i];
+        }
+    }
+
+  *ch_frames = self->ch_bufs;
+  return (ssize_t) out_frames;
+}
+
+void
+audio_encoder_stream_free (
+  AudioEncoderStream * self)
+{
+  if (self->src_state)
+    src_delete (self->src_state);
+  if (self->sndfile)
+    sf_close (self->sndfile);
+  object_zero_and_free_if_nonnull (self->in_buf);
+  object_zero_and_free_if_nonnull (self->out_buf);
+  for (unsigned int i = 0; i < self->channels; i++)
+    {
+      object_zero_and_free_if_nonnull (
+        self->ch_bufs[i]);
+    }
+  g_free_and_null (self->file);
+
+  object_zero_and_free (self);
+}
@@ -66,11 +66,14 @@
 #include "audio/midi_event.h"
 #include "audio/midi_mapping.h"
 #include "audio/pool.h"
+#include "audio/prerenderer.h"
 #include "audio/recording_manager.h"
 #include "audio/router.h"
 #include "audio/sample_playback.h"
 #include "audio/sample_processor.h"
 #include "audio/tempo_track.h"
+#include "audio/track.h"
+#include "audio/tracklist.h"
 #include "audio/transport.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
@@ -81,11 +84,13 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/cpu_affinity.h"
 #include "utils/dsp.h"
 #include "utils/flags.h"
 #include "utils/mpmc_queue.h"
 #include "utils/object_pool.h"
 #include "utils/objects.h"
+#include "utils/rt_memory.h"
 #include "utils/string.h"
 #include "utils/ui.h"
 #include "zrythm.h"
@@ -138,6 +143,64 @@ engine_set_buffer_size (
 #endif
 }
 
+/**
+ * Returns the frame offset of MIDI input that
+ * arrived at the given monotonic time (in
+ * microseconds), relative to the given period
+ * start.
+ *
+ * Hardware MIDI input is played back one period
+ * after it arrived, at the same offset, so that
+ * events keep their relative timing instead of
+ * being quantized to the start of the cycle they
+ * were received in.
+ *
+ * @param period_start Monotonic time of the
+ *   start of the period the event arrived in.
+ * @param nframes Number of frames in the cycle
+ *   the event is played in. The result is clamped
+ *   to it.
+ */
+midi_time_t
+engine_get_input_frame_offset (
+  const AudioEngine * self,
+  gint64              period_start,
+  gint64              timestamp,
+  nframes_t           nframes)
+{
+  if (nframes == 0 || timestamp <= period_start)
+    return 0;
+
+  gint64 offset =
+    ((timestamp - period_start) *
+       (gint64) self->sample_rate) / 1000000;
+
+  /* late events (eg, if the previous cycle was
+   * delayed) are played at the end of the cycle
+   * to keep their order */
+  return
+    (midi_time_t)
+    MIN (offset, (gint64) nframes - 1);
+}
+
+/**
+ * Returns the monotonic time at the start of the
+ * period before the current cycle, to be used with
+ * engine_get_input_frame_offset() for input
+ * received until the start of the current cycle.
+ */
+gint64
+engine_get_previous_period_start (
+  const AudioEngine * self)
+{
+  /* use the nominal period rather than the
+   * previous cycle's start time, which is subject
+   * to scheduling jitter */
+  return
+    self->timestamp_start -
+    (self->timestamp_end - self->timestamp_start);
+}
+
 /**
  * Updates frames per tick based on the time sig,
  * the BPM, and the sample rate
@@ -257,6 +320,24 @@ clean_duplicates_and_copy (
     }
 }
 
+/**
+ * Brings the region indices of the tracks in the
+ * given tracklist up to date.
+ */
+static void
+refresh_region_indices (
+  Tracklist * tracklist)
+{
+  if (!tracklist)
+    return;
+
+  for (int i = 0; i < tracklist->num_tracks; i++)
+    {
+      track_refresh_region_indices (
+        tracklist->tracks[i]);
+    }
+}
+
 /**
  * GSourceFunc to be added using idle add.
  *
@@ -363,6 +444,19 @@ engine_process_events (
       engine_resume (self, &state);
     }
 
+  /* rebuild the region indices used during
+   * processing if regions moved */
+  if (self->project)
+    {
+      refresh_region_indices (
+        self->project->tracklist);
+    }
+  if (self->sample_processor)
+    {
+      refresh_region_indices (
+        self->sample_processor->tracklist);
+    }
+
   self->last_events_processed =
     g_get_monotonic_time ();
 
@@ -929,6 +1023,27 @@ init_common (
     (size_t)
     ENGINE_MAX_EVENTS *
       sizeof (AudioEngineEvent *));
+
+  int rt_memory_size =
+    ZRYTHM_TESTING
+    ? 8
+    :
+    g_settings_get_int (
+      S_P_GENERAL_ENGINE, "rt-memory-size");
+  if (rt_memory_size > 0)
+    {
+      self->rt_arena =
+        rt_arena_new (
+          (size_t) rt_memory_size * 1024 * 1024,
+          true);
+    }
+
+  self->anticipative_rendering =
+    ZRYTHM_TESTING
+    ? false
+    :
+    g_settings_get_boolean (
+      S_P_GENERAL_ENGINE, "anticipative-rendering");
 }
 
 void
@@ -1129,6 +1244,14 @@ engine_wait_for_pause (
 
   g_message ("cycle finished");
 
+  /* take back the tracks being rendered ahead */
+  if (self->router && self->router->graph
+      && self->router->graph->prerenderer)
+    {
+      prerenderer_release_all (
+        self->router->graph->prerenderer);
+    }
+
   if (PROJECT->loaded)
     {
 #if 0
@@ -1234,6 +1357,22 @@ engine_activate (
 
       engine_realloc_port_buffers (
         self, self->block_length);
+
+      object_free_w_func_and_null (
+        g_array_unref, self->audio_thread_cpus);
+      self->audio_thread_cpus =
+        cpu_affinity_get_rt_cpus_from_settings (
+          "audio-thread-cpus");
+      g_atomic_int_set (
+        &self->audio_thread_prepared, 0);
+
+      if (!ZRYTHM_TESTING
+          &&
+          g_settings_get_boolean (
+            S_P_GENERAL_ENGINE, "lock-all-memory"))
+        {
+          rt_memory_lock_all ();
+        }
     }
   else
     {
@@ -1248,6 +1387,16 @@ engine_activate (
       engine_wait_for_pause (self, &state, true);
 
       self->activated = false;
+
+      int num_rt_allocs =
+        rt_memory_get_num_rt_allocations ();
+      if (num_rt_allocs > 0)
+        {
+          g_message (
+            "%d allocations were made from "
+            "realtime threads",
+            num_rt_allocs);
+        }
     }
 
   if (!activate)
@@ -1548,6 +1697,15 @@ engine_process_prepare (
   sample_processor_prepare_process (
     self->sample_processor, nframes);
 
+  /* decide which tracks are rendered ahead
+   * before preparing their channels */
+  if (self->router->graph
+      && self->router->graph->prerenderer)
+    {
+      prerenderer_prepare_cycle (
+        self->router->graph->prerenderer, nframes);
+    }
+
   /* prepare channels for this cycle */
   Channel * ch;
   for (int i = 0; i < TRACKLIST->num_tracks; i++)
@@ -1616,6 +1774,26 @@ engine_process (
   /*g_message ("processing...");*/
   g_atomic_int_set (&self->cycle_running, 1);
 
+  /* the backend thread may have been created by
+   * a housekeeping thread and inherited its
+   * affinity, so pin it once */
+  if (G_UNLIKELY (
+        !g_atomic_int_get (
+          &self->audio_thread_prepared)))
+    {
+      if (self->audio_thread_cpus)
+        {
+          cpu_affinity_pin_current_thread (
+            (int *) self->audio_thread_cpus->data,
+            self->audio_thread_cpus->len);
+        }
+      rt_memory_prefault_stack (
+        RT_MEMORY_STACK_PREFAULT_SIZE);
+      rt_memory_set_thread_realtime (true);
+      g_atomic_int_set (
+        &self->audio_thread_prepared, 1);
+    }
+
   /* calculate timestamps (used for synchronizing
    * external events like Windows MME MIDI) */
   self->timestamp_start =
@@ -1856,6 +2034,14 @@ finalize_processing:
     self, total_frames_remaining,
     total_frames_to_process);
 
+  if (self->router->graph
+      && self->router->graph->prerenderer)
+    {
+      prerenderer_finish_cycle (
+        self->router->graph->prerenderer,
+        total_frames_to_process);
+    }
+
   self->cycle++;
 
   g_atomic_int_set (&self->cycle_running, 0);
@@ -2253,6 +2439,8 @@ engine_free (
     object_pool_free, self->ev_pool);
   object_free_w_func_and_null (
     mpmc_queue_free, self->ev_queue);
+  object_free_w_func_and_null (
+    rt_arena_free_arena, self->rt_arena);
 
   object_free_w_func_and_null (
     hardware_processor_free,
@@ -2261,6 +2449,9 @@ engine_free (
     hardware_processor_free,
     self->hw_out_processor);
 
+  object_free_w_func_and_null (
+    g_array_unref, self->audio_thread_cpus);
+
   object_zero_and_free (self);
 
   g_debug ("finished freeing engine");
@@ -242,14 +242,22 @@ on_midi_event (
   snd_seq_event_t *ev;
   Port * port;
 
-  uint32_t time = 0;
-
   do
     {
       /* get alsa seq event */
       snd_seq_event_input (
         self->seq_handle, &ev);
 
+      /* the queued events are dequeued at the
+       * start of the next cycle, so place the
+       * event at the offset it arrived at in the
+       * current one */
+      midi_time_t time =
+        engine_get_input_frame_offset (
+          self, self->timestamp_start,
+          g_get_monotonic_time (),
+          self->block_length);
+
       /* find the zrythm port by the alsa seq
        * port ID */
       port =
@@ -271,7 +279,7 @@ on_midi_event (
             port->midi_events, 1,
             (midi_byte_t)
             ev->data.control.value,
-            time++, 1);
+            time, 1);
           break;
         case SND_SEQ_EVENT_CONTROLLER:
           g_message ("modulation %d",
@@ -280,7 +288,7 @@ on_midi_event (
             port->midi_events,
             1, (midi_byte_t) ev->data.control.param,
             (midi_byte_t) ev->data.control.value,
-            time++, 1);
+            time, 1);
           break;
         case SND_SEQ_EVENT_NOTEON:
           g_message ("note on: note %d vel %d",
@@ -293,7 +301,7 @@ on_midi_event (
             port->midi_events,
             1, ev->data.note.note,
             ev->data.note.velocity,
-            time++, 1);
+            time, 1);
           break;
         case SND_SEQ_EVENT_NOTEOFF:
           g_message ("note off: note %d",
@@ -301,7 +309,7 @@ on_midi_event (
           midi_events_add_note_off (
             port->midi_events,
             1, ev->data.note.note,
-            time++, 1);
+            time, 1);
           /* FIXME passing ticks, should pass
            * frames */
           break;
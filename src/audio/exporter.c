@@ -43,6 +43,7 @@
 #include "utils/io.h"
 #include "utils/math.h"
 #include "utils/objects.h"
+#include "utils/string.h"
 #include "utils/ui.h"
 #include "zrythm_app.h"
 
@@ -102,6 +103,37 @@ exporter_stringize_audio_format (
   g_return_val_if_reached (NULL);
 }
 
+/**
+ * Returns the audio format for the given file
+ * extension (case insensitive), or
+ * NUM_AUDIO_FORMATS if unknown.
+ *
+ * "ogg" is parsed as Vorbis and "opus" as Opus.
+ */
+AudioFormat
+exporter_get_audio_format_from_extension (
+  const char * extension)
+{
+  if (string_is_equal_ignore_case (
+        extension, "opus"))
+    return AUDIO_FORMAT_OGG_OPUS;
+  if (string_is_equal_ignore_case (
+        extension, "midi"))
+    return AUDIO_FORMAT_MIDI;
+
+  for (int i = 0; i < NUM_AUDIO_FORMATS; i++)
+    {
+      /* Vorbis comes first */
+      if (string_is_equal_ignore_case (
+            extension,
+            exporter_stringize_audio_format (
+              (AudioFormat) i, true)))
+        return (AudioFormat) i;
+    }
+
+  return NUM_AUDIO_FORMATS;
+}
+
 static int
 export_audio (
   ExportSettings * info)
@@ -387,6 +419,12 @@ export_audio (
   /*sf_count_t last_playhead_frames = start_pos.frames;*/
   float out_ptr[
     AUDIO_ENGINE->block_length * EXPORT_CHANNELS];
+  nframes_t block_length =
+    info->block_length > 0 ?
+      MIN (
+        info->block_length,
+        AUDIO_ENGINE->block_length) :
+      AUDIO_ENGINE->block_length;
   do
     {
       /* calculate number of frames to process
@@ -398,7 +436,7 @@ export_audio (
         (nframes_t)
         MIN (
           (long) ceil (AUDIO_ENGINE->frames_per_tick * nticks),
-          (long) AUDIO_ENGINE->block_length);
+          (long) block_length);
       g_return_val_if_fail (nframes > 0, -1);
 
       /* run process code */
@@ -487,6 +525,11 @@ export_audio (
         (TRANSPORT->playhead_pos.ticks -
           start_pos.ticks) /
         total_ticks;
+      if (info->progress_cb)
+        {
+          info->progress_cb (
+            info, info->progress_cb_user_data);
+        }
     } while (
       TRANSPORT->playhead_pos.ticks <
         stop_pos.ticks &&
@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include "audio/audio_analyzer.h"
+#include "audio/clip.h"
+#include "audio/file_import.h"
+#include "audio/pool.h"
+#include "audio/supported_file.h"
+#include "gui/widgets/dialogs/generic_progress_dialog.h"
+#include "gui/widgets/main_window.h"
+#include "project.h"
+#include "utils/file.h"
+#include "utils/flags.h"
+#include "utils/hash.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+#include "utils/string.h"
+#include "zrythm_app.h"
+
+#include <gtk/gtk.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+/**
+ * Creates a new import for the given
+ * SupportedFile's.
+ */
+FileImport *
+file_import_new (
+  GPtrArray * files)
+{
+  FileImport * self = object_new (FileImport);
+
+  self->num_files = (int) files->len;
+  self->paths =
+    object_new_n (files->len, char *);
+  self->clips =
+    object_new_n (files->len, AudioClip *);
+  self->tmp_paths =
+    object_new_n (files->len, char *);
+  self->is_audio =
+    object_new_n (files->len, bool);
+  for (size_t i = 0; i < files->len; i++)
+    {
+      SupportedFile * file =
+        g_ptr_array_index (files, i);
+      self->paths[i] = g_strdup (file->abs_path);
+      if (supported_file_type_is_supported (
+            file->type)
+          &&
+          supported_file_type_is_audio (
+            file->type))
+        {
+          self->is_audio[i] = true;
+          self->num_jobs++;
+        }
+    }
+
+  /* encode to a directory next to the pool (on
+   * the same filesystem, so that the files can be
+   * renamed into it) instead of the pool itself,
+   * which is cleaned up of unused files on save */
+  char * pool_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_POOL, F_NOT_BACKUP);
+  if (pool_dir && file_exists (pool_dir))
+    {
+      char * tmp_dir =
+        project_get_path (
+          PROJECT, PROJECT_PATH_IMPORT_TMP,
+          F_NOT_BACKUP);
+      if (io_mkdir (tmp_dir) == 0)
+        {
+          self->tmp_dir = tmp_dir;
+        }
+      else
+        {
+          g_message (
+            "failed to create %s", tmp_dir);
+          g_free (tmp_dir);
+        }
+    }
+  g_free (pool_dir);
+
+  self->analyze =
+    ZRYTHM && AUDIO_ANALYZER
+    && AUDIO_ANALYZER->analyze_imports;
+
+  g_mutex_init (&self->mutex);
+
+  return self;
+}
+
+/**
+ * Encodes the clip to a temporary file in the
+ * import directory.
+ *
+ * @return The path of the file, or NULL if
+ *   failed.
+ */
+static char *
+write_tmp_file (
+  FileImport * self,
+  AudioClip *  clip)
+{
+  char * tmp_path =
+    g_build_filename (
+      self->tmp_dir, "XXXXXX", NULL);
+  int fd = g_mkstemp (tmp_path);
+  if (fd < 0)
+    {
+      g_message (
+        "failed to create temporary file %s",
+        tmp_path);
+      g_free (tmp_path);
+      return NULL;
+    }
+  g_close (fd, NULL);
+
+  if (audio_clip_write_to_file (
+        clip, tmp_path, false) != 0)
+    {
+      g_message (
+        "failed to write clip %s to %s",
+        clip->name, tmp_path);
+      io_remove (tmp_path);
+      g_free (tmp_path);
+      return NULL;
+    }
+
+  clip->file_hash =
+    hash_get_from_file (
+      tmp_path, HASH_ALGORITHM_XXH3_64);
+
+  return tmp_path;
+}
+
+/**
+ * Stops syncing the progress and closes the
+ * progress dialog, if any.
+ */
+static void
+stop_progress (
+  FileImport * self)
+{
+  if (self->progress_source_id)
+    {
+      g_source_remove (self->progress_source_id);
+      self->progress_source_id = 0;
+    }
+  if (self->progress_dialog)
+    {
+      gtk_widget_destroy (self->progress_dialog);
+    }
+}
+
+static int
+on_done (
+  FileImport * self)
+{
+  g_mutex_lock (&self->mutex);
+  self->done_source_id = 0;
+  g_mutex_unlock (&self->mutex);
+
+  stop_progress (self);
+
+  /* all jobs are finished so this does not
+   * block */
+  if (self->thread_pool)
+    {
+      g_thread_pool_free (
+        self->thread_pool, false, true);
+      self->thread_pool = NULL;
+    }
+
+  bool cancelled =
+    g_atomic_int_get (&self->cancelled);
+  g_message (
+    "imported %d/%d audio files%s",
+    g_atomic_int_get (&self->num_done),
+    self->num_jobs,
+    cancelled ? " (cancelled)" : "");
+
+  /* may free the import */
+  self->callback (
+    self, cancelled, self->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Schedules the callback of an asynchronous run.
+ */
+static void
+queue_done (
+  FileImport * self)
+{
+  g_mutex_lock (&self->mutex);
+  self->done_source_id =
+    g_idle_add ((GSourceFunc) on_done, self);
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+import_thread_func (
+  gpointer     data,
+  FileImport * self)
+{
+  int idx = GPOINTER_TO_INT (data) - 1;
+
+  if (!g_atomic_int_get (&self->cancelled))
+    {
+      AudioClip * clip =
+        audio_clip_new_from_file (
+          self->paths[idx]);
+      if (clip && self->tmp_dir)
+        {
+          self->tmp_paths[idx] =
+            write_tmp_file (self, clip);
+        }
+
+      /* the clip is only owned by this job until
+       * it is added to the pool, so the frames can
+       * be copied for the analysis here instead of
+       * in the GTK thread */
+      if (clip && self->analyze)
+        {
+          audio_analyzer_queue (
+            AUDIO_ANALYZER, clip, NULL, NULL);
+        }
+      self->clips[idx] = clip;
+    }
+
+  /* the last job to finish reports back */
+  if (g_atomic_int_add (&self->num_done, 1) + 1
+        == self->num_jobs
+      && self->callback)
+    {
+      queue_done (self);
+    }
+}
+
+/**
+ * Pushes a job for each audio file to the thread
+ * pool.
+ */
+static void
+push_jobs (
+  FileImport * self)
+{
+  GError * err = NULL;
+  self->thread_pool =
+    g_thread_pool_new (
+      (GFunc) import_thread_func, self,
+      (int) g_get_num_processors (),
+      F_NOT_EXCLUSIVE, &err);
+  if (!self->thread_pool)
+    {
+      g_message (
+        "failed to create import thread pool: %s",
+        err->message);
+      g_clear_error (&err);
+    }
+  for (int i = 0; i < self->num_files; i++)
+    {
+      if (!self->is_audio[i])
+        continue;
+
+      gpointer data = GINT_TO_POINTER (i + 1);
+      if (!self->thread_pool
+          ||
+          !g_thread_pool_push (
+             self->thread_pool, data, &err))
+        {
+          /* fall back to decoding here */
+          if (err)
+            {
+              g_message (
+                "failed to push import task: %s",
+                err->message);
+              g_clear_error (&err);
+            }
+          import_thread_func (data, self);
+        }
+    }
+}
+
+/**
+ * Decodes all audio files on a thread pool and
+ * waits for them to finish.
+ *
+ * To be used when there is no UI to keep
+ * responsive.
+ */
+void
+file_import_run (
+  FileImport * self)
+{
+  if (self->num_jobs == 0)
+    return;
+
+  push_jobs (self);
+  if (self->thread_pool)
+    {
+      g_thread_pool_free (
+        self->thread_pool, false, true);
+      self->thread_pool = NULL;
+    }
+
+  g_message (
+    "imported %d/%d audio files",
+    g_atomic_int_get (&self->num_done),
+    self->num_jobs);
+}
+
+/**
+ * Syncs the progress shown in the dialog with the
+ * jobs and forwards cancellation to them.
+ */
+static int
+update_progress (
+  FileImport * self)
+{
+  if (self->progress_info.cancelled)
+    {
+      g_atomic_int_set (&self->cancelled, 1);
+    }
+  self->progress_info.progress =
+    (double) g_atomic_int_get (&self->num_done) /
+    (double) self->num_jobs;
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+on_progress_dialog_response (
+  GtkDialog *  dialog,
+  gint         response_id,
+  FileImport * self)
+{
+  /* pick up a cancel before closing */
+  update_progress (self);
+  gtk_widget_destroy (GTK_WIDGET (dialog));
+}
+
+static void
+show_progress_dialog (
+  FileImport * self)
+{
+  sprintf (
+    self->progress_info.label_str,
+    _("Importing %d files..."), self->num_jobs);
+  strcpy (
+    self->progress_info.label_done_str,
+    _("Done"));
+  strcpy (
+    self->progress_info.error_str,
+    _("Failed"));
+
+  GenericProgressDialogWidget * dialog =
+    generic_progress_dialog_widget_new ();
+  generic_progress_dialog_widget_setup (
+    dialog, _("Importing..."),
+    &self->progress_info, true, true);
+  gtk_window_set_transient_for (
+    GTK_WINDOW (dialog),
+    GTK_WINDOW (MAIN_WINDOW));
+  gtk_window_set_modal (GTK_WINDOW (dialog), false);
+  g_signal_connect (
+    G_OBJECT (dialog), "response",
+    G_CALLBACK (on_progress_dialog_response),
+    self);
+  self->progress_dialog = GTK_WIDGET (dialog);
+  g_object_add_weak_pointer (
+    G_OBJECT (dialog),
+    (gpointer *) &self->progress_dialog);
+
+  self->progress_source_id =
+    g_timeout_add (
+      100, (GSourceFunc) update_progress, self);
+
+  gtk_widget_show (GTK_WIDGET (dialog));
+}
+
+/**
+ * Starts decoding all audio files on a thread
+ * pool and returns immediately.
+ *
+ * Must be called from the GTK thread.
+ *
+ * @param show_progress Whether to show a
+ *   non-modal, cancelable progress dialog.
+ * @param callback Callback to call on the GTK
+ *   thread when all files are decoded or the
+ *   import is cancelled.
+ */
+void
+file_import_run_async (
+  FileImport *       self,
+  bool               show_progress,
+  FileImportCallback callback,
+  void *             user_data)
+{
+  self->callback = callback;
+  self->user_data = user_data;
+
+  /* report back asynchronously either way */
+  if (self->num_jobs == 0)
+    {
+      queue_done (self);
+      return;
+    }
+
+  if (show_progress && ZRYTHM_HAVE_UI
+      && MAIN_WINDOW)
+    {
+      show_progress_dialog (self);
+    }
+
+  push_jobs (self);
+}
+
+/**
+ * Adds the clip decoded by the import for the
+ * given file to the pool.
+ *
+ * The encoded file is moved into place in the
+ * pool, so the clip is not written again.
+ *
+ * @return The pool ID of the clip, or -1 if the
+ *   import has no clip for the file.
+ */
+int
+file_import_add_clip_to_pool (
+  FileImport * self,
+  const char * abs_path)
+{
+  int idx = -1;
+  for (int i = 0; i < self->num_files; i++)
+    {
+      if (self->clips[i]
+          &&
+          string_is_equal (
+            self->paths[i], abs_path))
+        {
+          idx = i;
+          break;
+        }
+    }
+  if (idx < 0)
+    return -1;
+
+  AudioClip * clip = self->clips[idx];
+  self->clips[idx] = NULL;
+  int pool_id =
+    audio_pool_add_clip (AUDIO_POOL, clip);
+
+  /* move the encoded file into place (if a file
+   * already exists there, leave it to
+   * audio_clip_write_to_pool() to check) */
+  char * tmp_path = self->tmp_paths[idx];
+  if (tmp_path)
+    {
+      char * pool_path =
+        audio_clip_get_path_in_pool (
+          clip, F_NOT_BACKUP);
+      if (pool_path && !file_exists (pool_path)
+          && g_rename (tmp_path, pool_path) == 0)
+        {
+          g_debug (
+            "moved imported clip to %s",
+            pool_path);
+        }
+      else
+        {
+          io_remove (tmp_path);
+        }
+      g_free (pool_path);
+      g_free_and_null (self->tmp_paths[idx]);
+    }
+
+  return pool_id;
+}
+
+/**
+ * Cancels any running jobs and frees the import.
+ */
+void
+file_import_free (
+  FileImport * self)
+{
+  /* drop the pending jobs and wait for the
+   * running ones */
+  g_atomic_int_set (&self->cancelled, 1);
+  if (self->thread_pool)
+    {
+      g_thread_pool_free (
+        self->thread_pool, true, true);
+      self->thread_pool = NULL;
+    }
+  g_mutex_lock (&self->mutex);
+  if (self->done_source_id)
+    {
+      g_source_remove (self->done_source_id);
+      self->done_source_id = 0;
+    }
+  g_mutex_unlock (&self->mutex);
+  stop_progress (self);
+
+  for (int i = 0; i < self->num_files; i++)
+    {
+      if (self->tmp_paths[i])
+        {
+          io_remove (self->tmp_paths[i]);
+          g_free (self->tmp_paths[i]);
+        }
+      object_free_w_func_and_null (
+        audio_clip_free, self->clips[i]);
+      g_free (self->paths[i]);
+    }
+  object_zero_and_free (self->paths);
+  object_zero_and_free (self->clips);
+  object_zero_and_free (self->tmp_paths);
+  object_zero_and_free (self->is_audio);
+  if (self->tmp_dir)
+    {
+      /* only succeeds if no other import is
+       * using it */
+      g_rmdir (self->tmp_dir);
+      g_free (self->tmp_dir);
+    }
+  g_mutex_clear (&self->mutex);
+
+  object_zero_and_free (self);
+}
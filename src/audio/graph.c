@@ -35,23 +35,29 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 
 #include "audio/control_room.h"
 #include "audio/engine.h"
 #include "audio/fader.h"
 #include "audio/graph.h"
+#include "audio/graph_buffer_pool.h"
 #include "audio/graph_node.h"
 #include "audio/graph_thread.h"
 #include "audio/hardware_processor.h"
+#include "audio/modulation_matrix.h"
 #include "audio/port.h"
+#include "audio/prerenderer.h"
 #include "audio/router.h"
 #include "audio/sample_processor.h"
 #include "audio/track.h"
 #include "audio/tracklist.h"
 #include "plugins/plugin.h"
 #include "project.h"
+#include "settings/settings.h"
 #include "utils/arrays.h"
 #include "utils/audio.h"
+#include "utils/cpu_affinity.h"
 #include "utils/env.h"
 #include "utils/flags.h"
 #include "utils/mem.h"
@@ -60,6 +66,100 @@
 #include "utils/objects.h"
 #include "utils/stoat.h"
 #include "utils/string.h"
+#include "zrythm.h"
+
+/**
+ * Sets the number of active workers, waking up the
+ * newly activated ones.
+ */
+static void
+set_num_active_threads (
+  Graph * self,
+  int     num_active)
+{
+  int prev_num_active =
+    g_atomic_int_get (&self->num_active_threads);
+  g_atomic_int_set (
+    &self->num_active_threads, num_active);
+  for (int i = prev_num_active; i < num_active; i++)
+    {
+      zix_sem_post (&self->threads[i]->park_sem);
+    }
+  self->thread_stats.num_active_threads =
+    num_active;
+}
+
+/**
+ * Updates the parallelism estimate with the work
+ * measured in the cycle that just finished and
+ * parks or wakes up workers accordingly.
+ */
+static void
+update_active_threads (
+  Graph * self)
+{
+  gint critical_path_ns = 0;
+  for (int i = 0; i < self->n_terminal_nodes; i++)
+    {
+      critical_path_ns =
+        MAX (
+          critical_path_ns,
+          self->terminal_nodes[i]->path_end_ns);
+    }
+  gint work_ns =
+    g_atomic_int_get (&self->cycle_work_ns);
+  g_atomic_int_set (&self->cycle_work_ns, 0);
+  if (critical_path_ns <= 0)
+    return;
+
+  GraphThreadStats * stats = &self->thread_stats;
+  float parallelism =
+    (float) work_ns / (float) critical_path_ns;
+  stats->parallelism =
+    stats->parallelism <= 0.f ?
+      parallelism :
+      0.95f * stats->parallelism +
+        0.05f * parallelism;
+  stats->critical_path_ns = critical_path_ns;
+  stats->work_ns = work_ns;
+
+  /* the thread that finishes the cycle processes
+   * nodes too, so it counts as one worker */
+  int target =
+    (int) ceilf (stats->parallelism - 0.05f) - 1;
+  target =
+    CLAMP (
+      target,
+      MIN (self->min_active_threads,
+           self->num_threads),
+      self->num_threads);
+
+  int num_active =
+    g_atomic_int_get (&self->num_active_threads);
+  if (target > num_active)
+    {
+      /* grow immediately */
+      stats->num_unparks += target - num_active;
+      set_num_active_threads (self, target);
+      self->shrink_cycles = 0;
+    }
+  else if (target < num_active)
+    {
+      /* shrink slowly, one worker at a time */
+      if (++self->shrink_cycles >=
+            GRAPH_THREAD_SHRINK_DELAY_CYCLES)
+        {
+          stats->num_parks++;
+          set_num_active_threads (
+            self, num_active - 1);
+          self->shrink_cycles = 0;
+        }
+    }
+  else
+    {
+      self->shrink_cycles = 0;
+    }
+}
 
 /* called from a terminal node (from the Graph
  * worked-thread) to indicate it has completed
@@ -99,6 +199,11 @@ graph_on_reached_terminal_node (
              self->num_threads)
         sched_yield ();
 
+      if (self->measure_parallelism)
+        {
+          update_active_threads (self);
+        }
+
       if (g_atomic_int_get (&self->terminate))
         return;
 
@@ -667,6 +772,14 @@ graph_setup (
 {
   GraphNode * node, * node2;
 
+  /* the tracks rendered ahead refer to the
+   * current nodes */
+  if (rechain)
+    {
+      object_free_w_func_and_null (
+        prerenderer_free, self->prerenderer);
+    }
+
   /* ========================
    * first add all the nodes
    * ======================== */
@@ -691,6 +804,14 @@ graph_setup (
     self, ROUTE_NODE_TYPE_HW_PROCESSOR,
     HW_IN_PROCESSOR);
 
+  const int lane_parallelism_threshold =
+    ZRYTHM_TESTING
+    ? GRAPH_DEFAULT_LANE_PARALLELISM_THRESHOLD
+    :
+    g_settings_get_int (
+      S_P_GENERAL_ENGINE,
+      "lane-parallelism-threshold");
+
   /* add plugins */
   Track * tr;
   Plugin * pl;
@@ -707,6 +828,34 @@ graph_setup (
       graph_create_node (
         self, ROUTE_NODE_TYPE_TRACK, tr);
 
+      /* add the lanes if they should be processed
+       * in parallel */
+      int num_lanes_in_graph = 0;
+      if (track_should_process_lanes_in_parallel (
+            tr, lane_parallelism_threshold))
+        {
+          for (int j = 0; j < tr->num_lanes; j++)
+            {
+              TrackLane * lane = tr->lanes[j];
+              if (rechain)
+                {
+                  track_lane_allocate_bufs (lane);
+                }
+              graph_create_node (
+                self, ROUTE_NODE_TYPE_TRACK_LANE,
+                lane);
+            }
+          num_lanes_in_graph = tr->num_lanes;
+        }
+
+      /* only touch the track when the graph is
+       * going to be used (not when validating) */
+      if (rechain)
+        {
+          tr->num_lanes_in_graph =
+            num_lanes_in_graph;
+        }
+
       for (int j = 0; j < tr->num_modulators; j++)
         {
           pl = tr->modulators[j];
@@ -798,6 +947,12 @@ graph_setup (
     {
       port = g_ptr_array_index (ports, i);
       g_return_if_fail (IS_PORT_AND_NONNULL (port));
+
+      /* buffers are pooled again after
+       * rechaining */
+      if (rechain)
+        port_release_pooled_buf (port);
+
       if (port->deleting)
         continue;
       if (port->id.owner_type ==
@@ -953,6 +1108,20 @@ graph_setup (
       /* connect the track */
       node =
         graph_find_node_from_track (self, tr, true);
+
+      /* connect the lanes */
+      for (int j = 0; j < tr->num_lanes; j++)
+        {
+          node2 =
+            graph_find_node_from_track_lane (
+              self, tr->lanes[j]);
+          if (!node2)
+            break;
+
+          graph_node_connect (
+            initial_processor_node, node2);
+          graph_node_connect (node2, node);
+        }
       if (tr->in_signal_type == TYPE_AUDIO)
         {
           if (tr->type == TRACK_TYPE_AUDIO)
@@ -1371,6 +1540,27 @@ graph_setup (
       connect_port (self, port);
     }
 
+  /* ========================
+   * set up the modulation matrix
+   * ======================== */
+
+  if (rechain)
+    {
+      const int control_rate =
+        ZRYTHM_TESTING
+        ? MODULATION_MATRIX_DEFAULT_CONTROL_RATE
+        :
+        g_settings_get_int (
+          S_P_GENERAL_ENGINE,
+          "modulation-control-rate");
+      object_free_w_func_and_null (
+        modulation_matrix_free, self->mod_matrix);
+      self->mod_matrix =
+        modulation_matrix_new (
+          ports, (unsigned int) control_rate,
+          AUDIO_ENGINE->sample_rate);
+    }
+
   /* ========================
    * set initial and terminal nodes
    * ======================== */
@@ -1438,7 +1628,29 @@ graph_setup (
   g_ptr_array_unref (ports);
 
   if (rechain)
-    graph_rechain (self);
+    {
+      graph_rechain (self);
+
+      if (AUDIO_ENGINE->anticipative_rendering)
+        {
+          self->prerenderer =
+            prerenderer_new (self);
+        }
+
+      object_free_w_func_and_null (
+        graph_buffer_pool_free, self->buffer_pool);
+      bool pool_buffers =
+        ZRYTHM_TESTING ?
+          true :
+          g_settings_get_boolean (
+            S_P_GENERAL_ENGINE,
+            "pool-port-buffers");
+      if (pool_buffers)
+        {
+          self->buffer_pool =
+            graph_buffer_pool_new (self);
+        }
+    }
 }
 
 /**
@@ -1488,6 +1700,122 @@ graph_validate_with_connection (
   return valid;
 }
 
+/**
+ * Warns if any of the graph thread CPUs share a
+ * physical core or are also used by the main
+ * thread.
+ */
+static void
+check_cpu_placement (
+  Graph * self)
+{
+  if (!self->graph_thread_cpus)
+    return;
+
+  GArray * cpus = self->graph_thread_cpus;
+  for (guint i = 0; i < cpus->len; i++)
+    {
+      int cpu = g_array_index (cpus, int, i);
+      GArray * siblings =
+        cpu_affinity_get_smt_siblings (cpu);
+      if (siblings)
+        {
+          for (guint j = i + 1; j < cpus->len; j++)
+            {
+              int other =
+                g_array_index (cpus, int, j);
+              for (guint k = 0; k < siblings->len;
+                   k++)
+                {
+                  if (g_array_index (
+                        siblings, int, k) == other)
+                    {
+                      g_message (
+                        "graph thread CPUs %d and %d "
+                        "are SMT siblings and will "
+                        "compete for the same core",
+                        cpu, other);
+                    }
+                }
+            }
+          g_array_free (siblings, true);
+        }
+
+      if (!self->audio_thread_cpus)
+        continue;
+
+      for (guint j = 0;
+           j < self->audio_thread_cpus->len; j++)
+        {
+          if (g_array_index (
+                self->audio_thread_cpus, int, j) ==
+                  cpu)
+            {
+              g_message (
+                "CPU %d is used by both a graph "
+                "thread and the main audio thread",
+                cpu);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the worker thread metrics.
+ *
+ * The metrics are updated from the realtime
+ * thread so they may be slightly inconsistent.
+ */
+void
+graph_get_thread_stats (
+  Graph *            self,
+  GraphThreadStats * stats)
+{
+  *stats = self->thread_stats;
+  stats->num_active_threads =
+    g_atomic_int_get (&self->num_active_threads);
+  stats->num_threads = self->num_threads;
+}
+
+/**
+ * Logs the thread ID, allowed CPUs and number of
+ * CPU migrations of each graph thread.
+ */
+void
+graph_print_thread_placement (
+  Graph * self)
+{
+  GraphThreadStats stats;
+  graph_get_thread_stats (self, &stats);
+  g_message (
+    "graph threads: %d/%d active, parallelism "
+    "%.2f (critical path %" G_GINT64_FORMAT
+    "ns, work %" G_GINT64_FORMAT "ns), parked %"
+    G_GINT64_FORMAT " times, woken up %"
+    G_GINT64_FORMAT " times",
+    stats.num_active_threads, stats.num_threads,
+    (double) stats.parallelism,
+    stats.critical_path_ns, stats.work_ns,
+    stats.num_parks, stats.num_unparks);
+
+  for (int i = -1; i < self->num_threads; i++)
+    {
+      GraphThread * thread =
+        i == -1 ? self->main_thread : self->threads[i];
+      if (!thread || thread->tid <= 0)
+        continue;
+
+      long migrations =
+        cpu_affinity_get_thread_migrations (
+          thread->tid);
+      g_message (
+        "graph thread %d: tid %ld, CPUs %s, "
+        "migrations %ld",
+        thread->id, thread->tid,
+        thread->allowed_cpus, migrations);
+    }
+}
+
 /**
  * Starts as many threads as there are cores.
  *
@@ -1510,6 +1838,43 @@ graph_start (
   graph->num_threads =
     MAX (graph->num_threads, 0);
 
+  object_free_w_func_and_null (
+    g_array_unref, graph->graph_thread_cpus);
+  object_free_w_func_and_null (
+    g_array_unref, graph->audio_thread_cpus);
+  graph->graph_thread_cpus =
+    cpu_affinity_get_rt_cpus_from_settings (
+      "graph-thread-cpus");
+  graph->audio_thread_cpus =
+    cpu_affinity_get_rt_cpus_from_settings (
+      "audio-thread-cpus");
+  check_cpu_placement (graph);
+
+  graph->thread_policy =
+    ZRYTHM_TESTING ?
+      GRAPH_THREAD_POLICY_ADAPTIVE :
+      (GraphThreadPolicy)
+      g_settings_get_enum (
+        S_P_GENERAL_ENGINE, "graph-thread-policy");
+  graph->min_active_threads =
+    ZRYTHM_TESTING ?
+      0 :
+      g_settings_get_int (
+        S_P_GENERAL_ENGINE,
+        "graph-min-active-threads");
+  graph->measure_parallelism =
+    graph->thread_policy ==
+      GRAPH_THREAD_POLICY_ADAPTIVE;
+  graph->shrink_cycles = 0;
+  object_set_to_zero (&graph->thread_stats);
+  g_atomic_int_set (&graph->cycle_work_ns, 0);
+  g_atomic_int_set (&graph->parked_thread_cnt, 0);
+  g_atomic_int_set (
+    &graph->num_active_threads,
+    graph->num_threads);
+  graph->thread_stats.num_active_threads =
+    graph->num_threads;
+
   /* create worker threads (num cores - 2 because
    * the main thread will become a worker too, so
    * in total N_CORES - 1 threads */
@@ -1550,6 +1915,8 @@ graph_start (
       g_usleep (10000);
     }
 
+  graph_print_thread_placement (graph);
+
   return 1;
 }
 
@@ -1600,6 +1967,8 @@ graph_terminate (
 {
   g_message ("terminating graph...");
 
+  graph_print_thread_placement (self);
+
   /* Flag threads to terminate */
   g_atomic_int_set (&self->terminate, 1);
 
@@ -1627,6 +1996,12 @@ graph_terminate (
       zix_sem_post (&self->trigger);
     }
 
+  /* and parked threads */
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      zix_sem_post (&self->threads[i]->park_sem);
+    }
+
   /* and the main thread */
   zix_sem_post (&self->callback_start);
 
@@ -1646,7 +2021,8 @@ graph_terminate (
           pthread_join (
             self->threads[i]->jthread, NULL);
 #endif // HAVE_JACK_CLIENT_STOP_THREAD
-          self->threads[i] = NULL;
+          object_free_w_func_and_null (
+            graph_thread_free, self->threads[i]);
         }
       g_return_if_fail (self->main_thread);
 #ifdef HAVE_JACK_CLIENT_STOP_THREAD
@@ -1658,7 +2034,8 @@ graph_terminate (
         self->main_thread->jthread, NULL);
 #endif // HAVE_JACK_CLIENT_STOP_THREAD
 
-      self->main_thread = NULL;
+      object_free_w_func_and_null (
+        graph_thread_free, self->main_thread);
     }
   else
     {
@@ -1668,12 +2045,14 @@ graph_terminate (
           g_return_if_fail (self->threads[i]);
           pthread_join (
             self->threads[i]->pthread, NULL);
-          self->threads[i] = NULL;
+          object_free_w_func_and_null (
+            graph_thread_free, self->threads[i]);
         }
       g_return_if_fail (self->main_thread);
       pthread_join (
         self->main_thread->pthread, NULL);
-      self->main_thread = NULL;
+      object_free_w_func_and_null (
+        graph_thread_free, self->main_thread);
 #ifdef HAVE_JACK
     }
 #endif
@@ -1734,6 +2113,22 @@ graph_find_node_from_track (
     return NULL;
 }
 
+GraphNode *
+graph_find_node_from_track_lane (
+  const Graph *     self,
+  const TrackLane * lane)
+{
+  GraphNode * node =
+    (GraphNode *)
+    g_hash_table_lookup (
+      self->setup_graph_nodes, lane);
+  if (node
+      && node->type == ROUTE_NODE_TYPE_TRACK_LANE)
+    return node;
+  else
+    return NULL;
+}
+
 GraphNode *
 graph_find_node_from_fader (
   const Graph * self,
@@ -1897,6 +2292,8 @@ graph_free (
 {
   g_debug ("%s: freeing...", __func__);
 
+  object_free_w_func_and_null (
+    prerenderer_free, self->prerenderer);
   object_free_w_func_and_null (
     g_hash_table_unref, self->graph_nodes);
   object_zero_and_free (self->init_trigger_list);
@@ -1906,9 +2303,20 @@ graph_free (
     self->setup_init_trigger_list);
   object_zero_and_free (
     self->terminal_nodes);
+  object_free_w_func_and_null (
+    modulation_matrix_free, self->mod_matrix);
 
   object_free_w_func_and_null (
     g_ptr_array_unref, self->external_out_ports);
+  object_free_w_func_and_null (
+    g_array_unref, self->graph_thread_cpus);
+  object_free_w_func_and_null (
+    g_array_unref, self->audio_thread_cpus);
+
+  /* also makes ports still using the pool go back
+   * to their own buffers */
+  object_free_w_func_and_null (
+    graph_buffer_pool_free, self->buffer_pool);
 
   zix_sem_destroy (&self->callback_start);
   zix_sem_destroy (&self->callback_done);
@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio/engine.h"
+#include "audio/graph.h"
+#include "audio/graph_buffer_pool.h"
+#include "audio/graph_node.h"
+#include "audio/port.h"
+#include "project.h"
+#include "utils/objects.h"
+#include "utils/rt_memory.h"
+
+#include <glib.h>
+
+/**
+ * Graph nodes in topological order and the
+ * descendants of each node.
+ */
+typedef struct NodeOrder
+{
+  /** Nodes in topological order. */
+  GraphNode ** nodes;
+  size_t       num_nodes;
+
+  /** Node to index in @ref NodeOrder.nodes plus
+   * one. */
+  GHashTable * indices;
+
+  /** Descendant bitset of each node, @ref
+   * NodeOrder.num_words words per node. */
+  guint64 *    descendants;
+  size_t       num_words;
+} NodeOrder;
+
+static size_t
+get_index (
+  NodeOrder * self,
+  GraphNode * node)
+{
+  return
+    GPOINTER_TO_SIZE (
+      g_hash_table_lookup (self->indices, node)) - 1;
+}
+
+static bool
+is_descendant (
+  NodeOrder * self,
+  size_t      node,
+  size_t      other)
+{
+  return
+    (self->descendants[
+       node * self->num_words + other / 64] &
+     ((guint64) 1 << (other % 64))) != 0;
+}
+
+/**
+ * Sorts the nodes topologically and calculates
+ * their descendants.
+ *
+ * @return Whether successful.
+ */
+static bool
+node_order_init (
+  NodeOrder * self,
+  Graph *     graph)
+{
+  self->num_nodes =
+    g_hash_table_size (graph->graph_nodes);
+  self->nodes =
+    object_new_n (self->num_nodes, GraphNode *);
+  self->indices =
+    g_hash_table_new (
+      g_direct_hash, g_direct_equal);
+
+  /* Kahn's algorithm, starting from the nodes
+   * without parents */
+  int * refcounts =
+    object_new_n (self->num_nodes, int);
+  GHashTable * unordered_indices =
+    g_hash_table_new (
+      g_direct_hash, g_direct_equal);
+  GraphNode ** unordered =
+    object_new_n (self->num_nodes, GraphNode *);
+  size_t num_unordered = 0;
+  size_t num_ordered = 0;
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init (
+    &iter, graph->graph_nodes);
+  while (g_hash_table_iter_next (
+           &iter, NULL, &value))
+    {
+      GraphNode * node = (GraphNode *) value;
+      refcounts[num_unordered] = node->init_refcount;
+      unordered[num_unordered] = node;
+      g_hash_table_insert (
+        unordered_indices, node,
+        GSIZE_TO_POINTER (num_unordered + 1));
+      if (node->init_refcount == 0)
+        {
+          self->nodes[num_ordered++] = node;
+        }
+      num_unordered++;
+    }
+  for (size_t i = 0; i < num_ordered; i++)
+    {
+      GraphNode * node = self->nodes[i];
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          GraphNode * child = node->childnodes[j];
+          size_t idx =
+            GPOINTER_TO_SIZE (
+              g_hash_table_lookup (
+                unordered_indices, child)) - 1;
+          if (--refcounts[idx] == 0)
+            {
+              self->nodes[num_ordered++] = child;
+            }
+        }
+    }
+  free (refcounts);
+  free (unordered);
+  g_hash_table_unref (unordered_indices);
+
+  if (num_ordered != self->num_nodes)
+    {
+      g_message (
+        "graph has a cycle, not pooling buffers");
+      return false;
+    }
+
+  for (size_t i = 0; i < self->num_nodes; i++)
+    {
+      g_hash_table_insert (
+        self->indices, self->nodes[i],
+        GSIZE_TO_POINTER (i + 1));
+    }
+
+  /* children come after their parents, so going
+   * backwards each child's descendants are known
+   * when its parents are visited */
+  self->num_words = (self->num_nodes + 63) / 64;
+  self->descendants =
+    object_new_n (
+      self->num_nodes * self->num_words, guint64);
+  for (size_t i = self->num_nodes; i-- > 0;)
+    {
+      GraphNode * node = self->nodes[i];
+      guint64 * row =
+        &self->descendants[i * self->num_words];
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          size_t child =
+            get_index (self, node->childnodes[j]);
+          row[child / 64] |=
+            (guint64) 1 << (child % 64);
+          guint64 * child_row =
+            &self->descendants[
+              child * self->num_words];
+          for (size_t k = 0; k < self->num_words;
+               k++)
+            {
+              row[k] |= child_row[k];
+            }
+        }
+    }
+
+  return true;
+}
+
+static void
+node_order_free_members (
+  NodeOrder * self)
+{
+  free (self->nodes);
+  free (self->descendants);
+  object_free_w_func_and_null (
+    g_hash_table_unref, self->indices);
+}
+
+/**
+ * Returns whether all nodes that may read the
+ * buffer of the port node at @p a are guaranteed
+ * to finish before any node that may write to the
+ * buffer of the port node at @p b starts.
+ *
+ * Readers are the children of the port node and
+ * writers are its parents, or the node itself if
+ * it has none.
+ */
+static bool
+lifetime_precedes (
+  NodeOrder * self,
+  size_t      a,
+  size_t      b)
+{
+  GraphNode * a_node = self->nodes[a];
+  GraphNode * b_node = self->nodes[b];
+  int num_readers = MAX (a_node->n_childnodes, 1);
+  int num_writers = MAX (b_node->init_refcount, 1);
+  for (int i = 0; i < num_readers; i++)
+    {
+      size_t reader =
+        a_node->n_childnodes > 0 ?
+          get_index (self, a_node->childnodes[i]) :
+          a;
+      for (int j = 0; j < num_writers; j++)
+        {
+          size_t writer =
+            b_node->init_refcount > 0 ?
+              get_index (
+                self, b_node->parentnodes[j]) :
+              b;
+          if (!is_descendant (self, reader, writer))
+            return false;
+        }
+    }
+
+  return true;
+}
+
+/**
+ * Computes the buffer lifetimes of the ports in
+ * the graph's current nodes and makes the ports
+ * that can share buffers use pooled buffers.
+ *
+ * Must be called while the graph is not running,
+ * after all ports were released with
+ * port_release_pooled_buf().
+ */
+GraphBufferPool *
+graph_buffer_pool_new (
+  Graph * graph)
+{
+  GraphBufferPool * self =
+    object_new (GraphBufferPool);
+
+  NodeOrder order;
+  object_set_to_zero (&order);
+  if (!node_order_init (&order, graph))
+    {
+      node_order_free_members (&order);
+      return self;
+    }
+
+  /* assign candidates in topological order to
+   * chains of ports with ordered lifetimes. since
+   * lifetimes are ordered transitively, only the
+   * last port of each chain needs to be checked */
+  GArray * chain_lasts =
+    g_array_new (false, false, sizeof (size_t));
+  GArray * chain_sizes =
+    g_array_new (false, true, sizeof (int));
+  size_t * candidates =
+    object_new_n (order.num_nodes, size_t);
+  int * candidate_chains =
+    object_new_n (order.num_nodes, int);
+  size_t num_candidates = 0;
+  for (size_t i = 0; i < order.num_nodes; i++)
+    {
+      GraphNode * node = order.nodes[i];
+      /* ports rendered ahead are processed outside
+       * of the graph cycle */
+      if (node->type != ROUTE_NODE_TYPE_PORT
+          || node->prerender_track
+          || !port_can_use_pooled_buf (node->port))
+        continue;
+
+      int chain = -1;
+      for (guint j = 0; j < chain_lasts->len; j++)
+        {
+          if (lifetime_precedes (
+                &order,
+                g_array_index (
+                  chain_lasts, size_t, j), i))
+            {
+              chain = (int) j;
+              break;
+            }
+        }
+      if (chain < 0)
+        {
+          chain = (int) chain_lasts->len;
+          g_array_append_val (chain_lasts, i);
+          int size = 0;
+          g_array_append_val (chain_sizes, size);
+        }
+      g_array_index (chain_lasts, size_t, chain) = i;
+      g_array_index (chain_sizes, int, chain)++;
+
+      candidates[num_candidates] = i;
+      candidate_chains[num_candidates] = chain;
+      num_candidates++;
+    }
+
+  /* only chains with more than one port save
+   * anything */
+  int * chain_bufs =
+    object_new_n (chain_lasts->len + 1, int);
+  for (guint i = 0; i < chain_lasts->len; i++)
+    {
+      if (g_array_index (chain_sizes, int, i) > 1)
+        {
+          chain_bufs[i] = self->num_bufs++;
+        }
+      else
+        {
+          chain_bufs[i] = -1;
+        }
+    }
+
+  self->buf_size =
+    MAX (AUDIO_ENGINE->block_length, 1);
+  for (size_t i = 0; i < num_candidates; i++)
+    {
+      if (chain_bufs[candidate_chains[i]] < 0)
+        continue;
+
+      Port * port = order.nodes[candidates[i]]->port;
+      self->buf_size =
+        MAX (self->buf_size, port->min_buf_size);
+    }
+
+  if (self->num_bufs > 0)
+    {
+      size_t stride =
+        self->buf_size * sizeof (float);
+      stride =
+        (stride + GRAPH_BUFFER_POOL_ALIGNMENT - 1) &
+        ~((size_t) GRAPH_BUFFER_POOL_ALIGNMENT - 1);
+
+      self->bufs =
+        object_new_n (
+          (size_t) self->num_bufs, float *);
+      self->mems =
+        object_new_n (
+          (size_t) self->num_bufs, void *);
+      for (int i = 0; i < self->num_bufs; i++)
+        {
+          /* prefer locked memory (arena blocks are
+           * already aligned) */
+          void * mem = NULL;
+          if (AUDIO_ENGINE->rt_arena)
+            {
+              mem =
+                rt_arena_alloc (
+                  AUDIO_ENGINE->rt_arena, stride);
+            }
+          if (mem)
+            {
+              memset (mem, 0, stride);
+            }
+          else
+            {
+              mem =
+                g_malloc0 (
+                  stride +
+                    GRAPH_BUFFER_POOL_ALIGNMENT);
+            }
+          self->mems[i] = mem;
+          self->bufs[i] =
+            (float *)
+            (((uintptr_t) mem +
+                GRAPH_BUFFER_POOL_ALIGNMENT - 1) &
+             ~((uintptr_t)
+                 GRAPH_BUFFER_POOL_ALIGNMENT - 1));
+        }
+
+      self->ports =
+        object_new_n (num_candidates, Port *);
+      for (size_t i = 0; i < num_candidates; i++)
+        {
+          int buf = chain_bufs[candidate_chains[i]];
+          if (buf < 0)
+            continue;
+
+          Port * port =
+            order.nodes[candidates[i]]->port;
+          port_use_pooled_buf (
+            port, self, self->bufs[buf]);
+        }
+    }
+
+  g_message (
+    "%d of %zu candidate port buffers pooled into "
+    "%d buffers",
+    self->num_ports, num_candidates,
+    self->num_bufs);
+
+  free (chain_bufs);
+  free (candidates);
+  free (candidate_chains);
+  g_array_free (chain_lasts, true);
+  g_array_free (chain_sizes, true);
+  node_order_free_members (&order);
+
+  return self;
+}
+
+/**
+ * Frees the pool.
+ *
+ * Ports still using its buffers (eg, ports that
+ * were removed from the graph) go back to their
+ * own buffers.
+ */
+void
+graph_buffer_pool_free (
+  GraphBufferPool * self)
+{
+  for (int i = 0; i < self->num_ports; i++)
+    {
+      if (self->ports[i])
+        port_release_pooled_buf (self->ports[i]);
+    }
+  free (self->ports);
+
+  for (int i = 0; i < self->num_bufs; i++)
+    {
+      if (AUDIO_ENGINE->rt_arena
+          &&
+          rt_arena_contains (
+            AUDIO_ENGINE->rt_arena, self->mems[i]))
+        {
+          rt_arena_free (
+            AUDIO_ENGINE->rt_arena, self->mems[i]);
+        }
+      else
+        {
+          g_free (self->mems[i]);
+        }
+    }
+  free (self->mems);
+  free (self->bufs);
+
+  object_zero_and_free (self);
+}
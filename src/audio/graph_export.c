@@ -86,6 +86,7 @@ get_parent_graph (
     case ROUTE_NODE_TYPE_PREFADER:
     case ROUTE_NODE_TYPE_MODULATOR_MACRO_PROCESOR:
     case ROUTE_NODE_TYPE_CHANNEL_SEND:
+    case ROUTE_NODE_TYPE_TRACK_LANE:
       parent_node = node;
       break;
     case ROUTE_NODE_TYPE_PORT:
@@ -335,6 +336,7 @@ fill_anodes (
           node->type != ROUTE_NODE_TYPE_FADER &&
           node->type != ROUTE_NODE_TYPE_PREFADER &&
           node->type != ROUTE_NODE_TYPE_CHANNEL_SEND &&
+          node->type != ROUTE_NODE_TYPE_TRACK_LANE &&
           node->type !=
             ROUTE_NODE_TYPE_MODULATOR_MACRO_PROCESOR)
         continue;
@@ -383,6 +385,11 @@ fill_anodes (
                 node->graph, tr, true);
           }
           break;
+        case ROUTE_NODE_TYPE_TRACK_LANE:
+          parent_node =
+            graph_find_node_from_track (
+              node->graph, node->track, true);
+          break;
         case ROUTE_NODE_TYPE_MODULATOR_MACRO_PROCESOR:
           {
             ModulatorMacroProcessor * mmp =
@@ -37,6 +37,7 @@
 
 #include <inttypes.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "audio/engine.h"
 #include "audio/fader.h"
@@ -45,6 +46,7 @@
 #include "audio/master_track.h"
 #include "audio/midi_event.h"
 #include "audio/port.h"
+#include "audio/prerenderer.h"
 #include "audio/router.h"
 #include "audio/sample_processor.h"
 #include "audio/tempo_track.h"
@@ -55,6 +57,7 @@
 #include "plugins/plugin.h"
 #include "project.h"
 #include "utils/arrays.h"
+#include "utils/flags.h"
 #include "utils/mpmc_queue.h"
 #include "utils/objects.h"
 
@@ -136,6 +139,11 @@ graph_node_get_name (
             "%s/Channel Send %d",
             track->name, node->send->slot + 1);
       }
+    case ROUTE_NODE_TYPE_TRACK_LANE:
+      return
+        g_strdup_printf (
+          "%s/Lane %d",
+          node->track->name, node->lane_pos + 1);
     }
   g_return_val_if_reached (NULL);
 }
@@ -173,6 +181,10 @@ graph_node_get_pointer (
       return node->modulator_macro_processor;
     case ROUTE_NODE_TYPE_CHANNEL_SEND:
       return node->send;
+    case ROUTE_NODE_TYPE_TRACK_LANE:
+      if (node->lane_pos < node->track->num_lanes)
+        return node->track->lanes[node->lane_pos];
+      return NULL;
     }
   g_return_val_if_reached (NULL);
 }
@@ -260,11 +272,16 @@ on_node_finish (
     }
 }
 
+/**
+ * @param cursors Region index cursors to use
+ *   (live or ahead).
+ */
 HOT
 static void
 process_node (
   const GraphNode *                   node,
-  const EngineProcessTimeInfo * const time_nfo)
+  const EngineProcessTimeInfo * const time_nfo,
+  RegionIndexCursor *                 cursors)
 {
 #define g_start_frames (time_nfo->g_start_frames)
 #define local_offset (time_nfo->local_offset)
@@ -317,10 +334,17 @@ process_node (
             track->type != TRACK_TYPE_MARKER)
           {
             track_processor_process (
-              track->processor, time_nfo);
+              track->processor, time_nfo, cursors,
+              node->num_region_cursors);
           }
       }
       break;
+    case ROUTE_NODE_TYPE_TRACK_LANE:
+      track_fill_lane_events (
+        node->track, node->lane_pos, time_nfo,
+        node->num_region_cursors > 0 ?
+          cursors : NULL);
+      break;
     case ROUTE_NODE_TYPE_PORT:
       {
         /* decide what to do based on what port it
@@ -362,6 +386,160 @@ process_node (
 #undef nframes
 }
 
+/**
+ * Returns a monotonic time in nanoseconds.
+ */
+static inline gint64
+get_time_ns (void)
+{
+#ifdef _WOE32
+  return g_get_monotonic_time () * 1000;
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return
+    (gint64) ts.tv_sec * 1000000000 +
+    (gint64) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Records the node's processing time for the
+ * graph's parallelism estimate.
+ *
+ * All parents have finished when this is called,
+ * so their path lengths are final.
+ */
+static inline void
+record_process_time (
+  GraphNode * node,
+  gint64      start_ns)
+{
+  gint own_ns =
+    (gint) (get_time_ns () - start_ns);
+  gint path_start_ns = 0;
+  for (int i = 0; i < node->init_refcount; i++)
+    {
+      path_start_ns =
+        MAX (
+          path_start_ns,
+          node->parentnodes[i]->path_end_ns);
+    }
+  node->path_end_ns = path_start_ns + own_ns;
+  g_atomic_int_add (
+    &node->graph->cycle_work_ns, own_ns);
+}
+
+/**
+ * Clears the pooled buffers the node writes to.
+ *
+ * Pooled buffers contain data of other ports, so
+ * they are cleared when their lifetime starts
+ * rather than before the cycle.
+ */
+static inline void
+clear_pooled_bufs (
+  GraphNode * node)
+{
+  if (node->type == ROUTE_NODE_TYPE_PORT)
+    {
+      Port * port = node->port;
+      if (port->own_buf
+          && port->id.flow == FLOW_INPUT)
+        {
+          port_clear_buffer (port);
+        }
+    }
+  else if (node->type == ROUTE_NODE_TYPE_PLUGIN)
+    {
+      Plugin * pl = node->pl;
+      for (int i = 0; i < pl->num_out_ports; i++)
+        {
+          Port * port = pl->out_ports[i];
+          if (port->own_buf)
+            {
+              port_clear_buffer (port);
+            }
+        }
+    }
+}
+
+/**
+ * Lane events are merged by the track node per
+ * split, so clear them once for the whole cycle.
+ */
+static inline void
+clear_lane_events (
+  GraphNode * node)
+{
+  if (node->type != ROUTE_NODE_TYPE_TRACK_LANE)
+    return;
+
+  Track * track = node->track;
+  if (node->lane_pos < track->num_lanes
+      && track->lanes[node->lane_pos]->midi_events)
+    {
+      midi_events_clear (
+        track->lanes[node->lane_pos]->
+          midi_events,
+        F_QUEUED);
+    }
+}
+
+/**
+ * Processes the node, splitting at loop points.
+ */
+static inline void
+process_split_at_loop_points (
+  GraphNode *           node,
+  EngineProcessTimeInfo time_nfo,
+  RegionIndexCursor *   cursors)
+{
+  /* split at loop points */
+  for (nframes_t num_processable_frames = 0;
+       (num_processable_frames =
+          MIN (
+            transport_is_loop_point_met (
+              TRANSPORT, time_nfo.g_start_frames,
+              time_nfo.nframes),
+            time_nfo.nframes)) != 0;)
+    {
+#if 0
+      g_message (
+        "splitting from %ld "
+        "(num processable frames %"
+        PRIu32 ")",
+        g_start_frames, num_processable_frames);
+#endif
+
+      /* temporarily change the nframes to avoid
+       * having to declare a separate
+       * EngineProcessTimeInfo */
+      nframes_t orig_nframes = time_nfo.nframes;
+      time_nfo.nframes =
+        num_processable_frames;
+      process_node (node, &time_nfo, cursors);
+
+      /* calculate the remaining frames */
+      time_nfo.nframes =
+        orig_nframes - num_processable_frames;
+
+      /* loop back to loop start */
+      time_nfo.g_start_frames =
+        (time_nfo.g_start_frames
+         + num_processable_frames
+         + TRANSPORT->loop_start_pos.frames)
+        - TRANSPORT->loop_end_pos.frames;
+      time_nfo.local_offset +=
+        num_processable_frames;
+    }
+
+  if (time_nfo.nframes > 0)
+    {
+      process_node (node, &time_nfo, cursors);
+    }
+}
+
 /**
  * Processes the GraphNode.
  */
@@ -373,6 +551,13 @@ graph_node_process (
   g_return_if_fail (
     node && node->graph && node->graph->router);
 
+  bool measure =
+    node->graph->measure_parallelism &&
+    node->graph->router->callback_in_progress;
+  gint64 start_ns = measure ? get_time_ns () : 0;
+
+  clear_pooled_bufs (node);
+
   /*g_message (*/
     /*"processing %s", graph_node_get_name (node));*/
 
@@ -386,6 +571,23 @@ graph_node_process (
       goto node_process_finish;
     }
 
+  /* nodes rendered ahead by the prerenderer */
+  if (node->prerender_track
+      && node->prerender_track->skip_nodes)
+    {
+      goto node_process_finish;
+    }
+  if (node->prerender_output
+      && node->prerender_output->skip_nodes)
+    {
+      prerender_track_read (
+        node->prerender_output, node->port,
+        &time_nfo);
+      goto node_process_finish;
+    }
+
+  clear_lane_events (node);
+
   /* figure out if we are doing a no-roll */
   if (node->route_playback_latency <
         AUDIO_ENGINE->remaining_latency_preroll)
@@ -435,57 +637,38 @@ graph_node_process (
         playhead_copy.frames;
     }
 
-  /* split at loop points */
-  for (nframes_t num_processable_frames = 0;
-       (num_processable_frames =
-          MIN (
-            transport_is_loop_point_met (
-              TRANSPORT, time_nfo.g_start_frames,
-              time_nfo.nframes),
-            time_nfo.nframes)) != 0;)
-    {
-#if 0
-      g_message (
-        "splitting from %ld "
-        "(num processable frames %"
-        PRIu32 ")",
-        g_start_frames, num_processable_frames);
-#endif
+  process_split_at_loop_points (
+    node, time_nfo, node->region_cursors);
 
-      /* temporarily change the nframes to avoid
-       * having to declare a separate
-       * EngineProcessTimeInfo */
-      nframes_t orig_nframes = time_nfo.nframes;
-      time_nfo.nframes =
-        num_processable_frames;
-      process_node (node, &time_nfo);
-
-      /* calculate the remaining frames */
-      time_nfo.nframes =
-        orig_nframes - num_processable_frames;
-
-      /* loop back to loop start */
-      time_nfo.g_start_frames =
-        (time_nfo.g_start_frames
-         + num_processable_frames
-         + TRANSPORT->loop_start_pos.frames)
-        - TRANSPORT->loop_end_pos.frames;
-      time_nfo.local_offset +=
-        num_processable_frames;
-    }
-
-  if (time_nfo.nframes > 0)
+node_process_finish:
+  if (measure)
     {
-      process_node (node, &time_nfo);
+      record_process_time (node, start_ns);
     }
 
-node_process_finish:
   if (node->graph->router->callback_in_progress)
     {
       on_node_finish (node);
     }
 }
 
+/**
+ * Processes the GraphNode outside of a graph
+ * cycle at the given (already latency
+ * compensated) time.
+ *
+ * The node's children are not triggered.
+ */
+void
+graph_node_process_ahead (
+  GraphNode *           node,
+  EngineProcessTimeInfo time_nfo)
+{
+  clear_lane_events (node);
+  process_split_at_loop_points (
+    node, time_nfo, node->ahead_region_cursors);
+}
+
 /**
  * Called by an upstream node when it has completed
  * processing.
@@ -679,6 +862,8 @@ graph_node_new (
       /* set cache */
       node->track->name_hash =
         track_get_name_hash (node->track);
+      node->num_region_cursors =
+        node->track->num_lanes;
       break;
     case ROUTE_NODE_TYPE_INITIAL_PROCESSOR:
       break;
@@ -693,10 +878,30 @@ graph_node_new (
     case ROUTE_NODE_TYPE_CHANNEL_SEND:
       node->send = (ChannelSend *) data;
       break;
+    case ROUTE_NODE_TYPE_TRACK_LANE:
+      {
+        TrackLane * lane = (TrackLane *) data;
+        node->track = lane->track;
+        node->lane_pos = lane->pos;
+        node->num_region_cursors = 1;
+      }
+      break;
     default:
       g_return_val_if_reached (node);
     }
 
+  if (node->num_region_cursors > 0)
+    {
+      node->region_cursors =
+        object_new_n (
+          (size_t) node->num_region_cursors,
+          RegionIndexCursor);
+      node->ahead_region_cursors =
+        object_new_n (
+          (size_t) node->num_region_cursors,
+          RegionIndexCursor);
+    }
+
   return node;
 }
 
@@ -706,6 +911,10 @@ graph_node_free (
 {
   free (self->childnodes);
   free (self->parentnodes);
+  object_zero_and_free_if_nonnull (
+    self->region_cursors);
+  object_zero_and_free_if_nonnull (
+    self->ahead_region_cursors);
 
   object_zero_and_free (self);
 }
@@ -43,12 +43,97 @@
 #include "audio/graph_thread.h"
 #include "audio/router.h"
 #include "project.h"
+#include "utils/cpu_affinity.h"
 #include "utils/mpmc_queue.h"
 #include "utils/objects.h"
+#include "utils/rt_memory.h"
 
 /* uncomment to show debug messages */
 /*#define DEBUG_THREADS 1*/
 
+/**
+ * Pins the thread to its CPUs, if any, and
+ * remembers its placement for reporting.
+ *
+ * Worker threads get one CPU each and the main
+ * thread gets all of the audio thread CPUs.
+ */
+static void
+apply_cpu_affinity (
+  GraphThread * self)
+{
+  Graph * graph = self->graph;
+
+  self->tid = cpu_affinity_get_current_thread_id ();
+
+  if (self->id == -1 && graph->audio_thread_cpus)
+    {
+      cpu_affinity_pin_current_thread (
+        (int *) graph->audio_thread_cpus->data,
+        graph->audio_thread_cpus->len);
+    }
+  else if (self->id >= 0
+           && graph->graph_thread_cpus)
+    {
+      int cpu =
+        g_array_index (
+          graph->graph_thread_cpus, int,
+          (guint) self->id %
+            graph->graph_thread_cpus->len);
+      cpu_affinity_pin_current_thread (&cpu, 1);
+    }
+
+  char * cpus =
+    cpu_affinity_get_current_thread_cpus ();
+  if (cpus)
+    {
+      g_strlcpy (
+        self->allowed_cpus, cpus,
+        sizeof (self->allowed_cpus));
+      g_free (cpus);
+    }
+}
+
+/**
+ * Parks the thread until it is activated again or
+ * the graph terminates.
+ *
+ * Parked threads count as idle so that the end of
+ * the cycle does not wait for them.
+ */
+static void
+park (
+  GraphThread * self)
+{
+  Graph * graph = self->graph;
+
+  /* increase the idle count first so the number
+   * of idle, unparked threads is never
+   * underestimated */
+  g_atomic_int_inc (&graph->idle_thread_cnt);
+  g_atomic_int_inc (&graph->parked_thread_cnt);
+
+#ifdef DEBUG_THREADS
+  g_message ("[%d]: parking", self->id);
+#endif
+
+  /* the semaphore may have been posted while the
+   * thread was still active, so recheck */
+  while (
+    self->id >=
+      g_atomic_int_get (
+        &graph->num_active_threads)
+    && !g_atomic_int_get (&graph->terminate))
+    {
+      zix_sem_wait (&self->park_sem);
+    }
+
+  g_atomic_int_dec_and_test (
+    &graph->parked_thread_cnt);
+  g_atomic_int_dec_and_test (
+    &graph->idle_thread_cnt);
+}
+
 static void *
 worker_thread (void * arg)
 {
@@ -60,9 +145,13 @@ worker_thread (void * arg)
    * allocation is done later on */
   g_thread_self ();
 
+  apply_cpu_affinity (thread);
+
   g_message (
-    "WORKER THREAD %d created (num threads %d)",
-    thread->id, graph->num_threads);
+    "WORKER THREAD %d created (num threads %d, "
+    "tid %ld, CPUs %s)",
+    thread->id, graph->num_threads, thread->tid,
+    thread->allowed_cpus);
 
   /* wait for all threads to get created */
   if (thread->id < graph->num_threads - 1)
@@ -77,12 +166,17 @@ worker_thread (void * arg)
     }
 #endif
 
+  rt_memory_prefault_stack (
+    RT_MEMORY_STACK_PREFAULT_SIZE);
+  rt_memory_set_thread_realtime (true);
+
   for (;;)
     {
       to_run = NULL;
 
       if (g_atomic_int_get (&graph->terminate))
         {
+          rt_memory_set_thread_realtime (false);
           if (thread->id == -1)
             {
               g_message ("terminating main thread");
@@ -114,10 +208,14 @@ worker_thread (void * arg)
            * threads.
            * This thread as not yet decreased
            * _trigger_queue_size. */
-          guint idle_cnt =
-            (guint)
+          gint unparked_idle_cnt =
+            (gint)
             g_atomic_int_get (
-              &graph->idle_thread_cnt);
+              &graph->idle_thread_cnt) -
+            g_atomic_int_get (
+              &graph->parked_thread_cnt);
+          guint idle_cnt =
+            (guint) MAX (unparked_idle_cnt, 0);
           guint work_avail =
             (guint)
             g_atomic_int_get (
@@ -139,6 +237,23 @@ worker_thread (void * arg)
 
       while (!to_run)
         {
+          if (thread->id >=
+                g_atomic_int_get (
+                  &graph->num_active_threads))
+            {
+              park (thread);
+
+              if (g_atomic_int_get (
+                    &graph->terminate))
+                {
+                  goto terminate_thread;
+                }
+
+              mpmc_queue_dequeue_node (
+                graph->trigger_queue, &to_run);
+              continue;
+            }
+
           /* wait for work, fall asleep */
           g_atomic_int_inc (
             &graph->idle_thread_cnt);
@@ -200,6 +315,8 @@ worker_thread (void * arg)
 
 terminate_thread:
 
+  rt_memory_set_thread_realtime (false);
+
 #ifdef HAVE_LSP_DSP
   if (ZRYTHM_USE_OPTIMIZED_DSP)
     {
@@ -276,6 +393,7 @@ graph_thread_new (
 
   self->id = id;
   self->graph = graph;
+  zix_sem_init (&self->park_sem, 0);
 
 #ifdef HAVE_JACK
   if (AUDIO_ENGINE->audio_backend ==
@@ -314,3 +432,15 @@ graph_thread_new (
 
   return self;
 }
+
+/**
+ * Frees the thread after it was joined.
+ */
+void
+graph_thread_free (
+  GraphThread * self)
+{
+  zix_sem_destroy (&self->park_sem);
+
+  object_zero_and_free (self);
+}
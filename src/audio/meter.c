@@ -23,6 +23,7 @@
 #include "audio/midi_event.h"
 #include "audio/peak_dsp.h"
 #include "audio/port.h"
+#include "audio/router.h"
 #include "audio/track.h"
 #include "audio/true_peak_dsp.h"
 #include "project.h"
@@ -230,6 +231,18 @@ meter_new_for_port (
 
   self->port = port;
 
+  /* the meter reads the buffer outside the
+   * processing cycle, so it can't be shared */
+  port->metered = true;
+  if (port->own_buf)
+    {
+      if (ROUTER)
+        zix_sem_wait (&ROUTER->graph_access);
+      port_release_pooled_buf (port);
+      if (ROUTER)
+        zix_sem_post (&ROUTER->graph_access);
+    }
+
   /* master */
   if (port->id.type == TYPE_AUDIO ||
       port->id.type == TYPE_CV)
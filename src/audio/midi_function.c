@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2020 Alexandros Theodotou <alex at zrythm dot org>
+ * Copyright (C) 2020-2021 Alexandros Theodotou <alex at zrythm dot org>
  *
  * This file is part of Zrythm
  *
@@ -17,14 +17,345 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "audio/engine.h"
 #include "audio/midi_function.h"
+#include "audio/midi_note_columns.h"
+#include "audio/position.h"
 #include "gui/backend/arranger_selections.h"
-#include "gui/backend/event.h"
-#include "gui/backend/event_manager.h"
-#include "project.h"
-#include "settings/settings.h"
-#include "zrythm_app.h"
+#include "gui/backend/midi_arranger_selections.h"
+#include "utils/math.h"
+
+#include <math.h>
+
+#include <glib/gi18n.h>
+
+typedef enum
+{
+  Z_AUDIO_MIDI_FUNCTION_ERROR_UNSUPPORTED,
+} ZAudioMidiFunctionError;
+
+#define Z_AUDIO_MIDI_FUNCTION_ERROR \
+  z_audio_midi_function_error_quark ()
+GQuark z_audio_midi_function_error_quark (void);
+G_DEFINE_QUARK (
+  z-audio-midi-function-error-quark, z_audio_midi_function_error)
+
+/** Offset between strummed notes. */
+#define STRUM_TICKS (TICKS_PER_SIXTEENTH_NOTE_DBL / 4.0)
+
+static int
+cmp_notes (
+  gconstpointer a,
+  gconstpointer b,
+  gpointer      user_data)
+{
+  const MidiNoteColumns * cols =
+    (const MidiNoteColumns *) user_data;
+  int i = *(const int *) a;
+  int j = *(const int *) b;
+
+  if (cols->region_indices[i] !=
+        cols->region_indices[j])
+    return
+      cols->region_indices[i] -
+      cols->region_indices[j];
+  if (cols->start_ticks[i] < cols->start_ticks[j])
+    return -1;
+  if (cols->start_ticks[i] > cols->start_ticks[j])
+    return 1;
+  return
+    (int) cols->pitches[i] - (int) cols->pitches[j];
+}
+
+/**
+ * Returns the note indices sorted by region, start
+ * position and pitch.
+ *
+ * Must be free'd with g_free().
+ */
+static int *
+get_sorted_notes (
+  MidiNoteColumns * cols)
+{
+  int * sorted =
+    g_new (int, (size_t) MAX (cols->num_notes, 1));
+  for (int i = 0; i < cols->num_notes; i++)
+    sorted[i] = i;
+  g_qsort_with_data (
+    sorted, cols->num_notes, sizeof (int),
+    cmp_notes, cols);
+
+  return sorted;
+}
+
+/**
+ * Returns the index in @p sorted after the last
+ * note in the same region as sorted[@p from].
+ */
+static int
+get_region_end (
+  MidiNoteColumns * cols,
+  int *             sorted,
+  int               from)
+{
+  int end = from;
+  while (end < cols->num_notes &&
+         cols->region_indices[sorted[end]] ==
+           cols->region_indices[sorted[from]])
+    end++;
+
+  return end;
+}
+
+/**
+ * Ramps the velocities of the notes in each region
+ * from half the loudest velocity to the loudest
+ * velocity.
+ */
+static void
+crescendo (
+  MidiNoteColumns * cols,
+  int *             sorted)
+{
+  for (int from = 0; from < cols->num_notes;)
+    {
+      int to = get_region_end (cols, sorted, from);
+      int num = to - from;
+
+      uint8_t max_vel = 0;
+      for (int k = from; k < to; k++)
+        {
+          max_vel =
+            MAX (max_vel, cols->velocities[sorted[k]]);
+        }
+      double start_vel = max_vel / 2.0;
+      for (int k = from; k < to && num > 1; k++)
+        {
+          double vel =
+            start_vel +
+            ((max_vel - start_vel) * (k - from)) /
+              (num - 1);
+          cols->velocities[sorted[k]] =
+            (uint8_t) CLAMP (round (vel), 1, 127);
+        }
+
+      from = to;
+    }
+}
+
+static void
+flip (
+  MidiNoteColumns * cols,
+  int *             sorted,
+  bool              vertical)
+{
+  if (vertical)
+    {
+      uint8_t min_pitch = 127;
+      uint8_t max_pitch = 0;
+      for (int i = 0; i < cols->num_notes; i++)
+        {
+          min_pitch =
+            MIN (min_pitch, cols->pitches[i]);
+          max_pitch =
+            MAX (max_pitch, cols->pitches[i]);
+        }
+      for (int i = 0; i < cols->num_notes; i++)
+        {
+          cols->pitches[i] =
+            (uint8_t)
+            ((min_pitch + max_pitch) -
+               cols->pitches[i]);
+        }
+      return;
+    }
+
+  for (int from = 0; from < cols->num_notes;)
+    {
+      int to = get_region_end (cols, sorted, from);
+
+      double min_start =
+        cols->start_ticks[sorted[from]];
+      double max_end =
+        cols->end_ticks[sorted[from]];
+      for (int k = from; k < to; k++)
+        {
+          max_end =
+            MAX (max_end, cols->end_ticks[sorted[k]]);
+        }
+      for (int k = from; k < to; k++)
+        {
+          int i = sorted[k];
+          double start = cols->start_ticks[i];
+          cols->start_ticks[i] =
+            (min_start + max_end) -
+            cols->end_ticks[i];
+          cols->end_ticks[i] =
+            (min_start + max_end) - start;
+        }
+
+      from = to;
+    }
+}
+
+/**
+ * Extends each note to the start of the next note
+ * in the same region.
+ */
+static void
+legato (
+  MidiNoteColumns * cols,
+  int *             sorted)
+{
+  for (int from = 0; from < cols->num_notes;)
+    {
+      int to = get_region_end (cols, sorted, from);
+
+      int next = from;
+      for (int k = from; k < to; k++)
+        {
+          int i = sorted[k];
+
+          /* find the next note starting after this
+           * one (skipping notes in the same
+           * chord) */
+          if (next <= k)
+            next = k + 1;
+          while (next < to &&
+                 cols->start_ticks[sorted[next]] <=
+                   cols->start_ticks[i])
+            next++;
+          if (next == to)
+            break;
+
+          cols->end_ticks[i] =
+            cols->start_ticks[sorted[next]];
+        }
+
+      from = to;
+    }
+}
+
+static void
+scale_lengths (
+  MidiNoteColumns * cols,
+  double            factor)
+{
+  for (int i = 0; i < cols->num_notes; i++)
+    {
+      cols->end_ticks[i] =
+        cols->start_ticks[i] +
+        (cols->end_ticks[i] - cols->start_ticks[i]) *
+          factor;
+    }
+}
+
+/**
+ * Offsets notes starting at the same position by
+ * increasing pitch.
+ */
+static void
+strum (
+  MidiNoteColumns * cols,
+  int *             sorted)
+{
+  int chord_idx = 0;
+  double chord_start = 0.0;
+  for (int k = 0; k < cols->num_notes; k++)
+    {
+      int i = sorted[k];
+      if (k > 0 &&
+          cols->region_indices[i] ==
+            cols->region_indices[sorted[k - 1]] &&
+          math_doubles_equal (
+            cols->start_ticks[i], chord_start))
+        {
+          chord_idx++;
+        }
+      else
+        {
+          chord_idx = 0;
+          chord_start = cols->start_ticks[i];
+          continue;
+        }
+
+      cols->start_ticks[i] +=
+        chord_idx * STRUM_TICKS;
+      if (cols->end_ticks[i] <=
+            cols->start_ticks[i])
+        {
+          cols->end_ticks[i] =
+            cols->start_ticks[i] + STRUM_TICKS;
+        }
+    }
+}
+
+/**
+ * Applies the given function to all the notes in
+ * the given columns in one pass.
+ *
+ * This only edits the columns. The result can be
+ * written to the notes with
+ * midi_note_columns_apply().
+ *
+ * @return Non-zero if failed.
+ */
+int
+midi_function_apply_to_columns (
+  MidiNoteColumns *    cols,
+  MidiFunctionType     type,
+  GError **            error)
+{
+  if (type == MIDI_FUNCTION_FLAM)
+    {
+      /* flams need new grace notes, which the
+       * columns cannot add */
+      g_set_error (
+        error, Z_AUDIO_MIDI_FUNCTION_ERROR,
+        Z_AUDIO_MIDI_FUNCTION_ERROR_UNSUPPORTED,
+        _("%s is not supported yet"),
+        _(midi_function_type_to_string (type)));
+      return -1;
+    }
+
+  g_message (
+    "applying %s to %d notes...",
+    midi_function_type_to_string (type),
+    cols->num_notes);
+
+  int * sorted = get_sorted_notes (cols);
+
+  switch (type)
+    {
+    case MIDI_FUNCTION_CRESCENDO:
+      crescendo (cols, sorted);
+      break;
+    case MIDI_FUNCTION_FLAM:
+      /* handled above */
+      break;
+    case MIDI_FUNCTION_FLIP_HORIZONTAL:
+      flip (cols, sorted, false);
+      break;
+    case MIDI_FUNCTION_FLIP_VERTICAL:
+      flip (cols, sorted, true);
+      break;
+    case MIDI_FUNCTION_LEGATO:
+      legato (cols, sorted);
+      break;
+    case MIDI_FUNCTION_PORTATO:
+      scale_lengths (cols, 0.75);
+      break;
+    case MIDI_FUNCTION_STACCATO:
+      scale_lengths (cols, 0.5);
+      break;
+    case MIDI_FUNCTION_STRUM:
+      strum (cols, sorted);
+      break;
+    }
+
+  g_free (sorted);
+
+  return 0;
+}
 
 /**
  * Applies the given action to the given selections.
@@ -38,16 +369,19 @@ midi_function_apply (
   MidiFunctionType     type,
   GError **            error)
 {
-  /* TODO */
-  g_message (
-    "applying %s...",
-    midi_function_type_to_string (type));
-
-  /* set last action */
-  g_settings_set_int (
-    S_UI, "midi-function", type);
+  MidiArrangerSelections * mas =
+    (MidiArrangerSelections *) sel;
+  MidiNoteColumns * cols =
+    midi_note_columns_new_from_selections (mas);
+  int ret =
+    midi_function_apply_to_columns (
+      cols, type, error);
+  if (ret == 0)
+    {
+      midi_note_columns_apply_to_selections (
+        cols, mas);
+    }
+  midi_note_columns_free (cols);
 
-  EVENTS_PUSH (ET_EDITOR_FUNCTION_APPLIED, NULL);
-
-  return 0;
+  return ret;
 }
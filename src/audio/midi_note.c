@@ -319,6 +319,8 @@ midi_note_set_val (
     }
 
   midi_note->val = val;
+  arranger_object_bump_region_content_version (
+    (ArrangerObject *) midi_note);
 }
 
 /**
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "audio/midi_note.h"
+#include "audio/midi_note_columns.h"
+#include "audio/region.h"
+#include "gui/backend/midi_arranger_selections.h"
+#include "utils/objects.h"
+
+#include <glib/gi18n.h>
+
+typedef enum
+{
+  Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR_NOT_FOUND,
+} ZAudioMidiNoteColumnsError;
+
+#define Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR \
+  z_audio_midi_note_columns_error_quark ()
+GQuark z_audio_midi_note_columns_error_quark (void);
+G_DEFINE_QUARK (
+  z-audio-midi-note-columns-error-quark, z_audio_midi_note_columns_error)
+
+static void
+alloc_columns (
+  MidiNoteColumns * self,
+  int               num_notes)
+{
+  size_t n = (size_t) MAX (num_notes, 1);
+  self->num_notes = num_notes;
+  self->region_indices = g_new0 (int, n);
+  self->note_indices = g_new0 (int, n);
+  self->start_ticks = g_new0 (double, n);
+  self->end_ticks = g_new0 (double, n);
+  self->pitches = g_new0 (uint8_t, n);
+  self->velocities = g_new0 (uint8_t, n);
+  self->muted = g_new0 (uint8_t, n);
+}
+
+/**
+ * Returns the index of the given region
+ * identifier in the region IDs, adding it if not
+ * found.
+ */
+static int
+get_or_add_region_idx (
+  MidiNoteColumns *        self,
+  const RegionIdentifier * id)
+{
+  /* notes in the selections are usually grouped
+   * by region, so check the last one first */
+  for (int i = self->num_region_ids - 1; i >= 0;
+       i--)
+    {
+      if (region_identifier_is_equal (
+            &self->region_ids[i], id))
+        return i;
+    }
+
+  self->region_ids =
+    g_renew (
+      RegionIdentifier, self->region_ids,
+      (size_t) self->num_region_ids + 1);
+  region_identifier_copy (
+    &self->region_ids[self->num_region_ids], id);
+
+  return self->num_region_ids++;
+}
+
+/**
+ * Creates columns from the MIDI notes in the
+ * given selections (project selections or a
+ * clone).
+ */
+MidiNoteColumns *
+midi_note_columns_new_from_selections (
+  MidiArrangerSelections * sel)
+{
+  MidiNoteColumns * self =
+    object_new (MidiNoteColumns);
+  self->schema_version =
+    MIDI_NOTE_COLUMNS_SCHEMA_VERSION;
+
+  alloc_columns (self, sel->num_midi_notes);
+  for (int i = 0; i < sel->num_midi_notes; i++)
+    {
+      MidiNote * mn = sel->midi_notes[i];
+      ArrangerObject * obj = (ArrangerObject *) mn;
+      self->region_indices[i] =
+        get_or_add_region_idx (
+          self, &obj->region_id);
+      self->note_indices[i] = mn->pos;
+      self->start_ticks[i] = obj->pos.ticks;
+      self->end_ticks[i] = obj->end_pos.ticks;
+      self->pitches[i] = mn->val;
+      self->velocities[i] = mn->vel->vel;
+      self->muted[i] = (uint8_t) obj->muted;
+    }
+
+  return self;
+}
+
+MidiNoteColumns *
+midi_note_columns_clone (
+  const MidiNoteColumns * src)
+{
+  MidiNoteColumns * self =
+    object_new (MidiNoteColumns);
+  self->schema_version =
+    MIDI_NOTE_COLUMNS_SCHEMA_VERSION;
+
+  self->num_region_ids = src->num_region_ids;
+  self->region_ids =
+    g_new (
+      RegionIdentifier,
+      (size_t) MAX (src->num_region_ids, 1));
+  for (int i = 0; i < src->num_region_ids; i++)
+    {
+      region_identifier_copy (
+        &self->region_ids[i], &src->region_ids[i]);
+    }
+
+  int n = src->num_notes;
+  alloc_columns (self, n);
+#define COPY_COLUMN(x) \
+  memcpy ( \
+    self->x, src->x, \
+    (size_t) n * sizeof (*src->x))
+
+  COPY_COLUMN (region_indices);
+  COPY_COLUMN (note_indices);
+  COPY_COLUMN (start_ticks);
+  COPY_COLUMN (end_ticks);
+  COPY_COLUMN (pitches);
+  COPY_COLUMN (velocities);
+  COPY_COLUMN (muted);
+
+#undef COPY_COLUMN
+
+  return self;
+}
+
+/**
+ * Writes the attributes of note @p i to the given
+ * MidiNote.
+ *
+ * @param in_project Whether the note is a project
+ *   note (sends note offs if needed).
+ */
+static void
+write_note (
+  const MidiNoteColumns * self,
+  int                     i,
+  MidiNote *              mn,
+  bool                    in_project)
+{
+  ArrangerObject * obj = (ArrangerObject *) mn;
+
+  /* skip invalid lengths and keep the previous
+   * positions */
+  if (self->end_ticks[i] > self->start_ticks[i])
+    {
+      position_from_ticks (
+        &obj->pos, self->start_ticks[i]);
+      position_from_ticks (
+        &obj->end_pos, self->end_ticks[i]);
+    }
+
+  if (mn->val != self->pitches[i])
+    {
+      if (in_project)
+        midi_note_set_val (mn, self->pitches[i]);
+      else
+        mn->val = self->pitches[i];
+    }
+  mn->vel->vel = self->velocities[i];
+  obj->muted = self->muted[i];
+}
+
+/**
+ * Writes the attributes to the corresponding MIDI
+ * notes in the project.
+ *
+ * Each region is looked up once and no events are
+ * published; the caller is expected to publish a
+ * single event for the whole change.
+ *
+ * @return Non-zero if failed.
+ */
+int
+midi_note_columns_apply (
+  const MidiNoteColumns * self,
+  GError **               error)
+{
+  ZRegion ** regions =
+    g_new (ZRegion *, MAX (self->num_region_ids, 1));
+  for (int i = 0; i < self->num_region_ids; i++)
+    {
+      regions[i] =
+        region_find (&self->region_ids[i]);
+      if (!regions[i])
+        {
+          g_set_error_literal (
+            error,
+            Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR,
+            Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR_NOT_FOUND,
+            _("Failed to find the region of "
+            "the MIDI notes"));
+          g_free (regions);
+          return -1;
+        }
+    }
+
+  for (int i = 0; i < self->num_notes; i++)
+    {
+      ZRegion * r =
+        regions[self->region_indices[i]];
+      int idx = self->note_indices[i];
+      if (idx < 0 || idx >= r->num_midi_notes)
+        {
+          g_set_error (
+            error,
+            Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR,
+            Z_AUDIO_MIDI_NOTE_COLUMNS_ERROR_NOT_FOUND,
+            _("MIDI note %d not found in region "
+            "%s"), idx, r->name);
+          g_free (regions);
+          return -1;
+        }
+
+      write_note (
+        self, i, r->midi_notes[idx], true);
+    }
+
+  /* invalidate the thumbnails and update linked
+   * regions once per region */
+  for (int i = 0; i < self->num_region_ids; i++)
+    {
+      regions[i]->content_version++;
+      region_update_link_group (regions[i]);
+    }
+  g_free (regions);
+
+  return 0;
+}
+
+/**
+ * Writes the attributes to the MIDI notes in the
+ * given selections, which must be the selections
+ * (or a clone of the selections) the columns were
+ * created from.
+ *
+ * This is meant for non-project notes and only
+ * sets the values.
+ */
+void
+midi_note_columns_apply_to_selections (
+  const MidiNoteColumns *  self,
+  MidiArrangerSelections * sel)
+{
+  g_return_if_fail (
+    sel->num_midi_notes == self->num_notes);
+
+  for (int i = 0; i < self->num_notes; i++)
+    {
+      write_note (
+        self, i, sel->midi_notes[i], false);
+    }
+}
+
+void
+midi_note_columns_free (
+  MidiNoteColumns * self)
+{
+  g_free (self->region_ids);
+  g_free (self->region_indices);
+  g_free (self->note_indices);
+  g_free (self->start_ticks);
+  g_free (self->end_ticks);
+  g_free (self->pitches);
+  g_free (self->velocities);
+  g_free (self->muted);
+
+  object_zero_and_free (self);
+}
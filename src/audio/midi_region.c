@@ -192,6 +192,7 @@ midi_region_insert_midi_note (
       midi_note_set_region_and_index (
         mn, self, i);
     }
+  self->content_version++;
 
   if (pub_events)
     {
@@ -369,6 +370,7 @@ midi_region_remove_midi_note (
       midi_note_set_region_and_index (
         region->midi_notes[i], region, i);
     }
+  region->content_version++;
 
   if (free)
     free_later (midi_note, arranger_object_free);
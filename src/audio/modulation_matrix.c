@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audio/modulation_matrix.h"
+#include "audio/port.h"
+#include "audio/port_connection.h"
+#include "plugins/plugin.h"
+#include "utils/objects.h"
+
+/**
+ * Returns whether the port is a control input
+ * with at least one CV source.
+ */
+static bool
+is_modulated (
+  Port * port)
+{
+  if (port->deleting
+      || port->id.type != TYPE_CONTROL
+      || port->id.flow != FLOW_INPUT)
+    return false;
+
+  if (port->id.owner_type ==
+        PORT_OWNER_TYPE_PLUGIN)
+    {
+      Plugin * pl = port_get_plugin (port, true);
+      if (!pl || pl->deleting)
+        return false;
+    }
+
+  for (int i = 0; i < port->num_srcs; i++)
+    {
+      if (port->srcs[i]->id.type == TYPE_CV)
+        return true;
+    }
+
+  return false;
+}
+
+/**
+ * Creates a modulation matrix from the CV
+ * connections of the given control ports.
+ *
+ * Port.srcs of the ports must be up to date.
+ * Control ports without CV sources get their
+ * modulation offset reset.
+ *
+ * @param ports Ports to consider (ports that are
+ *   not control inputs with CV sources or that are
+ *   being deleted are ignored).
+ * @param control_rate Control rate in Hz, or 0 to
+ *   update every cycle.
+ */
+ModulationMatrix *
+modulation_matrix_new (
+  GPtrArray *    ports,
+  unsigned int   control_rate,
+  sample_rate_t  sample_rate)
+{
+  ModulationMatrix * self =
+    object_new (ModulationMatrix);
+
+  /* count the destinations and routes first so
+   * that everything can be allocated at once */
+  int num_dests = 0, num_routes = 0;
+  for (size_t i = 0; i < ports->len; i++)
+    {
+      Port * port = g_ptr_array_index (ports, i);
+      if (!is_modulated (port))
+        {
+          /* restore the unmodulated value of ports
+           * that stopped being destinations */
+          if (port->id.type == TYPE_CONTROL
+              && port->modulation_offset != 0.f)
+            {
+              port->modulation_offset = 0.f;
+              port->control = port->base_value;
+            }
+          continue;
+        }
+
+      num_dests++;
+      for (int j = 0; j < port->num_srcs; j++)
+        {
+          if (port->srcs[j]->id.type == TYPE_CV)
+            num_routes++;
+        }
+    }
+
+  self->src_ports =
+    object_new_n ((size_t) num_routes, Port *);
+  self->conns =
+    object_new_n (
+      (size_t) num_routes,
+      const PortConnection *);
+  self->cv_vals =
+    object_new_n ((size_t) num_routes, float);
+  self->depths =
+    object_new_n ((size_t) num_routes, float);
+  self->dest_ports =
+    object_new_n ((size_t) num_dests, Port *);
+  self->depth_ranges =
+    object_new_n ((size_t) num_dests, float);
+  self->dest_route_starts =
+    object_new_n ((size_t) num_dests + 1, int);
+
+  for (size_t i = 0; i < ports->len; i++)
+    {
+      Port * port = g_ptr_array_index (ports, i);
+      if (!is_modulated (port))
+        continue;
+
+      int d = self->num_dests++;
+      self->dest_ports[d] = port;
+      self->depth_ranges[d] =
+        (port->maxf - port->minf) * 0.5f;
+      self->dest_route_starts[d] =
+        self->num_routes;
+      for (int j = 0; j < port->num_srcs; j++)
+        {
+          Port * src = port->srcs[j];
+          if (src->id.type != TYPE_CV)
+            continue;
+
+          int r = self->num_routes++;
+          self->src_ports[r] = src;
+          self->conns[r] = port->src_connections[j];
+        }
+    }
+  self->dest_route_starts[self->num_dests] =
+    self->num_routes;
+
+  if (control_rate > 0 && sample_rate > 0)
+    {
+      self->control_period =
+        sample_rate / control_rate;
+    }
+
+  /* update on the first cycle */
+  self->frames_since_update = self->control_period;
+
+  g_debug (
+    "created modulation matrix with %d routes to "
+    "%d destinations (control period %u)",
+    self->num_routes, self->num_dests,
+    self->control_period);
+
+  return self;
+}
+
+/**
+ * Calculates the modulation offset of each
+ * destination if due.
+ *
+ * To be called by the processing thread after
+ * the graph finished processing the given range.
+ *
+ * @param last_frame Index of the last processed
+ *   frame in the CV buffers.
+ * @param nframes Number of frames processed.
+ */
+void
+modulation_matrix_process (
+  ModulationMatrix * self,
+  nframes_t          last_frame,
+  nframes_t          nframes)
+{
+  self->frames_since_update += nframes;
+  if (self->frames_since_update <
+        self->control_period)
+    return;
+  self->frames_since_update = 0;
+
+  const int num_routes = self->num_routes;
+  const int num_dests = self->num_dests;
+  float * restrict cv_vals = self->cv_vals;
+  float * restrict depths = self->depths;
+
+  /* gather the latest CV value and depth of each
+   * route */
+  for (int r = 0; r < num_routes; r++)
+    {
+      const PortConnection * conn =
+        self->conns[r];
+      cv_vals[r] =
+        self->src_ports[r]->buf[last_frame];
+      depths[r] =
+        conn->enabled ? conn->multiplier : 0.f;
+    }
+
+  /* scale all routes in one pass */
+  for (int r = 0; r < num_routes; r++)
+    {
+      cv_vals[r] *= depths[r];
+    }
+
+  /* sum the routes of each destination */
+  for (int d = 0; d < num_dests; d++)
+    {
+      float sum = 0.f;
+      const int end =
+        self->dest_route_starts[d + 1];
+      for (int r = self->dest_route_starts[d];
+           r < end; r++)
+        {
+          sum += cv_vals[r];
+        }
+      self->dest_ports[d]->modulation_offset =
+        sum * self->depth_ranges[d];
+    }
+}
+
+void
+modulation_matrix_free (
+  ModulationMatrix * self)
+{
+  object_zero_and_free (self->src_ports);
+  object_zero_and_free (self->conns);
+  object_zero_and_free (self->cv_vals);
+  object_zero_and_free (self->depths);
+  object_zero_and_free (self->dest_ports);
+  object_zero_and_free (self->depth_ranges);
+  object_zero_and_free (self->dest_route_starts);
+
+  object_zero_and_free (self);
+}
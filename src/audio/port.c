@@ -30,11 +30,13 @@
 #include "audio/control_port.h"
 #include "audio/engine_jack.h"
 #include "audio/graph.h"
+#include "audio/graph_buffer_pool.h"
 #include "audio/hardware_processor.h"
 #include "audio/master_track.h"
 #include "audio/midi_event.h"
 #include "audio/pan.h"
 #include "audio/port.h"
+#include "audio/prerenderer.h"
 #include "audio/router.h"
 #include "audio/rtaudio_device.h"
 #include "audio/rtmidi_device.h"
@@ -55,6 +57,7 @@
 #include "utils/mem.h"
 #include "utils/object_utils.h"
 #include "utils/objects.h"
+#include "utils/rt_memory.h"
 #include "utils/string.h"
 #include "zix/ring.h"
 #include "zrythm_app.h"
@@ -84,6 +87,8 @@ port_allocate_bufs (
   g_message ("allocating bufs for %s", str);
 #endif
 
+  port_release_pooled_buf (self);
+
   switch (self->id.type)
     {
     case TYPE_EVENT:
@@ -118,6 +123,79 @@ port_allocate_bufs (
     }
 }
 
+/**
+ * Returns whether the port's buffer may be shared
+ * with other ports whose buffers are never live at
+ * the same time.
+ *
+ * Only audio ports of plugins qualify, since
+ * their buffers are only accessed by graph nodes
+ * connected to the port's node.
+ */
+bool
+port_can_use_pooled_buf (
+  const Port * self)
+{
+  return
+    self->id.type == TYPE_AUDIO
+    && self->id.owner_type ==
+         PORT_OWNER_TYPE_PLUGIN
+    && self->internal_type == INTERNAL_NONE
+    && !self->metered
+    && !self->write_ring_buffers
+    && self->buf;
+}
+
+/**
+ * Makes the port use the given buffer of @p pool
+ * instead of its own.
+ *
+ * Must only be called while the graph is not
+ * running.
+ */
+void
+port_use_pooled_buf (
+  Port *            self,
+  GraphBufferPool * pool,
+  float *           buf)
+{
+  port_release_pooled_buf (self);
+
+  self->own_buf = self->buf;
+  self->buf = buf;
+
+  /* let the pool restore the port's buffer if it
+   * is freed while the port is not part of the
+   * graph anymore */
+  self->buffer_pool = pool;
+  self->buffer_pool_idx = pool->num_ports;
+  pool->ports[pool->num_ports++] = self;
+}
+
+/**
+ * Makes the port use its own buffer again if it
+ * was using a pooled buffer.
+ *
+ * Must only be called while the graph is not
+ * running.
+ */
+void
+port_release_pooled_buf (
+  Port * self)
+{
+  if (self->own_buf)
+    {
+      self->buf = self->own_buf;
+      self->own_buf = NULL;
+    }
+  if (self->buffer_pool)
+    {
+      self->buffer_pool->ports[
+        self->buffer_pool_idx] = NULL;
+      self->buffer_pool = NULL;
+    }
+}
+
 /**
  * Frees buffers.
  *
@@ -128,6 +206,8 @@ void
 port_free_bufs (
   Port * self)
 {
+  port_release_pooled_buf (self);
+
   object_free_w_func_and_null (
     midi_events_free, self->midi_events);
   object_free_w_func_and_null (
@@ -2032,6 +2112,11 @@ port_sum_data_from_rtmidi (
 /**
  * Dequeue the midi events from the ring
  * buffers into \ref RtMidiDevice.events.
+ *
+ * Only events that arrived before the current
+ * cycle started are dequeued. They are placed at
+ * the offset they arrived at in the previous
+ * period.
  */
 void
 port_prepare_rtmidi_events (
@@ -2042,7 +2127,10 @@ port_prepare_rtmidi_events (
     midi_backend_is_rtmidi (
       AUDIO_ENGINE->midi_backend));
 
-  gint64 cur_time = g_get_monotonic_time ();
+  gint64 cycle_start = AUDIO_ENGINE->timestamp_start;
+  gint64 period_start =
+    engine_get_previous_period_start (AUDIO_ENGINE);
+  nframes_t nframes = AUDIO_ENGINE->block_length;
   for (int i = 0; i < self->num_rtmidi_ins; i++)
     {
       RtMidiDevice * dev = self->rtmidi_ins[i];
@@ -2050,13 +2138,11 @@ port_prepare_rtmidi_events (
       /* clear the events */
       midi_events_clear (dev->events, 0);
 
-      uint32_t read_space = 0;
-      zix_sem_wait (&dev->midi_ring_sem);
-      do
+      for (;;)
         {
-          read_space =
+          uint32_t read_space =
             zix_ring_read_space (dev->midi_ring);
-          if (read_space <= sizeof(MidiEventHeader))
+          if (read_space <= sizeof (MidiEventHeader))
             {
               /* no more events */
               break;
@@ -2067,7 +2153,16 @@ port_prepare_rtmidi_events (
           MidiEventHeader h = { 0, 0 };
           zix_ring_peek (
             dev->midi_ring, &h, sizeof (h));
-          g_return_if_fail (h.size > 0);
+          g_return_if_fail (
+            h.size > 0 && h.size <= MIDI_BUFFER_SIZE);
+
+          /* received during this cycle or still
+           * being written - leave it for the next
+           * cycle */
+          if ((gint64) h.time >= cycle_start
+              || read_space <
+                   sizeof (MidiEventHeader) + h.size)
+            break;
 
           /* read event header */
           zix_ring_read (
@@ -2078,38 +2173,17 @@ port_prepare_rtmidi_events (
           zix_ring_read (
             dev->midi_ring, raw, sizeof (raw));
 
-          /* calculate event timestamp */
-          gint64 length =
-            cur_time - self->last_midi_dequeue;
           midi_time_t ev_time =
-            (midi_time_t)
-            (((double) h.time / (double) length) *
-            (double) AUDIO_ENGINE->block_length);
-
-          if (ev_time >= AUDIO_ENGINE->block_length)
-            {
-              g_warning (
-                "event with invalid time %u "
-                "received. the maximum allowed time "
-                "is %" PRIu32 ". setting it to "
-                "%u...",
-                ev_time,
-                AUDIO_ENGINE->block_length - 1,
-                AUDIO_ENGINE->block_length - 1);
-              ev_time =
-                (midi_byte_t)
-                (AUDIO_ENGINE->block_length - 1);
-            }
-
+            engine_get_input_frame_offset (
+              AUDIO_ENGINE, period_start,
+              (gint64) h.time, nframes);
           midi_events_add_event_from_buf (
             dev->events,
             ev_time, raw, (int) h.size,
             F_NOT_QUEUED);
-        } while (
-            read_space > sizeof (MidiEventHeader));
-      zix_sem_post (&dev->midi_ring_sem);
+        }
     }
-  self->last_midi_dequeue = cur_time;
+  self->last_midi_dequeue = cycle_start;
 }
 #endif // HAVE_RTMIDI
 
@@ -2312,12 +2386,17 @@ sum_data_from_windows_mme (
           continue;
         }
 
+      /* dequeue the events that arrived in the
+       * previous period */
       MidiEvent ev;
-      gint64 cur_time = g_get_monotonic_time ();
+      gint64 cur_time = AUDIO_ENGINE->timestamp_start;
+      gint64 period_start =
+        engine_get_previous_period_start (
+          AUDIO_ENGINE);
       while (
         windows_mme_device_dequeue_midi_event_struct (
-          dev, self->last_midi_dequeue,
-          cur_time, &ev))
+          dev, (uint64_t) period_start,
+          (uint64_t) cur_time, &ev))
         {
           int is_valid =
             ev.time >= start_frame &&
@@ -2541,6 +2620,22 @@ port_set_control_value (
       self->last_change = g_get_monotonic_time ();
       self->value_changed_from_reading = false;
 
+      if (id->owner_type == PORT_OWNER_TYPE_PLUGIN
+          && self->plugin)
+        {
+          plugin_set_state_changed (self->plugin);
+        }
+
+      /* changes from realtime threads come from
+       * automation and are rendered ahead too */
+      if (!rt_memory_is_thread_realtime ()
+          && ROUTER && ROUTER->graph
+          && ROUTER->graph->prerenderer)
+        {
+          prerenderer_invalidate_port (
+            ROUTER->graph->prerenderer, &self->id);
+        }
+
       /* if bpm, update engine */
       if (id->flags & PORT_FLAG_BPM)
         {
@@ -3541,50 +3636,19 @@ port_process (
               }
           }
 
-        float maxf, minf, depth_range, val_to_use;
-        /* whether this is the first CV processed
-         * on this control port */
-        bool first_cv = true;
-        for (int k = 0; k < port->num_srcs; k++)
+        /* apply the modulation calculated by the
+         * modulation matrix (control ports only
+         * have CV sources) */
+        if (port->num_srcs > 0)
           {
-            Port * src_port = port->srcs[k];
-            const PortConnection * conn =
-              port->src_connections[k];
-            if (!conn->enabled)
-              continue;
-
-            if (src_port->id.type == TYPE_CV)
+            float result =
+              CLAMP (
+                port->base_value
+                + port->modulation_offset,
+                port->minf, port->maxf);
+            if (!math_floats_equal (
+                   port->control, result))
               {
-                maxf = port->maxf;
-                minf = port->minf;
-
-                /*float deff =*/
-                  /*port->lv2_port->lv2_control->deff;*/
-                /*port->lv2_port->control =*/
-                  /*deff + (maxf - deff) **/
-                    /*src_port->buf[0];*/
-                depth_range =
-                  (maxf - minf) / 2.f;
-
-                /* figure out whether to use base
-                 * value or the current value */
-                if (first_cv)
-                  {
-                    val_to_use = port->base_value;
-                    first_cv = false;
-                  }
-                else
-                  {
-                    val_to_use = port->control;
-                  }
-
-                float result =
-                  CLAMP (
-                    val_to_use
-                    + depth_range
-                      * src_port->buf[0]
-                      *  conn->multiplier,
-                    minf, maxf);
                 port->control = result;
                 port_forward_control_change_event (
                   port);
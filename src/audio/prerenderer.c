@@ -0,0 +1,1157 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <time.h>
+
+#include "audio/automation_track.h"
+#include "audio/channel.h"
+#include "audio/clip.h"
+#include "audio/control_port.h"
+#include "audio/engine.h"
+#include "audio/fader.h"
+#include "audio/graph.h"
+#include "audio/graph_node.h"
+#include "audio/midi_event.h"
+#include "audio/port.h"
+#include "audio/prerenderer.h"
+#include "audio/track.h"
+#include "audio/track_processor.h"
+#include "audio/tracklist.h"
+#include "audio/transport.h"
+#include "gui/backend/clip_editor.h"
+#include "plugins/plugin.h"
+#include "project.h"
+#include "settings/settings.h"
+#include "utils/dsp.h"
+#include "utils/math.h"
+#include "utils/objects.h"
+#include "utils/rt_memory.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
+
+#include <glib.h>
+
+#ifdef HAVE_LSP_DSP
+#include <lsp-plug.in/dsp/dsp.h>
+#endif
+
+/**
+ * Returns whether the node processes something
+ * owned by the given track before its prefader.
+ */
+static bool
+node_belongs_to_track (
+  GraphNode *  node,
+  Track *      track,
+  unsigned int track_name_hash)
+{
+  switch (node->type)
+    {
+    case ROUTE_NODE_TYPE_TRACK:
+    case ROUTE_NODE_TYPE_TRACK_LANE:
+      return node->track == track;
+    case ROUTE_NODE_TYPE_PLUGIN:
+      return
+        node->pl->id.track_name_hash ==
+          track_name_hash;
+    case ROUTE_NODE_TYPE_PORT:
+      switch (node->port->id.owner_type)
+        {
+        case PORT_OWNER_TYPE_PLUGIN:
+        case PORT_OWNER_TYPE_TRACK:
+        case PORT_OWNER_TYPE_TRACK_PROCESSOR:
+          return
+            node->port->id.track_name_hash ==
+              track_name_hash;
+        default:
+          return false;
+        }
+    default:
+      return false;
+    }
+}
+
+/**
+ * Returns whether the node is an input the track
+ * ignores unless armed or monitored (or a dummy
+ * processor).
+ */
+static bool
+node_is_ignorable_input (
+  GraphNode * node)
+{
+  return
+    node->type == ROUTE_NODE_TYPE_INITIAL_PROCESSOR
+    || node->type == ROUTE_NODE_TYPE_HW_PROCESSOR
+    || (node->type == ROUTE_NODE_TYPE_PORT
+        && node->port->id.owner_type ==
+             PORT_OWNER_TYPE_HW);
+}
+
+/**
+ * Collects the nodes feeding the given prefader
+ * input node into @p nodes.
+ *
+ * @return Whether all of them belong to the track.
+ */
+static bool
+collect_nodes (
+  GraphNode *  out_node,
+  Track *      track,
+  GHashTable * nodes)
+{
+  unsigned int track_name_hash =
+    track_get_name_hash (track);
+  GPtrArray * stack = g_ptr_array_new ();
+  for (int i = 0; i < out_node->init_refcount; i++)
+    {
+      g_ptr_array_add (
+        stack, out_node->parentnodes[i]);
+    }
+
+  bool ret = true;
+  while (stack->len > 0)
+    {
+      GraphNode * node =
+        g_ptr_array_remove_index (
+          stack, stack->len - 1);
+      if (g_hash_table_contains (nodes, node)
+          || node_is_ignorable_input (node))
+        continue;
+
+      if (!node_belongs_to_track (
+             node, track, track_name_hash))
+        {
+          ret = false;
+          break;
+        }
+
+      g_hash_table_add (nodes, node);
+      for (int i = 0; i < node->init_refcount; i++)
+        {
+          g_ptr_array_add (
+            stack, node->parentnodes[i]);
+        }
+    }
+  g_ptr_array_free (stack, true);
+
+  return ret;
+}
+
+/**
+ * Sorts the given nodes topologically (considering
+ * only edges between them).
+ */
+static GraphNode **
+sort_nodes (
+  GHashTable * nodes,
+  int *        num_nodes)
+{
+  *num_nodes = (int) g_hash_table_size (nodes);
+  GraphNode ** sorted =
+    object_new_n ((size_t) *num_nodes, GraphNode *);
+
+  /* number of unprocessed parents in the set */
+  GHashTable * refcounts =
+    g_hash_table_new (
+      g_direct_hash, g_direct_equal);
+  int num_sorted = 0;
+  GHashTableIter iter;
+  gpointer key;
+  g_hash_table_iter_init (&iter, nodes);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GraphNode * node = (GraphNode *) key;
+      int refcount = 0;
+      for (int i = 0; i < node->init_refcount; i++)
+        {
+          if (g_hash_table_contains (
+                nodes, node->parentnodes[i]))
+            refcount++;
+        }
+      if (refcount == 0)
+        sorted[num_sorted++] = node;
+      else
+        g_hash_table_insert (
+          refcounts, node,
+          GINT_TO_POINTER (refcount));
+    }
+
+  for (int i = 0; i < num_sorted; i++)
+    {
+      GraphNode * node = sorted[i];
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          GraphNode * child = node->childnodes[j];
+          if (!g_hash_table_contains (
+                refcounts, child))
+            continue;
+
+          int refcount =
+            GPOINTER_TO_INT (
+              g_hash_table_lookup (
+                refcounts, child)) - 1;
+          if (refcount == 0)
+            {
+              g_hash_table_remove (refcounts, child);
+              sorted[num_sorted++] = child;
+            }
+          else
+            {
+              g_hash_table_insert (
+                refcounts, child,
+                GINT_TO_POINTER (refcount));
+            }
+        }
+    }
+  g_warn_if_fail (num_sorted == *num_nodes);
+  *num_nodes = num_sorted;
+  g_hash_table_unref (refcounts);
+
+  return sorted;
+}
+
+static PrerenderTrack *
+prerender_track_new (
+  Prerenderer * prerenderer,
+  Track *       track,
+  int           num_chunks)
+{
+  Graph * graph = prerenderer->graph;
+  Fader * prefader = track->channel->prefader;
+  GraphNode * out_l =
+    g_hash_table_lookup (
+      graph->graph_nodes, prefader->stereo_in->l);
+  GraphNode * out_r =
+    g_hash_table_lookup (
+      graph->graph_nodes, prefader->stereo_in->r);
+  if (!out_l || !out_r
+      || out_l->type != ROUTE_NODE_TYPE_PORT
+      || out_r->type != ROUTE_NODE_TYPE_PORT)
+    return NULL;
+
+  GHashTable * nodes =
+    g_hash_table_new (
+      g_direct_hash, g_direct_equal);
+  bool valid =
+    collect_nodes (out_l, track, nodes)
+    && collect_nodes (out_r, track, nodes);
+
+  /* the prefader inputs must only be fed by the
+   * track, and nothing else may read from the
+   * rendered nodes */
+  for (int i = 0;
+       valid && i < out_l->init_refcount; i++)
+    {
+      valid =
+        g_hash_table_contains (
+          nodes, out_l->parentnodes[i]);
+    }
+  for (int i = 0;
+       valid && i < out_r->init_refcount; i++)
+    {
+      valid =
+        g_hash_table_contains (
+          nodes, out_r->parentnodes[i]);
+    }
+  GHashTableIter iter;
+  gpointer key;
+  g_hash_table_iter_init (&iter, nodes);
+  while (valid
+         && g_hash_table_iter_next (
+              &iter, &key, NULL))
+    {
+      GraphNode * node = (GraphNode *) key;
+      for (int i = 0; i < node->n_childnodes; i++)
+        {
+          GraphNode * child = node->childnodes[i];
+          if (child != out_l && child != out_r
+              && !g_hash_table_contains (
+                   nodes, child))
+            {
+              valid = false;
+              break;
+            }
+        }
+    }
+
+  if (!valid || g_hash_table_size (nodes) == 0)
+    {
+      g_hash_table_unref (nodes);
+      return NULL;
+    }
+
+  PrerenderTrack * self =
+    object_new (PrerenderTrack);
+  self->track = track;
+  self->out_l = prefader->stereo_in->l;
+  self->out_r = prefader->stereo_in->r;
+  self->nodes =
+    sort_nodes (nodes, &self->num_nodes);
+  g_hash_table_unref (nodes);
+  g_atomic_int_set (
+    &self->state, PRERENDER_TRACK_STATE_LIVE);
+
+  self->chunk_length = prerenderer->block_length;
+  self->num_chunks = num_chunks;
+  self->chunks =
+    object_new_n (
+      (size_t) num_chunks, PrerenderChunk);
+  for (int i = 0; i < num_chunks; i++)
+    {
+      self->chunks[i].l =
+        object_new_n (
+          prerenderer->block_length, float);
+      self->chunks[i].r =
+        object_new_n (
+          prerenderer->block_length, float);
+    }
+
+  for (int i = 0; i < self->num_nodes; i++)
+    {
+      self->nodes[i]->prerender_track = self;
+    }
+  out_l->prerender_output = self;
+  out_r->prerender_output = self;
+  track->prerender = self;
+
+  return self;
+}
+
+static void
+prerender_track_free (
+  PrerenderTrack * self)
+{
+  for (int i = 0; i < self->num_chunks; i++)
+    {
+      free (self->chunks[i].l);
+      free (self->chunks[i].r);
+    }
+  free (self->chunks);
+  free (self->nodes);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Sums the sources of the given prefader input
+ * like port_process() does.
+ */
+static void
+sum_sources (
+  Port *    port,
+  float *   buf,
+  nframes_t nframes)
+{
+  dsp_fill (buf, 0.f, nframes);
+  for (int i = 0; i < port->num_srcs; i++)
+    {
+      const PortConnection * conn =
+        port->src_connections[i];
+      if (!conn->enabled)
+        continue;
+
+      Port * src_port = port->srcs[i];
+      if (math_floats_equal_epsilon (
+            conn->multiplier, 1.f, 0.00001f))
+        {
+          dsp_add2 (buf, src_port->buf, nframes);
+        }
+      else
+        {
+          dsp_mix2 (
+            buf, src_port->buf, 1.f,
+            conn->multiplier, nframes);
+        }
+    }
+
+  float abs_peak = 0.f;
+  dsp_abs_max (buf, &abs_peak, nframes);
+  if (abs_peak > 2.f)
+    {
+      dsp_limit1 (buf, -2.f, 2.f, nframes);
+    }
+}
+
+/**
+ * Returns a monotonic time in nanoseconds.
+ */
+static inline gint64
+get_time_ns (void)
+{
+#ifdef _WOE32
+  return g_get_monotonic_time () * 1000;
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return
+    (gint64) ts.tv_sec * 1000000000 +
+    (gint64) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Renders the next chunk of the track.
+ *
+ * Must only be called by the thread that set the
+ * track's state to
+ * PRERENDER_TRACK_STATE_RENDERING, or by the
+ * engine while the track is in
+ * PRERENDER_TRACK_STATE_PREFILL.
+ */
+static void
+render_chunk (
+  Prerenderer *    prerenderer,
+  PrerenderTrack * self)
+{
+  gint64 start_ns = get_time_ns ();
+  nframes_t nframes = prerenderer->block_length;
+  PrerenderChunk * chunk =
+    &self->chunks[
+      g_atomic_int_get (&self->write_idx) %
+        self->num_chunks];
+  chunk->pos = self->render_pos;
+
+  channel_prepare_process_pre_fader (
+    self->track->channel);
+
+  for (int i = 0; i < self->num_nodes; i++)
+    {
+      GraphNode * node = self->nodes[i];
+
+      /* compensate latency like the live graph */
+      Position pos = self->render_pos;
+      transport_position_add_frames (
+        TRANSPORT, &pos,
+        node->route_playback_latency);
+      EngineProcessTimeInfo time_nfo = {
+        .g_start_frames = pos.frames,
+        .local_offset = 0,
+        .nframes = nframes,
+      };
+      graph_node_process_ahead (node, time_nfo);
+    }
+
+  sum_sources (self->out_l, chunk->l, nframes);
+  sum_sources (self->out_r, chunk->r, nframes);
+
+  transport_position_add_frames (
+    TRANSPORT, &self->render_pos, nframes);
+
+  /* moving average */
+  gint64 render_ns = get_time_ns () - start_ns;
+  self->render_ns =
+    self->render_ns == 0
+    ? render_ns
+    : (self->render_ns * 3 + render_ns) / 4;
+
+  /* publish */
+  g_atomic_int_inc (&self->write_idx);
+}
+
+static void *
+render_thread (
+  void * data)
+{
+  Prerenderer * self = (Prerenderer *) data;
+
+#ifdef HAVE_LSP_DSP
+  lsp_dsp_context_t lsp_ctx;
+  if (ZRYTHM_USE_OPTIMIZED_DSP)
+    {
+      lsp_dsp_start (&lsp_ctx);
+    }
+#endif
+
+  /* control changes from this thread come from
+   * automation, not from the user */
+  rt_memory_set_thread_realtime (true);
+
+  while (!g_atomic_int_get (&self->stop))
+    {
+      bool rendered = false;
+      for (int i = 0; i < self->num_tracks; i++)
+        {
+          PrerenderTrack * pt = self->tracks[i];
+          if (g_atomic_int_get (&pt->write_idx) -
+                g_atomic_int_get (&pt->read_idx) >=
+                pt->num_chunks
+              || g_atomic_int_get (&pt->invalidated))
+            continue;
+
+          if (!g_atomic_int_compare_and_exchange (
+                 &pt->state,
+                 PRERENDER_TRACK_STATE_IDLE,
+                 PRERENDER_TRACK_STATE_RENDERING))
+            continue;
+
+          render_chunk (self, pt);
+          rendered = true;
+
+          g_atomic_int_set (
+            &pt->state, PRERENDER_TRACK_STATE_IDLE);
+        }
+
+      if (!rendered)
+        {
+          zix_sem_wait (&self->work_sem);
+        }
+    }
+
+  rt_memory_set_thread_realtime (false);
+
+#ifdef HAVE_LSP_DSP
+  if (ZRYTHM_USE_OPTIMIZED_DSP)
+    {
+      lsp_dsp_finish (&lsp_ctx);
+    }
+#endif
+
+  return NULL;
+}
+
+/**
+ * Finds the tracks of the graph's current nodes
+ * that can be rendered ahead and starts the
+ * rendering threads.
+ *
+ * Must be called after the graph is rechained and
+ * before its ports are pooled.
+ *
+ * @return The prerenderer, or NULL if no tracks
+ *   can be rendered ahead.
+ */
+Prerenderer *
+prerenderer_new (
+  Graph * graph)
+{
+  Prerenderer * self = object_new (Prerenderer);
+  self->graph = graph;
+
+  /* plugins are instantiated with the engine's
+   * block length as their maximum, so chunks
+   * can't be larger */
+  self->block_length =
+    MAX (AUDIO_ENGINE->block_length, 1);
+
+  int lookahead_ms =
+    ZRYTHM_TESTING
+    ? 100
+    :
+    g_settings_get_int (
+      S_P_GENERAL_ENGINE,
+      "anticipative-lookahead");
+  int num_chunks =
+    (int)
+    (((gint64) lookahead_ms *
+        AUDIO_ENGINE->sample_rate) /
+     (1000 * (gint64) self->block_length));
+  num_chunks = CLAMP (num_chunks, 2, 4096);
+
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      track->prerender = NULL;
+      if (!track->channel
+          || track->out_signal_type != TYPE_AUDIO
+          || track_is_auditioner (track))
+        continue;
+
+      PrerenderTrack * pt =
+        prerender_track_new (
+          self, track, num_chunks);
+      if (!pt)
+        continue;
+
+      self->tracks =
+        g_realloc (
+          self->tracks,
+          (size_t) (self->num_tracks + 1) *
+            sizeof (PrerenderTrack *));
+      self->tracks[self->num_tracks++] = pt;
+    }
+
+  if (self->num_tracks == 0)
+    {
+      g_message (
+        "no tracks can be rendered ahead");
+      object_zero_and_free (self);
+      return NULL;
+    }
+
+  zix_sem_init (&self->work_sem, 0);
+  self->num_threads =
+    ZRYTHM_TESTING
+    ? 1
+    :
+    g_settings_get_int (
+      S_P_GENERAL_ENGINE,
+      "anticipative-render-threads");
+  self->num_threads =
+    CLAMP (
+      self->num_threads, 1,
+      PRERENDERER_MAX_THREADS);
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      self->threads[i] =
+        g_thread_new (
+          "prerenderer", render_thread, self);
+    }
+
+  g_message (
+    "rendering %d tracks ahead with %d threads "
+    "(%d chunks of %u frames)",
+    self->num_tracks, self->num_threads,
+    num_chunks, self->block_length);
+
+  return self;
+}
+
+/**
+ * Returns whether the track could be rendered
+ * ahead in the current cycle.
+ */
+static bool
+is_track_eligible (
+  PrerenderTrack * self)
+{
+  Track * tr = self->track;
+
+  if (!TRANSPORT_IS_ROLLING
+      || AUDIO_ENGINE->remaining_latency_preroll > 0
+      || TRANSPORT->countin_frames_remaining > 0
+      || TRANSPORT->preroll_frames_remaining > 0
+      || AUDIO_ENGINE->exporting
+      || g_atomic_int_get (&AUDIO_ENGINE->panic))
+    return false;
+
+  /* live input */
+  if (track_type_can_record (tr->type)
+      && track_get_recording (tr))
+    return false;
+  if (tr->type == TRACK_TYPE_AUDIO
+      && control_port_is_toggled (
+           tr->processor->monitor_audio))
+    return false;
+  if (tr->in_signal_type == TYPE_EVENT
+      && CLIP_EDITOR->has_region
+      && clip_editor_get_track (CLIP_EDITOR) == tr)
+    return false;
+
+  /* automation being recorded */
+  AutomationTracklist * atl =
+    &tr->automation_tracklist;
+  for (int i = 0; i < atl->num_ats; i++)
+    {
+      if (atl->ats[i]->automation_mode ==
+            AUTOMATION_MODE_RECORD)
+        return false;
+    }
+
+  return true;
+}
+
+/**
+ * Returns the number of rendered frames not
+ * consumed yet.
+ */
+static inline gint64
+get_available_frames (
+  Prerenderer *    prerenderer,
+  PrerenderTrack * self)
+{
+  gint num_chunks =
+    g_atomic_int_get (&self->write_idx) -
+    self->read_idx;
+  return
+    (gint64) num_chunks *
+      prerenderer->block_length -
+    self->read_offset;
+}
+
+/**
+ * Returns whether the rendered audio continues
+ * at the playhead for at least @p nframes.
+ */
+static bool
+has_frames (
+  Prerenderer *    prerenderer,
+  PrerenderTrack * self,
+  nframes_t        nframes)
+{
+  if (get_available_frames (prerenderer, self) <
+        nframes)
+    return false;
+
+  Position pos =
+    self->chunks[
+      self->read_idx % self->num_chunks].pos;
+  transport_position_add_frames (
+    TRANSPORT, &pos, self->read_offset);
+
+  return pos.frames == PLAYHEAD->frames;
+}
+
+/**
+ * Discards the rendered audio.
+ *
+ * The track must be processed live.
+ */
+static void
+reset (
+  PrerenderTrack * self)
+{
+  g_atomic_int_set (&self->write_idx, 0);
+  g_atomic_int_set (&self->read_idx, 0);
+  self->read_offset = 0;
+  self->eligible_cycles = 0;
+  g_atomic_int_set (&self->invalidated, 0);
+
+  /* the plugins already received the notes
+   * rendered ahead */
+  TrackProcessor * processor =
+    self->track->processor;
+  if (processor->piano_roll)
+    {
+      midi_events_panic (
+        processor->piano_roll->midi_events, true);
+    }
+}
+
+/**
+ * Decides which tracks use rendered audio in the
+ * cycle about to start.
+ *
+ * To be called by the engine before preparing the
+ * channels.
+ */
+void
+prerenderer_prepare_cycle (
+  Prerenderer * self,
+  nframes_t     nframes)
+{
+  self->cycle_start_ns = get_time_ns ();
+
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      PrerenderTrack * pt = self->tracks[i];
+      pt->skip_nodes = false;
+      pt->consuming = false;
+
+      bool eligible = is_track_eligible (pt);
+      bool invalidated =
+        g_atomic_int_get (&pt->invalidated);
+      bool synced =
+        eligible && !invalidated
+        && has_frames (self, pt, nframes);
+
+      switch (g_atomic_int_get (&pt->state))
+        {
+        case PRERENDER_TRACK_STATE_LIVE:
+          if (eligible && !invalidated)
+            {
+              pt->eligible_cycles++;
+            }
+          else
+            {
+              pt->eligible_cycles = 0;
+              g_atomic_int_set (&pt->invalidated, 0);
+            }
+          continue;
+        case PRERENDER_TRACK_STATE_PREFILL:
+          /* only the engine touches the track, so
+           * it can go back to live processing
+           * right away */
+          if (synced)
+            {
+              pt->skip_nodes = true;
+              pt->consuming = true;
+            }
+          else
+            {
+              g_atomic_int_set (
+                &pt->state,
+                PRERENDER_TRACK_STATE_LIVE);
+              reset (pt);
+            }
+          continue;
+        default:
+          break;
+        }
+
+      /* owned by the rendering threads */
+      if (synced)
+        {
+          pt->skip_nodes = true;
+          pt->consuming = true;
+        }
+      else if (
+        g_atomic_int_compare_and_exchange (
+          &pt->state,
+          PRERENDER_TRACK_STATE_IDLE,
+          PRERENDER_TRACK_STATE_LIVE))
+        {
+          reset (pt);
+        }
+      else
+        {
+          /* a chunk ahead is being rendered, so
+           * the track can't be processed live
+           * before the next cycle - keep playing
+           * what was rendered until the thread
+           * releases it */
+          g_atomic_int_set (&pt->invalidated, 1);
+          pt->skip_nodes = true;
+          if (get_available_frames (self, pt) >=
+                nframes)
+            {
+              pt->consuming = true;
+            }
+          else
+            {
+              /* the thread fell behind by the
+               * whole lookahead (overload) */
+              g_atomic_int_inc (
+                &pt->num_underruns);
+            }
+        }
+    }
+}
+
+/**
+ * Returns whether there is time left in the
+ * current cycle to render a chunk of the track
+ * in the engine's thread.
+ */
+static bool
+can_prefill (
+  Prerenderer *    self,
+  PrerenderTrack * pt,
+  nframes_t        nframes)
+{
+  gint64 budget_ns =
+    ((gint64) nframes * 1000000000 *
+       PRERENDERER_PREFILL_BUDGET_PERCENT) /
+    (100 * (gint64) AUDIO_ENGINE->sample_rate);
+  return
+    get_time_ns () + pt->render_ns <
+      self->cycle_start_ns + budget_ns;
+}
+
+/**
+ * Renders chunks of a track being handed over to
+ * the rendering threads in the engine's thread,
+ * and hands it over once enough are ready.
+ *
+ * The chunk needed by the next cycle is always
+ * rendered (this costs the same as processing the
+ * track live), more only if the cycle has time
+ * left.
+ */
+static void
+prefill (
+  Prerenderer *    self,
+  PrerenderTrack * pt,
+  nframes_t        nframes)
+{
+  int target_chunks =
+    MIN (PRERENDERER_PREFILL_CHUNKS, pt->num_chunks);
+  while (
+    g_atomic_int_get (&pt->write_idx) -
+      pt->read_idx < pt->num_chunks)
+    {
+      if (get_available_frames (self, pt) >=
+            self->block_length
+          && (g_atomic_int_get (&pt->write_idx) -
+                pt->read_idx >= target_chunks
+              || !can_prefill (self, pt, nframes)))
+        break;
+
+      render_chunk (self, pt);
+    }
+
+  if (g_atomic_int_get (&pt->write_idx) -
+        pt->read_idx >= target_chunks)
+    {
+      g_atomic_int_set (
+        &pt->state, PRERENDER_TRACK_STATE_IDLE);
+      zix_sem_post (&self->work_sem);
+    }
+}
+
+/**
+ * Consumes the rendered audio used in the cycle
+ * that just finished and hands eligible tracks
+ * over to the rendering threads.
+ *
+ * To be called by the engine after the playhead
+ * was moved.
+ */
+void
+prerenderer_finish_cycle (
+  Prerenderer * self,
+  nframes_t     nframes)
+{
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      PrerenderTrack * pt = self->tracks[i];
+      if (pt->consuming)
+        {
+          pt->read_offset += nframes;
+          while (pt->read_offset >=
+                   self->block_length)
+            {
+              pt->read_offset -= self->block_length;
+              g_atomic_int_inc (&pt->read_idx);
+              zix_sem_post (&self->work_sem);
+            }
+        }
+
+      PrerenderTrackState state =
+        (PrerenderTrackState)
+        g_atomic_int_get (&pt->state);
+      if (state == PRERENDER_TRACK_STATE_PREFILL)
+        {
+          prefill (self, pt, nframes);
+        }
+      else if (
+        state == PRERENDER_TRACK_STATE_LIVE
+        && pt->eligible_cycles >=
+             PRERENDERER_HOLD_CYCLES
+        && can_prefill (self, pt, nframes))
+        {
+          /* the track was processed live up to
+           * the playhead, so continue from there
+           * (the live nodes are skipped from the
+           * next cycle) */
+          g_atomic_int_set (&pt->write_idx, 0);
+          g_atomic_int_set (&pt->read_idx, 0);
+          pt->read_offset = 0;
+          pt->eligible_cycles = 0;
+          pt->render_pos = *PLAYHEAD;
+          g_atomic_int_set (
+            &pt->state,
+            PRERENDER_TRACK_STATE_PREFILL);
+          prefill (self, pt, nframes);
+        }
+
+      pt->skip_nodes = false;
+      pt->consuming = false;
+    }
+}
+
+/**
+ * Writes the rendered audio for the given part of
+ * the cycle to the given prefader input port (or
+ * silence if not available).
+ *
+ * Realtime safe.
+ */
+void
+prerender_track_read (
+  PrerenderTrack *                    self,
+  Port *                              port,
+  const EngineProcessTimeInfo * const time_nfo)
+{
+  float * dest = &port->buf[time_nfo->local_offset];
+  if (!self->consuming)
+    {
+      dsp_fill (dest, 0.f, time_nfo->nframes);
+      return;
+    }
+
+  bool left = port == self->out_l;
+  gint read_idx = self->read_idx;
+  nframes_t offset =
+    self->read_offset + time_nfo->local_offset;
+  nframes_t chunk_length = self->chunk_length;
+  nframes_t frames_written = 0;
+  while (frames_written < time_nfo->nframes)
+    {
+      read_idx += (gint) (offset / chunk_length);
+      offset = offset % chunk_length;
+      const PrerenderChunk * chunk =
+        &self->chunks[read_idx % self->num_chunks];
+      nframes_t frames_to_copy =
+        MIN (
+          chunk_length - offset,
+          time_nfo->nframes - frames_written);
+      dsp_copy (
+        &dest[frames_written],
+        &(left ? chunk->l : chunk->r)[offset],
+        frames_to_copy);
+      frames_written += frames_to_copy;
+      offset += frames_to_copy;
+    }
+}
+
+/**
+ * Makes the track go back to live processing and
+ * discards what was rendered.
+ *
+ * Can be called from any thread.
+ */
+void
+prerenderer_invalidate_track (
+  Prerenderer * self,
+  Track *       track)
+{
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      PrerenderTrack * pt = self->tracks[i];
+      if (pt->track == track)
+        {
+          g_atomic_int_set (&pt->invalidated, 1);
+          return;
+        }
+    }
+}
+
+/**
+ * Invalidates the owner track of the given
+ * control port after a user change.
+ */
+void
+prerenderer_invalidate_port (
+  Prerenderer *          self,
+  const PortIdentifier * id)
+{
+  switch (id->owner_type)
+    {
+    case PORT_OWNER_TYPE_PLUGIN:
+    case PORT_OWNER_TYPE_TRACK:
+    case PORT_OWNER_TYPE_TRACK_PROCESSOR:
+      break;
+    default:
+      return;
+    }
+
+  Track * track =
+    tracklist_find_track_by_name_hash (
+      TRACKLIST, id->track_name_hash);
+  if (track && track->prerender)
+    {
+      prerenderer_invalidate_track (self, track);
+    }
+}
+
+/**
+ * Invalidates all tracks, eg, after an edit.
+ */
+void
+prerenderer_invalidate_all (
+  Prerenderer * self)
+{
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      g_atomic_int_set (
+        &self->tracks[i]->invalidated, 1);
+    }
+}
+
+/**
+ * Waits until all tracks are back to live
+ * processing.
+ *
+ * The engine must not be running.
+ */
+void
+prerenderer_release_all (
+  Prerenderer * self)
+{
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      PrerenderTrack * pt = self->tracks[i];
+      g_atomic_int_set (&pt->invalidated, 1);
+      if (g_atomic_int_get (&pt->state) ==
+            PRERENDER_TRACK_STATE_PREFILL)
+        {
+          g_atomic_int_set (
+            &pt->state, PRERENDER_TRACK_STATE_LIVE);
+          reset (pt);
+        }
+      while (
+        g_atomic_int_get (&pt->state) !=
+          PRERENDER_TRACK_STATE_LIVE)
+        {
+          if (g_atomic_int_compare_and_exchange (
+                &pt->state,
+                PRERENDER_TRACK_STATE_IDLE,
+                PRERENDER_TRACK_STATE_LIVE))
+            {
+              reset (pt);
+              break;
+            }
+          g_usleep (100);
+        }
+    }
+}
+
+/**
+ * Stops the rendering threads and frees the
+ * prerenderer.
+ */
+void
+prerenderer_free (
+  Prerenderer * self)
+{
+  g_atomic_int_set (&self->stop, 1);
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      zix_sem_post (&self->work_sem);
+    }
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      g_thread_join (self->threads[i]);
+    }
+  zix_sem_destroy (&self->work_sem);
+
+  /* the tracks may already be freed, so only
+   * clear the references of the remaining ones */
+  if (PROJECT && TRACKLIST)
+    {
+      for (int i = 0; i < TRACKLIST->num_tracks; i++)
+        {
+          Track * track = TRACKLIST->tracks[i];
+          for (int j = 0; j < self->num_tracks; j++)
+            {
+              PrerenderTrack * pt = self->tracks[j];
+              if (track->prerender != pt)
+                continue;
+
+              if (g_atomic_int_get (&pt->state) !=
+                    PRERENDER_TRACK_STATE_LIVE)
+                {
+                  reset (pt);
+                }
+              track->prerender = NULL;
+            }
+        }
+    }
+
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      prerender_track_free (self->tracks[i]);
+    }
+  g_free (self->tracks);
+
+  object_zero_and_free (self);
+}
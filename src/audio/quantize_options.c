@@ -27,6 +27,7 @@
 #include "audio/transport.h"
 #include "project.h"
 #include "utils/algorithms.h"
+#include "utils/math.h"
 #include "utils/objects.h"
 #include "utils/pcg_rand.h"
 #include "zrythm.h"
@@ -193,28 +194,17 @@ get_next_point (
 }
 
 /**
- * Quantizes the given Position using the given
- * QuantizeOptions.
- *
- * This assumes that the start/end check has been
- * done already and it ignores the adjust_start and
- * adjust_end options.
- *
- * @return The amount of ticks moved (negative for
- *   backwards).
+ * Returns the amount of ticks to move the given
+ * ticks by, taking into account the amount and
+ * randomization.
  */
-double
-quantize_options_quantize_position (
+static double
+get_diff (
   QuantizeOptions * self,
-  Position *        pos)
+  double            ticks,
+  double            prev_point_ticks,
+  double            next_point_ticks)
 {
-  Position * prev_point =
-    get_prev_point (self, pos);
-  Position * next_point =
-    get_next_point (self, pos);
-  g_return_val_if_fail (
-    prev_point && next_point, 0);
-
   const double upper = self->rand_ticks;
   const double lower = - self->rand_ticks;
   double rand_double =
@@ -224,15 +214,15 @@ quantize_options_quantize_position (
 
   /* if previous point is closer */
   double diff;
-  if (pos->ticks - prev_point->ticks <=
-      next_point->ticks - pos->ticks)
+  if (ticks - prev_point_ticks <=
+      next_point_ticks - ticks)
     {
-      diff = prev_point->ticks - pos->ticks;
+      diff = prev_point_ticks - ticks;
     }
   /* if next point is closer */
   else
     {
-      diff = next_point->ticks - pos->ticks;
+      diff = next_point_ticks - ticks;
     }
 
   /* multiply by amount */
@@ -242,12 +232,104 @@ quantize_options_quantize_position (
   /* add random ticks */
   diff += rand_ticks;
 
+  return diff;
+}
+
+/**
+ * Quantizes the given Position using the given
+ * QuantizeOptions.
+ *
+ * This assumes that the start/end check has been
+ * done already and it ignores the adjust_start and
+ * adjust_end options.
+ *
+ * @return The amount of ticks moved (negative for
+ *   backwards).
+ */
+double
+quantize_options_quantize_position (
+  QuantizeOptions * self,
+  Position *        pos)
+{
+  Position * prev_point =
+    get_prev_point (self, pos);
+  Position * next_point =
+    get_next_point (self, pos);
+  g_return_val_if_fail (
+    prev_point && next_point, 0);
+
+  double diff =
+    get_diff (
+      self, pos->ticks, prev_point->ticks,
+      next_point->ticks);
+
   /* quantize position */
   position_add_ticks (pos, diff);
 
   return diff;
 }
 
+/**
+ * Quantizes the given ticks (eg, a column of
+ * MidiNoteColumns) in one pass.
+ *
+ * This is the bulk version of
+ * quantize_options_quantize_position(). Values
+ * outside the quantize points are left as is.
+ *
+ * @param diffs Array to store the amount of ticks
+ *   each value was moved by (negative for
+ *   backwards), or NULL.
+ */
+void
+quantize_options_quantize_ticks (
+  QuantizeOptions * self,
+  double *          ticks,
+  double *          diffs,
+  size_t            num_ticks)
+{
+  const Position * q_points = self->q_points;
+  const size_t num_q_points =
+    (size_t) self->num_q_points;
+
+  for (size_t i = 0; i < num_ticks; i++)
+    {
+      const double t = ticks[i];
+
+      /* find the first point after t */
+      size_t lo = 0;
+      size_t hi = num_q_points;
+      while (lo < hi)
+        {
+          size_t mid = lo + (hi - lo) / 2;
+          if (q_points[mid].ticks <= t)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      double diff = 0.0;
+      if (lo > 0 && lo < num_q_points)
+        {
+          double prev_point_ticks =
+            q_points[lo - 1].ticks;
+          double next_point_ticks =
+            math_doubles_equal (
+              prev_point_ticks, t) ?
+              prev_point_ticks :
+              q_points[lo].ticks;
+          diff =
+            get_diff (
+              self, t, prev_point_ticks,
+              next_point_ticks);
+        }
+
+      ticks[i] += diff;
+      if (diffs)
+        diffs[i] = diff;
+    }
+}
+
 /**
  * Clones the QuantizeOptions.
  */
@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/region.h"
+#include "audio/region_index.h"
+#include "utils/objects.h"
+
+/**
+ * Last build generation handed out to an index.
+ *
+ * Generations are unique across indices so that a
+ * cursor used with another index is never taken as
+ * up to date.
+ */
+static volatile gint last_generation = 0;
+
+/**
+ * Marks the index as stale.
+ *
+ * To be called whenever the position of one of
+ * the owner's regions changes. Stale indices are
+ * not used until region_index_refresh() is called
+ * on them.
+ */
+void
+region_index_mark_positions_changed (
+  RegionIndex * self)
+{
+  g_atomic_int_inc (&self->version);
+}
+
+/**
+ * Marks the index as unusable and waits for any
+ * current readers to finish.
+ *
+ * Must be called before a region is removed from
+ * the owner's array.
+ */
+void
+region_index_invalidate (
+  RegionIndex * self)
+{
+  g_atomic_int_set (&self->valid, 0);
+
+  /* readers only hold the index for the duration
+   * of a lookup so this is short */
+  while (g_atomic_int_get (&self->num_readers) > 0)
+    {
+      g_thread_yield ();
+    }
+}
+
+static int
+cmp_region_start (
+  const void * a,
+  const void * b)
+{
+  const ArrangerObject * obj_a =
+    *(const ArrangerObject * const *) a;
+  const ArrangerObject * obj_b =
+    *(const ArrangerObject * const *) b;
+  if (obj_a->pos.frames < obj_b->pos.frames)
+    return -1;
+  else if (obj_a->pos.frames > obj_b->pos.frames)
+    return 1;
+
+  /* keep the original order for regions starting
+   * at the same position */
+  const ZRegion * r_a = (const ZRegion *) obj_a;
+  const ZRegion * r_b = (const ZRegion *) obj_b;
+  return r_a->id.idx - r_b->id.idx;
+}
+
+/**
+ * Rebuilds the index from the given regions.
+ *
+ * To be called from the GTK thread.
+ */
+void
+region_index_rebuild (
+  RegionIndex * self,
+  ZRegion **    regions,
+  int           num_regions)
+{
+  int version = g_atomic_int_get (&self->version);
+
+  region_index_invalidate (self);
+
+  if ((size_t) num_regions > self->size)
+    {
+      size_t new_size =
+        MAX (
+          (size_t) num_regions, self->size * 2);
+      self->regions =
+        g_realloc_n (
+          self->regions, new_size,
+          sizeof (ZRegion *));
+      self->starts =
+        g_realloc_n (
+          self->starts, new_size, sizeof (long));
+      self->ends =
+        g_realloc_n (
+          self->ends, new_size, sizeof (long));
+      self->max_ends =
+        g_realloc_n (
+          self->max_ends, new_size, sizeof (long));
+      self->max_end_idxs =
+        g_realloc_n (
+          self->max_end_idxs, new_size,
+          sizeof (int));
+      self->size = new_size;
+    }
+
+  if (num_regions > 0)
+    {
+      memcpy (
+        self->regions, regions,
+        (size_t) num_regions * sizeof (ZRegion *));
+      qsort (
+        self->regions, (size_t) num_regions,
+        sizeof (ZRegion *), cmp_region_start);
+    }
+
+  for (int i = 0; i < num_regions; i++)
+    {
+      ArrangerObject * r_obj =
+        (ArrangerObject *) self->regions[i];
+      self->starts[i] = r_obj->pos.frames;
+      self->ends[i] = r_obj->end_pos.frames;
+      if (i == 0
+          || self->ends[i] >= self->max_ends[i - 1])
+        {
+          self->max_ends[i] = self->ends[i];
+          self->max_end_idxs[i] = i;
+        }
+      else
+        {
+          self->max_ends[i] = self->max_ends[i - 1];
+          self->max_end_idxs[i] =
+            self->max_end_idxs[i - 1];
+        }
+    }
+  self->num_regions = num_regions;
+
+  g_atomic_int_set (
+    &self->generation,
+    g_atomic_int_add (&last_generation, 1) + 1);
+  g_atomic_int_set (&self->built_version, version);
+  g_atomic_int_set (&self->valid, 1);
+}
+
+/**
+ * Rebuilds the index if it is invalid or if any of
+ * the given regions moved since it was built,
+ * otherwise marks it up to date.
+ *
+ * To be called periodically from the GTK thread.
+ */
+void
+region_index_refresh (
+  RegionIndex * self,
+  ZRegion **    regions,
+  int           num_regions)
+{
+  int version = g_atomic_int_get (&self->version);
+  if (g_atomic_int_get (&self->valid)
+      && self->num_regions == num_regions)
+    {
+      if (g_atomic_int_get (&self->built_version)
+            == version)
+        return;
+
+      /* regions are only added or removed after
+       * invalidating the index, so it is enough
+       * to check that their positions did not
+       * change */
+      bool changed = false;
+      for (int i = 0; i < self->num_regions; i++)
+        {
+          ArrangerObject * r_obj =
+            (ArrangerObject *) self->regions[i];
+          if (r_obj->pos.frames != self->starts[i]
+              ||
+              r_obj->end_pos.frames != self->ends[i])
+            {
+              changed = true;
+              break;
+            }
+        }
+
+      if (!changed)
+        {
+          g_atomic_int_set (
+            &self->built_version, version);
+          return;
+        }
+    }
+
+  region_index_rebuild (self, regions, num_regions);
+}
+
+/**
+ * Starts reading the index.
+ *
+ * @return Whether the index can be used. If true,
+ *   region_index_release() must be called when
+ *   done.
+ */
+bool
+region_index_acquire (
+  const RegionIndex * _self)
+{
+  /* only the reader count is modified */
+  RegionIndex * self = (RegionIndex *) _self;
+
+  /* the reader count must be incremented before
+   * checking validity, see
+   * region_index_invalidate() */
+  g_atomic_int_inc (&self->num_readers);
+  if (g_atomic_int_get (&self->valid)
+      &&
+      g_atomic_int_get (&self->built_version) ==
+        g_atomic_int_get (&self->version))
+    {
+      return true;
+    }
+
+  g_atomic_int_dec_and_test (&self->num_readers);
+  return false;
+}
+
+/**
+ * Stops reading the index.
+ */
+void
+region_index_release (
+  const RegionIndex * _self)
+{
+  RegionIndex * self = (RegionIndex *) _self;
+  g_atomic_int_dec_and_test (&self->num_readers);
+}
+
+/**
+ * Returns the first index whose running max end
+ * is at or after \ref frames.
+ */
+static inline int
+lower_bound_max_end (
+  const RegionIndex * self,
+  long                frames)
+{
+  int lo = 0, hi = self->num_regions;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (self->max_ends[mid] < frames)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/**
+ * Returns the first index whose start is after
+ * \ref frames.
+ */
+static inline int
+upper_bound_start (
+  const RegionIndex * self,
+  long                frames)
+{
+  int lo = 0, hi = self->num_regions;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (self->starts[mid] <= frames)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/**
+ * Returns the range of candidate regions in
+ * RegionIndex.regions that may overlap the given
+ * range (inclusive).
+ *
+ * @param cursor Optional playback cursor.
+ * @param[out] lo First candidate index.
+ * @param[out] hi One past the last candidate
+ *   index.
+ */
+void
+region_index_get_candidates (
+  const RegionIndex * self,
+  RegionIndexCursor * cursor,
+  long                start,
+  long                end,
+  int *               lo,
+  int *               hi)
+{
+  int n = self->num_regions;
+  int generation = g_atomic_int_get (&self->generation);
+  int l, h;
+  if (cursor
+      && cursor->generation == generation
+      && start >= cursor->start
+      && end >= cursor->end)
+    {
+      /* moving forward: both bounds can only
+       * increase */
+      l = cursor->lo;
+      h = cursor->hi;
+      while (l < n && self->max_ends[l] < start)
+        l++;
+      while (h < n && self->starts[h] <= end)
+        h++;
+    }
+  else
+    {
+      l = lower_bound_max_end (self, start);
+      h = upper_bound_start (self, end);
+    }
+
+  if (cursor)
+    {
+      cursor->generation = generation;
+      cursor->start = start;
+      cursor->end = end;
+      cursor->lo = l;
+      cursor->hi = h;
+    }
+
+  *lo = l;
+  *hi = h;
+}
+
+/**
+ * Returns the region starting at or before
+ * \ref frames that ends last, or NULL.
+ */
+ZRegion *
+region_index_get_latest_ending_before (
+  const RegionIndex * self,
+  long                frames)
+{
+  int h = upper_bound_start (self, frames);
+  if (h == 0)
+    return NULL;
+
+  return self->regions[self->max_end_idxs[h - 1]];
+}
+
+/**
+ * Frees the members of the index.
+ */
+void
+region_index_free_members (
+  RegionIndex * self)
+{
+  region_index_invalidate (self);
+
+  object_zero_and_free_if_nonnull (self->regions);
+  object_zero_and_free_if_nonnull (self->starts);
+  object_zero_and_free_if_nonnull (self->ends);
+  object_zero_and_free_if_nonnull (self->max_ends);
+  object_zero_and_free_if_nonnull (
+    self->max_end_idxs);
+  self->num_regions = 0;
+  self->size = 0;
+}
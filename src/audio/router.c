@@ -52,13 +52,16 @@
 #include "audio/master_track.h"
 #include "audio/midi.h"
 #include "audio/midi_track.h"
+#include "audio/modulation_matrix.h"
 #include "audio/pan.h"
 #include "audio/port.h"
+#include "audio/prerenderer.h"
 #include "audio/router.h"
 #include "audio/stretcher.h"
 #include "audio/tempo_track.h"
 #include "audio/track.h"
 #include "audio/track_processor.h"
+#include "audio/tracklist.h"
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
@@ -90,6 +93,46 @@ router_get_max_route_playback_latency (
   return router->max_route_playback_latency;
 }
 
+/**
+ * Applies all complete batches of control port
+ * changes in the queue.
+ *
+ * Must be called with graph access.
+ */
+HOT
+static void
+apply_control_port_changes (
+  Router * self)
+{
+  ZixRing * queue = self->ctrl_port_change_queue;
+  const uint32_t header_size =
+    sizeof (ControlPortChangeBatchHeader);
+  while (zix_ring_read_space (queue) >=
+           header_size)
+    {
+      ControlPortChangeBatchHeader header;
+      zix_ring_peek (queue, &header, header_size);
+
+      /* wait until the whole batch is written */
+      uint32_t batch_size =
+        header_size +
+          (uint32_t) header.num_changes *
+            sizeof (ControlPortChange);
+      if (zix_ring_read_space (queue) < batch_size)
+        break;
+
+      zix_ring_skip (queue, header_size);
+      for (int i = 0; i < header.num_changes; i++)
+        {
+          ControlPortChange change;
+          zix_ring_read (
+            queue, &change, sizeof (change));
+          control_port_change_apply (
+            &change, header.timestamp);
+        }
+    }
+}
+
 /**
  * Starts a new cycle.
  */
@@ -124,33 +167,8 @@ router_start_cycle (
     &self->time_nfo, &time_nfo,
     sizeof (EngineProcessTimeInfo));
 
-  /* read control port change events */
-  while (zix_ring_read_space (
-           self->ctrl_port_change_queue)
-             >= sizeof (ControlPortChange))
-    {
-      ControlPortChange change = { 0 };
-      zix_ring_read (
-        self->ctrl_port_change_queue, &change,
-        sizeof (change));
-      if (change.flag1 & PORT_FLAG_BPM)
-        {
-          tempo_track_set_bpm (
-            P_TEMPO_TRACK, change.real_val, 0.f,
-            true, F_PUBLISH_EVENTS);
-        }
-      else if (change.flag2 &
-                 PORT_FLAG2_BEATS_PER_BAR)
-        {
-          tempo_track_set_beats_per_bar (
-            P_TEMPO_TRACK, change.ival);
-        }
-      else if (change.flag2 & PORT_FLAG2_BEAT_UNIT)
-        {
-          tempo_track_set_beat_unit_from_enum (
-            P_TEMPO_TRACK, change.beat_unit);
-        }
-    }
+  /* apply control port changes */
+  apply_control_port_changes (self);
 
   /* process tempo track ports first */
   if (self->graph->bpm_node)
@@ -174,6 +192,17 @@ router_start_cycle (
   zix_sem_wait (&self->graph->callback_done);
   self->callback_in_progress = false;
 
+  /* calculate the modulation to apply in the
+   * next cycle now that all CV sources are
+   * processed */
+  if (self->graph->mod_matrix)
+    {
+      modulation_matrix_process (
+        self->graph->mod_matrix,
+        time_nfo.local_offset + time_nfo.nframes - 1,
+        time_nfo.nframes);
+    }
+
   zix_sem_post (&self->graph_access);
 }
 
@@ -200,6 +229,18 @@ router_recalc_graph (
       return;
     }
 
+  /* defer until the end of the tracklist batch */
+  if (PROJECT && TRACKLIST &&
+      tracklist_is_batching (TRACKLIST))
+    {
+      if (soft)
+        TRACKLIST->batch_recalc_graph_soft = true;
+      else
+        TRACKLIST->batch_recalc_graph = true;
+      g_debug ("deferred until end of batch");
+      return;
+    }
+
   if (soft)
     {
       zix_sem_wait (&self->graph_access);
@@ -211,35 +252,124 @@ router_recalc_graph (
       zix_sem_wait (&self->graph_access);
       graph_setup (self->graph, 1, 1);
       zix_sem_post (&self->graph_access);
+      self->num_graph_rebuilds++;
     }
 
   g_message ("done");
 }
 
+/**
+ * Writes the given header and changes to the queue
+ * if there is enough space for all of them.
+ */
+static bool
+queue_changes (
+  Router *                             self,
+  const ControlPortChangeBatchHeader * header,
+  const ControlPortChange *            changes)
+{
+  ZixRing * queue = self->ctrl_port_change_queue;
+  uint32_t changes_size =
+    (uint32_t) header->num_changes *
+      sizeof (ControlPortChange);
+  uint32_t batch_size =
+    sizeof (ControlPortChangeBatchHeader) +
+      changes_size;
+
+  zix_sem_wait (&self->ctrl_port_change_write_lock);
+  if (zix_ring_write_space (queue) < batch_size)
+    {
+      zix_sem_post (
+        &self->ctrl_port_change_write_lock);
+      int num_dropped =
+        g_atomic_int_add (
+          &self->num_dropped_ctrl_port_changes,
+          header->num_changes) +
+        header->num_changes;
+      g_message (
+        "control port change queue full, dropped "
+        "%d changes (%d total)",
+        header->num_changes, num_dropped);
+      return false;
+    }
+
+  /* the reader only applies the batch once all of
+   * it is written */
+  zix_ring_write (
+    queue, header,
+    sizeof (ControlPortChangeBatchHeader));
+  if (changes_size > 0)
+    {
+      zix_ring_write (queue, changes, changes_size);
+    }
+  zix_sem_post (&self->ctrl_port_change_write_lock);
+
+  /* the changes are applied in the realtime
+   * thread, which doesn't invalidate the tracks
+   * rendered ahead */
+  if (self->graph && self->graph->prerenderer)
+    {
+      Prerenderer * prerenderer =
+        self->graph->prerenderer;
+      for (int i = 0; i < header->num_changes; i++)
+        {
+          const ControlPortChange * change =
+            &changes[i];
+          if (change->flag1 || change->flag2)
+            {
+              /* tempo changes affect all tracks */
+              prerenderer_invalidate_all (
+                prerenderer);
+              break;
+            }
+          else if (change->has_port_id)
+            {
+              prerenderer_invalidate_port (
+                prerenderer, &change->port_id);
+            }
+        }
+    }
+
+  return true;
+}
+
 /**
  * Queues a control port change to be applied
  * when processing starts.
  *
- * Currently only applies to BPM/time signature
- * changes.
+ * @return Whether the change was queued (false if
+ *   the queue is full).
  */
-void
+bool
 router_queue_control_port_change (
   Router *                  self,
   const ControlPortChange * change)
 {
-  if (zix_ring_write_space (
-        self->ctrl_port_change_queue) <
-          sizeof (ControlPortChange))
-    {
-      zix_ring_skip (
-        self->ctrl_port_change_queue,
-        sizeof (ControlPortChange));
-    }
+  ControlPortChangeBatchHeader header = {
+    .num_changes = 1,
+    .timestamp = g_get_monotonic_time (), };
+  return queue_changes (self, &header, change);
+}
 
-  zix_ring_write (
-    self->ctrl_port_change_queue, change,
-    sizeof (ControlPortChange));
+/**
+ * Queues a batch of control port changes to be
+ * applied together when processing starts.
+ *
+ * @return Whether the batch was queued (false if
+ *   the queue is full, in which case the whole
+ *   batch is dropped).
+ */
+bool
+router_queue_control_port_changes (
+  Router *                       self,
+  const ControlPortChangeBatch * batch)
+{
+  if (batch->header.num_changes == 0)
+    return true;
+
+  return
+    queue_changes (
+      self, &batch->header, batch->changes);
 }
 
 /**
@@ -255,10 +385,15 @@ router_new (void)
   Router * self = object_new (Router);
 
   zix_sem_init (&self->graph_access, 1);
+  zix_sem_init (
+    &self->ctrl_port_change_write_lock, 1);
 
+  /* enough for a few full batches */
   self->ctrl_port_change_queue =
     zix_ring_new (
-      sizeof (ControlPortChange) * (size_t) 24);
+      (uint32_t)
+      (sizeof (ControlPortChangeBatch) * 4));
+  zix_ring_mlock (self->ctrl_port_change_queue);
 
   g_message ("done");
 
@@ -353,6 +488,8 @@ router_free (
 
   zix_sem_destroy (&self->graph_access);
   object_set_to_zero (&self->graph_access);
+  zix_sem_destroy (
+    &self->ctrl_port_change_write_lock);
 
   object_free_w_func_and_null (
     zix_ring_free, self->ctrl_port_change_queue);
@@ -88,33 +88,37 @@ midi_in_cb (
   size_t                message_size,
   RtMidiDevice *        self)
 {
-  zix_sem_wait (&self->midi_ring_sem);
-
-  /* generate timestamp */
+  /* timestamp at arrival - mapped to the cycle
+   * when dequeued */
   gint64 cur_time = g_get_monotonic_time ();
-  gint64 ts =
-    cur_time - self->port->last_midi_dequeue;
-  g_return_if_fail (ts >= 0);
-  char portname[900];
-  port_get_full_designation (self->port, portname);
   if (DEBUGGING)
     {
+      char portname[900];
+      port_get_full_designation (
+        self->port, portname);
       g_debug (
-        "[%s] message received of size %zu at %ld",
-        portname, message_size, ts);
+        "[%s] message received of size %zu at %"
+        G_GINT64_FORMAT,
+        portname, message_size, cur_time);
     }
 
-  /* add to ring buffer */
+  /* this is the only writer, so the ring can be
+   * written without locking */
   MidiEventHeader h = {
-    .time = (uint64_t) ts, .size = message_size,
+    .time = (uint64_t) cur_time,
+    .size = message_size,
   };
+  if (zix_ring_write_space (self->midi_ring) <
+        sizeof (MidiEventHeader) + message_size)
+    {
+      g_message ("RtMidi ring full, dropping event");
+      return;
+    }
   zix_ring_write (
     self->midi_ring,
     (uint8_t *) &h, sizeof (MidiEventHeader));
   zix_ring_write (
     self->midi_ring, message, message_size);
-
-  zix_sem_post (&self->midi_ring_sem);
 }
 
 static bool rtmidi_device_first_run = false;
@@ -247,8 +251,6 @@ rtmidi_device_new (
 
   self->events = midi_events_new ();
 
-  zix_sem_init (&self->midi_ring_sem, 1);
-
   return self;
 }
 
@@ -372,8 +374,6 @@ rtmidi_device_free (
   if (self->events)
     midi_events_free (self->events);
 
-  zix_sem_destroy (&self->midi_ring_sem);
-
   free (self);
 }
 
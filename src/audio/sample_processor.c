@@ -335,7 +335,7 @@ sample_processor_process (
           if (track->type == TRACK_TYPE_AUDIO)
             {
               track_processor_process (
-                track->processor, &time_nfo);
+                track->processor, &time_nfo, NULL, 0);
 
               audio_data_l =
                 track->processor->stereo_out->l->buf;
@@ -345,7 +345,7 @@ sample_processor_process (
           else if (track->type == TRACK_TYPE_MIDI)
             {
               track_processor_process (
-                track->processor, &time_nfo);
+                track->processor, &time_nfo, NULL, 0);
               midi_events_append (
                 track->processor->midi_out->
                   midi_events,
@@ -547,8 +547,12 @@ sample_processor_queue_file (
     {
       Track * track = self->tracklist->tracks[i];
 
-      /* remove state dir if instrument */
-      if (track->type == TRACK_TYPE_INSTRUMENT)
+      /* remove state dir if instrument (unless
+       * shared with other plugins) */
+      if (track->type == TRACK_TYPE_INSTRUMENT
+          &&
+          !plugin_state_dir_is_snapshot (
+            track->channel->instrument->state_dir))
         {
           char * state_dir =
             plugin_get_abs_state_dir (
@@ -2145,7 +2145,7 @@ track_freeze (
 
   if (freeze)
     {
-      ExportSettings settings;
+      ExportSettings settings = {};
       track_mark_for_bounce (
         self, F_BOUNCE, F_MARK_REGIONS,
         F_NO_MARK_CHILDREN, F_NO_MARK_PARENTS);
@@ -2611,6 +2611,34 @@ track_get_automation_tracklist (
   return NULL;
 }
 
+/**
+ * Brings the region indices of the track's lanes
+ * and automation tracks up to date.
+ *
+ * To be called periodically from the GTK thread.
+ */
+void
+track_refresh_region_indices (
+  Track * self)
+{
+  for (int i = 0; i < self->num_lanes; i++)
+    {
+      track_lane_refresh_region_index (
+        self->lanes[i]);
+    }
+
+  AutomationTracklist * atl =
+    track_get_automation_tracklist (self);
+  if (atl)
+    {
+      for (int i = 0; i < atl->num_ats; i++)
+        {
+          automation_track_refresh_region_index (
+            atl->ats[i]);
+        }
+    }
+}
+
 /**
  * Returns the region at the given position, or
  * NULL.
@@ -2637,6 +2665,39 @@ track_get_region_at_pos (
         {
           lane = track->lanes[i];
 
+          const RegionIndex * index =
+            &lane->region_index;
+          if (region_index_acquire (index))
+            {
+              int lo, hi;
+              region_index_get_candidates (
+                index, NULL, pos->frames,
+                pos->frames, &lo, &hi);
+              ZRegion * ret = NULL;
+              for (j = lo; j < hi; j++)
+                {
+                  r = index->regions[j];
+                  r_obj = (ArrangerObject *) r;
+                  if (pos->frames >=
+                        r_obj->pos.frames &&
+                      pos->frames <
+                        r_obj->end_pos.frames +
+                          (include_region_end ? 1 : 0)
+                      &&
+                      /* prefer the first one in the
+                       * lane like below */
+                      (!ret || r->id.idx < ret->id.idx))
+                    {
+                      ret = r;
+                    }
+                }
+              region_index_release (index);
+              if (ret)
+                return ret;
+
+              continue;
+            }
+
           for (j = 0; j < lane->num_regions; j++)
             {
               r = lane->regions[j];
@@ -2806,36 +2867,401 @@ track_update_positions (
     &self->automation_tracklist, from_ticks);
 }
 
+/**
+ * Fills in the events (or audio) for a single
+ * region.
+ *
+ * @note The engine splits the cycle so transport
+ *   loop related logic is not needed.
+ */
+HOT
+static void
+fill_events_from_region (
+  const Track *                       self,
+  ZRegion *                           r,
+  const EngineProcessTimeInfo * const time_nfo,
+  MidiEvents *                        midi_events,
+  StereoPorts *                       stereo_ports)
+{
+#define g_start_frames (time_nfo->g_start_frames)
+#define local_offset (time_nfo->local_offset)
+#define nframes (time_nfo->nframes)
+
+  ArrangerObject * r_obj =
+    (ArrangerObject *) r;
+
+  const long g_end_frames =
+    g_start_frames + nframes;
+
+  /* skip region if muted */
+  if (arranger_object_get_muted (r_obj))
+    {
+      return;
+    }
+
+  /* skip if in bounce mode and the
+   * region should not be bounced */
+  if (AUDIO_ENGINE->bounce_mode !=
+        BOUNCE_OFF &&
+      (!r->bounce || !self->bounce))
+    {
+      return;
+    }
+
+  /* skip if region is not hit
+   * (inclusive of its last point) */
+  if (!region_is_hit_by_range (
+         r, g_start_frames,
+         midi_events ?
+           g_end_frames :
+           (g_end_frames - 1),
+         F_INCLUSIVE))
+    {
+      return;
+    }
+
+  long num_frames_to_process =
+    MIN (
+      r_obj->end_pos.frames -
+        g_start_frames,
+      nframes);
+  nframes_t frames_processed = 0;
+
+  while (num_frames_to_process > 0)
+    {
+      long cur_g_start_frame =
+        g_start_frames + frames_processed;
+      nframes_t cur_local_start_frame =
+        local_offset + frames_processed;
+
+      bool is_end_loop;
+      long cur_num_frames_till_next_r_loop_or_end;
+      region_get_frames_till_next_loop_or_end (
+        r, cur_g_start_frame,
+        &cur_num_frames_till_next_r_loop_or_end,
+        &is_end_loop);
+
+#if 0
+      g_message (
+        "%s: cur num frames till next r "
+        "loop or end %ld, "
+        "num_frames_to_process %ld, "
+        "cur local start frame %u",
+        __func__, cur_num_frames_till_next_r_loop_or_end,
+        num_frames_to_process,
+        cur_local_start_frame);
+#endif
+
+      /* whether we need a note off */
+      bool need_note_off =
+        (cur_num_frames_till_next_r_loop_or_end <
+           num_frames_to_process) ||
+        (cur_num_frames_till_next_r_loop_or_end ==
+           num_frames_to_process &&
+         !is_end_loop) ||
+        /* region end */
+        (g_start_frames +
+           num_frames_to_process ==
+             r_obj->end_pos.frames) ||
+        /* transport end */
+        (TRANSPORT_IS_LOOPING &&
+         g_start_frames +
+           num_frames_to_process ==
+             TRANSPORT->loop_end_pos.frames);
+
+      /* number of frames to process this
+       * time */
+      cur_num_frames_till_next_r_loop_or_end =
+        MIN (
+          cur_num_frames_till_next_r_loop_or_end,
+          num_frames_to_process);
+
+      if (midi_events)
+        {
+          midi_region_fill_midi_events (
+            r, cur_g_start_frame,
+            cur_local_start_frame,
+            cur_num_frames_till_next_r_loop_or_end, need_note_off,
+            midi_events);
+        }
+      else if (stereo_ports)
+        {
+          audio_region_fill_stereo_ports (
+            r, cur_g_start_frame,
+            cur_local_start_frame,
+            cur_num_frames_till_next_r_loop_or_end, stereo_ports);
+        }
+
+      frames_processed += cur_num_frames_till_next_r_loop_or_end;
+      num_frames_to_process -=
+        cur_num_frames_till_next_r_loop_or_end;
+    } /* end while frames left */
+
+#undef g_start_frames
+#undef local_offset
+#undef nframes
+}
+
+/**
+ * Max number of overlapping audio regions in a
+ * lane that can be looked up using the region
+ * index before falling back to a linear scan.
+ */
+#define MAX_OVERLAPPING_AUDIO_REGIONS 16
+
+/**
+ * Fills in the events (or audio) from the regions
+ * in the given lane hit in the current cycle using
+ * the lane's region index.
+ *
+ * @param cursor Caller's cursor into the lane's
+ *   index, or NULL.
+ *
+ * @return Whether the index could be used.
+ */
+HOT
+static bool
+fill_events_from_lane_index (
+  const Track *                       self,
+  TrackLane *                         lane,
+  RegionIndexCursor *                 cursor,
+  const EngineProcessTimeInfo * const time_nfo,
+  MidiEvents *                        midi_events,
+  StereoPorts *                       stereo_ports)
+{
+  const RegionIndex * index = &lane->region_index;
+  if (!region_index_acquire (index))
+    return false;
+
+  int lo, hi;
+  region_index_get_candidates (
+    index, cursor,
+    time_nfo->g_start_frames,
+    time_nfo->g_start_frames + time_nfo->nframes,
+    &lo, &hi);
+
+  if (midi_events)
+    {
+      /* order does not matter since the events
+       * are sorted afterwards */
+      for (int i = lo; i < hi; i++)
+        {
+          fill_events_from_region (
+            self, index->regions[i], time_nfo,
+            midi_events, stereo_ports);
+        }
+      region_index_release (index);
+      return true;
+    }
+
+  /* audio regions overwrite each other so process
+   * overlapping ones in lane order, as
+   * fill_events_from_lane() does */
+  ZRegion * hits[MAX_OVERLAPPING_AUDIO_REGIONS];
+  int num_hits = 0;
+  for (int i = lo; i < hi; i++)
+    {
+      ZRegion * r = index->regions[i];
+      if (!region_is_hit_by_range (
+             r, time_nfo->g_start_frames,
+             time_nfo->g_start_frames +
+               time_nfo->nframes,
+             F_INCLUSIVE))
+        continue;
+
+      if (num_hits == MAX_OVERLAPPING_AUDIO_REGIONS)
+        {
+          region_index_release (index);
+          return false;
+        }
+
+      int j = num_hits++;
+      while (j > 0 && hits[j - 1]->id.idx > r->id.idx)
+        {
+          hits[j] = hits[j - 1];
+          j--;
+        }
+      hits[j] = r;
+    }
+
+  /* keep the index acquired while filling so the
+   * regions cannot be removed in the meantime */
+  for (int i = 0; i < num_hits; i++)
+    {
+      fill_events_from_region (
+        self, hits[i], time_nfo, midi_events,
+        stereo_ports);
+    }
+  region_index_release (index);
+
+  return true;
+}
+
+/**
+ * Fills in the events (or audio) from all the
+ * regions in the given lane.
+ */
+HOT
+static void
+fill_events_from_lane (
+  const Track *                       self,
+  TrackLane *                         lane,
+  RegionIndexCursor *                 cursor,
+  const EngineProcessTimeInfo * const time_nfo,
+  MidiEvents *                        midi_events,
+  StereoPorts *                       stereo_ports)
+{
+  if (fill_events_from_lane_index (
+        self, lane, cursor, time_nfo, midi_events,
+        stereo_ports))
+    {
+      return;
+    }
+
+  for (int i = 0; i < lane->num_regions; i++)
+    {
+      ZRegion * r = lane->regions[i];
+      g_return_if_fail (IS_REGION (r));
+
+      fill_events_from_region (
+        self, r, time_nfo, midi_events,
+        stereo_ports);
+    }
+}
+
+/**
+ * Appends the queued events of a lane that was
+ * processed in its own graph node to the given
+ * queued events, for the current (split) cycle.
+ */
+HOT
+static void
+merge_lane_events (
+  const TrackLane *                   lane,
+  const EngineProcessTimeInfo * const time_nfo,
+  MidiEvents *                        midi_events)
+{
+  MidiEvents * src = lane->midi_events;
+  for (int i = 0; i < src->num_queued_events; i++)
+    {
+      MidiEvent * src_ev =
+        &src->queued_events[i];
+
+      /* only copy events inside the current time
+       * range (the lane was filled for the whole
+       * cycle) */
+      if (src_ev->time < time_nfo->local_offset ||
+          src_ev->time >=
+            time_nfo->local_offset +
+              time_nfo->nframes)
+        {
+          continue;
+        }
+
+      g_return_if_fail (
+        midi_events->num_queued_events <
+          MAX_MIDI_EVENTS);
+
+      midi_event_copy (
+        &midi_events->queued_events[
+          midi_events->num_queued_events++],
+        src_ev);
+    }
+}
+
+/**
+ * Returns whether the lanes of the track should be
+ * processed in separate graph nodes.
+ *
+ * @param threshold Minimum number of lanes, or 0 to
+ *   disable.
+ */
+bool
+track_should_process_lanes_in_parallel (
+  const Track * self,
+  const int     threshold)
+{
+  /* audio regions share the track's real-time
+   * stretcher and overwrite each other's output,
+   * so only MIDI lanes are processed in parallel */
+  return
+    threshold > 0
+    && track_type_has_piano_roll (self->type)
+    && self->num_lanes >= threshold
+    && !track_is_auditioner (self);
+}
+
+/**
+ * Fills the scratch events of the lane at the
+ * given position from its regions.
+ *
+ * To be called by the lane's graph node when the
+ * lanes of the track are processed in parallel.
+ * The events are then merged by
+ * track_fill_events().
+ *
+ * @param lane_pos Lane index.
+ * @param cursor Caller's cursor into the lane's
+ *   region index, or NULL.
+ */
+void
+track_fill_lane_events (
+  Track *                             self,
+  const int                           lane_pos,
+  const EngineProcessTimeInfo * const time_nfo,
+  RegionIndexCursor *                 cursor)
+{
+  if (!TRANSPORT_IS_ROLLING ||
+      self->frozen || !track_is_enabled (self))
+    return;
+
+  /* lane may have been removed since the graph
+   * was created */
+  if (lane_pos >= self->num_lanes)
+    return;
+
+  TrackLane * lane = self->lanes[lane_pos];
+  if (!lane || !lane->midi_events)
+    return;
+
+  fill_events_from_lane (
+    self, lane, cursor, time_nfo,
+    lane->midi_events, NULL);
+}
+
 /**
  * Wrapper for audio and MIDI/instrument tracks
  * to fill in MidiEvents or StereoPorts from the
  * timeline data.
  *
+ * If the lanes of the track are processed in
+ * parallel by the graph, their events are merged
+ * instead.
+ *
  * @note The engine splits the cycle so transport
  *   loop related logic is not needed.
  *
  * @param stereo_ports StereoPorts to fill.
  * @param midi_events MidiEvents to fill (from
  *   Piano Roll Port for example).
+ * @param cursors Caller's cursors into the region
+ *   indices of the lanes (one per lane), or NULL.
+ * @param num_cursors Number of cursors. Lanes
+ *   without a cursor are searched without one.
  */
 void
 track_fill_events (
   const Track *                       self,
   const EngineProcessTimeInfo * const time_nfo,
   MidiEvents *                        midi_events,
-  StereoPorts *                       stereo_ports)
+  StereoPorts *                       stereo_ports,
+  RegionIndexCursor *                 cursors,
+  int                                 num_cursors)
 {
-#define g_start_frames (time_nfo->g_start_frames)
-#define local_offset (time_nfo->local_offset)
-#define nframes (time_nfo->nframes)
-
   if (!track_is_auditioner (self)
       && !TRANSPORT_IS_ROLLING)
     return;
 
-  const long g_end_frames =
-    g_start_frames + nframes;
-
   if (midi_events)
     {
       zix_sem_wait (&midi_events->access_sem);
@@ -2849,139 +3275,43 @@ track_fill_events (
     local_start_frame, nframes);
 #endif
 
-  TrackType tt = self->type;
-
-  /* go through each lane */
-  const int num_loops =
-    (tt == TRACK_TYPE_CHORD ?
-     1 : self->num_lanes);
-  for (int j = 0; j < num_loops; j++)
+  if (self->type == TRACK_TYPE_CHORD)
     {
-      TrackLane * lane = NULL;
-      if (tt != TRACK_TYPE_CHORD)
+      for (int i = 0; i < self->num_chord_regions;
+           i++)
         {
-          lane = self->lanes[j];
-          g_return_if_fail (lane);
+          ZRegion * r = self->chord_regions[i];
+          g_return_if_fail (IS_REGION (r));
+          fill_events_from_region (
+            self, r, time_nfo, midi_events,
+            stereo_ports);
         }
-
-      /* go through each region */
-      const int num_regions =
-        (tt == TRACK_TYPE_CHORD ?
-         self->num_chord_regions :
-         lane->num_regions);
-      for (int i = 0; i < num_regions; i++)
+    }
+  else
+    {
+      /* go through each lane */
+      for (int j = 0; j < self->num_lanes; j++)
         {
-          ZRegion * r =
-            tt == TRACK_TYPE_CHORD ?
-            self->chord_regions[i] :
-            lane->regions[i];
-          ArrangerObject * r_obj =
-            (ArrangerObject *) r;
-          g_return_if_fail (IS_REGION (r));
-
-          /* skip region if muted */
-          if (arranger_object_get_muted (r_obj))
-            {
-              continue;
-            }
+          TrackLane * lane = self->lanes[j];
+          g_return_if_fail (lane);
 
-          /* skip if in bounce mode and the
-           * region should not be bounced */
-          if (AUDIO_ENGINE->bounce_mode !=
-                BOUNCE_OFF &&
-              (!r->bounce || !self->bounce))
+          /* if already filled by the lane's graph
+           * node, merge */
+          if (midi_events
+              && j < self->num_lanes_in_graph
+              && lane->midi_events)
             {
-              continue;
+              merge_lane_events (
+                lane, time_nfo, midi_events);
             }
-
-          /* skip if region is not hit
-           * (inclusive of its last point) */
-          if (!region_is_hit_by_range (
-                 r, g_start_frames,
-                 midi_events ?
-                   g_end_frames :
-                   (g_end_frames - 1),
-                 F_INCLUSIVE))
+          else
             {
-              continue;
+              fill_events_from_lane (
+                self, lane,
+                j < num_cursors ? &cursors[j] : NULL,
+                time_nfo, midi_events,
+                stereo_ports);
             }
-
-          long num_frames_to_process =
-            MIN (
-              r_obj->end_pos.frames -
-                g_start_frames,
-              nframes);
-          nframes_t frames_processed = 0;
-
-          while (num_frames_to_process > 0)
-            {
-              long cur_g_start_frame =
-                g_start_frames + frames_processed;
-              nframes_t cur_local_start_frame =
-                local_offset + frames_processed;
-
-              bool is_end_loop;
-              long cur_num_frames_till_next_r_loop_or_end;
-              region_get_frames_till_next_loop_or_end (
-                r, cur_g_start_frame,
-                &cur_num_frames_till_next_r_loop_or_end,
-                &is_end_loop);
-
-#if 0
-              g_message (
-                "%s: cur num frames till next r "
-                "loop or end %ld, "
-                "num_frames_to_process %ld, "
-                "cur local start frame %u",
-                __func__, cur_num_frames_till_next_r_loop_or_end,
-                num_frames_to_process,
-                cur_local_start_frame);
-#endif
-
-              /* whether we need a note off */
-              bool need_note_off =
-                (cur_num_frames_till_next_r_loop_or_end <
-                   num_frames_to_process) ||
-                (cur_num_frames_till_next_r_loop_or_end ==
-                   num_frames_to_process &&
-                 !is_end_loop) ||
-                /* region end */
-                (g_start_frames +
-                   num_frames_to_process ==
-                     r_obj->end_pos.frames) ||
-                /* transport end */
-                (TRANSPORT_IS_LOOPING &&
-                 g_start_frames +
-                   num_frames_to_process ==
-                     TRANSPORT->loop_end_pos.frames);
-
-              /* number of frames to process this
-               * time */
-              cur_num_frames_till_next_r_loop_or_end =
-                MIN (
-                  cur_num_frames_till_next_r_loop_or_end,
-                  num_frames_to_process);
-
-              if (midi_events)
-                {
-                  midi_region_fill_midi_events (
-                    r, cur_g_start_frame,
-                    cur_local_start_frame,
-                    cur_num_frames_till_next_r_loop_or_end, need_note_off,
-                    midi_events);
-                }
-              else if (stereo_ports)
-                {
-                  audio_region_fill_stereo_ports (
-                    r, cur_g_start_frame,
-                    cur_local_start_frame,
-                    cur_num_frames_till_next_r_loop_or_end, stereo_ports);
-                }
-
-              frames_processed += cur_num_frames_till_next_r_loop_or_end;
-              num_frames_to_process -=
-                cur_num_frames_till_next_r_loop_or_end;
-            } /* end while frames left */
         }
     }
 
@@ -2999,10 +3329,6 @@ track_fill_events (
 
       zix_sem_post (&midi_events->access_sem);
     }
-
-#undef g_start_frames
-#undef local_offset
-#undef nframes
 }
 
 /**
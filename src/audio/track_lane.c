@@ -20,6 +20,7 @@
 #include <stdlib.h>
 
 #include "audio/audio_region.h"
+#include "audio/midi_event.h"
 #include "audio/track.h"
 #include "audio/track_lane.h"
 #include "audio/tracklist.h"
@@ -60,6 +61,10 @@ track_lane_init_loaded (
       region_set_lane (region, self);
       arranger_object_init_loaded (r_obj);
     }
+
+  region_index_rebuild (
+    &self->region_index, self->regions,
+    self->num_regions);
 }
 
 /**
@@ -201,6 +206,8 @@ track_lane_insert_region (
 
   region_set_lane (region, self);
 
+  region_index_invalidate (&self->region_index);
+
   array_double_size_if_full (
     self->regions, self->num_regions,
     self->regions_size, ZRegion *);
@@ -296,6 +303,10 @@ track_lane_clone (
         new_region, region->name, NULL, NULL);
     }
 
+  region_index_rebuild (
+    &self->region_index, self->regions,
+    self->num_regions);
+
   return self;
 }
 
@@ -319,6 +330,20 @@ track_lane_unselect_all (
     }
 }
 
+/**
+ * Brings the region index up to date.
+ *
+ * To be called from the GTK thread.
+ */
+void
+track_lane_refresh_region_index (
+  TrackLane * self)
+{
+  region_index_refresh (
+    &self->region_index, self->regions,
+    self->num_regions);
+}
+
 /**
  * Removes all objects recursively from the track
  * lane.
@@ -382,6 +407,8 @@ track_lane_remove_region (
         }
     }
 
+  region_index_invalidate (&self->region_index);
+
   bool deleted = false;
   array_delete_confirm (
     self->regions, self->num_regions, region,
@@ -450,6 +477,24 @@ track_lane_write_to_midi_file (
     }
 }
 
+/**
+ * Allocates the scratch buffers used when the lane
+ * is processed in its own graph node.
+ *
+ * To be called during graph setup.
+ */
+void
+track_lane_allocate_bufs (
+  TrackLane * self)
+{
+  /* MIDI events have a fixed size so they only
+   * need to be allocated once */
+  if (!self->midi_events)
+    {
+      self->midi_events = midi_events_new ();
+    }
+}
+
 /**
  * Frees the TrackLane.
  */
@@ -459,6 +504,8 @@ track_lane_free (
 {
   g_free_and_null (self->name);
 
+  region_index_free_members (&self->region_index);
+
   for (int i = 0; i < self->num_regions; i++)
     {
       arranger_object_free (
@@ -467,5 +514,8 @@ track_lane_free (
 
   object_zero_and_free_if_nonnull (self->regions);
 
+  object_free_w_func_and_null (
+    midi_events_free, self->midi_events);
+
   object_zero_and_free (self);
 }
@@ -857,11 +857,16 @@ add_events_from_midi_cc_control_ports (
  * @param g_start_frames The global start frames.
  * @param local_offset The local start frames.
  * @param nframes The number of frames to process.
+ * @param cursors Caller's cursors into the region
+ *   indices of the track's lanes, or NULL.
+ * @param num_cursors Number of cursors.
  */
 void
 track_processor_process (
   const TrackProcessor *              self,
-  const EngineProcessTimeInfo * const time_nfo)
+  const EngineProcessTimeInfo * const time_nfo,
+  RegionIndexCursor *                 cursors,
+  int                                 num_cursors)
 {
 #define g_start_frames (time_nfo->g_start_frames)
 #define local_offset (time_nfo->local_offset)
@@ -880,7 +885,8 @@ track_processor_process (
   if (tr->type == TRACK_TYPE_AUDIO)
     {
       track_fill_events (
-        tr, time_nfo, NULL, self->stereo_out);
+        tr, time_nfo, NULL, self->stereo_out,
+        cursors, num_cursors);
     }
 
   /* set the piano roll contents to midi out */
@@ -909,7 +915,8 @@ track_processor_process (
             tr->name, g_start_frames);
 #endif
           track_fill_events (
-            tr, time_nfo, pr->midi_events, NULL);
+            tr, time_nfo, pr->midi_events, NULL,
+            cursors, num_cursors);
         }
       midi_events_dequeue (pr->midi_events);
 #if 0
@@ -21,6 +21,7 @@
 #include "audio/audio_region.h"
 #include "audio/channel.h"
 #include "audio/chord_track.h"
+#include "audio/file_import.h"
 #include "audio/group_target_track.h"
 #include "audio/master_track.h"
 #include "audio/midi_file.h"
@@ -1264,98 +1265,80 @@ tracklist_expose_ports_to_backend (
 }
 
 /**
- * Handles a file drop inside the timeline or in
- * empty space in the tracklist.
- *
- * @param uri_list URI list, if URI list was dropped.
- * @param file File, if SupportedFile was dropped.
- * @param track Track, if any.
- * @param lane TrackLane, if any.
- * @param pos Position the file was dropped at, if
- *   inside track.
- * @param perform_actions Whether to perform
- *   undoable actions in addition to creating the
- *   regions/tracks.
+ * File drop waiting for its audio files to be
+ * decoded.
  */
-void
-tracklist_handle_file_drop (
-  Tracklist *     self,
-  char **         uri_list,
-  SupportedFile * orig_file,
-  Track *         track,
-  TrackLane *     lane,
-  Position *      pos,
-  bool            perform_actions)
+typedef struct FileDrop
 {
-  GPtrArray * file_arr =
-    g_ptr_array_new_with_free_func (
-      (GDestroyNotify) supported_file_free);
-  if (orig_file)
-    {
-      SupportedFile * file =
-        supported_file_clone (orig_file);
-      g_ptr_array_add (file_arr, file);
-    }
-  else
-    {
-      g_return_if_fail (uri_list);
+  /** Project.generation of the project the files
+   * were dropped in. */
+  unsigned int  project_generation;
 
-      char * uri = NULL;
-      int i = 0;
-      while ((uri = uri_list[i++]) != NULL)
-        {
-          /* strip "file://" */
-          if (!string_contains_substr (
-                uri, "file://"))
-            continue;
+  /** SupportedFile's. */
+  GPtrArray *   files;
 
-          GError * err = NULL;
-          char * filepath =
-            g_filename_from_uri (uri, NULL, &err);
-          if (err)
-            {
-              g_warning (
-                "%s", err->message);
-            }
+  /** Name hash of the track dropped on, or 0. */
+  unsigned int  track_name_hash;
 
-          if (filepath)
-            {
-              SupportedFile * file =
-                supported_file_new_from_path (
-                  filepath);
-              g_free (filepath);
-              g_ptr_array_add (file_arr, file);
-            }
-        }
-    }
+  /** Lane dropped on, or -1. */
+  int           lane_pos;
 
-  if (file_arr->len == 0)
-    {
-      ui_show_error_message (
-        MAIN_WINDOW, _("No file was found"));
+  Position      pos;
+  bool          has_pos;
+} FileDrop;
 
-      goto free_file_array_and_return;
+/**
+ * Gets the type of track to create for the given
+ * file.
+ *
+ * @return Whether the file type is supported.
+ */
+static bool
+get_track_type_for_file (
+  SupportedFile * file,
+  TrackType *     track_type)
+{
+  if (supported_file_type_is_supported (
+        file->type) &&
+      supported_file_type_is_audio (
+        file->type))
+    {
+      *track_type = TRACK_TYPE_AUDIO;
+      return true;
+    }
+  else if (supported_file_type_is_midi (
+             file->type))
+    {
+      *track_type = TRACK_TYPE_MIDI;
+      return true;
     }
 
+  return false;
+}
+
+/**
+ * Checks that the files can be dropped (on the
+ * given track, if any) and shows an error if not.
+ *
+ * This only looks at the file types and headers so
+ * it can run before any file is decoded.
+ *
+ * @return Whether the drop can proceed.
+ */
+static bool
+validate_dropped_files (
+  GPtrArray *  file_arr,
+  Track *      track,
+  bool         perform_actions)
+{
   for (size_t i = 0; i < file_arr->len; i++)
     {
       SupportedFile * file =
         g_ptr_array_index (file_arr, i);
 
-      TrackType track_type = 0;
-      if (supported_file_type_is_supported (
-            file->type) &&
-          supported_file_type_is_audio (
-            file->type))
-        {
-          track_type = TRACK_TYPE_AUDIO;
-        }
-      else if (supported_file_type_is_midi (
-                 file->type))
-        {
-          track_type = TRACK_TYPE_MIDI;
-        }
-      else
+      TrackType track_type;
+      if (!get_track_type_for_file (
+             file, &track_type))
         {
           char * descr =
             supported_file_type_get_description (
@@ -1367,65 +1350,114 @@ tracklist_handle_file_drop (
           g_free (descr);
           ui_show_error_message (MAIN_WINDOW, msg);
           g_free (msg);
+          return false;
+        }
 
-          goto free_file_array_and_return;
+      /* if current track exists and track type
+       * are incompatible, do nothing */
+      if (!perform_actions || !track)
+        continue;
+
+      if (file_arr->len > 1)
+        {
+          ui_show_error_message (
+            MAIN_WINDOW,
+            _("Can only drop 1 file at a "
+            "time on existing tracks"));
+          return false;
         }
 
-      if (perform_actions)
+      if (track_type == TRACK_TYPE_MIDI)
         {
-          /* if current track exists and track
-           * type are incompatible, do nothing */
-          if (track)
+          if (track->type != TRACK_TYPE_MIDI &&
+              track->type != TRACK_TYPE_INSTRUMENT)
             {
-              if (file_arr->len > 1)
-                {
-                  ui_show_error_message (
-                    MAIN_WINDOW,
-                    _("Can only drop 1 file at a "
-                    "time on existing tracks"));
-                  goto free_file_array_and_return;
-                }
+              ui_show_error_message (
+                MAIN_WINDOW,
+                _("Can only drop MIDI files on "
+                "MIDI/instrument tracks"));
+              return false;
+            }
 
-              if (track_type == TRACK_TYPE_MIDI)
-                {
-                  if (track->type != TRACK_TYPE_MIDI &&
-                      track->type !=
-                        TRACK_TYPE_INSTRUMENT)
-                    {
-                      ui_show_error_message (
-                        MAIN_WINDOW,
-                        _("Can only drop MIDI files on "
-                        "MIDI/instrument tracks"));
-                      goto free_file_array_and_return;
-                    }
+          int num_nonempty_tracks =
+            midi_file_get_num_tracks (
+              file->abs_path, true);
+          if (num_nonempty_tracks > 1)
+            {
+              char msg[600];
+              sprintf (
+                msg,
+                _("This MIDI file contains %d "
+                "tracks. It cannot be dropped "
+                "into an existing track"),
+                num_nonempty_tracks);
+              ui_show_error_message (
+                MAIN_WINDOW, msg);
+              return false;
+            }
+        }
+      else if (track_type == TRACK_TYPE_AUDIO &&
+          track->type != TRACK_TYPE_AUDIO)
+        {
+          ui_show_error_message (
+            MAIN_WINDOW,
+            _("Can only drop audio files on "
+            "audio tracks"));
+          return false;
+        }
+    }
 
-                  int num_nonempty_tracks =
-                    midi_file_get_num_tracks (
-                      file->abs_path, true);
-                  if (num_nonempty_tracks > 1)
-                    {
-                      char msg[600];
-                      sprintf (
-                        msg,
-                        _("This MIDI file contains %d "
-                        "tracks. It cannot be dropped "
-                        "into an existing track"),
-                        num_nonempty_tracks);
-                      ui_show_error_message (
-                        MAIN_WINDOW, msg);
-                      goto free_file_array_and_return;
-                    }
-                }
-              else if (track_type == TRACK_TYPE_AUDIO &&
-                  track->type != TRACK_TYPE_AUDIO)
-                {
-                  ui_show_error_message (
-                    MAIN_WINDOW,
-                    _("Can only drop audio files on "
-                    "audio tracks"));
-                  goto free_file_array_and_return;
-                }
+  return true;
+}
+
+/**
+ * Creates the regions/tracks for dropped files.
+ *
+ * The files must have been checked with
+ * validate_dropped_files().
+ *
+ * @param import Import with the decoded audio
+ *   files, if any.
+ */
+static void
+create_objects_for_dropped_files (
+  Tracklist *  self,
+  GPtrArray *  file_arr,
+  FileImport * import,
+  Track *      track,
+  TrackLane *  lane,
+  Position *   pos,
+  bool         perform_actions)
+{
+  bool in_batch = false;
+
+  /* create the tracks for multiple files in one
+   * batch */
+  if (perform_actions && file_arr->len > 1)
+    {
+      tracklist_begin_batch (self);
+      in_batch = true;
+    }
 
+  for (size_t i = 0; i < file_arr->len; i++)
+    {
+      SupportedFile * file =
+        g_ptr_array_index (file_arr, i);
+
+      TrackType track_type;
+      if (!get_track_type_for_file (
+             file, &track_type))
+        {
+          g_warn_if_reached ();
+          goto end_batch_and_return;
+        }
+
+      if (perform_actions)
+        {
+          /* the files were validated in
+           * validate_dropped_files() */
+          if (track)
+            {
               int lane_pos =
                 lane ? lane->pos :
                 (track->num_lanes == 1 ?
@@ -1436,16 +1468,26 @@ tracklist_handle_file_drop (
               switch (track_type)
                 {
                 case TRACK_TYPE_AUDIO:
-                  /* create audio region in audio
-                   * track */
-                  region =
-                    audio_region_new (
-                      -1, file->abs_path, true, NULL,
-                      -1, NULL,
-                      0, 0, pos,
-                      track_get_name_hash (track),
-                      lane_pos,
-                      idx_in_lane);
+                  {
+                    /* create audio region in audio
+                     * track */
+                    int pool_id =
+                      import ?
+                        file_import_add_clip_to_pool (
+                          import, file->abs_path) :
+                        -1;
+                    region =
+                      audio_region_new (
+                        pool_id,
+                        pool_id < 0 ?
+                          file->abs_path : NULL,
+                        true, NULL,
+                        -1, NULL,
+                        0, 0, pos,
+                        track_get_name_hash (track),
+                        lane_pos,
+                        idx_in_lane);
+                  }
                   break;
                 case TRACK_TYPE_MIDI:
                   region =
@@ -1485,15 +1527,37 @@ tracklist_handle_file_drop (
                   g_warn_if_reached ();
                 }
 
-              goto free_file_array_and_return;
+              goto end_batch_and_return;
             }
           else /* else if no track given */
             {
               GError * err = NULL;
-              bool ret =
-                track_create_with_action (
-                  track_type, NULL, file, pos,
-                  self->num_tracks, 1, &err);
+              int pool_id =
+                import
+                && track_type == TRACK_TYPE_AUDIO ?
+                  file_import_add_clip_to_pool (
+                    import, file->abs_path) :
+                  -1;
+              bool ret;
+              if (pool_id >= 0)
+                {
+                  char * basename =
+                    g_path_get_basename (
+                      file->abs_path);
+                  ret =
+                    tracklist_selections_action_perform_create_from_pool_clip (
+                      pool_id, basename,
+                      self->num_tracks, pos, &err);
+                  g_free (basename);
+                }
+              else
+                {
+                  ret =
+                    track_create_with_action (
+                      track_type, NULL, file, pos,
+                      self->num_tracks, 1, &err)
+                    != NULL;
+                }
               if (ret)
                 {
                   UndoableAction * ua =
@@ -1506,7 +1570,7 @@ tracklist_handle_file_drop (
                   HANDLE_ERROR (
                     err, "%s",
                     _("Failed to create track"));
-                  goto free_file_array_and_return;
+                  goto end_batch_and_return;
                 }
             }
         }
@@ -1516,10 +1580,192 @@ tracklist_handle_file_drop (
         }
     } /* foreach file */
 
-free_file_array_and_return:
-  g_ptr_array_unref (file_arr);
+end_batch_and_return:
+  if (in_batch)
+    {
+      tracklist_end_batch (self);
+    }
+}
+
+static void
+on_file_drop_import_done (
+  FileImport * import,
+  bool         cancelled,
+  FileDrop *   drop)
+{
+  if (cancelled)
+    {
+      g_message ("file import cancelled");
+    }
+  /* skip if the project was closed meanwhile */
+  else if (
+    PROJECT
+    && PROJECT->generation
+         == drop->project_generation)
+    {
+      /* the track may have been removed while
+       * decoding */
+      Track * track = NULL;
+      TrackLane * lane = NULL;
+      bool have_track = true;
+      if (drop->track_name_hash)
+        {
+          track =
+            tracklist_find_track_by_name_hash (
+              TRACKLIST, drop->track_name_hash);
+          have_track = track != NULL;
+          if (track && drop->lane_pos >= 0
+              && drop->lane_pos < track->num_lanes)
+            {
+              lane = track->lanes[drop->lane_pos];
+            }
+        }
+      if (have_track)
+        {
+          create_objects_for_dropped_files (
+            TRACKLIST, drop->files, import, track,
+            lane,
+            drop->has_pos ? &drop->pos : NULL,
+            true);
+        }
+      else
+        {
+          g_message (
+            "track removed during file import");
+        }
+    }
 
-  return;
+  file_import_free (import);
+  g_ptr_array_unref (drop->files);
+  object_zero_and_free (drop);
+}
+
+/**
+ * Handles a file drop inside the timeline or in
+ * empty space in the tracklist.
+ *
+ * @param uri_list URI list, if URI list was dropped.
+ * @param file File, if SupportedFile was dropped.
+ * @param track Track, if any.
+ * @param lane TrackLane, if any.
+ * @param pos Position the file was dropped at, if
+ *   inside track.
+ * @param perform_actions Whether to perform
+ *   undoable actions in addition to creating the
+ *   regions/tracks.
+ */
+void
+tracklist_handle_file_drop (
+  Tracklist *     self,
+  char **         uri_list,
+  SupportedFile * orig_file,
+  Track *         track,
+  TrackLane *     lane,
+  Position *      pos,
+  bool            perform_actions)
+{
+  GPtrArray * file_arr =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) supported_file_free);
+  if (orig_file)
+    {
+      SupportedFile * file =
+        supported_file_clone (orig_file);
+      g_ptr_array_add (file_arr, file);
+    }
+  else
+    {
+      g_return_if_fail (uri_list);
+
+      char * uri = NULL;
+      int i = 0;
+      while ((uri = uri_list[i++]) != NULL)
+        {
+          /* strip "file://" */
+          if (!string_contains_substr (
+                uri, "file://"))
+            continue;
+
+          GError * err = NULL;
+          char * filepath =
+            g_filename_from_uri (uri, NULL, &err);
+          if (err)
+            {
+              g_warning (
+                "%s", err->message);
+            }
+
+          if (filepath)
+            {
+              SupportedFile * file =
+                supported_file_new_from_path (
+                  filepath);
+              g_free (filepath);
+              g_ptr_array_add (file_arr, file);
+            }
+        }
+    }
+
+  if (file_arr->len == 0)
+    {
+      ui_show_error_message (
+        MAIN_WINDOW, _("No file was found"));
+      g_ptr_array_unref (file_arr);
+      return;
+    }
+
+  /* reject invalid drops before decoding
+   * anything */
+  if (!validate_dropped_files (
+         file_arr, track, perform_actions))
+    {
+      g_ptr_array_unref (file_arr);
+      return;
+    }
+
+  if (!perform_actions)
+    {
+      create_objects_for_dropped_files (
+        self, file_arr, NULL, track, lane, pos,
+        perform_actions);
+      g_ptr_array_unref (file_arr);
+      return;
+    }
+
+  /* decode the audio files concurrently before
+   * creating the regions/tracks */
+  FileImport * import = file_import_new (file_arr);
+  if (!ZRYTHM_HAVE_UI)
+    {
+      file_import_run (import);
+      create_objects_for_dropped_files (
+        self, file_arr, import, track, lane, pos,
+        perform_actions);
+      file_import_free (import);
+      g_ptr_array_unref (file_arr);
+      return;
+    }
+
+  /* keep the UI responsive while decoding and
+   * continue in on_file_drop_import_done() */
+  FileDrop * drop = object_new (FileDrop);
+  drop->project_generation = PROJECT->generation;
+  drop->files = file_arr;
+  if (track)
+    {
+      drop->track_name_hash =
+        track_get_name_hash (track);
+      drop->lane_pos = lane ? lane->pos : -1;
+    }
+  if (pos)
+    {
+      drop->pos = *pos;
+      drop->has_pos = true;
+    }
+  file_import_run_async (
+    import, true,
+    (FileImportCallback) on_file_drop_import_done,
+    drop);
 }
 
 static void
@@ -1960,6 +2206,74 @@ tracklist_new (
   return self;
 }
 
+/**
+ * Starts a batch of tracklist mutations (eg,
+ * creating or deleting many tracks with separate
+ * actions).
+ *
+ * The engine is paused for the whole batch, and
+ * graph recalculations and UI event processing
+ * are deferred until the matching
+ * tracklist_end_batch() call. Batches can be
+ * nested.
+ */
+void
+tracklist_begin_batch (
+  Tracklist * self)
+{
+  if (self->batch_depth++ > 0)
+    return;
+
+  g_message ("starting tracklist batch...");
+
+  self->batch_recalc_graph = false;
+  self->batch_recalc_graph_soft = false;
+  engine_wait_for_pause (
+    AUDIO_ENGINE, &self->batch_engine_state,
+    F_NO_FORCE);
+}
+
+/**
+ * Ends a batch started with
+ * tracklist_begin_batch().
+ *
+ * When the outermost batch ends, the graph is
+ * recalculated once (if requested during the
+ * batch), the engine is resumed and the queued UI
+ * events are processed.
+ */
+void
+tracklist_end_batch (
+  Tracklist * self)
+{
+  g_return_if_fail (self->batch_depth > 0);
+
+  if (--self->batch_depth > 0)
+    return;
+
+  if (self->batch_recalc_graph)
+    {
+      router_recalc_graph (ROUTER, F_NOT_SOFT);
+    }
+  else if (self->batch_recalc_graph_soft)
+    {
+      router_recalc_graph (ROUTER, F_SOFT);
+    }
+  self->batch_recalc_graph = false;
+  self->batch_recalc_graph_soft = false;
+
+  engine_resume (
+    AUDIO_ENGINE, &self->batch_engine_state);
+
+  if (ZRYTHM_HAVE_UI)
+    {
+      /* process the coalesced UI events */
+      event_manager_process_now (EVENT_MANAGER);
+    }
+
+  g_message ("tracklist batch finished");
+}
+
 void
 tracklist_free (
   Tracklist * self)
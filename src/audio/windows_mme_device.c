@@ -114,9 +114,11 @@ windows_mme_device_new (
  * MidiEvent struct.
  *
  * @param timestamp_start The timestamp at the start
- *   of the processing cycle.
- * @param timestamp_end The expected timestamp at
- *   the end of the processing cycle.
+ *   of the period the events to dequeue arrived
+ *   in.
+ * @param timestamp_end The timestamp at the end of
+ *   that period. Events arriving later are left in
+ *   the queue.
  *
  * @return Whether a MIDI event was dequeued or
  * not.
@@ -131,7 +133,7 @@ windows_mme_device_dequeue_midi_event_struct (
   g_return_val_if_fail (self, 0);
 
   uint64_t timestamp;
-  size_t data_size;
+  size_t data_size = sizeof (ev->raw_buffer);
   int ret =
     windows_mme_device_dequeue_midi_event (
       self, timestamp_start, timestamp_end,
@@ -140,24 +142,11 @@ windows_mme_device_dequeue_midi_event_struct (
     return 0;
 
   /* calculate the time in frames */
-  uint64_t timestamp_interval =
-    timestamp_end - timestamp_start;
-  int64_t timestamp_offset =
-    (int64_t) timestamp - (int64_t) timestamp_start;
-  double ratio =
-    (double) timestamp_offset /
-    (double) timestamp_interval;
-#if 0
-  if (ratio < 0.001 || ratio >= 1.0)
-  {
-    g_warning ("Event time is not within this cycle, skipping");
-    return 0;
-  }
-#endif
-
   ev->time =
-    (midi_time_t)
-    (ratio * (double) AUDIO_ENGINE->block_length);
+    engine_get_input_frame_offset (
+      AUDIO_ENGINE, (gint64) timestamp_start,
+      (gint64) timestamp,
+      AUDIO_ENGINE->block_length);
 
   return 1;
 }
@@ -191,7 +180,13 @@ windows_mme_device_dequeue_midi_event (
 
   zix_ring_peek (
     self->midi_ring, &h, sizeof (h));
-  g_return_val_if_fail (h.time < timestamp_end, 0);
+  if (h.time >= timestamp_end
+      || read_space < sizeof (MidiEventHeader) + h.size)
+    {
+      /* arrived after the period or still being
+       * written - defer */
+      return 0;
+    }
 
   /* read event header */
   zix_ring_read (
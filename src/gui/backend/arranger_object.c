@@ -24,6 +24,7 @@
 #include "audio/chord_track.h"
 #include "audio/marker_track.h"
 #include "audio/midi_region.h"
+#include "audio/region_index.h"
 #include "audio/router.h"
 #include "audio/stretcher.h"
 #include "gui/backend/arranger_object.h"
@@ -52,6 +53,7 @@
 #include "gui/widgets/midi_note.h"
 #include "gui/widgets/midi_region.h"
 #include "gui/widgets/region.h"
+#include "gui/widgets/region_thumbnail.h"
 #include "gui/widgets/scale_object.h"
 #include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/timeline_panel.h"
@@ -268,6 +270,8 @@ arranger_object_set_muted (
   bool             fire_events)
 {
   self->muted = muted;
+  arranger_object_bump_region_content_version (
+    self);
 
   if (fire_events)
     {
@@ -337,6 +341,9 @@ arranger_object_set_to_object (
     default:
       break;
     }
+
+  arranger_object_bump_region_content_version (
+    dest);
 }
 
 /**
@@ -391,6 +398,116 @@ arranger_object_get_region (
   return region;
 }
 
+/**
+ * Bumps the content version of the region the
+ * object belongs to, if it is a child of a region
+ * in the project.
+ *
+ * To be called whenever something drawn in region
+ * thumbnails changes. Clones of child objects are
+ * ignored.
+ */
+void
+arranger_object_bump_region_content_version (
+  ArrangerObject * self)
+{
+  if (!PROJECT || !TRACKLIST)
+    return;
+
+  /* look up the region without warnings since
+   * the object may be a clone of an object whose
+   * region no longer exists */
+  const RegionIdentifier * id = &self->region_id;
+  ZRegion ** regions = NULL;
+  int num_regions = 0;
+  switch (self->type)
+    {
+    case TYPE (MIDI_NOTE):
+    case TYPE (AUTOMATION_POINT):
+      {
+        Track * track =
+          tracklist_find_track_by_name_hash (
+            TRACKLIST, id->track_name_hash);
+        if (!track)
+          return;
+
+        if (self->type == TYPE (MIDI_NOTE))
+          {
+            if (id->lane_pos < 0
+                || id->lane_pos >= track->num_lanes)
+              return;
+            TrackLane * lane =
+              track->lanes[id->lane_pos];
+            regions = lane->regions;
+            num_regions = lane->num_regions;
+          }
+        else
+          {
+            AutomationTracklist * atl =
+              &track->automation_tracklist;
+            if (id->at_idx < 0
+                || id->at_idx >= atl->num_ats)
+              return;
+            AutomationTrack * at =
+              atl->ats[id->at_idx];
+            regions = at->regions;
+            num_regions = at->num_regions;
+          }
+      }
+      break;
+    case TYPE (CHORD_OBJECT):
+      if (!P_CHORD_TRACK)
+        return;
+      regions = P_CHORD_TRACK->chord_regions;
+      num_regions = P_CHORD_TRACK->num_chord_regions;
+      break;
+    default:
+      return;
+    }
+
+  if (id->idx < 0 || id->idx >= num_regions)
+    return;
+  ZRegion * r = regions[id->idx];
+
+  /* only bump if the object is the one in the
+   * region */
+  bool in_region = false;
+  switch (self->type)
+    {
+    case TYPE (MIDI_NOTE):
+      {
+        MidiNote * mn = (MidiNote *) self;
+        in_region =
+          mn->pos >= 0 && mn->pos < r->num_midi_notes
+          && r->midi_notes[mn->pos] == mn;
+      }
+      break;
+    case TYPE (AUTOMATION_POINT):
+      {
+        AutomationPoint * ap =
+          (AutomationPoint *) self;
+        in_region =
+          ap->index >= 0 && ap->index < r->num_aps
+          && r->aps[ap->index] == ap;
+      }
+      break;
+    case TYPE (CHORD_OBJECT):
+      {
+        ChordObject * co = (ChordObject *) self;
+        in_region =
+          co->index >= 0
+          && co->index < r->num_chord_objects
+          && r->chord_objects[co->index] == co;
+      }
+      break;
+    default:
+      break;
+    }
+
+  if (in_region)
+    r->content_version++;
+}
+
 /**
  * Returns whether the given object is hit by the
  * given position or range.
@@ -683,6 +800,60 @@ arranger_object_copy_identifier (
     }
 }
 
+/**
+ * Marks the region index of the lane or
+ * automation track owning the region as stale, if
+ * the region is in the project.
+ */
+static void
+mark_region_index_stale (
+  ArrangerObject * self)
+{
+  if (!PROJECT || !TRACKLIST)
+    return;
+
+  /* look up the owner without warnings since the
+   * region may be a clone or not added yet */
+  ZRegion * r = (ZRegion *) self;
+  Tracklist * tracklist =
+    self->is_auditioner ?
+      SAMPLE_PROCESSOR->tracklist : TRACKLIST;
+  Track * track =
+    tracklist_find_track_by_name_hash (
+      tracklist, r->id.track_name_hash);
+  if (!track)
+    return;
+
+  switch (r->id.type)
+    {
+    case REGION_TYPE_MIDI:
+    case REGION_TYPE_AUDIO:
+      if (r->id.lane_pos >= 0
+          && r->id.lane_pos < track->num_lanes)
+        {
+          region_index_mark_positions_changed (
+            &track->lanes[r->id.lane_pos]->
+              region_index);
+        }
+      break;
+    case REGION_TYPE_AUTOMATION:
+      {
+        AutomationTracklist * atl =
+          track_get_automation_tracklist (track);
+        if (atl && r->id.at_idx >= 0
+            && r->id.at_idx < atl->num_ats)
+          {
+            region_index_mark_positions_changed (
+              &atl->ats[r->id.at_idx]->
+                region_index);
+          }
+      }
+      break;
+    default:
+      break;
+    }
+}
+
 /**
  * Sets the Position  all of the object's linked
  * objects (see ArrangerObjectInfo)
@@ -713,6 +884,20 @@ arranger_object_set_position (
   pos_ptr = get_position_ptr (self, pos_type);
   g_return_if_fail (pos_ptr);
   position_set_to_pos (pos_ptr, pos);
+
+  arranger_object_bump_region_content_version (
+    self);
+
+  if (self->type == TYPE (REGION)
+      &&
+      (pos_type ==
+         ARRANGER_OBJECT_POSITION_TYPE_START
+       ||
+       pos_type ==
+         ARRANGER_OBJECT_POSITION_TYPE_END))
+    {
+      mark_region_index_stale (self);
+    }
 }
 
 /**
@@ -1156,6 +1341,10 @@ arranger_object_update_positions (
     }
 
   position_update (&self->pos, from_ticks);
+  if (self->type == TYPE (REGION))
+    {
+      mark_region_index_stale (self);
+    }
   if (arranger_object_type_has_length (self->type))
     {
       position_update (&self->end_pos, from_ticks);
@@ -3851,6 +4040,12 @@ free_region (
       FREE_R (AUTOMATION, automation);
     }
 
+  for (int i = 0; i < 2; i++)
+    {
+      object_free_w_func_and_null (
+        region_thumbnail_free, self->thumbnails[i]);
+    }
+
   g_free_and_null (self->name);
   g_free_and_null (self->escaped_name);
   if (G_IS_OBJECT (self->layout))
@@ -3873,9 +4068,6 @@ free_midi_note (
   arranger_object_free (
     (ArrangerObject *) self->vel);
 
-  if (G_IS_OBJECT (self->layout))
-    g_object_unref (self->layout);
-
   object_zero_and_free (self);
 }
 
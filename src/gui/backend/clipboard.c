@@ -20,6 +20,14 @@
 #include "gui/backend/clipboard.h"
 #include "utils/flags.h"
 #include "utils/objects.h"
+#include "utils/yaml.h"
+
+/** Clipboard offered with clipboard_offer(), if
+ * still owned. */
+static Clipboard * offered_clipboard = NULL;
+
+/** System clipboard it was offered on. */
+static GtkClipboard * offered_gtk_clipboard = NULL;
 
 /**
  * Creates a new Clipboard instance for the given
@@ -112,6 +120,99 @@ clipboard_get_selections (
   g_return_val_if_reached (NULL);
 }
 
+static void
+get_clipboard_data (
+  GtkClipboard *     gtk_clipboard,
+  GtkSelectionData * selection_data,
+  guint              info,
+  Clipboard *        self)
+{
+  g_message (
+    "serializing clipboard (%s) on request...",
+    clipboard_type_strings[self->type].str);
+
+  char * serialized =
+    yaml_serialize (self, &clipboard_schema);
+  g_return_if_fail (serialized);
+  gtk_selection_data_set_text (
+    selection_data, serialized, -1);
+  g_free (serialized);
+}
+
+static void
+clear_clipboard_data (
+  GtkClipboard * gtk_clipboard,
+  Clipboard *    self)
+{
+  if (offered_clipboard == self)
+    {
+      offered_clipboard = NULL;
+      offered_gtk_clipboard = NULL;
+    }
+  clipboard_free (self);
+}
+
+/**
+ * Offers the clipboard on the given system
+ * clipboard, taking ownership of it.
+ *
+ * The clipboard is only serialized when its
+ * contents are requested (eg, by another
+ * instance). It is free'd when the system
+ * clipboard is set by someone else.
+ */
+void
+clipboard_offer (
+  Clipboard *    self,
+  GtkClipboard * gtk_clipboard)
+{
+  GtkTargetList * list = gtk_target_list_new (NULL, 0);
+  gtk_target_list_add_text_targets (list, 0);
+  int num_targets;
+  GtkTargetEntry * targets =
+    gtk_target_table_new_from_list (
+      list, &num_targets);
+  gtk_target_list_unref (list);
+
+  /* this clears the previous contents (and frees
+   * the previously offered clipboard) */
+  if (gtk_clipboard_set_with_data (
+        gtk_clipboard, targets,
+        (guint) num_targets,
+        (GtkClipboardGetFunc) get_clipboard_data,
+        (GtkClipboardClearFunc)
+          clear_clipboard_data,
+        self))
+    {
+      offered_clipboard = self;
+      offered_gtk_clipboard = gtk_clipboard;
+    }
+  else
+    {
+      g_warning ("failed to set clipboard data");
+      clipboard_free (self);
+    }
+  gtk_target_table_free (targets, num_targets);
+}
+
+/**
+ * Returns the clipboard offered with
+ * clipboard_offer() if it is still the contents of
+ * the given system clipboard, or NULL.
+ *
+ * This allows pasting within this instance without
+ * serializing and deserializing the contents.
+ */
+Clipboard *
+clipboard_get_offered (
+  GtkClipboard * gtk_clipboard)
+{
+  if (offered_gtk_clipboard != gtk_clipboard)
+    return NULL;
+
+  return offered_clipboard;
+}
+
 /**
  * Frees the clipboard and all associated data.
  */
@@ -27,8 +27,10 @@
 #include "audio/automation_tracklist.h"
 #include "audio/channel.h"
 #include "audio/clip.h"
+#include "audio/graph.h"
 #include "audio/modulator_track.h"
 #include "audio/pool.h"
+#include "audio/prerenderer.h"
 #include "audio/router.h"
 #include "audio/stretcher.h"
 #include "audio/track.h"
@@ -71,6 +73,7 @@
 #include "gui/widgets/midi_editor_space.h"
 #include "gui/widgets/mixer.h"
 #include "gui/widgets/piano_roll_keys.h"
+#include "gui/widgets/panel_file_browser.h"
 #include "gui/widgets/plugin_browser.h"
 #include "gui/widgets/plugin_strip_expander.h"
 #include "gui/widgets/right_dock_edge.h"
@@ -80,6 +83,7 @@
 #include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/timeline_bot_box.h"
 #include "gui/widgets/timeline_minimap.h"
+#include "gui/widgets/timeline_minimap_bg.h"
 #include "gui/widgets/timeline_panel.h"
 #include "gui/widgets/timeline_ruler.h"
 #include "gui/widgets/timeline_toolbar.h"
@@ -494,15 +498,14 @@ on_automation_track_added (
 }
 
 static void
-on_track_added (Track * track)
+on_track_added (
+  EventManager * self,
+  Track *        track)
 {
   if (!MAIN_WINDOW || !MW_CENTER_DOCK)
     return;
 
-  if (MW_MIXER)
-    mixer_widget_hard_refresh (MW_MIXER);
-  if (MW_TRACKLIST)
-    tracklist_widget_hard_refresh (MW_TRACKLIST);
+  self->pending_track_widgets_refresh = true;
 
   /* needs to be called later because tracks need
    * time to get allocated */
@@ -640,6 +643,111 @@ refresh_for_selections_type (
     }
 }
 
+/**
+ * Invalidates the minimap rows of the tracks
+ * owning the regions in the given selections.
+ *
+ * The minimap only redraws rows marked dirty, and
+ * the arranger selection events are the only
+ * notification that regions were created, edited
+ * or quantized, so they must invalidate the rows.
+ *
+ * @param whole Whether to invalidate the whole
+ *   overview instead (eg, when regions were moved
+ *   or removed, since their previous tracks are no
+ *   longer known from the selections).
+ */
+static void
+invalidate_minimap_for_selections (
+  ArrangerSelections * sel,
+  bool                 whole)
+{
+  if (sel->type != ARRANGER_SELECTIONS_TYPE_TIMELINE)
+    return;
+
+  if (whole)
+    {
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
+      return;
+    }
+
+  int size = 0;
+  ArrangerObject ** objs =
+    arranger_selections_get_all_objects (
+      sel, &size);
+  for (int i = 0; i < size; i++)
+    {
+      ArrangerObject * obj = objs[i];
+      if (obj->type != ARRANGER_OBJECT_TYPE_REGION)
+        continue;
+
+      /* the track may already be gone, so don't
+       * use arranger_object_get_track() here */
+      ZRegion * r = (ZRegion *) obj;
+      Track * track =
+        tracklist_find_track_by_name_hash (
+          TRACKLIST, r->id.track_name_hash);
+      if (!track)
+        {
+          timeline_minimap_bg_widget_invalidate (
+            MW_TIMELINE_MINIMAP->bg);
+          break;
+        }
+      timeline_minimap_bg_widget_invalidate_track (
+        MW_TIMELINE_MINIMAP->bg, track);
+    }
+  free (objs);
+}
+
+/**
+ * Makes the tracks owning the objects in the
+ * given selections go back to live processing if
+ * they are rendered ahead.
+ */
+static void
+invalidate_prerendered_tracks_for_selections (
+  ArrangerSelections * sel)
+{
+  if (!ROUTER->graph || !ROUTER->graph->prerenderer)
+    return;
+
+  Prerenderer * prerenderer =
+    ROUTER->graph->prerenderer;
+  int size = 0;
+  ArrangerObject ** objs =
+    arranger_selections_get_all_objects (
+      sel, &size);
+  for (int i = 0; i < size; i++)
+    {
+      ArrangerObject * obj = objs[i];
+      switch (obj->type)
+        {
+        case ARRANGER_OBJECT_TYPE_REGION:
+        case ARRANGER_OBJECT_TYPE_MIDI_NOTE:
+        case ARRANGER_OBJECT_TYPE_AUTOMATION_POINT:
+          {
+            Track * track =
+              arranger_object_get_track (obj);
+            if (track)
+              {
+                prerenderer_invalidate_track (
+                  prerenderer, track);
+              }
+          }
+          break;
+        case ARRANGER_OBJECT_TYPE_CHORD_OBJECT:
+        case ARRANGER_OBJECT_TYPE_SCALE_OBJECT:
+          /* may be heard by any track */
+          prerenderer_invalidate_all (prerenderer);
+          break;
+        default:
+          break;
+        }
+    }
+  free (objs);
+}
+
 static void
 on_arranger_selections_changed (
   ArrangerSelections * sel)
@@ -690,6 +798,8 @@ on_arranger_selections_changed (
 
   timeline_toolbar_widget_refresh (
     MW_TIMELINE_TOOLBAR);
+
+  invalidate_minimap_for_selections (sel, false);
 }
 
 static void
@@ -763,6 +873,7 @@ on_arranger_selections_created (
 {
   arranger_selections_change_redraw_everything (
     sel);
+  invalidate_minimap_for_selections (sel, false);
 }
 
 static void
@@ -771,6 +882,10 @@ on_arranger_selections_moved (
 {
   arranger_selections_change_redraw_everything (
     sel);
+  /* moves may change the track of a region
+   * (region_move_to_track), so the source rows
+   * must be redrawn too */
+  invalidate_minimap_for_selections (sel, true);
 }
 
 static void
@@ -786,6 +901,8 @@ on_arranger_selections_removed (
 
   arranger_selections_change_redraw_everything (
     sel);
+  /* the removed regions' tracks may be gone */
+  invalidate_minimap_for_selections (sel, true);
 
 #if 0
   switch (type)
@@ -860,6 +977,8 @@ on_track_color_changed (Track * track)
   track_widget_force_redraw (track->widget);
   left_dock_edge_widget_refresh (
     MW_LEFT_DOCK_EDGE);
+  timeline_minimap_bg_widget_invalidate_track (
+    MW_TIMELINE_MINIMAP->bg, track);
 }
 
 static void
@@ -987,6 +1106,13 @@ on_arranger_object_changed (
   /*ArrangerWidget * arranger =*/
     /*arranger_object_get_arranger (obj);*/
   /*arranger_widget_redraw_whole (arranger);*/
+
+  if (obj->type == ARRANGER_OBJECT_TYPE_REGION)
+    {
+      timeline_minimap_bg_widget_invalidate_track (
+        MW_TIMELINE_MINIMAP->bg,
+        arranger_object_get_track (obj));
+    }
 }
 
 static void
@@ -1005,6 +1131,12 @@ on_arranger_object_created (
         (ArrangerWidget *)
         MW_MIDI_MODIFIER_ARRANGER);
     }
+  else if (obj->type == ARRANGER_OBJECT_TYPE_REGION)
+    {
+      timeline_minimap_bg_widget_invalidate_track (
+        MW_TIMELINE_MINIMAP->bg,
+        arranger_object_get_track (obj));
+    }
 }
 
 static void
@@ -1021,6 +1153,11 @@ on_arranger_object_removed (
         MW_MIDI_MODIFIER_ARRANGER);
       break;
     case ARRANGER_OBJECT_TYPE_REGION:
+      /* the track of the removed region is not
+       * known */
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
+      /* fallthrough */
     case ARRANGER_OBJECT_TYPE_SCALE_OBJECT:
     case ARRANGER_OBJECT_TYPE_MARKER:
       arranger_widget_redraw_whole (
@@ -1220,11 +1357,9 @@ event_manager_process_event (
         }
       break;
     case ET_TRACKS_REMOVED:
-      if (MW_MIXER)
-        mixer_widget_hard_refresh (MW_MIXER);
-      if (MW_TRACKLIST)
-        tracklist_widget_hard_refresh (
-          MW_TRACKLIST);
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
+      self->pending_track_widgets_refresh = true;
       visibility_widget_refresh (
         MW_VISIBILITY);
       tracklist_header_widget_refresh_track_count (
@@ -1251,6 +1386,10 @@ event_manager_process_event (
     case ET_ARRANGER_SELECTIONS_CHANGED:
       on_arranger_selections_changed (
         ARRANGER_SELECTIONS (ev->arg));
+      /* objects may have been edited without an
+       * undoable action yet */
+      invalidate_prerendered_tracks_for_selections (
+        ARRANGER_SELECTIONS (ev->arg));
       break;
     case ET_ARRANGER_SELECTIONS_CREATED:
       on_arranger_selections_created (
@@ -1267,6 +1406,8 @@ event_manager_process_event (
     case ET_ARRANGER_SELECTIONS_QUANTIZED:
       redraw_arranger_for_selections (
         ARRANGER_SELECTIONS (ev->arg));
+      invalidate_minimap_for_selections (
+        ARRANGER_SELECTIONS (ev->arg), false);
       break;
     case ET_ARRANGER_SELECTIONS_ACTION_FINISHED:
       redraw_all_arranger_bgs ();
@@ -1441,7 +1582,7 @@ event_manager_process_event (
         /*(ArrangerWidget *) MW_PINNED_TIMELINE);*/
       break;
     case ET_TRACK_ADDED:
-      on_track_added ((Track *) ev->arg);
+      on_track_added (self, (Track *) ev->arg);
       tracklist_header_widget_refresh_track_count (
         MW_TRACKLIST_HEADER);
       break;
@@ -1449,11 +1590,9 @@ event_manager_process_event (
       on_track_changed ((Track *) ev->arg);
       break;
     case ET_TRACKS_ADDED:
-      if (MW_MIXER)
-        mixer_widget_hard_refresh (MW_MIXER);
-      if (MW_TRACKLIST)
-        tracklist_widget_hard_refresh (
-          MW_TRACKLIST);
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
+      self->pending_track_widgets_refresh = true;
       visibility_widget_refresh (
         MW_VISIBILITY);
       tracklist_header_widget_refresh_track_count (
@@ -1496,6 +1635,8 @@ event_manager_process_event (
         MW_MONITOR_SECTION);
       break;
     case ET_TRACK_VISIBILITY_CHANGED:
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
       tracklist_widget_update_track_visibility (
         MW_TRACKLIST);
       arranger_widget_redraw_whole (
@@ -1553,6 +1694,8 @@ event_manager_process_event (
         (Channel *)ev->arg);
       break;
     case ET_TRACKS_MOVED:
+      timeline_minimap_bg_widget_invalidate (
+        MW_TIMELINE_MINIMAP->bg);
       if (MW_MIXER)
         mixer_widget_hard_refresh (MW_MIXER);
 
@@ -1626,6 +1769,10 @@ event_manager_process_event (
     case ET_ARRANGER_SELECTIONS_IN_TRANSIT:
       on_arranger_selections_in_transit (
         (ArrangerSelections *) ev->arg);
+      /* objects may have been edited without an
+       * undoable action yet */
+      invalidate_prerendered_tracks_for_selections (
+        (ArrangerSelections *) ev->arg);
       break;
     case ET_CHORD_KEY_CHANGED:
       for (int j = 0;
@@ -1890,6 +2037,24 @@ event_manager_process_event (
       plugin_browser_widget_refresh_collections (
         MW_PLUGIN_BROWSER);
       break;
+    case ET_PLUGIN_DESCRIPTORS_CHANGED:
+      if (MAIN_WINDOW && MW_CENTER_DOCK
+          && MW_RIGHT_DOCK_EDGE
+          && MW_PLUGIN_BROWSER)
+        {
+          plugin_browser_widget_refresh_plugins (
+            MW_PLUGIN_BROWSER);
+        }
+      break;
+    case ET_FILE_BROWSER_FILES_CHANGED:
+      if (MAIN_WINDOW && MW_CENTER_DOCK
+          && MW_RIGHT_DOCK_EDGE
+          && MW_PANEL_FILE_BROWSER)
+        {
+          panel_file_browser_refresh_files (
+            MW_PANEL_FILE_BROWSER);
+        }
+      break;
     case ET_SNAP_GRID_OPTIONS_CHANGED:
       {
         SnapGrid * sg = (SnapGrid *) ev->arg;
@@ -1935,7 +2100,7 @@ event_manager_process_event (
       }
       break;
     case ET_TRACK_FOLD_CHANGED:
-      on_track_added ((Track *) ev->arg);
+      on_track_added (self, (Track *) ev->arg);
       break;
     case ET_MIXER_CHANNEL_INSERTS_EXPANDED_CHANGED:
     case ET_MIXER_CHANNEL_MIDI_FX_EXPANDED_CHANGED:
@@ -2014,6 +2179,18 @@ return_to_pool:
       object_pool_return (
         self->obj_pool, ev);
     }
+
+  /* hard refresh once for all the tracks added
+   * or removed (eg, during a tracklist batch) */
+  if (self->pending_track_widgets_refresh)
+    {
+      if (MW_MIXER)
+        mixer_widget_hard_refresh (MW_MIXER);
+      if (MW_TRACKLIST)
+        tracklist_widget_hard_refresh (
+          MW_TRACKLIST);
+      self->pending_track_widgets_refresh = false;
+    }
   /*g_message ("processed %d events", i);*/
 
   if (self->events_arr->len > 6)
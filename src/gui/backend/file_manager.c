@@ -21,6 +21,8 @@
 #include <string.h>
 
 #include "audio/supported_file.h"
+#include "gui/backend/event.h"
+#include "gui/backend/event_manager.h"
 #include "gui/backend/file_manager.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
@@ -29,15 +31,22 @@
 #include "utils/string.h"
 #include "utils/strv_builder.h"
 #include "zrythm.h"
+#include "zrythm_app.h"
 
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 
 /**
  * Creates the file manager.
+ *
+ * @param load_files Whether to load the files of
+ *   the initial selection. If false, they must be
+ *   loaded later, eg, with
+ *   file_manager_begin_load_files().
  */
 FileManager *
-file_manager_new (void)
+file_manager_new (
+  bool load_files)
 {
   FileManager * self = object_new (FileManager);
 
@@ -60,7 +69,7 @@ file_manager_new (void)
   g_ptr_array_add (self->locations, fl);
 
   file_manager_set_selection (
-    self, fl, false, false);
+    self, fl, load_files, false);
 
   fl =
     file_browser_location_new ();
@@ -104,7 +113,7 @@ file_manager_new (void)
             loc->path, G_FILE_TEST_IS_DIR))
         {
           file_manager_set_selection (
-            self, loc, true, false);
+            self, loc, load_files, false);
         }
       file_browser_location_free (loc);
     }
@@ -125,17 +134,18 @@ alphaBetize (const void * _a,
   return -strcmp(a->label, b->label); /* aka: return strcmp(b, a); */
 }
 
+/**
+ * Appends the files under the given location to
+ * @p files.
+ */
 static void
 load_files_from_location (
-  FileManager *         self,
+  GPtrArray *           files,
   FileBrowserLocation * location)
 {
   const gchar * file;
   SupportedFile * fd;
 
-  g_ptr_array_remove_range (
-    self->files, 0, self->files->len);
-
   GDir * dir =
     g_dir_open (location->path, 0, NULL);
   if (!dir)
@@ -158,7 +168,7 @@ load_files_from_location (
   fd->label = g_strdup ("..");
   if (strlen (location->path) > 1)
     {
-      g_ptr_array_add (self->files, fd);
+      g_ptr_array_add (files, fd);
     }
   else
     {
@@ -217,7 +227,7 @@ load_files_from_location (
       if (file[0] == '.')
         fd->hidden = true;
 
-      g_ptr_array_add (self->files, fd);
+      g_ptr_array_add (files, fd);
       /*g_message ("File found: %s (%d - %d)",*/
                  /*fd->abs_path,*/
                  /*fd->type,*/
@@ -226,8 +236,8 @@ load_files_from_location (
   g_dir_close (dir);
 
   g_ptr_array_sort (
-    self->files, (GCompareFunc) alphaBetize);
-  g_message ("Total files: %d", self->files->len);
+    files, (GCompareFunc) alphaBetize);
+  g_message ("Total files: %d", files->len);
 }
 
 /**
@@ -236,17 +246,162 @@ load_files_from_location (
 void
 file_manager_load_files (FileManager * self)
 {
+  g_ptr_array_remove_range (
+    self->files, 0, self->files->len);
   if (self->selection)
     {
       load_files_from_location (
-        self,
+        self->files,
         (FileBrowserLocation *) self->selection);
     }
-  else
+}
+
+/**
+ * A background file loading job.
+ */
+typedef struct FileLoadJob
+{
+  FileManager *         mgr;
+
+  /** Location to load (owned). */
+  FileBrowserLocation * location;
+
+  /** Loaded files. */
+  GPtrArray *           files;
+
+  GenericCallback       on_finished;
+  void *                user_data;
+} FileLoadJob;
+
+static void
+file_load_job_free (
+  FileLoadJob * job)
+{
+  if (job->files)
+    g_ptr_array_unref (job->files);
+  if (job->location)
+    file_browser_location_free (job->location);
+  free (job);
+}
+
+static int
+on_files_loaded (
+  FileLoadJob * job)
+{
+  FileManager * self = job->mgr;
+
+  /* joining also guarantees that the loading
+   * thread has finished setting the source ID */
+  if (self->load_thread)
+    {
+      g_thread_join (self->load_thread);
+      self->load_thread = NULL;
+    }
+  self->load_source_id = 0;
+
+  /* only use the files if the selection didn't
+   * change in the meantime */
+  bool selection_unchanged =
+    job->location
+    ? (self->selection
+       && string_is_equal (
+            self->selection->path,
+            job->location->path))
+    : self->selection == NULL;
+  if (selection_unchanged)
+    {
+      GPtrArray * prev_files = self->files;
+      self->files = job->files;
+      job->files = NULL;
+
+      /* refresh the views before freeing the
+       * previous files they point to */
+      EVENTS_PUSH_NOW (
+        ET_FILE_BROWSER_FILES_CHANGED, NULL);
+      g_ptr_array_unref (prev_files);
+    }
+
+  if (job->on_finished)
+    job->on_finished (job->user_data);
+
+  /* the job is freed when the source is
+   * destroyed */
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Adds an idle source that finishes the given
+ * job in the GTK thread and returns its ID.
+ */
+static guint
+add_files_loaded_source (
+  FileLoadJob * job)
+{
+  return
+    g_idle_add_full (
+      G_PRIORITY_DEFAULT_IDLE,
+      (GSourceFunc) on_files_loaded, job,
+      (GDestroyNotify) file_load_job_free);
+}
+
+static void *
+load_files_thread_func (
+  FileLoadJob * job)
+{
+  load_files_from_location (
+    job->files, job->location);
+
+  job->mgr->load_source_id =
+    add_files_loaded_source (job);
+
+  return NULL;
+}
+
+/**
+ * Loads the files under the current selection in
+ * a background thread.
+ *
+ * The files are swapped in and the file browser
+ * is refreshed in the GTK thread once loaded.
+ *
+ * @param on_finished Callback to call in the GTK
+ *   thread when loading finished, or NULL. It is
+ *   always called from the main loop, even if
+ *   there is nothing to load.
+ */
+void
+file_manager_begin_load_files (
+  FileManager *   self,
+  GenericCallback on_finished,
+  void *          user_data)
+{
+  g_return_if_fail (
+    !self->load_thread && !self->load_source_id);
+
+  FileLoadJob * job = object_new (FileLoadJob);
+  job->mgr = self;
+  job->files =
+    g_ptr_array_new_full (
+      400, (GDestroyNotify) supported_file_free);
+  job->on_finished = on_finished;
+  job->user_data = user_data;
+
+  if (!self->selection)
     {
-      g_ptr_array_remove_range (
-        self->files, 0, self->files->len);
+      /* nothing to load, but still finish in a
+       * later iteration of the main loop like
+       * when loading */
+      self->load_source_id =
+        add_files_loaded_source (job);
+      return;
     }
+
+  job->location =
+    file_browser_location_clone (self->selection);
+  self->load_thread =
+    g_thread_new (
+      "file_manager_load_thread",
+      (GThreadFunc) load_files_thread_func, job);
 }
 
 /**
@@ -385,6 +540,19 @@ void
 file_manager_free (
   FileManager * self)
 {
+  if (self->load_thread)
+    {
+      g_thread_join (self->load_thread);
+      self->load_thread = NULL;
+    }
+  /* the job would otherwise run on the freed
+   * file manager */
+  if (self->load_source_id)
+    {
+      g_source_remove (self->load_source_id);
+      self->load_source_id = 0;
+    }
+
   g_ptr_array_free (self->files, true);
   g_ptr_array_free (self->locations, true);
 
@@ -6999,6 +6999,10 @@ finalize (
     g_object_unref, self->ap_layout);
   object_free_w_func_and_null (
     g_object_unref, self->audio_layout);
+  object_free_w_func_and_null (
+    g_free, self->track_geometries);
+  object_free_w_func_and_null (
+    g_free, self->track_geometry_indices);
 
   G_OBJECT_CLASS (
     arranger_widget_parent_class)->
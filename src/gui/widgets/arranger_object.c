@@ -719,17 +719,11 @@ arranger_object_set_full_rectangle (
             self->full_rect.width = 1;
           }
 
-        gint wx, wy;
-
-        gtk_widget_translate_coordinates(
-          (GtkWidget *) (track->widget),
-          (GtkWidget *) (arranger),
-          0, 0,
-          &wx, &wy);
-        /* for some reason it returns a few
-         * negatives at first */
-        if (wy < 0)
-          wy = 0;
+        /* use the cached track offset */
+        int wy =
+          MAX (
+            timeline_arranger_widget_get_track_y (
+              arranger, track), 0);
 
         if (region->id.type == REGION_TYPE_CHORD)
           {
@@ -757,15 +751,6 @@ arranger_object_set_full_rectangle (
                 !track->automation_visible)
               return;
 
-            gtk_widget_translate_coordinates(
-              (GtkWidget *) (track->widget),
-              (GtkWidget *) (arranger),
-              0, 0, &wx, &wy);
-            /* for some reason it returns a few
-             * negatives at first */
-            if (wy < 0)
-              wy = 0;
-
             self->full_rect.y =
               wy + at->y;
             self->full_rect.height =
@@ -847,16 +832,10 @@ arranger_object_set_full_rectangle (
       {
         Track * track = P_CHORD_TRACK;
 
-        gint wx, wy;
-        gtk_widget_translate_coordinates(
-          (GtkWidget *) (track->widget),
-          (GtkWidget *) (arranger),
-          0, 0,
-          &wx, &wy);
-        /* for some reason it returns a few
-         * negatives at first */
-        if (wy < 0)
-          wy = 0;
+        int wy =
+          MAX (
+            timeline_arranger_widget_get_track_y (
+              arranger, track), 0);
 
         self->full_rect.x =
           ui_pos_to_px_timeline (
@@ -882,16 +861,10 @@ arranger_object_set_full_rectangle (
       {
         Track * track = P_MARKER_TRACK;
 
-        gint wx, wy;
-        gtk_widget_translate_coordinates(
-          (GtkWidget *) (track->widget),
-          (GtkWidget *) (arranger),
-          0, 0,
-          &wx, &wy);
-        /* for some reason it returns a few
-         * negatives at first */
-        if (wy < 0)
-          wy = 0;
+        int wy =
+          MAX (
+            timeline_arranger_widget_get_track_y (
+              arranger, track), 0);
 
         self->full_rect.x =
           ui_pos_to_px_timeline (
@@ -221,6 +221,8 @@ on_curve_algorithm_selected (
 
   /* change */
   info->ap->curve_opts.algo = info->algo;
+  arranger_object_bump_region_content_version (
+    (ArrangerObject *) info->ap);
 
   /* perform action */
   GError * err = NULL;
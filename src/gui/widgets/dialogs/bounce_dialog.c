@@ -53,7 +53,7 @@ on_bounce_clicked (
   GtkButton * btn,
   BounceDialogWidget * self)
 {
-  ExportSettings settings;
+  ExportSettings settings = {};
 
   switch (self->type)
     {
@@ -24,6 +24,7 @@
 
 #include "audio/audio_bus_track.h"
 #include "audio/channel.h"
+#include "audio/chord_descriptor.h"
 #include "audio/chord_track.h"
 #include "audio/instrument_track.h"
 #include "audio/region.h"
@@ -48,26 +49,6 @@
 #include "utils/ui.h"
 #include "zrythm_app.h"
 
-static void
-recreate_pango_layouts (
-  MidiNote * self,
-  int        width)
-{
-  ArrangerObject * obj = (ArrangerObject *) self;
-
-  if (!PANGO_IS_LAYOUT (self->layout))
-    {
-      self->layout =
-        z_cairo_create_default_pango_layout (
-          GTK_WIDGET (
-            arranger_object_get_arranger (obj)));
-    }
-  pango_layout_set_width (
-    self->layout,
-    pango_units_from_double (
-      width - 2));
-}
-
 /**
  * Draws the background for a MidiNote.
  *
@@ -170,24 +151,9 @@ midi_note_draw (
     &full_rect, &draw_rect);
   cairo_fill (cr);
 
-  char str[30];
-  midi_note_get_val_as_string (self, str, 1);
-
-  char fontize_str[120];
   int fontsize =
     piano_roll_keys_widget_get_font_size (
       MW_PIANO_ROLL_KEYS);
-  sprintf (
-    fontize_str, "<span size=\"%d\">",
-    /* subtract half a point for the padding */
-    fontsize * 1000 - 4000);
-  strcat (fontize_str, "%s</span>");
-
-  char str_to_use[120];
-  sprintf (str_to_use, fontize_str, str);
-
-  double fontsize_ratio =
-    (double) fontsize / 12.0;
 
   Track * tr =
     arranger_object_get_track (
@@ -195,27 +161,63 @@ midi_note_draw (
   g_return_if_fail (IS_TRACK_AND_NONNULL (tr));
   bool drum_mode = tr->drum_mode;
 
-  if ((DEBUGGING || !drum_mode) && fontsize > 10)
-    {
-      GdkRGBA c2;
-      ui_get_contrast_color (&color, &c2);
-      gdk_cairo_set_source_rgba (cr, &c2);
+  /* skip the label if the note is too narrow to
+   * show anything meaningful */
+  int min_label_width =
+    2 * REGION_NAME_BOX_PADDING + fontsize;
+  if ((!DEBUGGING && drum_mode) || fontsize <= 10
+      || full_rect.width < min_label_width)
+    return;
 
-      recreate_pango_layouts (
-        self, MIN (full_rect.width, 400));
-      cairo_move_to (
-        cr,
-        REGION_NAME_BOX_PADDING +
-          (full_rect.x - arr_rect->x),
-        fontsize_ratio * REGION_NAME_BOX_PADDING +
-          (full_rect.y - arr_rect->y));
-      PangoLayout * layout = self->layout;
-      z_cairo_draw_text (
-        cr,
-        GTK_WIDGET (
-          arranger_object_get_arranger (obj)),
-        layout, str_to_use);
-    }
+  /* build the markup here instead of using
+   * midi_note_get_val_as_string() since that adds
+   * per-note debug info, which would create a
+   * cache entry for each note */
+  char str[30];
+  sprintf (
+    str, "%s<sup>%d</sup>",
+    chord_descriptor_note_to_string (
+      self->val % 12),
+    self->val / 12 - 1);
+
+  GdkRGBA c2;
+  ui_get_contrast_color (&color, &c2);
+
+  /* blit the shared pre-rendered label instead of
+   * shaping the text for each note */
+  GtkWidget * arranger =
+    GTK_WIDGET (arranger_object_get_arranger (obj));
+  cairo_surface_t * label =
+    z_cairo_get_surface_for_label (
+      arranger, str,
+      /* subtract half a point for the padding */
+      fontsize - 4, &c2,
+      gtk_widget_get_scale_factor (arranger));
+
+  double fontsize_ratio =
+    (double) fontsize / 12.0;
+  double x =
+    REGION_NAME_BOX_PADDING + Z_CAIRO_TEXT_PADDING +
+    (full_rect.x - arr_rect->x);
+  double y =
+    fontsize_ratio * REGION_NAME_BOX_PADDING +
+    Z_CAIRO_TEXT_PADDING +
+    (full_rect.y - arr_rect->y);
+
+  /* clip to the note */
+  cairo_save (cr);
+  cairo_rectangle (
+    cr, draw_rect.x - arr_rect->x,
+    full_rect.y - arr_rect->y,
+    MIN (
+      draw_rect.width,
+      (full_rect.x + full_rect.width - 2) -
+        draw_rect.x),
+    full_rect.height);
+  cairo_clip (cr);
+  cairo_set_source_surface (cr, label, x, y);
+  cairo_paint (cr);
+  cairo_restore (cr);
 }
 
 void
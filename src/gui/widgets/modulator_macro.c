@@ -263,6 +263,20 @@ on_automate_clicked (
 #endif
 }
 
+/**
+ * Knob setter that goes through the engine's
+ * control port change queue, so that dragging the
+ * knob does not race with processing.
+ */
+static void
+set_macro_val (
+  Port * port,
+  float  val)
+{
+  control_port_queue_real_val (
+    port, val, F_NO_PUBLISH_EVENTS);
+}
+
 static bool
 redraw_cb (
   GtkWidget *             widget,
@@ -292,7 +306,7 @@ modulator_macro_widget_new (
     knob_widget_new_simple (
       control_port_get_val,
       control_port_get_default_val,
-      control_port_set_real_val,
+      set_macro_val,
       port, port->minf, port->maxf, 48, port->zerof);
   self->knob_with_name =
     knob_with_name_widget_new (
@@ -867,6 +867,25 @@ refilter_files (
     self->files_tree_model);
 }
 
+/**
+ * Refreshes the file list after the files of the
+ * file manager were reloaded.
+ */
+void
+panel_file_browser_refresh_files (
+  PanelFileBrowserWidget * self)
+{
+  GtkTreeModelFilter * prev_model =
+    self->files_tree_model;
+  self->files_tree_model =
+    GTK_TREE_MODEL_FILTER (
+      create_model_for_files (self));
+  gtk_tree_view_set_model (
+    self->files_tree_view,
+    GTK_TREE_MODEL (self->files_tree_model));
+  g_object_unref (prev_model);
+}
+
 PanelFileBrowserWidget *
 panel_file_browser_widget_new ()
 {
@@ -360,7 +360,10 @@ on_row_activated (
   GtkTreeViewColumn *column,
   gpointer           user_data)
 {
-  GtkTreeModel * model = GTK_TREE_MODEL (user_data);
+  /* the model is replaced when plugins are
+   * added */
+  GtkTreeModel * model =
+    gtk_tree_view_get_model (tree_view);
   GtkTreeIter iter;
   gtk_tree_model_get_iter (model, &iter, tp);
   GValue value = G_VALUE_INIT;
@@ -1920,6 +1923,76 @@ plugin_browser_widget_refresh_collections (
     F_NO_MULTI_SELECT, F_NO_DND);
 }
 
+/**
+ * Inserts the strings not in the given sorted
+ * single-column list store, keeping it sorted and
+ * keeping the current selection.
+ */
+static void
+merge_sorted_strings_into_store (
+  GtkListStore * list_store,
+  char **        strs,
+  int            num_strs)
+{
+  GtkTreeModel * model = GTK_TREE_MODEL (list_store);
+  GtkTreeIter iter;
+  bool valid =
+    gtk_tree_model_get_iter_first (model, &iter);
+  for (int i = 0; i < num_strs; i++)
+    {
+      char * str = NULL;
+      if (valid)
+        {
+          gtk_tree_model_get (
+            model, &iter, 0, &str, -1);
+        }
+
+      if (str && string_is_equal (str, strs[i]))
+        {
+          valid =
+            gtk_tree_model_iter_next (model, &iter);
+        }
+      else
+        {
+          GtkTreeIter new_iter;
+          gtk_list_store_insert_before (
+            list_store, &new_iter,
+            valid ? &iter : NULL);
+          gtk_list_store_set (
+            list_store, &new_iter, 0, strs[i], -1);
+        }
+      g_free (str);
+    }
+}
+
+/**
+ * Refreshes the plugin, author and category lists
+ * after plugins were added to the plugin manager.
+ */
+void
+plugin_browser_widget_refresh_plugins (
+  PluginBrowserWidget * self)
+{
+  merge_sorted_strings_into_store (
+    GTK_LIST_STORE (self->author_tree_model),
+    PLUGIN_MANAGER->plugin_authors,
+    PLUGIN_MANAGER->num_plugin_authors);
+  merge_sorted_strings_into_store (
+    GTK_LIST_STORE (self->category_tree_model),
+    PLUGIN_MANAGER->plugin_categories,
+    PLUGIN_MANAGER->num_plugin_categories);
+
+  GtkTreeModelFilter * prev_model =
+    self->plugin_tree_model;
+  self->plugin_tree_model =
+    GTK_TREE_MODEL_FILTER (
+      create_model_for_plugins (self));
+  gtk_tree_view_set_model (
+    self->plugin_tree_view,
+    GTK_TREE_MODEL (self->plugin_tree_model));
+  g_object_unref (prev_model);
+}
+
 static void
 on_visible_child_changed (
   GtkStack * stack,
@@ -2245,8 +2318,7 @@ plugin_browser_widget_new ()
   g_signal_connect (
     G_OBJECT (self->plugin_tree_view),
     "row-activated",
-    G_CALLBACK (on_row_activated),
-    self->plugin_tree_model);
+    G_CALLBACK (on_row_activated), self);
 
   /* connect right click handler */
   mp =
@@ -37,6 +37,7 @@
 #include "gui/widgets/main_notebook.h"
 #include "gui/widgets/main_window.h"
 #include "gui/widgets/region.h"
+#include "gui/widgets/region_thumbnail.h"
 #include "gui/widgets/ruler.h"
 #include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/timeline_panel.h"
@@ -63,6 +64,10 @@ typedef enum RegionCounterpart
   REGION_COUNTERPART_LANE,
 } RegionCounterpart;
 
+/** Width of the end of the cached waveform to
+ * redraw while recording. */
+#define RECORDING_REDRAW_WIDTH 8
+
 /**
  * Recreates the pango layouts for drawing.
  *
@@ -580,6 +585,9 @@ draw_midi_region (
 
 /**
  * @param rect Arranger rectangle.
+ * @param names_only Whether to only draw the
+ *   chord names (if the rest was drawn from the
+ *   thumbnail).
  */
 static void
 draw_chord_region (
@@ -588,7 +596,8 @@ draw_chord_region (
   GdkRectangle * rect,
   GdkRectangle * full_rect,
   GdkRectangle * draw_rect,
-  RegionCounterpart counterpart)
+  RegionCounterpart counterpart,
+  bool           names_only)
 {
   ArrangerObject * obj =
     (ArrangerObject *) self;
@@ -704,19 +713,21 @@ draw_chord_region (
               if (x_start < 0.0)
                 continue;
 
-              cairo_set_source_rgba (
-                cr, 1, 1, 1, 0.3);
-
               /* get actual values using the
                * ratios */
               x_start *= (double) full_width;
               x_end *= (double) full_width;
 
               /* draw */
-              cairo_rectangle (
-                cr, x_start, 0,
-                12.0, full_height);
-              cairo_fill (cr);
+              if (!names_only)
+                {
+                  cairo_set_source_rgba (
+                    cr, 1, 1, 1, 0.3);
+                  cairo_rectangle (
+                    cr, x_start, 0,
+                    12.0, full_height);
+                  cairo_fill (cr);
+                }
 
               cairo_set_source_rgba (
                 cr, 0, 0, 0, 1);
@@ -1205,38 +1216,9 @@ draw_audio_part (
           curr_frames -= loop_frames;
         }
       float min = 0.f, max = 0.f;
-      for (long j = prev_frames;
-           j < curr_frames; j++)
-        {
-          for (unsigned int k = 0;
-               k < clip->channels; k++)
-            {
-              long index =
-                j * (long) clip->channels +
-                (long) k;
-
-              /* if outside bounds */
-              if (
-                index < 0 ||
-                index >=
-                (long)
-                  clip->num_frames *
-                  (long) clip->channels)
-                {
-                  /* skip */
-                  continue;
-                }
-              float val = clip->frames[index];
-              if (val > max)
-                {
-                  max = val;
-                }
-              if (val < min)
-                {
-                  min = val;
-                }
-            }
-        }
+      audio_clip_get_min_max (
+        clip, prev_frames, curr_frames, &min,
+        &max);
 #define DRAW_VLINE(cr,x,from_y,_height) \
   switch (detail) \
     { \
@@ -1553,6 +1535,35 @@ draw_bottom_right_part (
     }
 }
 
+/**
+ * Draws the contents of a non-audio region from
+ * its thumbnail.
+ *
+ * @return Whether drawn.
+ */
+static bool
+draw_thumbnail (
+  ZRegion *         self,
+  cairo_t *         cr,
+  GdkRectangle *    full_rect,
+  GdkRectangle *    draw_rect,
+  RegionCounterpart counterpart)
+{
+  if (!region_thumbnail_supports_region (self))
+    return false;
+
+  if (!self->thumbnails[counterpart])
+    {
+      self->thumbnails[counterpart] =
+        region_thumbnail_new (self);
+    }
+
+  return
+    region_thumbnail_draw (
+      self->thumbnails[counterpart], cr, full_rect,
+      draw_rect);
+}
+
 /**
  * Returns if the region is cacheable.
  */
@@ -1563,6 +1574,47 @@ is_cacheable (
   return self->id.type == REGION_TYPE_AUDIO;
 }
 
+/**
+ * Returns whether the region is being recorded
+ * into and has only grown to the right since it
+ * was last cached, in which case the previously
+ * drawn part is still valid.
+ */
+static bool
+is_growing_while_recording (
+  ZRegion *         self,
+  GdkRectangle *    full_rect,
+  RegionCounterpart counterpart)
+{
+  ArrangerObject * obj = (ArrangerObject *) self;
+
+  if (self->id.type != REGION_TYPE_AUDIO)
+    return false;
+
+  Track * track = arranger_object_get_track (obj);
+  if (!track || track->recording_region != self)
+    return false;
+
+  GdkRectangle * last_full_rect =
+    counterpart == REGION_COUNTERPART_MAIN ?
+      &self->last_main_full_rect :
+      &self->last_lane_full_rect;
+
+  return
+    last_full_rect->x == full_rect->x &&
+    last_full_rect->height == full_rect->height &&
+    last_full_rect->width <= full_rect->width &&
+    position_is_equal (
+      &self->last_positions_obj.clip_start_pos,
+      &obj->clip_start_pos) &&
+    position_is_equal (
+      &self->last_positions_obj.loop_start_pos,
+      &obj->loop_start_pos) &&
+    position_is_equal (
+      &self->last_positions_obj.fade_in_pos,
+      &obj->fade_in_pos);
+}
+
 /**
  * Returns whether the cached drawing is usable
  * (ie, contains usable parts).
@@ -1635,6 +1687,8 @@ is_cache_usable (
 
   return
     region_params_equal ||
+    is_growing_while_recording (
+      self, full_rect, counterpart) ||
     MW_TIMELINE->action ==
       UI_OVERLAY_ACTION_STRETCHING_R;
 }
@@ -1800,32 +1854,61 @@ region_draw (
           /*g_debug ("ignoring cache");*/
         }
 
+      /* draw the contents of non-audio regions
+       * from their thumbnails if possible */
+      bool thumbnail_drawn =
+        draw_thumbnail (
+          self, cr_to_use, &full_rect, &draw_rect,
+          i);
+
       /* draw any remaining parts */
       switch (self->id.type)
         {
         case REGION_TYPE_MIDI:
-          draw_midi_region (
-            self, cr_to_use, rect, &full_rect,
-            &draw_rect, i);
+          if (!thumbnail_drawn)
+            {
+              draw_midi_region (
+                self, cr_to_use, rect, &full_rect,
+                &draw_rect, i);
+            }
           break;
         case REGION_TYPE_AUTOMATION:
-          draw_automation_region (
-            self, cr_to_use, rect, &full_rect,
-            &draw_rect, i);
+          if (!thumbnail_drawn)
+            {
+              draw_automation_region (
+                self, cr_to_use, rect, &full_rect,
+                &draw_rect, i);
+            }
           break;
         case REGION_TYPE_CHORD:
           draw_chord_region (
             self, cr_to_use, rect, &full_rect,
-            &draw_rect, i);
+            &draw_rect, i, thumbnail_drawn);
           break;
         case REGION_TYPE_AUDIO:
-          draw_audio_region (
-            self, cr_to_use, rect, &full_rect,
-            &draw_rect, prev_cache_used,
-            (int)
-            last_draw_rect.x - last_full_rect.x,
-            (int)
-            last_draw_rect.width, i);
+          {
+            /* while recording, only draw the newly
+             * recorded part (and redraw the last
+             * few columns of the cache, which may
+             * have been drawn before all of their
+             * frames were recorded) */
+            int cache_width = last_draw_rect.width;
+            if (prev_cache_used &&
+                is_growing_while_recording (
+                  self, &full_rect, i))
+              {
+                cache_width =
+                  MAX (
+                    cache_width -
+                      RECORDING_REDRAW_WIDTH, 0);
+              }
+            draw_audio_region (
+              self, cr_to_use, rect, &full_rect,
+              &draw_rect, prev_cache_used,
+              (int)
+              last_draw_rect.x - last_full_rect.x,
+              cache_width, i);
+          }
           break;
         default:
           break;
@@ -0,0 +1,936 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <math.h>
+
+#include "audio/automation_region.h"
+#include "audio/chord_object.h"
+#include "audio/curve.h"
+#include "audio/midi_note.h"
+#include "audio/region.h"
+#include "audio/track.h"
+#include "gui/backend/arranger_object.h"
+#include "gui/widgets/region_thumbnail.h"
+#include "utils/color.h"
+#include "utils/flags.h"
+#include "utils/math.h"
+#include "utils/objects.h"
+
+/** Width of the chord bars in pixels. */
+#define CHORD_BAR_WIDTH 12.0
+
+typedef enum ThumbnailPass
+{
+  /** First pass, from the clip start to the loop
+   * end. */
+  THUMBNAIL_PASS_FIRST,
+
+  /** Loop body, from the loop start to the loop
+   * end. */
+  THUMBNAIL_PASS_LOOP,
+
+  NUM_THUMBNAIL_PASSES,
+} ThumbnailPass;
+
+typedef enum ThumbnailItemType
+{
+  /** MIDI note. */
+  THUMBNAIL_ITEM_NOTE,
+
+  /** Automation point. */
+  THUMBNAIL_ITEM_POINT,
+
+  /** Automation curve until the next point. */
+  THUMBNAIL_ITEM_CURVE,
+
+  /** Chord bar. */
+  THUMBNAIL_ITEM_CHORD,
+} ThumbnailItemType;
+
+/**
+ * Display list item, independent of the zoom
+ * level.
+ */
+typedef struct ThumbnailItem
+{
+  ThumbnailItemType type;
+
+  /** Start and end relative to the start of the
+   * pass. */
+  double       start_ticks;
+  double       end_ticks;
+
+  /** Normalized y of the start and end, where 0 is
+   * the top. */
+  double       y_start;
+  double       y_end;
+
+  /** Normalized height (notes only). */
+  double       height;
+
+  /** Curve options (curves only). */
+  CurveOptions curve_opts;
+  int          start_higher;
+} ThumbnailItem;
+
+/**
+ * What a rendered thumbnail depends on.
+ */
+typedef struct ThumbnailKey
+{
+  /** Content version of the region.
+   *
+   * @see ZRegion.content_version. */
+  guint   content_version;
+
+  /** Region positions the passes depend on. */
+  double  clip_start_ticks;
+  double  loop_start_ticks;
+  double  loop_end_ticks;
+
+  /** Whether MIDI notes are drawn grey. */
+  bool    grey;
+
+  int     zoom_bucket;
+  int     height;
+} ThumbnailKey;
+
+typedef struct RegionThumbnail
+{
+  /** Owner region, or NULL if it was freed. Only
+   * accessed from the GTK thread. */
+  ZRegion *         region;
+
+  /** Key of the rendered surfaces. */
+  ThumbnailKey      key;
+  cairo_surface_t * surfaces[NUM_THUMBNAIL_PASSES];
+  bool              has_surfaces;
+
+  /** Key of the last queued job. */
+  ThumbnailKey      pending_key;
+  bool              has_pending;
+
+  /** Protects the members above that are written
+   * by the render thread. */
+  GMutex            mutex;
+
+  volatile gint     refcount;
+} RegionThumbnail;
+
+/**
+ * Background render job.
+ */
+typedef struct ThumbnailJob
+{
+  RegionThumbnail * thumbnail;
+  ThumbnailKey      key;
+
+  /** Display lists. */
+  GArray *          items[NUM_THUMBNAIL_PASSES];
+
+  /** Length of each pass. */
+  double            length_ticks[NUM_THUMBNAIL_PASSES];
+
+  /** Source color. */
+  double            r, g, b, a;
+} ThumbnailJob;
+
+static GThreadPool * thread_pool = NULL;
+
+/**
+ * Returns whether the keys have the same contents,
+ * regardless of the zoom bucket.
+ */
+static bool
+contents_equal (
+  const ThumbnailKey * a,
+  const ThumbnailKey * b)
+{
+  return
+    a->content_version == b->content_version &&
+    math_doubles_equal (
+      a->clip_start_ticks, b->clip_start_ticks) &&
+    math_doubles_equal (
+      a->loop_start_ticks, b->loop_start_ticks) &&
+    math_doubles_equal (
+      a->loop_end_ticks, b->loop_end_ticks) &&
+    a->grey == b->grey &&
+    a->height == b->height;
+}
+
+static bool
+keys_equal (
+  const ThumbnailKey * a,
+  const ThumbnailKey * b)
+{
+  return
+    contents_equal (a, b) &&
+    a->zoom_bucket == b->zoom_bucket;
+}
+
+static double
+get_zoom_bucket_px_per_tick (
+  int bucket)
+{
+  return
+    exp2 (
+      (double) bucket /
+      REGION_THUMBNAIL_ZOOM_BUCKETS_PER_OCTAVE);
+}
+
+static RegionThumbnail *
+thumbnail_ref (
+  RegionThumbnail * self)
+{
+  g_atomic_int_inc (&self->refcount);
+  return self;
+}
+
+static void
+thumbnail_unref (
+  RegionThumbnail * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->refcount))
+    return;
+
+  for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+    {
+      object_free_w_func_and_null (
+        cairo_surface_destroy, self->surfaces[i]);
+    }
+  g_mutex_clear (&self->mutex);
+
+  object_zero_and_free (self);
+}
+
+static void
+job_free (
+  ThumbnailJob * self)
+{
+  for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+    {
+      g_array_free (self->items[i], true);
+    }
+  thumbnail_unref (self->thumbnail);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Returns whether thumbnails are used for the
+ * given region.
+ */
+bool
+region_thumbnail_supports_region (
+  ZRegion * region)
+{
+  switch (region->id.type)
+    {
+    case REGION_TYPE_MIDI:
+    case REGION_TYPE_AUTOMATION:
+    case REGION_TYPE_CHORD:
+      return true;
+    default:
+      break;
+    }
+
+  return false;
+}
+
+static bool
+is_midi_color_grey (
+  ZRegion * region)
+{
+  Track * track =
+    arranger_object_get_track (
+      (ArrangerObject *) region);
+
+  /* grey if the track color is very bright */
+  return
+    track && color_is_very_very_bright (&track->color);
+}
+
+/**
+ * Returns the start of the given pass, in ticks
+ * relative to the region start.
+ */
+static double
+get_pass_start_ticks (
+  ArrangerObject * obj,
+  ThumbnailPass    pass)
+{
+  return
+    pass == THUMBNAIL_PASS_FIRST ?
+      obj->clip_start_pos.ticks :
+      obj->loop_start_pos.ticks;
+}
+
+/**
+ * Returns whether an object at the given position
+ * is drawn in the given pass.
+ */
+static bool
+is_in_pass (
+  ArrangerObject * obj,
+  Position *       pos,
+  ThumbnailPass    pass)
+{
+  if (position_is_after_or_equal (
+        pos, &obj->loop_end_pos))
+    return false;
+
+  if (pass == THUMBNAIL_PASS_LOOP)
+    {
+      /* objects before the loop start are only
+       * drawn once */
+      return
+        position_is_after_or_equal (
+          pos, &obj->loop_start_pos);
+    }
+
+  return true;
+}
+
+static void
+add_midi_items (
+  ZRegion *     region,
+  ThumbnailPass pass,
+  GArray *      items)
+{
+  ArrangerObject * obj = (ArrangerObject *) region;
+
+  int min_val = 127, max_val = 0;
+  for (int i = 0; i < region->num_midi_notes; i++)
+    {
+      MidiNote * mn = region->midi_notes[i];
+      if (mn->val < min_val)
+        min_val = mn->val;
+      if (mn->val > max_val)
+        max_val = mn->val;
+    }
+  double y_interval =
+    MAX (
+      (double) (max_val - min_val) + 1.0, 7.0);
+
+  bool is_looped = region_is_looped (region);
+  double pass_start =
+    get_pass_start_ticks (obj, pass);
+  for (int i = 0; i < region->num_midi_notes; i++)
+    {
+      MidiNote * mn = region->midi_notes[i];
+      ArrangerObject * mn_obj =
+        (ArrangerObject *) mn;
+
+      if (arranger_object_get_muted (mn_obj)
+          || !is_in_pass (obj, &mn_obj->pos, pass))
+        continue;
+
+      /* note not playable if looped */
+      if (pass == THUMBNAIL_PASS_FIRST
+          && is_looped
+          &&
+          position_is_before (
+            &mn_obj->pos, &obj->loop_start_pos)
+          &&
+          position_is_before (
+            &mn_obj->pos, &obj->clip_start_pos))
+        continue;
+
+      double end_ticks =
+        position_is_after_or_equal (
+          &mn_obj->end_pos, &obj->loop_end_pos) ?
+          obj->loop_end_pos.ticks :
+          mn_obj->end_pos.ticks;
+
+      ThumbnailItem item = {
+        .type = THUMBNAIL_ITEM_NOTE,
+        .start_ticks =
+          mn_obj->pos.ticks - pass_start,
+        .end_ticks = end_ticks - pass_start,
+        .y_start =
+          ((double) max_val - (double) mn->val) /
+            y_interval,
+        .height = 1.0 / y_interval,
+      };
+      g_array_append_val (items, item);
+    }
+}
+
+static void
+add_automation_items (
+  ZRegion *     region,
+  ThumbnailPass pass,
+  GArray *      items)
+{
+  ArrangerObject * obj = (ArrangerObject *) region;
+
+  double pass_start =
+    get_pass_start_ticks (obj, pass);
+  for (int i = 0; i < region->num_aps; i++)
+    {
+      AutomationPoint * ap = region->aps[i];
+      ArrangerObject * ap_obj =
+        (ArrangerObject *) ap;
+      if (!is_in_pass (obj, &ap_obj->pos, pass))
+        continue;
+
+      AutomationPoint * next_ap =
+        automation_region_get_next_ap (
+          region, ap, true, true);
+
+      ThumbnailItem item = {
+        .type = THUMBNAIL_ITEM_POINT,
+        .start_ticks =
+          ap_obj->pos.ticks - pass_start,
+        .y_start =
+          1.0 - (double) ap->normalized_val,
+      };
+      item.end_ticks = item.start_ticks;
+      item.y_end = item.y_start;
+      g_array_append_val (items, item);
+
+      if (!next_ap)
+        continue;
+
+      ArrangerObject * next_ap_obj =
+        (ArrangerObject *) next_ap;
+      double end_ticks =
+        position_is_after_or_equal (
+          &next_ap_obj->pos, &obj->loop_end_pos) ?
+          obj->loop_end_pos.ticks :
+          next_ap_obj->pos.ticks;
+      item.type = THUMBNAIL_ITEM_CURVE;
+      item.end_ticks = end_ticks - pass_start;
+      item.y_end =
+        1.0 - (double) next_ap->normalized_val;
+      item.curve_opts = ap->curve_opts;
+      item.start_higher =
+        next_ap->normalized_val <
+          ap->normalized_val;
+      g_array_append_val (items, item);
+    }
+}
+
+static void
+add_chord_items (
+  ZRegion *     region,
+  ThumbnailPass pass,
+  GArray *      items)
+{
+  ArrangerObject * obj = (ArrangerObject *) region;
+
+  double pass_start =
+    get_pass_start_ticks (obj, pass);
+  for (int i = 0; i < region->num_chord_objects;
+       i++)
+    {
+      ArrangerObject * co_obj =
+        (ArrangerObject *) region->chord_objects[i];
+      if (!is_in_pass (obj, &co_obj->pos, pass))
+        continue;
+
+      ThumbnailItem item = {
+        .type = THUMBNAIL_ITEM_CHORD,
+        .start_ticks =
+          co_obj->pos.ticks - pass_start,
+      };
+
+      /* skip if before the region */
+      if (item.start_ticks < 0.0)
+        continue;
+
+      g_array_append_val (items, item);
+    }
+}
+
+/**
+ * Draws the display list of a pass on the given
+ * context.
+ */
+static void
+draw_items (
+  ThumbnailJob * job,
+  GArray *       items,
+  cairo_t *      cr,
+  double         px_per_tick,
+  double         width,
+  double         height)
+{
+  cairo_set_source_rgba (
+    cr, job->r, job->g, job->b, job->a);
+  cairo_set_line_width (cr, 2.0);
+
+  for (guint i = 0; i < items->len; i++)
+    {
+      ThumbnailItem * item =
+        &g_array_index (items, ThumbnailItem, i);
+      double x_start =
+        item->start_ticks * px_per_tick;
+      double x_end = item->end_ticks * px_per_tick;
+      double y_start = item->y_start * height;
+      double y_end = item->y_end * height;
+
+      switch (item->type)
+        {
+        case THUMBNAIL_ITEM_NOTE:
+          cairo_rectangle (
+            cr, x_start, y_start,
+            x_end - x_start,
+            item->height * height);
+          break;
+        case THUMBNAIL_ITEM_POINT:
+          if (x_start > 0.0 && x_start < width)
+            {
+              cairo_rectangle (
+                cr, x_start - 1.0, y_start - 1.0,
+                2.0, 2.0);
+            }
+          break;
+        case THUMBNAIL_ITEM_CHORD:
+          /* drawn below */
+          break;
+        case THUMBNAIL_ITEM_CURVE:
+          {
+            /* fill the pending rectangles before
+             * stroking */
+            cairo_fill (cr);
+
+            double ac_width = fabs (x_end - x_start);
+            double ac_height = fabs (y_end - y_start);
+            double base_y = MIN (y_start, y_end);
+            bool started = false;
+            for (double k = MAX (x_start, 0.0);
+                 k < x_start + ac_width + 0.5
+                 && k < width;
+                 k += 0.5)
+              {
+                double ap_y = 0.5;
+                if (ac_width > 0.0)
+                  {
+                    ap_y =
+                      1.0 -
+                      curve_get_normalized_y (
+                        CLAMP (
+                          (k - x_start) / ac_width,
+                          0.0, 1.0),
+                        &item->curve_opts,
+                        item->start_higher);
+                  }
+                double new_y =
+                  ap_y * ac_height + base_y;
+                if (started)
+                  {
+                    cairo_line_to (cr, k, new_y);
+                  }
+                else
+                  {
+                    cairo_move_to (cr, k, new_y);
+                    started = true;
+                  }
+              }
+            cairo_stroke (cr);
+          }
+          break;
+        }
+    }
+  cairo_fill (cr);
+
+  /* chord bars use a fixed translucent color */
+  cairo_set_source_rgba (cr, 1, 1, 1, 0.3);
+  for (guint i = 0; i < items->len; i++)
+    {
+      ThumbnailItem * item =
+        &g_array_index (items, ThumbnailItem, i);
+      if (item->type != THUMBNAIL_ITEM_CHORD)
+        continue;
+
+      cairo_rectangle (
+        cr, item->start_ticks * px_per_tick, 0,
+        CHORD_BAR_WIDTH, height);
+    }
+  cairo_fill (cr);
+}
+
+static gboolean
+on_job_finished (
+  RegionThumbnail * self)
+{
+  if (self->region)
+    {
+      arranger_object_queue_redraw (
+        (ArrangerObject *) self->region);
+    }
+  thumbnail_unref (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+render_thread_func (
+  ThumbnailJob * job,
+  gpointer       user_data)
+{
+  RegionThumbnail * self = job->thumbnail;
+
+  /* skip if superseded by another job */
+  g_mutex_lock (&self->mutex);
+  bool superseded =
+    !keys_equal (&job->key, &self->pending_key);
+  g_mutex_unlock (&self->mutex);
+  if (superseded)
+    {
+      job_free (job);
+      return;
+    }
+
+  double px_per_tick =
+    get_zoom_bucket_px_per_tick (
+      job->key.zoom_bucket);
+  cairo_surface_t * surfaces[NUM_THUMBNAIL_PASSES];
+  for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+    {
+      int width =
+        MAX (
+          (int)
+          ceil (job->length_ticks[i] * px_per_tick),
+          1);
+      surfaces[i] =
+        cairo_image_surface_create (
+          CAIRO_FORMAT_ARGB32, width,
+          job->key.height);
+      cairo_t * cr = cairo_create (surfaces[i]);
+      draw_items (
+        job, job->items[i], cr, px_per_tick,
+        (double) width, (double) job->key.height);
+      cairo_destroy (cr);
+      cairo_surface_flush (surfaces[i]);
+    }
+
+  g_mutex_lock (&self->mutex);
+  if (keys_equal (&job->key, &self->pending_key))
+    {
+      for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+        {
+          if (self->surfaces[i])
+            cairo_surface_destroy (self->surfaces[i]);
+          self->surfaces[i] = surfaces[i];
+        }
+      self->key = job->key;
+      self->has_surfaces = true;
+      self->has_pending = false;
+    }
+  else
+    {
+      for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+        {
+          cairo_surface_destroy (surfaces[i]);
+        }
+    }
+  g_mutex_unlock (&self->mutex);
+
+  g_idle_add (
+    (GSourceFunc) on_job_finished,
+    thumbnail_ref (self));
+
+  job_free (job);
+}
+
+/**
+ * Creates the display lists of the region and
+ * queues them for rendering.
+ */
+static void
+queue_job (
+  RegionThumbnail *    self,
+  const ThumbnailKey * key)
+{
+  if (!thread_pool)
+    {
+      GError * err = NULL;
+      thread_pool =
+        g_thread_pool_new (
+          (GFunc) render_thread_func, NULL,
+          MAX (
+            (int) g_get_num_processors () / 2, 1),
+          F_NOT_EXCLUSIVE, &err);
+      if (!thread_pool)
+        {
+          g_critical (
+            "failed to create region thumbnail "
+            "thread pool: %s", err->message);
+          g_error_free (err);
+          return;
+        }
+    }
+
+  ZRegion * region = self->region;
+  ArrangerObject * obj = (ArrangerObject *) region;
+
+  ThumbnailJob * job = object_new (ThumbnailJob);
+  job->thumbnail = thumbnail_ref (self);
+  job->key = *key;
+  job->r = 1;
+  job->g = 1;
+  job->b = 1;
+  job->a = 1;
+  if (key->grey)
+    {
+      job->r = 0.7;
+      job->g = 0.7;
+      job->b = 0.7;
+    }
+  for (int i = 0; i < NUM_THUMBNAIL_PASSES; i++)
+    {
+      ThumbnailPass pass = (ThumbnailPass) i;
+      job->items[i] =
+        g_array_new (
+          false, false, sizeof (ThumbnailItem));
+      job->length_ticks[i] =
+        obj->loop_end_pos.ticks -
+        get_pass_start_ticks (obj, pass);
+      switch (region->id.type)
+        {
+        case REGION_TYPE_MIDI:
+          add_midi_items (
+            region, pass, job->items[i]);
+          break;
+        case REGION_TYPE_AUTOMATION:
+          add_automation_items (
+            region, pass, job->items[i]);
+          break;
+        case REGION_TYPE_CHORD:
+          add_chord_items (
+            region, pass, job->items[i]);
+          break;
+        default:
+          break;
+        }
+    }
+
+  g_mutex_lock (&self->mutex);
+  self->pending_key = *key;
+  self->has_pending = true;
+  g_mutex_unlock (&self->mutex);
+
+  GError * err = NULL;
+  if (!g_thread_pool_push (thread_pool, job, &err))
+    {
+      g_critical (
+        "failed to queue region thumbnail: %s",
+        err->message);
+      g_error_free (err);
+      job_free (job);
+    }
+}
+
+/**
+ * Blits the cached surfaces.
+ *
+ * Must be called with the mutex locked.
+ */
+static void
+blit (
+  RegionThumbnail * self,
+  cairo_t *         cr,
+  GdkRectangle *    full_rect,
+  GdkRectangle *    draw_rect,
+  double            px_per_tick)
+{
+  ArrangerObject * obj =
+    (ArrangerObject *) self->region;
+
+  int vis_offset_x = draw_rect->x - full_rect->x;
+  double vis_start = (double) vis_offset_x;
+  double vis_end =
+    (double) (vis_offset_x + draw_rect->width);
+  double scale =
+    px_per_tick /
+    get_zoom_bucket_px_per_tick (
+      self->key.zoom_bucket);
+  double first_ticks =
+    obj->loop_end_pos.ticks -
+    obj->clip_start_pos.ticks;
+  double loop_ticks =
+    arranger_object_get_loop_length_in_ticks (obj);
+  int num_loops =
+    arranger_object_get_num_loops (obj, true);
+
+  cairo_save (cr);
+  cairo_rectangle (
+    cr, vis_start, 0,
+    MIN (vis_end, (double) full_rect->width) -
+      vis_start,
+    full_rect->height);
+  cairo_clip (cr);
+
+  for (int j = 0; j < num_loops; j++)
+    {
+      ThumbnailPass pass =
+        j == 0 ?
+          THUMBNAIL_PASS_FIRST : THUMBNAIL_PASS_LOOP;
+      double x_ticks =
+        j == 0 ?
+          0.0 :
+          first_ticks +
+            loop_ticks * (double) (j - 1);
+      double length_ticks =
+        j == 0 ? first_ticks : loop_ticks;
+      double x = x_ticks * px_per_tick;
+      double x_end =
+        (x_ticks + length_ticks) * px_per_tick;
+      if (x >= vis_end)
+        break;
+      if (x_end <= vis_start)
+        continue;
+
+      cairo_save (cr);
+      cairo_translate (cr, x, 0);
+      cairo_scale (cr, scale, 1);
+      cairo_set_source_surface (
+        cr, self->surfaces[pass], 0, 0);
+      cairo_paint (cr);
+      cairo_restore (cr);
+    }
+
+  cairo_restore (cr);
+}
+
+/**
+ * Draws the region contents from the cached
+ * thumbnail, queueing a regeneration in the
+ * background if the content or the zoom bucket
+ * changed.
+ *
+ * @param cr Cairo context translated to the full
+ *   rect.
+ *
+ * @return Whether the contents were drawn. If
+ *   false, the caller must draw them directly.
+ */
+bool
+region_thumbnail_draw (
+  RegionThumbnail * self,
+  cairo_t *         cr,
+  GdkRectangle *    full_rect,
+  GdkRectangle *    draw_rect)
+{
+  g_return_val_if_fail (self->region, false);
+
+  ZRegion * region = self->region;
+  ArrangerObject * obj = (ArrangerObject *) region;
+
+  double ticks_in_region =
+    arranger_object_get_length_in_ticks (obj);
+  double first_ticks =
+    obj->loop_end_pos.ticks -
+    obj->clip_start_pos.ticks;
+  if (ticks_in_region <= 0.0 || first_ticks <= 0.0
+      || full_rect->height <= 0)
+    return false;
+
+  double px_per_tick =
+    (double) full_rect->width / ticks_in_region;
+  ThumbnailKey key = {
+    .content_version = region->content_version,
+    .clip_start_ticks = obj->clip_start_pos.ticks,
+    .loop_start_ticks = obj->loop_start_pos.ticks,
+    .loop_end_ticks = obj->loop_end_pos.ticks,
+    .grey =
+      region->id.type == REGION_TYPE_MIDI
+      && is_midi_color_grey (region),
+    .zoom_bucket =
+      (int)
+      ceil (
+        log2 (px_per_tick) *
+        REGION_THUMBNAIL_ZOOM_BUCKETS_PER_OCTAVE),
+    .height = full_rect->height,
+  };
+
+  /* too wide to cache */
+  double max_ticks =
+    MAX (
+      first_ticks,
+      arranger_object_get_loop_length_in_ticks (
+        obj));
+  if (max_ticks *
+        get_zoom_bucket_px_per_tick (
+          key.zoom_bucket) >
+      REGION_THUMBNAIL_MAX_WIDTH)
+    return false;
+
+  bool drawn = false;
+  bool up_to_date = false;
+  bool needs_job = false;
+  g_mutex_lock (&self->mutex);
+  if (self->has_surfaces
+      && contents_equal (&self->key, &key))
+    {
+      /* draw the cached surfaces, scaled if the
+       * zoom bucket changed */
+      blit (
+        self, cr, full_rect, draw_rect,
+        px_per_tick);
+      drawn = true;
+      up_to_date =
+        self->key.zoom_bucket == key.zoom_bucket;
+    }
+  if (!up_to_date
+      &&
+      (!self->has_pending
+       || !keys_equal (&self->pending_key, &key)))
+    {
+      needs_job = true;
+    }
+  g_mutex_unlock (&self->mutex);
+
+  if (needs_job)
+    {
+      queue_job (self, &key);
+    }
+
+  return drawn;
+}
+
+RegionThumbnail *
+region_thumbnail_new (
+  ZRegion * region)
+{
+  RegionThumbnail * self =
+    object_new (RegionThumbnail);
+
+  self->region = region;
+  self->refcount = 1;
+  g_mutex_init (&self->mutex);
+
+  return self;
+}
+
+/**
+ * Detaches the thumbnail from its region and
+ * frees it once no background job uses it.
+ */
+void
+region_thumbnail_free (
+  RegionThumbnail * self)
+{
+  self->region = NULL;
+  thumbnail_unref (self);
+}
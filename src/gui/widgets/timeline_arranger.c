@@ -18,6 +18,7 @@
  */
 
 #include "actions/undo_manager.h"
+#include "audio/audio_analyzer.h"
 #include "audio/audio_region.h"
 #include "audio/automation_region.h"
 #include "audio/chord_region.h"
@@ -117,9 +118,12 @@ timeline_arranger_widget_get_track_lane_at_y (
     return NULL;
 
   /* y local to track */
-  int y_local =
-    track_widget_get_local_y (
-      track->widget, self, (int) y);
+  int track_y =
+    timeline_arranger_widget_get_track_y (
+      self, track);
+  if (track_y < 0)
+    return NULL;
+  int y_local = (int) y - track_y;
 
   TrackLane * lane;
   for (int j = 0; j < track->num_lanes; j++)
@@ -134,36 +138,159 @@ timeline_arranger_widget_get_track_lane_at_y (
   return NULL;
 }
 
-Track *
-timeline_arranger_widget_get_track_at_y (
-  ArrangerWidget * self,
-  double y)
+/**
+ * Marks the cached track geometry as outdated.
+ *
+ * To be called when tracks are resized, reordered
+ * or their visibility changes.
+ */
+void
+timeline_arranger_widget_invalidate_track_geometry (
+  ArrangerWidget * self)
 {
-  Track * track;
-  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+  self->track_geometries_valid = false;
+}
+
+/**
+ * Rebuilds the track y offsets as a prefix sum of
+ * the allocated track heights.
+ */
+static void
+rebuild_track_geometry (
+  ArrangerWidget * self)
+{
+  int num_tracks = TRACKLIST->num_tracks;
+  self->track_geometries =
+    g_renew (
+      ArrangerTrackGeometry,
+      self->track_geometries,
+      (size_t) MAX (num_tracks, 1));
+  self->track_geometry_indices =
+    g_renew (
+      int, self->track_geometry_indices,
+      (size_t) MAX (num_tracks, 1));
+  self->num_track_geometry_indices = num_tracks;
+  self->num_track_geometries = 0;
+
+  int y = 0;
+  int spacing = 0;
+  for (int i = 0; i < num_tracks; i++)
     {
-      track = TRACKLIST->tracks[i];
+      Track * track = TRACKLIST->tracks[i];
+      self->track_geometry_indices[i] = -1;
 
       if (
         /* ignore invisible tracks */
         !track->visible ||
         /* ignore tracks in the other timeline */
-        self->is_pinned != track_is_pinned (track))
+        self->is_pinned != track_is_pinned (track) ||
+        !track_get_should_be_visible (track) ||
+        !track->widget ||
+        !gtk_widget_get_visible (
+           GTK_WIDGET (track->widget)))
         continue;
 
-      if (!track_get_should_be_visible (track))
-        continue;
+      GtkWidget * tw = GTK_WIDGET (track->widget);
+      if (self->num_track_geometries == 0)
+        {
+          /* start from the offset of the first
+           * track in its box */
+          GtkWidget * box = gtk_widget_get_parent (tw);
+          gint wx, wy;
+          if (box &&
+              gtk_widget_translate_coordinates (
+                tw, box, 0, 0, &wx, &wy))
+            {
+              y = MAX (wy, 0);
+            }
+          if (GTK_IS_BOX (box))
+            {
+              spacing =
+                gtk_box_get_spacing (GTK_BOX (box));
+            }
+        }
+
+      ArrangerTrackGeometry * geom =
+        &self->track_geometries[
+          self->num_track_geometries];
+      geom->track = track;
+      geom->y = y;
+      geom->height =
+        gtk_widget_get_allocated_height (tw);
+      self->track_geometry_indices[i] =
+        self->num_track_geometries++;
+
+      y += geom->height + spacing;
+    }
 
-      g_return_val_if_fail (track->widget, NULL);
+  self->track_geometries_valid = true;
+}
 
-      if (ui_is_child_hit (
-            GTK_WIDGET (self),
-            GTK_WIDGET (track->widget),
-            0, 1, 0, y, 0, 1))
-        return track;
+static inline void
+ensure_track_geometry (
+  ArrangerWidget * self)
+{
+  if (!self->track_geometries_valid ||
+      self->num_track_geometry_indices !=
+        TRACKLIST->num_tracks)
+    {
+      rebuild_track_geometry (self);
     }
+}
 
-  return NULL;
+/**
+ * Returns the y offset of the given track in the
+ * arranger from the cached track geometry, or -1
+ * if the track is not visible in this arranger.
+ */
+int
+timeline_arranger_widget_get_track_y (
+  ArrangerWidget * self,
+  Track *          track)
+{
+  ensure_track_geometry (self);
+
+  if (track->pos < 0 ||
+      track->pos >= self->num_track_geometry_indices)
+    return -1;
+
+  int idx =
+    self->track_geometry_indices[track->pos];
+  if (idx < 0 ||
+      self->track_geometries[idx].track != track)
+    return -1;
+
+  return self->track_geometries[idx].y;
+}
+
+Track *
+timeline_arranger_widget_get_track_at_y (
+  ArrangerWidget * self,
+  double y)
+{
+  ensure_track_geometry (self);
+
+  /* find the last track starting before y */
+  int lo = 0;
+  int hi = self->num_track_geometries;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if ((double) self->track_geometries[mid].y
+            <= y)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  if (lo == 0)
+    return NULL;
+
+  ArrangerTrackGeometry * geom =
+    &self->track_geometries[lo - 1];
+  if (y > (double) (geom->y + geom->height))
+    return NULL;
+
+  return geom->track;
 }
 
 /**
@@ -186,9 +313,12 @@ timeline_arranger_widget_get_at_at_y (
     return NULL;
 
   /* y local to track */
-  int y_local =
-    track_widget_get_local_y (
-      track->widget, self, (int) y);
+  int track_y =
+    timeline_arranger_widget_get_track_y (
+      self, track);
+  if (track_y < 0)
+    return NULL;
+  int y_local = (int) y - track_y;
 
   for (int j = 0; j < atl->num_ats; j++)
     {
@@ -249,7 +379,7 @@ timeline_arranger_on_quick_bounce_clicked (
       return;
     }
 
-  ExportSettings settings;
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_REGIONS;
   export_settings_set_bounce_defaults (
     &settings, NULL, r->name);
@@ -1313,30 +1443,22 @@ on_audio_func_activate (
 }
 
 static void
-on_detect_bpm_activate (
-  GtkMenuItem * item,
-  void *        user_data)
+show_detected_bpm (
+  const AudioAnalysis * analysis,
+  void *                user_data)
 {
-  ZRegion * r = (ZRegion *) user_data;
-  g_return_if_fail (IS_REGION_AND_NONNULL (r));
-
-  GArray * candidates =
-    g_array_new (false, true, sizeof (float));
-  bpm_t bpm =
-    audio_region_detect_bpm (r, candidates);
-
   GString * gstr = g_string_new (NULL);
   g_string_append_printf (
-    gstr, _("Detected BPM: %.2f"), bpm);
+    gstr, _("Detected BPM: %.2f"), analysis->bpm);
   g_string_append (gstr, "\n\n");
   g_string_append_printf (
     gstr, _("Candidates:"));
-  for (size_t i = 0; i < candidates->len; i++)
+  for (int i = 0;
+       i < analysis->num_bpm_candidates; i++)
     {
-      float candidate =
-        g_array_index (candidates, float, i);
       g_string_append_printf (
-        gstr, " %.2f", candidate);
+        gstr, " %.2f",
+        analysis->bpm_candidates[i]);
     }
   char * str = g_string_free (gstr, false);
   ui_show_message_printf (
@@ -1345,6 +1467,35 @@ on_detect_bpm_activate (
   g_free (str);
 }
 
+static void
+on_detect_bpm_activate (
+  GtkMenuItem * item,
+  void *        user_data)
+{
+  ZRegion * r = (ZRegion *) user_data;
+  g_return_if_fail (IS_REGION_AND_NONNULL (r));
+
+  AudioClip * clip = audio_region_get_clip (r);
+  g_return_if_fail (clip);
+
+  /* show right away if already analyzed,
+   * otherwise analyze in the background */
+  AudioAnalysis * analysis =
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip);
+  if (analysis)
+    {
+      show_detected_bpm (analysis, NULL);
+      audio_analysis_free (analysis);
+    }
+  else
+    {
+      audio_analyzer_queue (
+        AUDIO_ANALYZER, clip, show_detected_bpm,
+        NULL);
+    }
+}
+
 /**
  * Show context menu at x, y.
  */
@@ -17,9 +17,10 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "audio/marker_track.h"
+#include "audio/position.h"
 #include "audio/track.h"
 #include "audio/tracklist.h"
+#include "audio/transport.h"
 #include "gui/widgets/center_dock.h"
 #include "gui/widgets/main_window.h"
 #include "gui/widgets/main_notebook.h"
@@ -27,6 +28,8 @@
 #include "gui/widgets/timeline_minimap_bg.h"
 #include "gui/widgets/timeline_panel.h"
 #include "project.h"
+#include "utils/math.h"
+#include "utils/objects.h"
 #include "zrythm_app.h"
 
 #include <gtk/gtk.h>
@@ -35,11 +38,165 @@ G_DEFINE_TYPE (TimelineMinimapBgWidget,
                timeline_minimap_bg_widget,
                GTK_TYPE_DRAWING_AREA)
 
+/**
+ * Returns the total ticks the minimap spans (the
+ * same range as the timeline ruler).
+ */
+static double
+get_total_ticks (void)
+{
+  Position pos;
+  position_set_to_bar (
+    &pos, TRANSPORT->total_bars + 1);
+  return position_to_ticks (&pos);
+}
+
+/**
+ * Returns whether the visible tracks or their
+ * heights differ from the ones the rows were laid
+ * out with.
+ */
+static bool
+layout_changed (
+  TimelineMinimapBgWidget * self)
+{
+  int row_idx = 0;
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (!(track->widget && track->visible))
+        continue;
+
+      if (row_idx >= self->num_rows)
+        return true;
+
+      TimelineMinimapBgRow * row =
+        &self->rows[row_idx++];
+      if (row->track != track ||
+          row->track_height !=
+            gtk_widget_get_allocated_height (
+              GTK_WIDGET (track->widget)))
+        return true;
+    }
+
+  return row_idx != self->num_rows;
+}
+
+/**
+ * Lays out the rows of the visible tracks and
+ * recreates the overview image.
+ */
+static void
+recreate_overview (
+  TimelineMinimapBgWidget * self,
+  int                       width,
+  int                       height,
+  double                    total_ticks)
+{
+  object_free_w_func_and_null (
+    cairo_surface_destroy, self->overview);
+  self->overview =
+    cairo_image_surface_create (
+      CAIRO_FORMAT_ARGB32, width, height);
+  self->overview_total_ticks = total_ticks;
+
+  self->rows =
+    g_renew (
+      TimelineMinimapBgRow, self->rows,
+      (size_t) MAX (TRACKLIST->num_tracks, 1));
+  self->num_rows = 0;
+  int total_track_height = 0;
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (!(track->widget && track->visible))
+        continue;
+
+      TimelineMinimapBgRow * row =
+        &self->rows[self->num_rows++];
+      row->track = track;
+      row->track_height =
+        gtk_widget_get_allocated_height (
+          GTK_WIDGET (track->widget));
+      row->dirty = true;
+      total_track_height += row->track_height;
+    }
+
+  double y = 0;
+  for (int i = 0; i < self->num_rows; i++)
+    {
+      TimelineMinimapBgRow * row = &self->rows[i];
+      row->y = y;
+      row->height =
+        total_track_height > 0 ?
+          ((double) row->track_height /
+             (double) total_track_height) *
+            height :
+          0;
+      y += row->height;
+    }
+
+  self->layout_invalid = false;
+}
+
+/**
+ * Redraws the regions of the given row in the
+ * overview.
+ */
+static void
+draw_row (
+  TimelineMinimapBgWidget * self,
+  cairo_t *                 cr,
+  TimelineMinimapBgRow *    row,
+  int                       width)
+{
+  /* clear the row */
+  cairo_save (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_rectangle (
+    cr, 0, row->y, width, row->height);
+  cairo_fill (cr);
+  cairo_restore (cr);
+
+  Track * track = row->track;
+  GdkRGBA * color = &track->color;
+  cairo_set_source_rgba (
+    cr, color->red, color->green, color->blue,
+    0.2);
+
+  double ticks_to_px =
+    self->overview_total_ticks > 0 ?
+      width / self->overview_total_ticks : 0;
+  for (int j = 0; j < track->num_lanes; j++)
+    {
+      TrackLane * lane = track->lanes[j];
+
+      for (int k = 0; k < lane->num_regions; k++)
+        {
+          ArrangerObject * r_obj =
+            (ArrangerObject *) lane->regions[k];
+
+          double px_start =
+            r_obj->pos.ticks * ticks_to_px;
+          double px_end =
+            r_obj->end_pos.ticks * ticks_to_px;
+
+          cairo_rectangle (
+            cr, px_start, row->y,
+            MAX (px_end - px_start, 1.0),
+            row->height);
+        }
+    }
+  cairo_fill (cr);
+
+  row->dirty = false;
+}
+
 static gboolean
 timeline_minimap_bg_draw_cb (
-  GtkWidget *widget,
-  cairo_t *cr,
-  gpointer data)
+  GtkWidget *               widget,
+  cairo_t *                 cr,
+  TimelineMinimapBgWidget * self)
 {
   if (!PROJECT->loaded)
     return FALSE;
@@ -55,96 +212,73 @@ timeline_minimap_bg_draw_cb (
   gtk_render_background (
     context, cr, 0, 0, width, height);
 
-  Marker * start =
-    marker_track_get_start_marker (
-      P_MARKER_TRACK);
-  ArrangerObject * start_obj =
-    (ArrangerObject *) start;
-  Marker * end =
-    marker_track_get_end_marker (
-      P_MARKER_TRACK);
-  ArrangerObject * end_obj =
-    (ArrangerObject *) end;
-  int song_px =
-    ui_pos_to_px_timeline (
-      &start_obj->pos, 1) -
-    ui_pos_to_px_timeline (
-      &end_obj->pos, 1);
-  /*int region_px;*/
-
-  int total_track_height = 0;
-  Track * track;
-  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+  double total_ticks = get_total_ticks ();
+  if (self->layout_invalid || !self->overview ||
+      cairo_image_surface_get_width (
+        self->overview) != width ||
+      cairo_image_surface_get_height (
+        self->overview) != height ||
+      !math_doubles_equal (
+        self->overview_total_ticks, total_ticks) ||
+      layout_changed (self))
     {
-      track = TRACKLIST->tracks[i];
-
-      if (track->widget && track->visible)
-        total_track_height +=
-          gtk_widget_get_allocated_height (
-            GTK_WIDGET (track->widget));
+      recreate_overview (
+        self, width, height, total_ticks);
     }
-  int track_height;
-  for (int i = 0; i < TRACKLIST->num_tracks; i++)
-    {
-      track = TRACKLIST->tracks[i];
 
-      if (!(track->widget && track->visible))
-        continue;
+  /* redraw only the rows that changed */
+  cairo_t * overview_cr =
+    cairo_create (self->overview);
+  for (int i = 0; i < self->num_rows; i++)
+    {
+      TimelineMinimapBgRow * row = &self->rows[i];
+      if (row->dirty)
+        {
+          draw_row (self, overview_cr, row, width);
+        }
+    }
+  cairo_destroy (overview_cr);
 
-      gint wx, wy;
-      gtk_widget_translate_coordinates(
-        GTK_WIDGET (track->widget),
-        GTK_WIDGET (MW_TIMELINE),
-        0, 0,
-        &wx, &wy);
-      track_height =
-        gtk_widget_get_allocated_height (
-          GTK_WIDGET (track->widget));
+  cairo_set_source_surface (
+    cr, self->overview, 0, 0);
+  cairo_paint (cr);
 
-      GdkRGBA * color = &track->color;
-      cairo_set_source_rgba (cr,
-                             color->red,
-                             color->green,
-                             color->blue,
-                             0.2);
+  return FALSE;
+}
 
-      TrackLane * lane;
-      ArrangerObject * r_obj;
-      for (int j = 0; j < track->num_lanes; j++)
+/**
+ * Marks the row of the given track for redrawing
+ * (eg, when one of its regions was created or
+ * changed).
+ */
+void
+timeline_minimap_bg_widget_invalidate_track (
+  TimelineMinimapBgWidget * self,
+  Track *                   track)
+{
+  for (int i = 0; i < self->num_rows; i++)
+    {
+      if (self->rows[i].track == track)
         {
-          lane = track->lanes[j];
-
-          for (int k = 0; k < lane->num_regions; k++)
-            {
-              r_obj =
-                (ArrangerObject *) lane->regions[k];
-
-              int px_start =
-                ui_pos_to_px_timeline (
-                  &r_obj->pos, 1);
-              int px_end =
-                ui_pos_to_px_timeline (
-                  &r_obj->end_pos, 1);
-              int px_length =
-                px_end - px_start;
-
-              cairo_rectangle (
-                cr,
-                ((double) px_start /
-                 (double) song_px) * width,
-                ((double) wy /
-                   (double) total_track_height) * height,
-                ((double) px_length /
-                  (double) song_px) * width,
-                ((double) track_height /
-                  (double) total_track_height) * height);
-              cairo_fill (cr);
-            }
+          self->rows[i].dirty = true;
+          break;
         }
     }
 
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
 
-  return FALSE;
+/**
+ * Marks the whole overview for recreation (eg,
+ * when tracks are added, removed or moved).
+ */
+void
+timeline_minimap_bg_widget_invalidate (
+  TimelineMinimapBgWidget * self)
+{
+  self->layout_invalid = true;
+
+  gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
 TimelineMinimapBgWidget *
@@ -157,6 +291,20 @@ timeline_minimap_bg_widget_new ()
   return self;
 }
 
+static void
+finalize (
+  TimelineMinimapBgWidget * self)
+{
+  object_free_w_func_and_null (
+    cairo_surface_destroy, self->overview);
+  object_free_w_func_and_null (
+    g_free, self->rows);
+
+  G_OBJECT_CLASS (
+    timeline_minimap_bg_widget_parent_class)->
+      finalize (G_OBJECT (self));
+}
+
 static void
 timeline_minimap_bg_widget_class_init (
   TimelineMinimapBgWidgetClass * _klass)
@@ -164,6 +312,11 @@ timeline_minimap_bg_widget_class_init (
   GtkWidgetClass * klass = GTK_WIDGET_CLASS (_klass);
   gtk_widget_class_set_css_name (klass,
                                  "timeline-minimap-bg");
+
+  GObjectClass * oklass =
+    G_OBJECT_CLASS (_klass);
+  oklass->finalize =
+    (GObjectFinalizeFunc) finalize;
 }
 
 static void
@@ -173,7 +326,9 @@ timeline_minimap_bg_widget_init (
   gtk_widget_set_visible (GTK_WIDGET (self),
                           1);
 
+  self->layout_invalid = true;
+
   g_signal_connect (
     G_OBJECT (self), "draw",
-    G_CALLBACK (timeline_minimap_bg_draw_cb), NULL);
+    G_CALLBACK (timeline_minimap_bg_draw_cb), self);
 }
@@ -1645,7 +1645,7 @@ on_quick_bounce_clicked (
   GtkMenuItem * menuitem,
   Track *       track)
 {
-  ExportSettings settings;
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_TRACKS;
   export_settings_set_bounce_defaults (
     &settings, NULL, track->name);
@@ -35,6 +35,7 @@
 #include "gui/widgets/main_window.h"
 #include "gui/widgets/main_notebook.h"
 #include "gui/widgets/mixer.h"
+#include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/timeline_panel.h"
 #include "gui/widgets/tracklist.h"
 #include "gui/widgets/track.h"
@@ -258,6 +259,33 @@ tracklist_widget_on_size_allocate (
   self->last_allocation = *allocation;
 }
 
+/**
+ * Called when the children of the pinned or
+ * unpinned box are resized, reordered, shown or
+ * hidden.
+ */
+static void
+on_track_box_size_allocate (
+  GtkWidget *       widget,
+  GdkRectangle *    allocation,
+  TracklistWidget * self)
+{
+  if (!MAIN_WINDOW || !MW_CENTER_DOCK ||
+      !MW_TIMELINE_PANEL)
+    return;
+
+  if (MW_TIMELINE)
+    {
+      timeline_arranger_widget_invalidate_track_geometry (
+        MW_TIMELINE);
+    }
+  if (MW_PINNED_TIMELINE)
+    {
+      timeline_arranger_widget_invalidate_track_geometry (
+        MW_PINNED_TIMELINE);
+    }
+}
+
 /**
  * Handle ctrl+shift+scroll.
  */
@@ -626,6 +654,12 @@ tracklist_widget_init (TracklistWidget * self)
     G_OBJECT (self), "size-allocate",
     G_CALLBACK (
       tracklist_widget_on_size_allocate), self);
+  g_signal_connect (
+    G_OBJECT (self->pinned_box), "size-allocate",
+    G_CALLBACK (on_track_box_size_allocate), self);
+  g_signal_connect (
+    G_OBJECT (self->unpinned_box), "size-allocate",
+    G_CALLBACK (on_track_box_size_allocate), self);
   g_signal_connect (
     G_OBJECT (self), "scroll-event",
     G_CALLBACK (on_scroll), self);
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "guile/modules.h"
+
+#ifndef SNARF_MODE
+#include <string.h>
+
+#include "audio/exporter.h"
+#include "audio/track.h"
+#include "audio/tracklist.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "zrythm_app.h"
+#endif
+
+/**
+ * Export job options shared by the functions
+ * below.
+ */
+typedef struct ExportJobOptions
+{
+  /** List of tracks, or SCM_UNDEFINED. */
+  SCM tracks;
+
+  /** Progress procedure, or SCM_UNDEFINED. */
+  SCM progress;
+} ExportJobOptions;
+
+static void
+on_progress (
+  ExportSettings * info,
+  void *           user_data)
+{
+  ExportJobOptions * opts =
+    (ExportJobOptions *) user_data;
+  scm_call_1 (
+    opts->progress,
+    scm_from_double (info->progress_info.progress));
+}
+
+/**
+ * Fills in @p info from the keyword arguments in
+ * @p rest.
+ */
+static void
+init_export_settings (
+  ExportSettings *   info,
+  ExportJobOptions * opts,
+  SCM                rest,
+  const char *       func_name)
+{
+  SCM format = SCM_UNDEFINED;
+  SCM depth = SCM_UNDEFINED;
+  SCM dither = SCM_UNDEFINED;
+  SCM start = SCM_UNDEFINED;
+  SCM end = SCM_UNDEFINED;
+  SCM block_size = SCM_UNDEFINED;
+  opts->tracks = SCM_UNDEFINED;
+  opts->progress = SCM_UNDEFINED;
+  scm_c_bind_keyword_arguments (
+    func_name, rest, 0,
+    scm_from_utf8_keyword ("format"), &format,
+    scm_from_utf8_keyword ("depth"), &depth,
+    scm_from_utf8_keyword ("dither"), &dither,
+    scm_from_utf8_keyword ("start"), &start,
+    scm_from_utf8_keyword ("end"), &end,
+    scm_from_utf8_keyword ("tracks"),
+    &opts->tracks,
+    scm_from_utf8_keyword ("block-size"),
+    &block_size,
+    scm_from_utf8_keyword ("progress"),
+    &opts->progress,
+    SCM_UNDEFINED);
+
+  memset (info, 0, sizeof (ExportSettings));
+  info->format = AUDIO_FORMAT_WAV;
+  if (!SCM_UNBNDP (format))
+    {
+      char * ext = scm_to_locale_string (format);
+      info->format =
+        exporter_get_audio_format_from_extension (
+          ext);
+      free (ext);
+      if (info->format == NUM_AUDIO_FORMATS)
+        {
+          scm_misc_error (
+            func_name, "unknown format: ~S",
+            scm_list_1 (format));
+        }
+    }
+
+  info->depth = BIT_DEPTH_16;
+  if (!SCM_UNBNDP (depth))
+    {
+      switch (scm_to_int (depth))
+        {
+        case 16:
+          info->depth = BIT_DEPTH_16;
+          break;
+        case 24:
+          info->depth = BIT_DEPTH_24;
+          break;
+        case 32:
+          info->depth = BIT_DEPTH_32;
+          break;
+        default:
+          scm_misc_error (
+            func_name, "unsupported depth: ~S",
+            scm_list_1 (depth));
+        }
+    }
+
+  info->dither =
+    !SCM_UNBNDP (dither) && scm_is_true (dither);
+
+  info->time_range = TIME_RANGE_SONG;
+  if (!SCM_UNBNDP (start) || !SCM_UNBNDP (end))
+    {
+      if (SCM_UNBNDP (start) || SCM_UNBNDP (end))
+        {
+          scm_misc_error (
+            func_name,
+            "both #:start and #:end are required",
+            SCM_EOL);
+        }
+      info->time_range = TIME_RANGE_CUSTOM;
+      position_set_to_pos (
+        &info->custom_start,
+        (Position *) scm_to_pointer (start));
+      position_set_to_pos (
+        &info->custom_end,
+        (Position *) scm_to_pointer (end));
+    }
+
+  if (!SCM_UNBNDP (block_size))
+    {
+      info->block_length =
+        (nframes_t) scm_to_uint32 (block_size);
+    }
+
+  if (!SCM_UNBNDP (opts->progress))
+    {
+      info->progress_cb = on_progress;
+      info->progress_cb_user_data = opts;
+    }
+
+  info->artist = g_strdup ("");
+  info->title = g_strdup ("");
+  info->genre = g_strdup ("");
+  info->mode = EXPORT_MODE_FULL;
+  info->bounce_with_parents = true;
+}
+
+static int
+run_export (
+  ExportSettings * info,
+  const char *     func_name)
+{
+  g_message ("exporting %s", info->file_uri);
+  int ret = exporter_export (info);
+  if (ret != 0 || info->progress_info.has_error)
+    {
+      export_settings_free_members (info);
+      scm_misc_error (
+        func_name, "export failed", SCM_EOL);
+    }
+
+  return ret;
+}
+
+SCM_DEFINE (
+  s_export_project, "export-project", 1, 0, 1,
+  (SCM file_path, SCM rest),
+  "Renders the project to @var{file_path} "
+  "faster than realtime.\n\n"
+  "Accepts the following keyword arguments: "
+  "@code{#:format} (a file extension such as "
+  "\"wav\" or \"flac\", default \"wav\"), "
+  "@code{#:depth} (16, 24 or 32), "
+  "@code{#:dither}, @code{#:start} and "
+  "@code{#:end} (positions, default the song "
+  "markers), @code{#:tracks} (list of tracks to "
+  "mix down, default all), "
+  "@code{#:block-size} (frames per cycle, "
+  "default the engine's block length) and "
+  "@code{#:progress} (procedure called with the "
+  "progress from 0 to 1).")
+#define FUNC_NAME s_
+{
+  ExportSettings info;
+  ExportJobOptions opts;
+  init_export_settings (
+    &info, &opts, rest, FUNC_NAME);
+  info.file_uri = scm_to_locale_string (file_path);
+
+  if (!SCM_UNBNDP (opts.tracks))
+    {
+      info.mode = EXPORT_MODE_TRACKS;
+      tracklist_mark_all_tracks_for_bounce (
+        TRACKLIST, false);
+      for (SCM l = opts.tracks; !scm_is_null (l);
+           l = scm_cdr (l))
+        {
+          track_mark_for_bounce (
+            (Track *) scm_to_pointer (scm_car (l)),
+            F_BOUNCE, F_MARK_REGIONS,
+            F_NO_MARK_CHILDREN, F_MARK_PARENTS);
+        }
+    }
+
+  run_export (&info, FUNC_NAME);
+
+  export_settings_free_members (&info);
+
+  return SCM_BOOL_T;
+}
+#undef FUNC_NAME
+
+/**
+ * Returns a file name for the stem of @p track
+ * with forbidden characters removed, adding the
+ * track position if the name is already taken by
+ * another stem.
+ *
+ * @param used_names Set of the names used so far.
+ */
+static char *
+get_stem_basename (
+  Track *      track,
+  GHashTable * used_names,
+  const char * ext)
+{
+  char * escaped =
+    g_malloc (strlen (track->name) + 1);
+  io_escape_dir_name (escaped, track->name);
+  if (escaped[0] == '\0' || escaped[0] == '.')
+    {
+      g_free (escaped);
+      escaped = g_strdup ("track");
+    }
+
+  char * name = g_strdup (escaped);
+  if (g_hash_table_contains (used_names, name))
+    {
+      g_free (name);
+      name =
+        g_strdup_printf (
+          "%s-%d", escaped, track->pos);
+    }
+  g_hash_table_add (used_names, g_strdup (name));
+  g_free (escaped);
+
+  char * basename =
+    g_strdup_printf ("%s.%s", name, ext);
+  g_free (name);
+
+  return basename;
+}
+
+SCM_DEFINE (
+  s_export_stems, "export-stems", 1, 0, 1,
+  (SCM dir_path, SCM rest),
+  "Renders each track to a separate file named "
+  "after the track in @var{dir_path} and returns "
+  "the list of paths.\n\n"
+  "Accepts the same keyword arguments as "
+  "@code{export-project}, with @code{#:tracks} "
+  "defaulting to all tracks that have a channel.")
+#define FUNC_NAME s_
+{
+  ExportSettings info;
+  ExportJobOptions opts;
+  init_export_settings (
+    &info, &opts, rest, FUNC_NAME);
+
+  SCM tracks = opts.tracks;
+  if (SCM_UNBNDP (tracks))
+    {
+      tracks = SCM_EOL;
+      for (int i = TRACKLIST->num_tracks - 1;
+           i >= 0; i--)
+        {
+          Track * track = TRACKLIST->tracks[i];
+          if (!track_type_has_channel (track->type))
+            continue;
+
+          tracks =
+            scm_cons (
+              scm_from_pointer (track, NULL), tracks);
+        }
+    }
+
+  /* free the temporary data if the export throws
+   * an error */
+  scm_dynwind_begin (0);
+  char * dir = scm_to_locale_string (dir_path);
+  scm_dynwind_free (dir);
+  GHashTable * used_names =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free, NULL);
+  scm_dynwind_unwind_handler (
+    (void (*) (void *)) g_hash_table_unref,
+    used_names, SCM_F_WIND_EXPLICITLY);
+  io_mkdir (dir);
+
+  SCM paths = SCM_EOL;
+  for (SCM l = tracks; !scm_is_null (l);
+       l = scm_cdr (l))
+    {
+      Track * track =
+        (Track *) scm_to_pointer (scm_car (l));
+
+      tracklist_mark_all_tracks_for_bounce (
+        TRACKLIST, false);
+      track_mark_for_bounce (
+        track, F_BOUNCE, F_MARK_REGIONS,
+        F_MARK_CHILDREN, F_MARK_PARENTS);
+
+      char * basename =
+        get_stem_basename (
+          track, used_names,
+          exporter_stringize_audio_format (
+            info.format, true));
+      g_free (info.file_uri);
+      info.file_uri =
+        g_build_filename (dir, basename, NULL);
+      g_free (basename);
+      info.mode = EXPORT_MODE_TRACKS;
+      info.progress_info.progress = 0;
+
+      run_export (&info, FUNC_NAME);
+
+      track->bounce = false;
+
+      paths =
+        scm_cons (
+          scm_from_locale_string (info.file_uri),
+          paths);
+    }
+  scm_dynwind_end ();
+
+  export_settings_free_members (&info);
+
+  return scm_reverse_x (paths, SCM_EOL);
+}
+#undef FUNC_NAME
+
+static void
+init_module (void * data)
+{
+#ifndef SNARF_MODE
+#include "audio_exporter.x"
+#endif
+  scm_c_export (
+    "export-project",
+    "export-stems",
+    NULL);
+}
+
+void
+guile_audio_exporter_define_module (void)
+{
+  scm_c_define_module (
+    "audio exporter", init_module, NULL);
+}
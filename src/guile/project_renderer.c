@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audio/exporter.h"
+#include "guile/guile.h"
+#include "guile/project_renderer.h"
+#include "project.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+static int
+render_song (
+  const char * output_path)
+{
+  ExportSettings info;
+  memset (&info, 0, sizeof (ExportSettings));
+  info.format = AUDIO_FORMAT_WAV;
+  const char * ext = io_file_get_ext (output_path);
+  if (ext && strlen (ext) > 0)
+    {
+      info.format =
+        exporter_get_audio_format_from_extension (
+          ext);
+      if (info.format == NUM_AUDIO_FORMATS)
+        {
+          g_warning ("Unknown format: %s", ext);
+          return -1;
+        }
+    }
+  info.depth = BIT_DEPTH_16;
+  info.time_range = TIME_RANGE_SONG;
+  info.mode = EXPORT_MODE_FULL;
+  info.artist = g_strdup ("");
+  info.title = g_strdup ("");
+  info.genre = g_strdup ("");
+  info.file_uri = g_strdup (output_path);
+
+  int ret = exporter_export (&info);
+  if (info.progress_info.has_error)
+    {
+      g_warning (
+        "Export failed: %s",
+        info.progress_info.error_str);
+      ret = -1;
+    }
+  export_settings_free_members (&info);
+
+  return ret;
+}
+
+/**
+ * Loads the project at @ref prj_path and renders
+ * it faster than realtime.
+ *
+ * If @ref script_path is given, the script is run
+ * with the loaded project and is expected to do
+ * the rendering using the (audio exporter) module.
+ * Otherwise, the whole song is rendered to
+ * @ref output_path, using the format matching its
+ * extension.
+ *
+ * Zrythm must already be initialized without a UI,
+ * preferably with the dummy backends.
+ *
+ * @return Non-zero if fail.
+ */
+int
+guile_project_renderer_render_from_file (
+  const char * prj_path,
+  const char * script_path,
+  const char * output_path)
+{
+  g_return_val_if_fail (
+    ZRYTHM && !ZRYTHM_HAVE_UI && prj_path
+    && (script_path || output_path), -1);
+
+  if (!g_file_test (
+         prj_path, G_FILE_TEST_IS_REGULAR))
+    {
+      g_warning (
+        "Project file not found: %s", prj_path);
+      return -1;
+    }
+
+  char * script = NULL;
+  if (script_path)
+    {
+      GError * err = NULL;
+      g_file_get_contents (
+        script_path, &script, NULL, &err);
+      if (err)
+        {
+          g_warning (
+            "Failed to open file: %s", err->message);
+          g_error_free (err);
+          return -1;
+        }
+    }
+
+  int ret = project_load (prj_path, false);
+  if (ret != 0)
+    {
+      g_warning (
+        "Failed to load project: %s", prj_path);
+      g_free (script);
+      return -1;
+    }
+
+  if (script)
+    {
+      /* the script can get the loaded project with
+       * zrythm-get-project */
+      char * markup =
+        (char *) guile_run_script (script);
+      g_message ("\nResult:\n%s", markup);
+      ret = guile_script_succeeded (markup) ? 0 : -1;
+      g_free (script);
+    }
+  else
+    {
+      ret = render_song (output_path);
+    }
+
+  return ret;
+}
@@ -230,6 +230,9 @@ host_ui_custom_data_changed (
   const char* key,
   const char* value)
 {
+  CarlaNativePlugin * self =
+    (CarlaNativePlugin *) handle;
+  plugin_set_state_changed (self->plugin);
 }
 
 static void
@@ -322,6 +325,8 @@ engine_callback (
   switch (action)
     {
     case ENGINE_CALLBACK_UI_STATE_CHANGED:
+      /* the UI may have changed the state */
+      plugin_set_state_changed (self->plugin);
       switch (val1)
         {
         case 0:
@@ -1646,6 +1651,8 @@ carla_native_plugin_save_state (
     }
   else
     {
+      plugin_ensure_writable_state_dir (
+        self->plugin, is_backup);
       dir_to_use =
         plugin_get_abs_state_dir (
           self->plugin, is_backup);
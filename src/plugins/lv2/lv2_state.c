@@ -44,10 +44,14 @@
 
 #include "lilv/lilv.h"
 
+#include "audio/control_port.h"
+#include "audio/engine.h"
+#include "audio/router.h"
 #include "audio/transport.h"
 #include "plugins/lv2_plugin.h"
 #include "plugins/lv2/lv2_state.h"
 #include "plugins/lv2/lv2_ui.h"
+#include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
 #include "project.h"
 #include "utils/datetime.h"
@@ -236,6 +240,8 @@ lv2_state_save_to_file (
     pl->plugin->instantiated &&
     pl->instance, NULL);
 
+  plugin_ensure_writable_state_dir (
+    pl->plugin, is_backup);
   char * abs_state_dir =
     plugin_get_abs_state_dir (pl->plugin, is_backup);
   char * copy_dir =
@@ -301,6 +307,19 @@ lv2_state_save_to_memory (
   return state;
 }
 
+/**
+ * User data passed to set_port_value().
+ */
+typedef struct StateRestoreContext
+{
+  Lv2Plugin *              plugin;
+
+  /** Changes to apply together at the start of a
+   * cycle while the engine is running, or NULL to
+   * set the values directly. */
+  ControlPortChangeBatch * batch;
+} StateRestoreContext;
+
 static void
 set_port_value (
   const char* port_symbol,
@@ -309,7 +328,9 @@ set_port_value (
   uint32_t    size,
   uint32_t    type)
 {
-  Lv2Plugin * plugin = (Lv2Plugin*)user_data;
+  StateRestoreContext * ctx =
+    (StateRestoreContext *) user_data;
+  Lv2Plugin * plugin = ctx->plugin;
   Plugin * pl = plugin->plugin;
   char pl_str[800];
   plugin_print (plugin->plugin, pl_str, 800);
@@ -348,7 +369,23 @@ set_port_value (
     "(lv2 state): setting %s=%f...",
     port_symbol, (double) fvalue);
 
-  if (TRANSPORT->play_state != PLAYSTATE_ROLLING)
+  if (TRANSPORT->play_state != PLAYSTATE_ROLLING
+      && ctx->batch)
+    {
+      /* apply all values in the same cycle */
+      if (!control_port_change_batch_add_port_val (
+             ctx->batch, port, fvalue, false))
+        {
+          router_queue_control_port_changes (
+            ROUTER, ctx->batch);
+          control_port_change_batch_clear (
+            ctx->batch);
+          control_port_change_batch_add_port_val (
+            ctx->batch, port, fvalue, false);
+        }
+    }
+  else if (
+    TRANSPORT->play_state != PLAYSTATE_ROLLING)
     {
       /* Set value on port struct directly */
       port->control = fvalue;
@@ -401,13 +438,31 @@ lv2_state_apply_state (
       engine_paused = true;
     }
 
+  plugin_set_state_changed (plugin->plugin);
+
+  StateRestoreContext ctx = {
+    .plugin = plugin,
+  };
+  if (AUDIO_ENGINE->run
+      && plugin_is_in_active_project (
+           plugin->plugin))
+    {
+      ctx.batch = control_port_change_batch_new ();
+    }
+
   g_message (
     "applying state for LV2 plugin '%s'...",
     pl_str);
   lilv_state_restore (
     state, plugin->instance,
-    set_port_value, plugin, 0,
+    set_port_value, &ctx, 0,
     plugin->state_features);
+  if (ctx.batch)
+    {
+      router_queue_control_port_changes (
+        ROUTER, ctx.batch);
+      control_port_change_batch_free (ctx.batch);
+    }
   g_message (
     "LV2 state applied for plugin '%s'",
     pl_str);
@@ -32,11 +32,17 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "audio/graph.h"
+#include "audio/prerenderer.h"
+#include "audio/router.h"
+#include "audio/track.h"
 #include "plugins/lv2_plugin.h"
 #include "plugins/lv2/lv2_gtk.h"
 #include "plugins/lv2/lv2_ui.h"
 #include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
+#include "project.h"
+#include "utils/rt_memory.h"
 #include "zrythm.h"
 #include "zrythm_app.h"
 
@@ -393,6 +399,21 @@ lv2_ui_send_event_from_ui_to_plugin (
   zix_ring_write (
     plugin->ui_to_plugin_events, buf,
     (uint32_t) sizeof(buf));
+
+  plugin_set_state_changed (plugin->plugin);
+
+  /* the change is applied when the plugin is
+   * processed, which may be far ahead if its track
+   * is rendered ahead */
+  Track * track = plugin->plugin->track;
+  if (track && track->prerender
+      && !rt_memory_is_thread_realtime ()
+      && ROUTER && ROUTER->graph
+      && ROUTER->graph->prerenderer)
+    {
+      prerenderer_invalidate_track (
+        ROUTER->graph->prerenderer, track);
+    }
 }
 
 /**
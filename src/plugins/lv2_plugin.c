@@ -396,6 +396,7 @@ create_port (
         {
           g_return_val_if_fail (
             IS_PORT_AND_NONNULL (port), NULL);
+          port_release_pooled_buf (port);
           port->buf =
             g_realloc (
               port->buf,
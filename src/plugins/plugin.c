@@ -35,6 +35,7 @@
 #include "audio/channel.h"
 #include "audio/control_port.h"
 #include "audio/engine.h"
+#include "audio/midi.h"
 #include "audio/midi_event.h"
 #include "audio/track.h"
 #include "audio/transport.h"
@@ -58,6 +59,7 @@
 #include "utils/error.h"
 #include "utils/file.h"
 #include "utils/gtk.h"
+#include "utils/hash.h"
 #include "utils/io.h"
 #include "utils/flags.h"
 #include "utils/math.h"
@@ -69,6 +71,7 @@
 
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 typedef enum
 {
@@ -468,6 +471,8 @@ plugin_set_selected_preset_from_index (
   g_message (
     "applying preset at index %d", idx);
 
+  plugin_set_state_changed (self);
+
   GError * err = NULL;
   bool applied = false;
   if (self->setting->open_with_carla)
@@ -1743,6 +1748,11 @@ plugin_instantiate (
 
   self->instantiated = true;
 
+  /* the state dir now has the current state,
+   * unless a different state was applied */
+  g_atomic_int_set (
+    &self->state_changed, state ? 1 : 0);
+
   return 0;
 }
 
@@ -1825,6 +1835,29 @@ plugin_process (
     }
 #endif
 
+  /* MIDI messages other than notes (eg, program
+   * changes) may change the state */
+  if (plugin->midi_in_port
+      && !g_atomic_int_get (&plugin->state_changed))
+    {
+      MidiEvents * events =
+        plugin->midi_in_port->midi_events;
+      for (int i = 0; i < events->num_events; i++)
+        {
+          midi_byte_t type =
+            events->events[i].raw_buffer[0] & 0xf0;
+          if (type != MIDI_CH1_NOTE_ON
+              && type != MIDI_CH1_NOTE_OFF
+              && type != MIDI_CH1_POLY_AFTERTOUCH
+              && type != MIDI_CH1_CHAN_AFTERTOUCH
+              && type != MIDI_CH1_PITCH_WHEEL_RANGE)
+            {
+              plugin_set_state_changed (plugin);
+              break;
+            }
+        }
+    }
+
   /* turn off any trigger input controls */
   for (int i = 0; i < plugin->num_in_ports; i++)
     {
@@ -2185,6 +2218,378 @@ plugin_ensure_state_dir (
   g_free (abs_state_dir);
 }
 
+/**
+ * Returns whether the given state dir basename
+ * is a content-addressed snapshot.
+ *
+ * Snapshots are shared between plugins (and
+ * between saves) with identical states so they
+ * must never be written to or deleted.
+ */
+bool
+plugin_state_dir_is_snapshot (
+  const char * state_dir)
+{
+  if (!state_dir
+      ||
+      !g_str_has_prefix (
+         state_dir, PLUGIN_STATE_SNAPSHOT_PREFIX))
+    return false;
+
+  /* regular state dirs and temporary snapshot
+   * dirs end in "_XXXXXX" */
+  const char * hash =
+    &state_dir[
+      strlen (PLUGIN_STATE_SNAPSHOT_PREFIX)];
+  if (*hash == '\0')
+    return false;
+  for (const char * c = hash; *c != '\0'; c++)
+    {
+      if (!g_ascii_isxdigit (*c))
+        return false;
+    }
+
+  return true;
+}
+
+/** Snapshots created or reused in this session. */
+static GHashTable * session_snapshots = NULL;
+static GMutex       session_snapshots_lock;
+
+static void
+add_session_snapshot (
+  const char * snapshot)
+{
+  g_mutex_lock (&session_snapshots_lock);
+  if (!session_snapshots)
+    {
+      session_snapshots =
+        g_hash_table_new_full (
+          g_str_hash, g_str_equal, g_free, NULL);
+    }
+  g_hash_table_add (
+    session_snapshots, g_strdup (snapshot));
+  g_mutex_unlock (&session_snapshots_lock);
+}
+
+static bool
+is_session_snapshot (
+  const char * snapshot)
+{
+  g_mutex_lock (&session_snapshots_lock);
+  bool ret =
+    session_snapshots
+    &&
+    g_hash_table_contains (
+      session_snapshots, snapshot);
+  g_mutex_unlock (&session_snapshots_lock);
+
+  return ret;
+}
+
+/**
+ * Ensures the plugin has a state dir of its own
+ * that can be written to.
+ *
+ * If the current state dir is a snapshot, the
+ * plugin is moved to a new state dir containing
+ * a copy of the snapshot.
+ *
+ * To be called before saving the state to the
+ * plugin's state dir.
+ */
+void
+plugin_ensure_writable_state_dir (
+  Plugin * self,
+  bool     is_backup)
+{
+  if (!plugin_state_dir_is_snapshot (
+         self->state_dir))
+    {
+      plugin_ensure_state_dir (self, is_backup);
+      return;
+    }
+
+  char * snapshot_dir =
+    plugin_get_abs_state_dir (self, is_backup);
+  g_free_and_null (self->state_dir);
+  char * new_dir =
+    plugin_get_abs_state_dir (self, is_backup);
+  g_debug (
+    "moving plugin state from snapshot %s to %s",
+    snapshot_dir, new_dir);
+  io_copy_dir (
+    new_dir, snapshot_dir, F_FOLLOW_SYMLINKS,
+    F_RECURSIVE);
+  g_free (snapshot_dir);
+  g_free (new_dir);
+}
+
+/**
+ * Marks the state as changed so that the next
+ * plugin_save_state() saves it.
+ *
+ * Realtime safe.
+ */
+void
+plugin_set_state_changed (
+  Plugin * self)
+{
+  g_atomic_int_set (&self->state_changed, 1);
+}
+
+/**
+ * Saves the state of the plugin to its state
+ * directory, if instantiated and changed since it
+ * was last saved.
+ */
+void
+plugin_save_state (
+  Plugin * self,
+  bool     is_backup)
+{
+  if (!self->instantiated)
+    return;
+
+  /* the UI may change the state without notifying
+   * us while it is open */
+  if (!is_backup && !self->visible
+      && !g_atomic_int_get (&self->state_changed)
+      && self->state_dir)
+    {
+      char * abs_state_dir =
+        plugin_get_abs_state_dir (self, is_backup);
+      bool exists =
+        g_file_test (
+          abs_state_dir, G_FILE_TEST_IS_DIR);
+      g_free (abs_state_dir);
+      if (exists)
+        {
+          g_debug (
+            "state of plugin %s unchanged, not "
+            "saving", self->state_dir);
+          return;
+        }
+    }
+
+  /* changes made while saving are saved next
+   * time */
+  g_atomic_int_set (&self->state_changed, 0);
+
+  if (self->setting->open_with_carla)
+    {
+#ifdef HAVE_CARLA
+      carla_native_plugin_save_state (
+        self->carla, is_backup, NULL);
+#else
+      g_return_if_reached ();
+#endif
+    }
+  else
+    {
+      LilvState * state =
+        lv2_state_save_to_file (
+          self->lv2, is_backup);
+      lilv_state_free (state);
+    }
+  g_message (
+    "saved plugin state to %s", self->state_dir);
+}
+
+/**
+ * Creates (or reuses) a snapshot of the plugin's
+ * current state dir named after the hash of its
+ * contents.
+ *
+ * Does not save the state first.
+ *
+ * @return The basename of the snapshot dir, or
+ *   NULL if failed.
+ */
+static char *
+create_state_snapshot (
+  Plugin * self,
+  bool     is_backup)
+{
+  /* already a snapshot - nothing could have been
+   * written to it */
+  if (plugin_state_dir_is_snapshot (
+        self->state_dir))
+    {
+      add_session_snapshot (self->state_dir);
+      return g_strdup (self->state_dir);
+    }
+
+  char * src_dir =
+    plugin_get_abs_state_dir (self, is_backup);
+  char * hash =
+    hash_get_from_dir (
+      src_dir, HASH_ALGORITHM_XXH3_64);
+  if (!hash)
+    {
+      g_free (src_dir);
+      g_return_val_if_reached (NULL);
+    }
+
+  char * snapshot =
+    g_strdup_printf (
+      PLUGIN_STATE_SNAPSHOT_PREFIX "%s", hash);
+
+  /* keep it from being removed by a save running
+   * in parallel */
+  add_session_snapshot (snapshot);
+  char * parent_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_PLUGIN_STATES,
+      is_backup);
+  char * snapshot_dir =
+    g_build_filename (parent_dir, snapshot, NULL);
+
+  /* identical state already written by another
+   * plugin or by a previous save */
+  if (g_file_test (
+        snapshot_dir, G_FILE_TEST_IS_DIR))
+    {
+      g_debug (
+        "reusing state snapshot %s", snapshot);
+      goto done;
+    }
+
+  /* copy to a temporary dir first and move it in
+   * place so the snapshot is never seen
+   * incomplete */
+  char * tmp =
+    g_strdup_printf ("%s_XXXXXX", snapshot_dir);
+  if (!g_mkdtemp (tmp))
+    {
+      g_critical (
+        "Failed to make dir using template %s: %s",
+        tmp, strerror (errno));
+      g_free (tmp);
+      g_free_and_null (snapshot);
+      goto done;
+    }
+  io_copy_dir (
+    tmp, src_dir, F_FOLLOW_SYMLINKS, F_RECURSIVE);
+  if (g_rename (tmp, snapshot_dir) != 0)
+    {
+      /* another thread created the same snapshot
+       * in the meantime */
+      if (g_file_test (
+            snapshot_dir, G_FILE_TEST_IS_DIR))
+        {
+          io_rmdir (tmp, F_FORCE);
+        }
+      else
+        {
+          g_critical (
+            "Failed to move %s to %s: %s",
+            tmp, snapshot_dir, strerror (errno));
+          g_free_and_null (snapshot);
+        }
+    }
+  g_free (tmp);
+
+done:
+  g_free (src_dir);
+  g_free (hash);
+  g_free (parent_dir);
+  g_free (snapshot_dir);
+
+  return snapshot;
+}
+
+/**
+ * Prepares a snapshot of the plugin's state dir
+ * to be used by the next plugin_clone().
+ *
+ * This does not call into the plugin so it can be
+ * called from any non-realtime thread, as long as
+ * the state was saved beforehand with
+ * plugin_save_state().
+ */
+void
+plugin_prepare_state_snapshot (
+  Plugin * self,
+  bool     is_backup)
+{
+  g_free_and_null (self->state_snapshot_dir);
+  self->state_snapshot_dir =
+    create_state_snapshot (self, is_backup);
+}
+
+/**
+ * Clears the snapshot prepared with
+ * plugin_prepare_state_snapshot().
+ */
+void
+plugin_clear_state_snapshot (
+  Plugin * self)
+{
+  g_free_and_null (self->state_snapshot_dir);
+}
+
+/**
+ * Returns whether the given snapshot name appears
+ * in the given text as a whole word.
+ */
+static bool
+is_snapshot_referenced (
+  const char * text,
+  const char * snapshot)
+{
+  size_t len = strlen (snapshot);
+  const char * match = text;
+  while ((match = strstr (match, snapshot)))
+    {
+      if (!g_ascii_isxdigit (match[len]))
+        return true;
+
+      match += len;
+    }
+
+  return false;
+}
+
+/**
+ * Removes the snapshots in the given plugin states
+ * dir that are not referenced in the given
+ * serialized project.
+ *
+ * Snapshots used in this session are kept since
+ * they may still be referenced elsewhere (eg, by
+ * the clipboard).
+ */
+void
+plugin_remove_unused_state_snapshots (
+  const char * states_dir,
+  const char * project_yaml)
+{
+  GDir * dir = g_dir_open (states_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  const char * name;
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (!plugin_state_dir_is_snapshot (name)
+          ||
+          is_snapshot_referenced (
+            project_yaml, name)
+          || is_session_snapshot (name))
+        continue;
+
+      char * path =
+        g_build_filename (states_dir, name, NULL);
+      g_message (
+        "removing unused plugin state snapshot %s",
+        name);
+      io_rmdir (path, F_FORCE);
+      g_free (path);
+    }
+  g_dir_close (dir);
+}
+
 /**
  * Clones the given plugin.
  *
@@ -2207,31 +2612,14 @@ plugin_clone (
   Plugin * self = NULL;
   g_debug ("[0/5] cloning plugin '%s'", buf);
 
-  /* save the state of the original plugin */
+  /* save the state of the original plugin,
+   * unless a snapshot was already prepared */
   g_message (
     "[1/5] saving state of source plugin (if "
     "instantiated)");
-  if (src->instantiated)
+  if (!src->state_snapshot_dir)
     {
-      if (src->setting->open_with_carla)
-        {
-#ifdef HAVE_CARLA
-          carla_native_plugin_save_state (
-            src->carla, F_NOT_BACKUP, NULL);
-#else
-          g_return_val_if_reached (NULL);
-#endif
-        }
-      else
-        {
-          LilvState * state =
-            lv2_state_save_to_file (
-              src->lv2, F_NOT_BACKUP);
-          lilv_state_free (state);
-        }
-      g_message (
-        "saved source plugin state to %s",
-        src->state_dir);
+      plugin_save_state (src, F_NOT_BACKUP);
     }
 
   /* create a new plugin with same descriptor */
@@ -2296,12 +2684,30 @@ plugin_clone (
   self->num_in_ports = src->num_in_ports;
   self->num_out_ports = src->num_out_ports;
 
-  /* copy the state directory */
+  /* use a snapshot of the state directory
+   * (shared if identical to an existing one) */
   g_message (
-    "[4/5] copying state directory from source "
+    "[4/5] snapshotting state directory of source "
     "plugin");
-  plugin_copy_state_dir (
-    self, src, F_NOT_BACKUP, NULL);
+  if (src->state_snapshot_dir)
+    {
+      self->state_dir =
+        g_strdup (src->state_snapshot_dir);
+    }
+  else
+    {
+      self->state_dir =
+        create_state_snapshot (src, F_NOT_BACKUP);
+    }
+  if (!self->state_dir)
+    {
+      g_set_error (
+        error, Z_PLUGINS_PLUGIN_ERROR,
+        Z_PLUGINS_PLUGIN_ERROR_CREATION_FAILED,
+        _("Failed to copy state of %s"), buf);
+      plugin_free (self);
+      return NULL;
+    }
 
   g_message ("[5/5] done");
 
@@ -2454,6 +2860,9 @@ plugin_close_ui (
   g_return_if_fail (
     plugin_is_in_active_project (self));
 
+  /* the UI may have changed the state */
+  plugin_set_state_changed (self);
+
   if (self->instantiation_failed)
     {
       g_message (
@@ -3040,6 +3449,11 @@ plugin_delete_state_files (
     "deleting state files for plugin %s (%s)",
     self->setting->descr->name, self->state_dir);
 
+  /* snapshots may be shared with other plugins */
+  if (plugin_state_dir_is_snapshot (
+        self->state_dir))
+    return;
+
   g_return_if_fail (
     g_path_is_absolute (self->state_dir));
 
@@ -3211,6 +3625,7 @@ plugin_free (
     }
 
   object_zero_and_free (self->lilv_ports);
+  g_free_and_null (self->state_snapshot_dir);
 
   object_zero_and_free (self);
 }
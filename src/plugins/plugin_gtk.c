@@ -38,6 +38,7 @@
 
 #include <math.h>
 
+#include "audio/control_port.h"
 #include "audio/engine.h"
 #include "audio/track.h"
 #include "gui/backend/event.h"
@@ -883,16 +884,14 @@ set_float_control (
       else if (port->id.flags &
                  PORT_FLAG_GENERIC_PLUGIN_PORT)
         {
-          port_set_control_value (
-            port, value, F_NOT_NORMALIZED,
-            F_PUBLISH_EVENTS);
+          control_port_queue_real_val (
+            port, value, F_PUBLISH_EVENTS);
         }
     }
   else if (pl->setting->open_with_carla)
     {
-      port_set_control_value (
-        port, value, F_NOT_NORMALIZED,
-        F_PUBLISH_EVENTS);
+      control_port_queue_real_val (
+        port, value, F_PUBLISH_EVENTS);
     }
 
   PluginGtkController * controller =
@@ -41,6 +41,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 
+#include "gui/backend/event.h"
+#include "gui/backend/event_manager.h"
 #include "gui/widgets/main_window.h"
 #include "plugins/cached_plugin_descriptors.h"
 #include "plugins/carla/carla_discovery.h"
@@ -153,6 +155,50 @@ static int sort_plugin_func (
   return -strcmp(pa->name, pb->name);
 }
 
+/**
+ * Adds a scanned descriptor to the plugin list,
+ * or to the pending descriptors to be published
+ * in the GTK thread if scanning in the background.
+ */
+static void
+add_descriptor (
+  PluginManager *    self,
+  PluginDescriptor * descr)
+{
+  if (g_atomic_int_get (&self->scanning))
+    {
+      g_mutex_lock (&self->pending_lock);
+      g_ptr_array_add (
+        self->pending_descriptors, descr);
+      g_mutex_unlock (&self->pending_lock);
+      return;
+    }
+
+  g_ptr_array_add (self->plugin_descriptors, descr);
+  add_category_and_author (
+    self, descr->category_str, descr->author);
+}
+
+static void
+sort_plugins (
+  PluginManager * self)
+{
+  /* sort alphabetically */
+  g_ptr_array_sort (
+    self->plugin_descriptors,
+    sort_plugin_func);
+  qsort (
+    self->plugin_categories,
+    (size_t) self->num_plugin_categories,
+    sizeof (char *),
+    sort_alphabetical_func);
+  qsort (
+    self->plugin_authors,
+    (size_t) self->num_plugin_authors,
+    sizeof (char *),
+    sort_alphabetical_func);
+}
+
 /*static void*/
 /*print_plugins ()*/
 /*{*/
@@ -415,6 +461,11 @@ plugin_manager_new (void)
       100,
       (GDestroyNotify) plugin_descriptor_free);
 
+  self->pending_descriptors =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) plugin_descriptor_free);
+  g_mutex_init (&self->pending_lock);
+
   self->symap = symap_new();
   zix_sem_init (&self->symap_lock, 1);
 
@@ -925,6 +976,9 @@ scan_carla_descriptors_from_paths (
       while ((plugin_path = plugins[plugin_idx++]) !=
                NULL)
         {
+          if (g_atomic_int_get (&self->cancel_scan))
+            break;
+
           PluginDescriptor ** descriptors =
             cached_plugin_descriptors_get (
               self->cached_plugin_descriptors,
@@ -943,15 +997,10 @@ scan_carla_descriptors_from_paths (
                     "Found cached %s %s",
                     protocol_str,
                     descriptor->name);
-                  PluginDescriptor * clone =
+                  add_descriptor (
+                    self,
                     plugin_descriptor_clone (
-                      descriptor);
-                  g_ptr_array_add (
-                    self->plugin_descriptors,
-                    clone);
-                  add_category_and_author (
-                    self, clone->category_str,
-                    clone->author);
+                      descriptor));
                 }
             }
           /* if no cached descriptors found */
@@ -1044,13 +1093,8 @@ scan_carla_descriptors_from_paths (
                       int i = 0;
                       while ((descriptor = descriptors[i++]))
                         {
-                          g_ptr_array_add (
-                            self->plugin_descriptors,
-                            descriptor);
-                          add_category_and_author (
-                            self,
-                            descriptor->category_str,
-                            descriptor->author);
+                          add_descriptor (
+                            self, descriptor);
                           g_message (
                             "Caching %s %s",
                             protocol_str,
@@ -1115,6 +1159,7 @@ scan_carla_descriptors_from_paths (
               zrythm_app_set_progress_status (
                 zrythm_app, prog_str, *progress);
             }
+          free (descriptors);
         }
       if (plugin_idx > 0 &&
           !ZRYTHM_TESTING)
@@ -1129,38 +1174,15 @@ scan_carla_descriptors_from_paths (
 #endif
 
 /**
- * Scans for plugins, optionally updating the
- * progress.
- *
- * @param max_progress Maximum progress for this
- *   stage.
- * @param progress Pointer to a double (0.0-1.0) to
- *   update based on the current progress.
+ * Returns the number of plugins to scan, for
+ * calculating the progress.
  */
-void
-plugin_manager_scan_plugins (
-  PluginManager * self,
-  const double    max_progress,
-  double *        progress)
+static double
+get_scan_size (
+  PluginManager * self)
 {
-  g_return_if_fail (self);
-
-  g_message ("%s: Scanning...", __func__);
-
-  double start_progress =
-    progress ? *progress : 0;
-
-  /* load all plugins with lilv */
-  LilvWorld * world = self->lilv_world;
-  const LilvPlugins * lilv_plugins =
-    lilv_world_get_all_plugins (world);
-  self->lilv_plugins = lilv_plugins;
-
-  if (getenv ("ZRYTHM_SKIP_PLUGIN_SCAN"))
-    return;
-
   double size =
-    (double) lilv_plugins_size (lilv_plugins);
+    (double) lilv_plugins_size (self->lilv_plugins);
 #ifdef HAVE_CARLA
   size += (double) get_vst_count (self);
   size += (double) get_vst3_count (self);
@@ -1172,10 +1194,24 @@ plugin_manager_scan_plugins (
 #  endif
 #endif
 
+  return size;
+}
+
+static void
+scan_lv2_plugins (
+  PluginManager * self,
+  unsigned int *  count,
+  const double    size,
+  double *        progress,
+  const double    start_progress,
+  const double    max_progress)
+{
+  const LilvPlugins * lilv_plugins =
+    self->lilv_plugins;
+
   /* scan LV2 */
   g_message (
     "%s: Scanning LV2 plugins...", __func__);
-  unsigned int count = 0;
   LILV_FOREACH (plugins, i, lilv_plugins)
     {
       const LilvPlugin* p =
@@ -1196,30 +1232,17 @@ plugin_manager_scan_plugins (
           /* if cached descriptor found, use it */
           if (found_descr)
             {
-              g_ptr_array_add (
-                self->plugin_descriptors,
-                plugin_descriptor_clone (
-                  found_descr));
-              add_category_and_author (
-                self, found_descr->category_str,
-                found_descr->author);
-
               plugin_descriptor_free (
                 descriptor);
               descriptor =
-                g_ptr_array_index (
-                  self->plugin_descriptors,
-                  self->plugin_descriptors->len - 1);
+                plugin_descriptor_clone (
+                  found_descr);
+              add_descriptor (self, descriptor);
             }
           else
             {
               /* add descriptor to list */
-              g_ptr_array_add (
-                self->plugin_descriptors,
-                descriptor);
-              add_category_and_author (
-                self, descriptor->category_str,
-                descriptor->author);
+              add_descriptor (self, descriptor);
 
               /* add descriptor to cached */
               cached_plugin_descriptors_add (
@@ -1228,13 +1251,13 @@ plugin_manager_scan_plugins (
             }
         }
 
-      count++;
+      (*count)++;
 
       if (progress)
         {
           *progress =
             start_progress +
-            ((double) count / size) *
+            ((double) *count / size) *
               (max_progress - start_progress);
           char prog_str[800];
           if (descriptor)
@@ -1260,43 +1283,58 @@ plugin_manager_scan_plugins (
         }
     }
   g_message (
-    "%s: Scanned %d LV2 plugins", __func__, count);
+    "%s: Scanned %u LV2 plugins", __func__,
+    *count);
 
   cached_plugin_descriptors_serialize_to_file (
     self->cached_plugin_descriptors);
+}
 
+/**
+ * Scans plugins discovered via carla (LADSPA,
+ * DSSI, VST, VST3, SFZ, SF2 and AU).
+ */
+static void
+scan_carla_plugins (
+  PluginManager * self,
+  unsigned int *  count,
+  const double    size,
+  double *        progress,
+  const double    start_progress,
+  const double    max_progress)
+{
 #ifdef HAVE_CARLA
 
 #if !defined (_WOE32) && !defined (__APPLE__)
   /* scan ladspa */
   scan_carla_descriptors_from_paths (
-    self, PROT_LADSPA, &count, size, progress,
+    self, PROT_LADSPA, count, size, progress,
     start_progress, max_progress);
 
   /* scan dssi */
   scan_carla_descriptors_from_paths (
-    self, PROT_DSSI, &count, size, progress,
+    self, PROT_DSSI, count, size, progress,
     start_progress, max_progress);
 #endif /* not apple/woe32 */
 
   /* scan vst */
   scan_carla_descriptors_from_paths (
-    self, PROT_VST, &count, size, progress,
+    self, PROT_VST, count, size, progress,
     start_progress, max_progress);
 
   /* scan vst3 */
   scan_carla_descriptors_from_paths (
-    self, PROT_VST3, &count, size, progress,
+    self, PROT_VST3, count, size, progress,
     start_progress, max_progress);
 
   /* scan sfz */
   scan_carla_descriptors_from_paths (
-    self, PROT_SFZ, &count, size, progress,
+    self, PROT_SFZ, count, size, progress,
     start_progress, max_progress);
 
   /* scan sf2 */
   scan_carla_descriptors_from_paths (
-    self, PROT_SF2, &count, size, progress,
+    self, PROT_SF2, count, size, progress,
     start_progress, max_progress);
 
 #ifdef __APPLE__
@@ -1319,21 +1357,16 @@ plugin_manager_scan_plugins (
 
           if (descriptor)
             {
-              g_ptr_array_add (
-                self->plugin_descriptors,
-                descriptor);
-              add_category_and_author (
-                self, descriptor->category_str,
-                descriptor->author);
+              add_descriptor (self, descriptor);
             }
 
-          count++;
+          (*count)++;
 
           if (progress)
             {
               *progress =
                 start_progress +
-                ((double) count / size) *
+                ((double) *count / size) *
                   (max_progress - start_progress);
               char prog_str[800];
               if (descriptor)
@@ -1361,21 +1394,47 @@ plugin_manager_scan_plugins (
     }
 #endif // __APPLE__
 #endif // HAVE_CARLA
+}
 
-  /* sort alphabetically */
-  g_ptr_array_sort (
-    self->plugin_descriptors,
-    sort_plugin_func);
-  qsort (
-    self->plugin_categories,
-    (size_t) self->num_plugin_categories,
-    sizeof (char *),
-    sort_alphabetical_func);
-  qsort (
-    self->plugin_authors,
-    (size_t) self->num_plugin_authors,
-    sizeof (char *),
-    sort_alphabetical_func);
+/**
+ * Scans for plugins, optionally updating the
+ * progress.
+ *
+ * @param max_progress Maximum progress for this
+ *   stage.
+ * @param progress Pointer to a double (0.0-1.0) to
+ *   update based on the current progress.
+ */
+void
+plugin_manager_scan_plugins (
+  PluginManager * self,
+  const double    max_progress,
+  double *        progress)
+{
+  g_return_if_fail (self);
+
+  g_message ("%s: Scanning...", __func__);
+
+  double start_progress =
+    progress ? *progress : 0;
+
+  /* load all plugins with lilv */
+  self->lilv_plugins =
+    lilv_world_get_all_plugins (self->lilv_world);
+
+  if (getenv ("ZRYTHM_SKIP_PLUGIN_SCAN"))
+    return;
+
+  double size = get_scan_size (self);
+  unsigned int count = 0;
+  scan_lv2_plugins (
+    self, &count, size, progress, start_progress,
+    max_progress);
+  scan_carla_plugins (
+    self, &count, size, progress, start_progress,
+    max_progress);
+
+  sort_plugins (self);
 
   g_message (
     "%s: %d Plugins scanned.",
@@ -1384,6 +1443,163 @@ plugin_manager_scan_plugins (
   /*print_plugins ();*/
 }
 
+static void *
+scan_thread_func (
+  PluginManager * self)
+{
+  unsigned int count = 0;
+  scan_carla_plugins (self, &count, 0, NULL, 0, 0);
+
+  g_message (
+    "%s: scanned %u plugins in the background",
+    __func__, count);
+
+  g_atomic_int_set (&self->scanning, 0);
+
+  return NULL;
+}
+
+/**
+ * Moves the descriptors found by the background
+ * scan to the plugin list.
+ *
+ * To be called periodically in the GTK thread
+ * while scanning.
+ */
+static int
+publish_pending_descriptors (
+  PluginManager * self)
+{
+  /* check before taking the pending descriptors
+   * so that nothing is added after the last
+   * publish */
+  bool finished =
+    !g_atomic_int_get (&self->scanning);
+
+  g_mutex_lock (&self->pending_lock);
+  GPtrArray * descrs = self->pending_descriptors;
+  self->pending_descriptors =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) plugin_descriptor_free);
+  g_mutex_unlock (&self->pending_lock);
+
+  /* ownership moves to the plugin list */
+  g_ptr_array_set_free_func (descrs, NULL);
+
+  for (size_t i = 0; i < descrs->len; i++)
+    {
+      PluginDescriptor * descr =
+        g_ptr_array_index (descrs, i);
+      g_ptr_array_add (
+        self->plugin_descriptors, descr);
+      add_category_and_author (
+        self, descr->category_str, descr->author);
+    }
+
+  if (descrs->len > 0)
+    {
+      g_debug (
+        "%s: published %u plugins", __func__,
+        descrs->len);
+      sort_plugins (self);
+      EVENTS_PUSH (
+        ET_PLUGIN_DESCRIPTORS_CHANGED, NULL);
+    }
+  g_ptr_array_unref (descrs);
+
+  if (!finished)
+    return G_SOURCE_CONTINUE;
+
+  if (self->scan_thread)
+    {
+      g_thread_join (self->scan_thread);
+      self->scan_thread = NULL;
+    }
+  self->publish_source_id = 0;
+
+  g_message (
+    "%s: %d Plugins scanned.",
+    __func__, self->plugin_descriptors->len);
+
+  if (self->scan_finished_cb)
+    {
+      self->scan_finished_cb (
+        self->scan_finished_cb_data);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Scans LV2 plugins synchronously and the rest of
+ * the plugins in a background thread.
+ *
+ * Plugins found in the background are published
+ * to \ref PluginManager.plugin_descriptors in
+ * batches in the GTK thread, so the plugin list
+ * must only be accessed from the GTK thread while
+ * scanning.
+ *
+ * @param on_finished Callback to call in the GTK
+ *   thread when scanning finished, or NULL.
+ */
+void
+plugin_manager_begin_scan_plugins (
+  PluginManager * self,
+  const double    max_progress,
+  double *        progress,
+  GenericCallback on_finished,
+  void *          user_data)
+{
+  g_return_if_fail (
+    self && !self->publish_source_id);
+
+  g_message ("%s: Scanning...", __func__);
+
+  double start_progress =
+    progress ? *progress : 0;
+
+  /* load all plugins with lilv */
+  self->lilv_plugins =
+    lilv_world_get_all_plugins (self->lilv_world);
+
+  self->scan_finished_cb = on_finished;
+  self->scan_finished_cb_data = user_data;
+
+  if (!getenv ("ZRYTHM_SKIP_PLUGIN_SCAN"))
+    {
+      /* LV2 plugins are scanned here because lilv
+       * is not safe to use from multiple threads
+       * and projects may instantiate LV2 plugins
+       * as soon as this returns */
+      unsigned int count = 0;
+      scan_lv2_plugins (
+        self, &count,
+        (double)
+        lilv_plugins_size (self->lilv_plugins),
+        progress, start_progress, max_progress);
+      sort_plugins (self);
+
+#ifdef HAVE_CARLA
+      g_atomic_int_set (&self->cancel_scan, 0);
+      g_atomic_int_set (&self->scanning, 1);
+      self->scan_thread =
+        g_thread_new (
+          "plugin_scan_thread",
+          (GThreadFunc) scan_thread_func, self);
+#endif
+    }
+
+  /* publish the results in batches instead of
+   * per plugin to avoid rebuilding the plugin
+   * browser too often */
+  self->publish_source_id =
+    g_timeout_add (
+      PLUGIN_MANAGER_PUBLISH_INTERVAL_MS,
+      (GSourceFunc) publish_pending_descriptors,
+      self);
+}
+
 /**
  * Returns the PluginDescriptor instance for the
  * given URI.
@@ -1486,6 +1702,20 @@ plugin_manager_free (
 {
   g_message ("%s: Freeing...", __func__);
 
+  if (self->scan_thread)
+    {
+      g_atomic_int_set (&self->cancel_scan, 1);
+      g_thread_join (self->scan_thread);
+      self->scan_thread = NULL;
+    }
+  if (self->publish_source_id)
+    {
+      g_source_remove (self->publish_source_id);
+      self->publish_source_id = 0;
+    }
+  g_ptr_array_unref (self->pending_descriptors);
+  g_mutex_clear (&self->pending_lock);
+
   symap_free (self->symap);
   zix_sem_destroy (&self->symap_lock);
 
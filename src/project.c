@@ -67,6 +67,7 @@
 #include "plugins/carla_native_plugin.h"
 #include "plugins/lv2_plugin.h"
 #include "plugins/lv2/lv2_state.h"
+#include "plugins/plugin.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
 #include "utils/datetime.h"
@@ -82,6 +83,7 @@
 
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 #include <zstd.h>
 
@@ -96,6 +98,29 @@ GQuark z_project_error_quark (void);
 G_DEFINE_QUARK (
   z-project-error-quark, z_project_error)
 
+/** Last Project.generation handed out. */
+static unsigned int last_generation = 0;
+
+/**
+ * Decompressed YAML of the last template used,
+ * so that creating more projects from the same
+ * template skips reading and decompressing it.
+ */
+static struct
+{
+  /** Path to the template's project file. */
+  char *  path;
+
+  /** Modification time of the file. */
+  gint64  mtime;
+
+  /** Size of the file. */
+  gint64  size;
+
+  /** Decompressed YAML. */
+  char *  yaml;
+} template_cache;
+
 static void
 init_common (
   Project * self)
@@ -928,6 +953,65 @@ project_get_existing_yaml (
   return yaml;
 }
 
+/**
+ * Returns the YAML of the template at the current
+ * project dir, using the cached copy if the file
+ * has not changed since it was last read.
+ *
+ * @return A newly allocated string or NULL.
+ */
+static char *
+get_template_yaml (
+  Project * self)
+{
+  char * project_file_path =
+    project_get_path (
+      self, PROJECT_PATH_PROJECT_FILE,
+      F_NOT_BACKUP);
+  g_return_val_if_fail (project_file_path, NULL);
+
+  GStatBuf st;
+  if (g_stat (project_file_path, &st) != 0)
+    {
+      g_free (project_file_path);
+      return
+        project_get_existing_yaml (
+          self, F_NOT_BACKUP);
+    }
+
+  if (template_cache.yaml
+      &&
+      string_is_equal (
+        template_cache.path, project_file_path)
+      && template_cache.mtime == (gint64) st.st_mtime
+      && template_cache.size == (gint64) st.st_size)
+    {
+      g_message (
+        "%s: using cached YAML for template %s",
+        __func__, project_file_path);
+      g_free (project_file_path);
+      return g_strdup (template_cache.yaml);
+    }
+
+  char * yaml =
+    project_get_existing_yaml (self, F_NOT_BACKUP);
+  if (yaml)
+    {
+      g_free (template_cache.path);
+      g_free (template_cache.yaml);
+      template_cache.path = project_file_path;
+      template_cache.mtime = (gint64) st.st_mtime;
+      template_cache.size = (gint64) st.st_size;
+      template_cache.yaml = g_strdup (yaml);
+    }
+  else
+    {
+      g_free (project_file_path);
+    }
+
+  return yaml;
+}
+
 /**
  * @param filename The filename to open. This will
  *   be the template in the case of template, or
@@ -1016,7 +1100,9 @@ load (
   PROJECT->loading_from_backup = use_backup;
 
   char * yaml =
-    project_get_existing_yaml (PROJECT, use_backup);
+    is_template
+    ? get_template_yaml (PROJECT)
+    : project_get_existing_yaml (PROJECT, use_backup);
 
   g_message ("project from yaml...");
   gint64 time_before = g_get_monotonic_time ();
@@ -1080,9 +1166,11 @@ load (
         g_build_filename (
           ZRYTHM->create_project_path,
           PROJECT_PLUGINS_DIR, NULL);
-      io_copy_dir (
-        new_pool_dir, prev_pool_dir,
-        F_NO_FOLLOW_SYMLINKS, F_RECURSIVE);
+      /* pool files can be large, so share their
+       * data (copy-on-write) with the template
+       * where possible */
+      io_reflink_dir (
+        new_pool_dir, prev_pool_dir, F_RECURSIVE);
       io_copy_dir (
         new_plugins_dir, prev_plugins_dir,
         F_NO_FOLLOW_SYMLINKS, F_RECURSIVE);
@@ -1114,6 +1202,7 @@ load (
 
   g_message (
     "%s: initing loaded structures", __func__);
+  self->generation = ++last_generation;
   PROJECT = self;
 
   /* re-update paths for the newly loaded project */
@@ -1503,6 +1592,14 @@ project_get_path (
       return
         g_build_filename (
           dir, PROJECT_POOL_DIR, NULL);
+    case PROJECT_PATH_ANALYSIS:
+      return
+        g_build_filename (
+          dir, PROJECT_ANALYSIS_DIR, NULL);
+    case PROJECT_PATH_IMPORT_TMP:
+      return
+        g_build_filename (
+          dir, PROJECT_IMPORT_TMP_DIR, NULL);
     case PROJECT_PATH_PROJECT_FILE:
       return
         g_build_filename (
@@ -1526,6 +1623,7 @@ project_new (
   Project * self = object_new (Project);
   self->schema_version =
     PROJECT_SCHEMA_VERSION;
+  self->generation = ++last_generation;
 
   if (_zrythm)
     {
@@ -1561,6 +1659,7 @@ project_save_data_free (
   ProjectSaveData * self)
 {
   g_free_and_null (self->project_file_path);
+  g_free_and_null (self->plugin_states_dir);
   object_free_w_func_and_null (
     project_free, self->project);
 
@@ -1577,12 +1676,13 @@ serialize_project_thread (
   char * compressed_yaml;
   size_t compressed_size;
   bool ret;
+  char * yaml = NULL;
 
   /* generate yaml */
   g_message ("serializing project to yaml...");
   GError *err = NULL;
   gint64 time_before = g_get_monotonic_time ();
-  char * yaml =
+  yaml =
     yaml_serialize (
       data->project, &project_schema);
   gint64 time_after = g_get_monotonic_time ();
@@ -1604,7 +1704,6 @@ serialize_project_thread (
       PROJECT_COMPRESS_DATA,
       yaml, strlen (yaml) * sizeof (char),
       PROJECT_COMPRESS_DATA, &err);
-  g_free (yaml);
   if (!ret)
     {
       HANDLE_ERROR (
@@ -1629,17 +1728,146 @@ serialize_project_thread (
         __func__, err->message);
       g_error_free (err);
       data->has_error = true;
+      goto serialize_end;
     }
 
   g_message (
     "%s: successfully saved project", __func__);
 
+  /* only the saved project (including its undo
+   * history) references the snapshots now */
+  if (data->plugin_states_dir)
+    {
+      plugin_remove_unused_state_snapshots (
+        data->plugin_states_dir, yaml);
+    }
+
 serialize_end:
+  g_free (yaml);
   zix_sem_post (&UNDO_MANAGER->action_sem);
   data->finished = true;
   return NULL;
 }
 
+/**
+ * Appends all the plugins in the project to the
+ * given array.
+ */
+static void
+get_all_plugins (
+  Project *   self,
+  GPtrArray * arr)
+{
+  for (int i = 0; i < self->tracklist->num_tracks;
+       i++)
+    {
+      Track * track = self->tracklist->tracks[i];
+      if (track->channel)
+        {
+          Plugin * pls[STRIP_SIZE * 2 + 1];
+          int num_pls =
+            channel_get_plugins (
+              track->channel, pls);
+          for (int j = 0; j < num_pls; j++)
+            {
+              g_ptr_array_add (arr, pls[j]);
+            }
+        }
+      for (int j = 0; j < track->num_modulators;
+           j++)
+        {
+          g_ptr_array_add (
+            arr, track->modulators[j]);
+        }
+    }
+}
+
+static void
+prepare_state_snapshot_thread_func (
+  Plugin * pl,
+  void *   data)
+{
+  plugin_prepare_state_snapshot (
+    pl, F_NOT_BACKUP);
+}
+
+/**
+ * Saves the state of each plugin and prepares
+ * content-addressed snapshots of the state dirs
+ * to be used when cloning the project.
+ *
+ * The states are saved serially since the plugin
+ * APIs do not allow saving concurrently with
+ * other non-realtime calls, but hashing and
+ * copying the state dirs is done in parallel.
+ */
+static void
+prepare_plugin_state_snapshots (
+  Project * self)
+{
+  GPtrArray * pls = g_ptr_array_new ();
+  get_all_plugins (self, pls);
+
+  for (size_t i = 0; i < pls->len; i++)
+    {
+      Plugin * pl = g_ptr_array_index (pls, i);
+      plugin_save_state (pl, F_NOT_BACKUP);
+    }
+
+  GError * err = NULL;
+  GThreadPool * pool =
+    g_thread_pool_new (
+      (GFunc) prepare_state_snapshot_thread_func,
+      NULL, (int) g_get_num_processors (),
+      F_NOT_EXCLUSIVE, &err);
+  for (size_t i = 0; i < pls->len; i++)
+    {
+      Plugin * pl = g_ptr_array_index (pls, i);
+      if (!pool
+          ||
+          !g_thread_pool_push (pool, pl, &err))
+        {
+          /* fall back to preparing the snapshot
+           * here */
+          if (err)
+            {
+              g_message (
+                "failed to push state snapshot "
+                "task: %s", err->message);
+              g_clear_error (&err);
+            }
+          plugin_prepare_state_snapshot (
+            pl, F_NOT_BACKUP);
+        }
+    }
+
+  /* wait for all tasks to finish */
+  if (pool)
+    {
+      g_thread_pool_free (pool, false, true);
+    }
+
+  g_ptr_array_unref (pls);
+}
+
+/**
+ * Clears the snapshots prepared with
+ * prepare_plugin_state_snapshots().
+ */
+static void
+clear_plugin_state_snapshots (
+  Project * self)
+{
+  GPtrArray * pls = g_ptr_array_new ();
+  get_all_plugins (self, pls);
+  for (size_t i = 0; i < pls->len; i++)
+    {
+      Plugin * pl = g_ptr_array_index (pls, i);
+      plugin_clear_state_snapshot (pl);
+    }
+  g_ptr_array_unref (pls);
+}
+
 /**
  * Idle func to check if the project has finished
  * saving and show a notification.
@@ -1935,7 +2163,16 @@ project_save (
       self, PROJECT_PATH_PROJECT_FILE, is_backup);
   data->show_notification = show_notification;
   data->is_backup = is_backup;
+  if (!is_backup)
+    {
+      data->plugin_states_dir =
+        project_get_path (
+          self, PROJECT_PATH_PLUGIN_STATES,
+          F_NOT_BACKUP);
+    }
+  prepare_plugin_state_snapshots (self);
   data->project = project_clone (PROJECT);
+  clear_plugin_state_snapshots (self);
   data->project->tracklist_selections->free_tracks =
     true;
 
@@ -320,11 +320,6 @@ audio_detect_bpm (
   vamp_plugin_initialize (
     plugin, 1, step_sz, block_sz);
 
-  ZVampOutputList * outputs =
-    vamp_plugin_get_output_descriptors (plugin);
-  vamp_plugin_output_list_print (outputs);
-  vamp_plugin_output_list_free (outputs);
-
   long cur_timestamp = 0;
   float bpm = 0.f;
   while ((cur_timestamp + (long) block_sz) <
@@ -343,7 +338,6 @@ audio_detect_bpm (
           feature_set, 0);
       if (fl)
         {
-          vamp_feature_list_print (fl);
           const ZVampFeature * feature =
             g_ptr_array_index (fl->list, 0);
           bpm = feature->values[0];
@@ -362,7 +356,6 @@ audio_detect_bpm (
       vamp_feature_set_free (feature_set);
     }
 
-  g_message ("getting remaining features");
   ZVampFeatureSet * feature_set =
     vamp_plugin_get_remaining_features (
       plugin, samplerate);
@@ -371,7 +364,6 @@ audio_detect_bpm (
       feature_set, 0);
   if (fl)
     {
-      vamp_feature_list_print (fl);
       const ZVampFeature * feature =
         g_ptr_array_index (fl->list, 0);
       bpm = feature->values[0];
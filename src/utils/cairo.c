@@ -276,6 +276,76 @@ z_cairo_get_surface_from_icon_name (
   return surface;
 }
 
+/**
+ * Returns a cached surface with the given Pango
+ * markup rendered in the default font at the given
+ * size and color, creating it if needed.
+ *
+ * The surface is owned by the cache and is meant
+ * to be blitted wherever the same label is drawn
+ * many times (eg, note names).
+ *
+ * @param markup Pango markup, also used as part of
+ *   the cache key.
+ * @param font_size Font size in points.
+ * @param scale Scale factor of the widget.
+ */
+cairo_surface_t *
+z_cairo_get_surface_for_label (
+  GtkWidget *     widget,
+  const char *    markup,
+  int             font_size,
+  const GdkRGBA * color,
+  int             scale)
+{
+  char key[200];
+  snprintf (
+    key, sizeof (key), "%s|%d|%d|%02x%02x%02x%02x",
+    markup, font_size, scale,
+    (int) (color->red * 255.0),
+    (int) (color->green * 255.0),
+    (int) (color->blue * 255.0),
+    (int) (color->alpha * 255.0));
+  cairo_surface_t * surface =
+    g_hash_table_lookup (
+      CAIRO_CACHES->label_surfaces, key);
+  if (surface)
+    return surface;
+
+  PangoLayout * layout =
+    z_cairo_create_default_pango_layout (widget);
+  PangoFontDescription * desc =
+    pango_font_description_copy (
+      pango_layout_get_font_description (layout));
+  pango_font_description_set_size (
+    desc, font_size * PANGO_SCALE);
+  pango_layout_set_font_description (layout, desc);
+  pango_font_description_free (desc);
+  pango_layout_set_markup (layout, markup, -1);
+
+  int width, height;
+  pango_layout_get_pixel_size (
+    layout, &width, &height);
+  surface =
+    cairo_image_surface_create (
+      CAIRO_FORMAT_ARGB32,
+      MAX (width, 1) * scale,
+      MAX (height, 1) * scale);
+  cairo_surface_set_device_scale (
+    surface, scale, scale);
+  cairo_t * cr = cairo_create (surface);
+  gdk_cairo_set_source_rgba (cr, color);
+  pango_cairo_show_layout (cr, layout);
+  cairo_destroy (cr);
+  g_object_unref (layout);
+
+  g_hash_table_insert (
+    CAIRO_CACHES->label_surfaces,
+    g_strdup (key), surface);
+
+  return surface;
+}
+
 /**
  * Resets a surface and cairo_t with a new surface
  * and cairo_t based on the given rectangle and
@@ -323,6 +393,10 @@ z_cairo_caches_new (void)
 
   self->icon_surface_dict =
     dictionary_new ();
+  self->label_surfaces =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) cairo_surface_destroy);
 
   return self;
 }
@@ -333,6 +407,8 @@ z_cairo_caches_free (
 {
   object_free_w_func_and_null (
     dictionary_free, self->icon_surface_dict);
+  object_free_w_func_and_null (
+    g_hash_table_unref, self->label_surfaces);
 
   object_zero_and_free (self);
 }
@@ -0,0 +1,513 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* for CPU_SET and friends */
+#define _GNU_SOURCE
+
+#include "zrythm-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "settings/settings.h"
+#include "utils/cpu_affinity.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
+
+#include <gtk/gtk.h>
+
+/**
+ * Parses a CPU list like "0,2-4" (the format used
+ * by isolcpus and taskset) into CPU indices.
+ *
+ * @param cpus Array of int to append to.
+ *
+ * @return Whether the list is valid. An empty list
+ *   is valid.
+ */
+bool
+cpu_affinity_parse_list (
+  const char * str,
+  GArray *     cpus)
+{
+  char ** parts = g_strsplit (str, ",", -1);
+  bool ret = true;
+  for (int i = 0; parts[i] != NULL; i++)
+    {
+      char * part = g_strstrip (parts[i]);
+      if (strlen (part) == 0)
+        continue;
+
+      char * end = NULL;
+      long first = strtol (part, &end, 10);
+      long last = first;
+      if (end == part || first < 0)
+        {
+          ret = false;
+          break;
+        }
+      if (*end == '-')
+        {
+          char * range_end = end + 1;
+          last = strtol (range_end, &end, 10);
+          if (end == range_end || last < first)
+            {
+              ret = false;
+              break;
+            }
+        }
+      if (*end != '\0' || last >= 4096)
+        {
+          ret = false;
+          break;
+        }
+
+      for (long cpu = first; cpu <= last; cpu++)
+        {
+          int val = (int) cpu;
+          g_array_append_val (cpus, val);
+        }
+    }
+  g_strfreev (parts);
+
+  return ret;
+}
+
+/**
+ * Returns a string representation of the given CPU
+ * indices in the format parsed by
+ * cpu_affinity_parse_list().
+ */
+char *
+cpu_affinity_list_to_string (
+  const int * cpus,
+  size_t      num_cpus)
+{
+  GString * gstr = g_string_new (NULL);
+  for (size_t i = 0; i < num_cpus; i++)
+    {
+      /* collapse consecutive CPUs into ranges */
+      size_t j = i;
+      while (j + 1 < num_cpus
+             && cpus[j + 1] == cpus[j] + 1)
+        {
+          j++;
+        }
+
+      if (gstr->len > 0)
+        g_string_append_c (gstr, ',');
+      if (j > i)
+        {
+          g_string_append_printf (
+            gstr, "%d-%d", cpus[i], cpus[j]);
+        }
+      else
+        {
+          g_string_append_printf (
+            gstr, "%d", cpus[i]);
+        }
+      i = j;
+    }
+
+  return g_string_free (gstr, false);
+}
+
+/**
+ * Restricts the calling thread to the given CPUs.
+ *
+ * Threads created afterwards by this thread
+ * inherit the affinity.
+ *
+ * @return Whether successful.
+ */
+bool
+cpu_affinity_pin_current_thread (
+  const int * cpus,
+  size_t      num_cpus)
+{
+#ifdef __linux__
+  if (num_cpus == 0)
+    return false;
+
+  cpu_set_t set;
+  CPU_ZERO (&set);
+  for (size_t i = 0; i < num_cpus; i++)
+    {
+      if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+        return false;
+      CPU_SET ((size_t) cpus[i], &set);
+    }
+
+  int ret =
+    pthread_setaffinity_np (
+      pthread_self (), sizeof (cpu_set_t), &set);
+  if (ret != 0)
+    {
+      g_message (
+        "failed to set CPU affinity: %s",
+        strerror (ret));
+      return false;
+    }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Returns the CPUs in the given setting, or NULL
+ * if the setting is empty or invalid.
+ */
+static GArray *
+get_cpus_from_setting (
+  const char * setting_key)
+{
+  if (ZRYTHM_TESTING)
+    return NULL;
+
+  char * str =
+    g_settings_get_string (
+      S_P_GENERAL_ENGINE, setting_key);
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+  if (!cpu_affinity_parse_list (str, cpus))
+    {
+      g_message (
+        "invalid CPU list for %s: '%s'",
+        setting_key, str);
+      g_array_set_size (cpus, 0);
+    }
+  g_free (str);
+
+  if (cpus->len == 0)
+    {
+      g_array_free (cpus, true);
+      return NULL;
+    }
+
+  return cpus;
+}
+
+/**
+ * Pins the calling thread to the CPUs in the given
+ * setting of the general/engine schema, if not
+ * empty.
+ *
+ * @param thread_name Name to use in messages.
+ *
+ * @return Whether the thread was pinned.
+ */
+bool
+cpu_affinity_pin_current_thread_from_setting (
+  const char * setting_key,
+  const char * thread_name)
+{
+  GArray * cpus =
+    get_cpus_from_setting (setting_key);
+  if (!cpus)
+    return false;
+
+  bool ret =
+    cpu_affinity_pin_current_thread (
+      (int *) cpus->data, cpus->len);
+  char * str =
+    cpu_affinity_list_to_string (
+      (int *) cpus->data, cpus->len);
+  g_message (
+    "%s %s to CPUs %s",
+    ret ? "pinned" : "failed to pin",
+    thread_name, str);
+  g_free (str);
+  g_array_free (cpus, true);
+
+  return ret;
+}
+
+/**
+ * Returns the online CPUs of the system as an
+ * array of int.
+ *
+ * Unlike g_get_num_processors(), this does not
+ * depend on the affinity of the calling thread.
+ */
+GArray *
+cpu_affinity_get_online_cpus (void)
+{
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+
+#ifdef __linux__
+  char * contents = NULL;
+  if (g_file_get_contents (
+        "/sys/devices/system/cpu/online", &contents,
+        NULL, NULL))
+    {
+      bool valid =
+        cpu_affinity_parse_list (
+          g_strstrip (contents), cpus);
+      g_free (contents);
+      if (valid && cpus->len > 0)
+        return cpus;
+
+      g_array_set_size (cpus, 0);
+    }
+
+  long num_cpus = sysconf (_SC_NPROCESSORS_CONF);
+#else
+  long num_cpus = (long) g_get_num_processors ();
+#endif
+  for (int i = 0; i < (int) MAX (num_cpus, 1); i++)
+    {
+      g_array_append_val (cpus, i);
+    }
+
+  return cpus;
+}
+
+/**
+ * Returns the online CPUs except the given ones
+ * as an array of int.
+ *
+ * If no other CPUs are online, all online CPUs
+ * are returned.
+ */
+GArray *
+cpu_affinity_get_cpus_excluding (
+  const int * excluded,
+  size_t      num_excluded)
+{
+  GArray * online = cpu_affinity_get_online_cpus ();
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+  for (guint i = 0; i < online->len; i++)
+    {
+      int cpu = g_array_index (online, int, i);
+      bool is_excluded = false;
+      for (size_t j = 0; j < num_excluded; j++)
+        {
+          if (excluded[j] == cpu)
+            {
+              is_excluded = true;
+              break;
+            }
+        }
+      if (!is_excluded)
+        g_array_append_val (cpus, cpu);
+    }
+
+  if (cpus->len == 0)
+    {
+      g_array_free (cpus, true);
+      return online;
+    }
+
+  g_array_free (online, true);
+
+  return cpus;
+}
+
+/**
+ * Returns the CPUs to use for realtime threads
+ * from the given setting of the general/engine
+ * schema.
+ *
+ * If the setting is empty but housekeeping CPUs
+ * are set, all other online CPUs are returned, so
+ * that realtime threads created by a (pinned)
+ * housekeeping thread don't inherit its affinity.
+ *
+ * @return An array of int, or NULL if the
+ *   affinity should be left alone.
+ */
+GArray *
+cpu_affinity_get_rt_cpus_from_settings (
+  const char * setting_key)
+{
+  GArray * cpus =
+    get_cpus_from_setting (setting_key);
+  if (cpus)
+    return cpus;
+
+  GArray * housekeeping_cpus =
+    get_cpus_from_setting ("housekeeping-cpus");
+  if (!housekeeping_cpus)
+    return NULL;
+
+  /* the calling thread may already be pinned to
+   * the housekeeping CPUs, so don't rely on its
+   * affinity */
+  cpus =
+    cpu_affinity_get_cpus_excluding (
+      (int *) housekeeping_cpus->data,
+      housekeeping_cpus->len);
+  g_array_free (housekeeping_cpus, true);
+
+  return cpus;
+}
+
+/**
+ * Returns the CPUs the calling thread is allowed
+ * to run on as a newly allocated string, or NULL
+ * if unknown.
+ */
+char *
+cpu_affinity_get_current_thread_cpus (void)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO (&set);
+  if (pthread_getaffinity_np (
+        pthread_self (), sizeof (cpu_set_t),
+        &set) != 0)
+    {
+      return NULL;
+    }
+
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+  for (int i = 0; i < CPU_SETSIZE; i++)
+    {
+      if (CPU_ISSET ((size_t) i, &set))
+        g_array_append_val (cpus, i);
+    }
+  char * ret =
+    cpu_affinity_list_to_string (
+      (int *) cpus->data, cpus->len);
+  g_array_free (cpus, true);
+
+  return ret;
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * Returns the CPU the calling thread is running
+ * on, or -1 if unknown.
+ */
+int
+cpu_affinity_get_current_cpu (void)
+{
+#ifdef __linux__
+  return sched_getcpu ();
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Returns the OS thread ID of the calling thread,
+ * or -1 if unknown.
+ */
+long
+cpu_affinity_get_current_thread_id (void)
+{
+#ifdef __linux__
+  return (long) syscall (SYS_gettid);
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Returns the SMT siblings of the given CPU
+ * (including itself) as an array of int, or NULL
+ * if unknown.
+ */
+GArray *
+cpu_affinity_get_smt_siblings (
+  int cpu)
+{
+#ifdef __linux__
+  char * path =
+    g_strdup_printf (
+      "/sys/devices/system/cpu/cpu%d/topology/"
+      "thread_siblings_list", cpu);
+  char * contents = NULL;
+  bool read =
+    g_file_get_contents (
+      path, &contents, NULL, NULL);
+  g_free (path);
+  if (!read)
+    return NULL;
+
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+  bool valid =
+    cpu_affinity_parse_list (
+      g_strstrip (contents), cpus);
+  g_free (contents);
+  if (!valid)
+    {
+      g_array_free (cpus, true);
+      return NULL;
+    }
+
+  return cpus;
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * Returns the number of times the given thread
+ * of this process migrated between CPUs, or -1 if
+ * unknown.
+ */
+long
+cpu_affinity_get_thread_migrations (
+  long thread_id)
+{
+#ifdef __linux__
+  /* only available with CONFIG_SCHED_DEBUG */
+  char * path =
+    g_strdup_printf (
+      "/proc/self/task/%ld/sched", thread_id);
+  char * contents = NULL;
+  bool read =
+    g_file_get_contents (
+      path, &contents, NULL, NULL);
+  g_free (path);
+  if (!read)
+    return -1;
+
+  long ret = -1;
+  const char * key = "se.nr_migrations";
+  char * line = strstr (contents, key);
+  if (line)
+    {
+      char * colon = strchr (line, ':');
+      if (colon)
+        ret = strtol (colon + 1, NULL, 10);
+    }
+  g_free (contents);
+
+  return ret;
+#else
+  return -1;
+#endif
+}
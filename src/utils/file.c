@@ -144,13 +144,26 @@ file_reflink (
 {
 #ifdef __linux__
   int src_fd = g_open (src, O_RDONLY);
-  if (src_fd)
-    return src_fd;
+  if (src_fd < 0)
+    return -1;
   int dest_fd =
-    g_open (dest, O_RDWR | O_CREAT, 0644);
-  if (dest_fd)
-    return src_fd;
-  return ioctl (dest_fd, FICLONE, src_fd);
+    g_open (
+      dest, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (dest_fd < 0)
+    {
+      close (src_fd);
+      return -1;
+    }
+  int ret = ioctl (dest_fd, FICLONE, src_fd);
+  close (src_fd);
+  close (dest_fd);
+
+  /* don't leave an empty file behind so callers
+   * can fall back to copying */
+  if (ret != 0)
+    g_unlink (dest);
+
+  return ret;
 #else
   return -1;
 #endif
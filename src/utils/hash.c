@@ -18,8 +18,11 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "utils/hash.h"
+#include "utils/io.h"
 
 #include <glib.h>
 
@@ -110,6 +113,28 @@ get_xxh3_64_hash (
 
   return ret;
 }
+#else
+static char *
+get_xxh64_hash (
+  FILE * stream)
+{
+  XXH64_state_t * state = XXH64_createState ();
+  g_return_val_if_fail (state, NULL);
+
+  XXH64_reset (state, 0);
+  size_t amt;
+  unsigned char buf[BUF_SIZE];
+  while ((amt = fread(buf, 1, sizeof(buf), stream)) != 0)
+    {
+      XXH64_update (state, buf, amt);
+    }
+  XXH64_hash_t hash = XXH64_digest (state);
+  XXH64_freeState (state);
+
+  return
+    g_strdup_printf (
+      "%016" G_GINT64_MODIFIER "x", (guint64) hash);
+}
 #endif
 
 char *
@@ -141,6 +166,126 @@ hash_get_from_file (
   return ret;
 }
 
+static int
+cmp_paths (
+  const void * a,
+  const void * b)
+{
+  return
+    strcmp (
+      *(const char * const *) a,
+      *(const char * const *) b);
+}
+
+/**
+ * Returns a hash of the contents of the given
+ * directory.
+ *
+ * The relative path and contents of each file are
+ * taken into account, so the hash is the same for
+ * identical directories in different locations.
+ *
+ * HASH_ALGORITHM_XXH3_64 uses XXH64 if XXH3 is not
+ * available, so the hash is always 64-bit.
+ *
+ * @return A newly allocated string, or NULL if
+ *   the directory could not be read.
+ */
+char *
+hash_get_from_dir (
+  const char *  dir,
+  HashAlgorithm algo)
+{
+  g_debug ("calculating hash for dir %s...", dir);
+
+  if (!g_file_test (dir, G_FILE_TEST_IS_DIR))
+    return NULL;
+
+  char ** files =
+    io_get_files_in_dir_ending_in (
+      dir, true, NULL, true);
+  g_return_val_if_fail (files, NULL);
+  size_t num_files = g_strv_length (files);
+  qsort (
+    files, num_files, sizeof (char *), cmp_paths);
+
+  /* combine the relative path and hash of each
+   * file and hash the result */
+  size_t dir_len = strlen (dir);
+  GString * gstr = g_string_new (NULL);
+  for (size_t i = 0; i < num_files; i++)
+    {
+      const char * file = files[i];
+      if (g_file_test (file, G_FILE_TEST_IS_DIR))
+        continue;
+
+      char * file_hash = NULL;
+      if (algo == HASH_ALGORITHM_XXH32)
+        {
+          file_hash =
+            hash_get_from_file (file, algo);
+        }
+      else
+        {
+          FILE * stream = fopen (file, "rb");
+          if (!stream)
+            {
+              g_warning (
+                "failed to open %s", file);
+              g_string_free (gstr, true);
+              g_strfreev (files);
+              return NULL;
+            }
+#if XXH_VERSION_NUMBER >= 800
+          file_hash = get_xxh3_64_hash (stream);
+#else
+          file_hash = get_xxh64_hash (stream);
+#endif
+          fclose (stream);
+        }
+      g_string_append_printf (
+        gstr, "%s:%s\n", &file[dir_len], file_hash);
+      g_free (file_hash);
+    }
+  g_strfreev (files);
+
+  char * ret = NULL;
+  switch (algo)
+    {
+    case HASH_ALGORITHM_XXH3_64:
+      {
+        /* XXH3 is only stable since xxhash 0.8.0,
+         * use XXH64 with older versions to keep a
+         * 64-bit hash */
+#if XXH_VERSION_NUMBER >= 800
+        XXH64_hash_t hash =
+          XXH3_64bits (gstr->str, gstr->len);
+#else
+        XXH64_hash_t hash =
+          XXH64 (gstr->str, gstr->len, 0);
+#endif
+        ret =
+          g_strdup_printf (
+            "%016" G_GINT64_MODIFIER "x",
+            (guint64) hash);
+      }
+      break;
+    case HASH_ALGORITHM_XXH32:
+      {
+        XXH32_hash_t hash =
+          XXH32 (gstr->str, gstr->len, 0);
+        ret =
+          g_strdup_printf ("%08x", (guint) hash);
+      }
+      break;
+    }
+  g_string_free (gstr, true);
+
+  g_debug ("hash for dir %s: %s", dir, ret);
+
+  return ret;
+}
+
 unsigned int
 hash_get_for_struct_full (
   XXH32_state_t *    state,
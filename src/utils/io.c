@@ -364,12 +364,13 @@ append_files_from_dir_ending_in (
   (*files)[*num_files] = NULL;
 }
 
-void
-io_copy_dir (
+static void
+copy_dir (
   const char * destdir_str,
   const char * srcdir_str,
   bool         follow_symlinks,
-  bool         recursive)
+  bool         recursive,
+  bool         reflink)
 {
   GDir * srcdir;
   GError *error = NULL;
@@ -412,13 +413,27 @@ io_copy_dir (
       /* recurse if necessary */
       if (recursive && is_dir)
         {
-          io_copy_dir (
+          copy_dir (
             dest_full_path, src_full_path,
-            follow_symlinks, recursive);
+            follow_symlinks, recursive, reflink);
         }
       /* otherwise if not dir, copy file */
       else if (!is_dir)
         {
+          /* share the data blocks with the source
+           * if the filesystem supports it */
+          if (reflink
+              && !g_file_test (
+                src_full_path,
+                G_FILE_TEST_IS_SYMLINK)
+              && file_reflink (
+                dest_full_path, src_full_path) == 0)
+            {
+              g_free (src_full_path);
+              g_free (dest_full_path);
+              continue;
+            }
+
           GFile * src_file =
             g_file_new_for_path (src_full_path);
           GFile * dest_file =
@@ -455,6 +470,47 @@ io_copy_dir (
   g_dir_close (srcdir);
 }
 
+/**
+ * Copies a directory.
+ *
+ * @note This will not work if \ref destdir_str has
+ *   a file with the same filename as a directory
+ *   in \ref srcdir_str.
+ *
+ * @seealso https://stackoverflow.com/questions/16453739/how-do-i-recursively-copy-a-directory-using-vala
+ */
+void
+io_copy_dir (
+  const char * destdir_str,
+  const char * srcdir_str,
+  bool         follow_symlinks,
+  bool         recursive)
+{
+  copy_dir (
+    destdir_str, srcdir_str, follow_symlinks,
+    recursive, false);
+}
+
+/**
+ * Same as io_copy_dir(), except that files are
+ * first attempted to be reflinked (copy-on-write
+ * clones sharing the data blocks of the source)
+ * and only copied if the filesystem does not
+ * support it.
+ *
+ * Symlinks are not followed.
+ */
+void
+io_reflink_dir (
+  const char * destdir_str,
+  const char * srcdir_str,
+  bool         recursive)
+{
+  copy_dir (
+    destdir_str, srcdir_str, false, recursive,
+    true);
+}
+
 /**
  * Returns a list of the files in the given
  * directory.
@@ -0,0 +1,450 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifndef _WOE32
+#include <sys/mman.h>
+#endif
+
+#include "utils/objects.h"
+#include "utils/rt_memory.h"
+#include "zrythm.h"
+
+/** Whether the current thread runs realtime
+ * code. */
+static __thread bool thread_is_realtime = false;
+
+/* if enabled with the trap_rt_allocations meson
+ * option, replace the allocator with one that
+ * reports allocations done by threads marked as
+ * realtime */
+#if defined (TRAP_RT_ALLOCATIONS) && \
+  defined (__GLIBC__) && \
+  !defined (__SANITIZE_ADDRESS__)
+#define RT_ALLOCATIONS_TRAPPED 1
+
+extern void * __libc_malloc (size_t size);
+extern void * __libc_calloc (
+  size_t nmemb, size_t size);
+extern void * __libc_realloc (
+  void * ptr, size_t size);
+extern void __libc_free (void * ptr);
+
+static volatile gint num_rt_allocs = 0;
+
+/** Whether an allocation was reported since the
+ * last reset. */
+static volatile gint rt_alloc_reported = 0;
+
+static inline void
+check_rt_alloc (void)
+{
+  if (G_LIKELY (!thread_is_realtime))
+    return;
+
+  g_atomic_int_inc (&num_rt_allocs);
+
+  if (!g_atomic_int_compare_and_exchange (
+         &rt_alloc_reported, 0, 1))
+    return;
+
+  /* reporting allocates, so stop tracking this
+   * thread while reporting */
+  thread_is_realtime = false;
+  g_critical (
+    "allocation from a realtime thread");
+  if (ZRYTHM_TESTING)
+    abort ();
+  thread_is_realtime = true;
+}
+
+void *
+malloc (
+  size_t size)
+{
+  check_rt_alloc ();
+  return __libc_malloc (size);
+}
+
+void *
+calloc (
+  size_t nmemb,
+  size_t size)
+{
+  check_rt_alloc ();
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (
+  void * ptr,
+  size_t size)
+{
+  check_rt_alloc ();
+  return __libc_realloc (ptr, size);
+}
+
+void
+free (
+  void * ptr)
+{
+  if (ptr)
+    check_rt_alloc ();
+  __libc_free (ptr);
+}
+#endif
+
+/**
+ * Creates an arena of the given size, split so
+ * that each block size has the same number of
+ * blocks.
+ *
+ * The main consumers are port buffers, whose size
+ * depends on the block length, so every size has
+ * room for as many buffers.
+ *
+ * @param lock Whether to try to lock the memory
+ *   in RAM.
+ */
+RtArena *
+rt_arena_new (
+  size_t size,
+  bool   lock)
+{
+  RtArena * self = object_new (RtArena);
+
+  /* sum of one block of each size */
+  size_t block_sizes_sum =
+    RT_ARENA_MIN_BLOCK_SIZE *
+    ((1 << RT_ARENA_NUM_BLOCK_SIZES) - 1);
+  size_t num_blocks =
+    MAX (size / block_sizes_sum, 1);
+  size_t block_size = RT_ARENA_MIN_BLOCK_SIZE;
+  size_t total_size = 0;
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      pool->block_size = block_size;
+      pool->num_blocks = num_blocks;
+      total_size +=
+        pool->num_blocks * pool->block_size;
+      block_size *= 2;
+    }
+
+  /* align the start to the smallest block size */
+  self->size = total_size;
+  self->mem =
+    g_malloc (total_size + RT_ARENA_MIN_BLOCK_SIZE);
+  char * start =
+    (char *)
+    (((guintptr) self->mem +
+      RT_ARENA_MIN_BLOCK_SIZE - 1) &
+     ~((guintptr) RT_ARENA_MIN_BLOCK_SIZE - 1));
+
+  /* touch every page so that allocations don't
+   * page fault */
+  memset (start, 0, total_size);
+
+#ifndef _WOE32
+  if (lock)
+    {
+      if (mlock (start, total_size) == 0)
+        {
+          self->locked = true;
+        }
+      else
+        {
+          g_message (
+            "failed to lock %zu bytes of realtime "
+            "memory: %s",
+            total_size, strerror (errno));
+        }
+    }
+#endif
+
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      pool->start = start;
+      pool->free_blocks = mpmc_queue_new ();
+      mpmc_queue_reserve (
+        pool->free_blocks, pool->num_blocks);
+      for (size_t j = 0; j < pool->num_blocks; j++)
+        {
+          mpmc_queue_push_back (
+            pool->free_blocks,
+            start + j * pool->block_size);
+        }
+      start += pool->num_blocks * pool->block_size;
+    }
+
+  return self;
+}
+
+/**
+ * Returns a block of at least @p size bytes
+ * aligned to RT_ARENA_MIN_BLOCK_SIZE, or NULL if
+ * no such block is available.
+ *
+ * Realtime safe.
+ */
+void *
+rt_arena_alloc (
+  RtArena * self,
+  size_t    size)
+{
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      if (pool->block_size < size)
+        continue;
+
+      void * block = NULL;
+      if (mpmc_queue_dequeue (
+            pool->free_blocks, &block))
+        {
+          g_atomic_int_inc (&pool->num_used);
+          return block;
+        }
+
+      /* exhausted - don't fall back to a larger
+       * block size to keep those available for
+       * large requests */
+      break;
+    }
+
+  g_atomic_int_inc (&self->num_failed_allocs);
+  return NULL;
+}
+
+/**
+ * Returns the pool the given memory belongs to,
+ * or NULL.
+ */
+static RtArenaPool *
+get_pool (
+  RtArena *    self,
+  const void * mem)
+{
+  const char * ptr = (const char *) mem;
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      if (ptr >= pool->start
+          &&
+          ptr <
+            pool->start +
+              pool->num_blocks * pool->block_size)
+        {
+          return pool;
+        }
+    }
+
+  return NULL;
+}
+
+/**
+ * Returns a block obtained with rt_arena_alloc()
+ * to the arena.
+ *
+ * Realtime safe.
+ */
+void
+rt_arena_free (
+  RtArena * self,
+  void *    block)
+{
+  RtArenaPool * pool = get_pool (self, block);
+  g_return_if_fail (pool);
+  g_return_if_fail (
+    ((size_t) ((char *) block - pool->start) %
+     pool->block_size) == 0);
+
+  mpmc_queue_push_back (pool->free_blocks, block);
+  g_atomic_int_add (&pool->num_used, -1);
+}
+
+/**
+ * Returns whether the given memory belongs to the
+ * arena.
+ */
+bool
+rt_arena_contains (
+  RtArena *    self,
+  const void * mem)
+{
+  return get_pool (self, mem) != NULL;
+}
+
+/**
+ * Logs the usage of each pool.
+ */
+void
+rt_arena_print (
+  RtArena * self)
+{
+  g_message (
+    "realtime arena: %zu bytes (%s), %d failed "
+    "allocations",
+    self->size,
+    self->locked ? "locked" : "not locked",
+    g_atomic_int_get (&self->num_failed_allocs));
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      g_message (
+        "  %zu-byte blocks: %d/%zu used",
+        pool->block_size,
+        g_atomic_int_get (&pool->num_used),
+        pool->num_blocks);
+    }
+}
+
+void
+rt_arena_free_arena (
+  RtArena * self)
+{
+  for (int i = 0; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      RtArenaPool * pool = &self->pools[i];
+      if (g_atomic_int_get (&pool->num_used) > 0)
+        {
+          g_message (
+            "%d %zu-byte realtime blocks still in "
+            "use", pool->num_used,
+            pool->block_size);
+        }
+      object_free_w_func_and_null (
+        mpmc_queue_free, pool->free_blocks);
+    }
+
+#ifndef _WOE32
+  if (self->locked)
+    {
+      munlock (
+        self->pools[0].start, self->size);
+    }
+#endif
+  g_free (self->mem);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Touches the next @p size bytes of the calling
+ * thread's stack so that later use of it does not
+ * page fault.
+ */
+void
+rt_memory_prefault_stack (
+  size_t size)
+{
+  volatile char stack[size];
+
+  /* write through the volatile array so that the
+   * writes are not optimized out */
+  for (size_t i = 0; i < size; i++)
+    stack[i] = 0;
+}
+
+/**
+ * Locks all current and future memory of the
+ * process in RAM.
+ *
+ * @return Whether successful.
+ */
+bool
+rt_memory_lock_all (void)
+{
+#ifndef _WOE32
+  if (mlockall (MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+      g_message (
+        "failed to lock memory: %s",
+        strerror (errno));
+      return false;
+    }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Marks the calling thread as running realtime
+ * code (or not).
+ *
+ * Used to detect allocations from realtime
+ * threads when built with the trap_rt_allocations
+ * option.
+ */
+void
+rt_memory_set_thread_realtime (
+  bool realtime)
+{
+  thread_is_realtime = realtime;
+}
+
+/**
+ * Returns whether the calling thread is marked as
+ * running realtime code.
+ */
+bool
+rt_memory_is_thread_realtime (void)
+{
+  return thread_is_realtime;
+}
+
+/**
+ * Returns the number of allocations (and frees)
+ * done by threads marked as realtime since the
+ * last reset, or -1 if they are not tracked.
+ *
+ * Allocations are only tracked when built with
+ * the trap_rt_allocations option using glibc. The
+ * first allocation is reported as a critical
+ * error and aborts when testing.
+ */
+int
+rt_memory_get_num_rt_allocations (void)
+{
+#ifdef RT_ALLOCATIONS_TRAPPED
+  return g_atomic_int_get (&num_rt_allocs);
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Resets the number of allocations done by
+ * realtime threads.
+ */
+void
+rt_memory_reset_num_rt_allocations (void)
+{
+#ifdef RT_ALLOCATIONS_TRAPPED
+  g_atomic_int_set (&num_rt_allocs, 0);
+  g_atomic_int_set (&rt_alloc_reported, 0);
+#endif
+}
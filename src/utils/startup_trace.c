@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* for pthread_getname_np */
+#define _GNU_SOURCE
+
+#include "zrythm-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "utils/objects.h"
+#include "utils/startup_trace.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
+
+#include <gtk/gtk.h>
+
+StartupTrace *
+startup_trace_new (void)
+{
+  StartupTrace * self = object_new (StartupTrace);
+
+  self->start_time = g_get_monotonic_time ();
+  self->stages =
+    g_array_new (
+      false, true, sizeof (StartupTraceStage));
+  g_mutex_init (&self->lock);
+
+  return self;
+}
+
+static void
+append_stage_json (
+  GString *           gstr,
+  StartupTraceStage * stage)
+{
+  char * name = g_strescape (stage->name, NULL);
+  char * thread_name =
+    g_strescape (stage->thread_name, NULL);
+  g_string_append_printf (
+    gstr,
+    "    { \"name\": \"%s\", \"thread\": \"%s\", "
+    "\"type\": \"%s\", "
+    "\"start_us\": %" G_GINT64_FORMAT,
+    name, thread_name,
+    stage->is_milestone ? "milestone" : "stage",
+    stage->start_time);
+  if (!stage->is_milestone)
+    {
+      if (stage->end_time >= 0)
+        {
+          g_string_append_printf (
+            gstr,
+            ", \"end_us\": %" G_GINT64_FORMAT
+            ", \"duration_us\": %" G_GINT64_FORMAT,
+            stage->end_time,
+            stage->end_time - stage->start_time);
+        }
+      else
+        {
+          g_string_append (
+            gstr, ", \"end_us\": null");
+        }
+    }
+  g_string_append (gstr, " }");
+  g_free (name);
+  g_free (thread_name);
+}
+
+/**
+ * Returns the JSON trace.
+ *
+ * Must be called with the lock held.
+ */
+static char *
+to_json (
+  StartupTrace * self)
+{
+  GString * gstr = g_string_new ("{\n");
+  g_string_append_printf (
+    gstr,
+    "  \"version\": \"%s\",\n"
+    "  \"stages\": [\n",
+    PACKAGE_VERSION);
+  for (guint i = 0; i < self->stages->len; i++)
+    {
+      StartupTraceStage * stage =
+        &g_array_index (
+          self->stages, StartupTraceStage, i);
+      append_stage_json (gstr, stage);
+      g_string_append (
+        gstr,
+        i == self->stages->len - 1 ? "\n" : ",\n");
+    }
+  g_string_append (gstr, "  ]\n}\n");
+
+  return g_string_free (gstr, false);
+}
+
+/**
+ * Writes the trace to the trace file, if any.
+ *
+ * Must be called with the lock held.
+ */
+static void
+write_to_file (
+  StartupTrace * self)
+{
+  if (!self->file_path)
+    return;
+
+  char * json = to_json (self);
+  GError * err = NULL;
+  if (!g_file_set_contents (
+         self->file_path, json, -1, &err))
+    {
+      g_warning (
+        "failed to write startup trace to %s: %s",
+        self->file_path, err->message);
+      g_error_free (err);
+    }
+  g_free (json);
+}
+
+/**
+ * Sets the path of the file to write the trace to
+ * and writes the stages traced so far.
+ *
+ * @param file_path Path, or NULL to use the value
+ *   of \ref STARTUP_TRACE_FILE_ENV or the default
+ *   file in the user log dir.
+ */
+void
+startup_trace_set_file_path (
+  StartupTrace * self,
+  const char *   file_path)
+{
+  g_mutex_lock (&self->lock);
+  g_free (self->file_path);
+  if (file_path)
+    {
+      self->file_path = g_strdup (file_path);
+    }
+  else if (getenv (STARTUP_TRACE_FILE_ENV))
+    {
+      self->file_path =
+        g_strdup (getenv (STARTUP_TRACE_FILE_ENV));
+    }
+  else
+    {
+      char * log_dir =
+        zrythm_get_dir (ZRYTHM_DIR_USER_LOG);
+      self->file_path =
+        g_build_filename (
+          log_dir, STARTUP_TRACE_FILE_BASENAME,
+          NULL);
+      g_free (log_dir);
+    }
+  write_to_file (self);
+  g_mutex_unlock (&self->lock);
+}
+
+static int
+add_stage (
+  StartupTrace * self,
+  const char *   name,
+  bool           is_milestone)
+{
+  gint64 now =
+    g_get_monotonic_time () - self->start_time;
+  char thread_name[16] = "";
+#ifdef __linux__
+  pthread_getname_np (
+    pthread_self (), thread_name,
+    sizeof (thread_name));
+#endif
+  if (ZRYTHM_APP_IS_GTK_THREAD)
+    {
+      strcpy (thread_name, "gtk");
+    }
+  else if (strlen (thread_name) == 0)
+    {
+      strcpy (thread_name, "unknown");
+    }
+
+  StartupTraceStage stage = {
+    .name = g_strdup (name),
+    .thread_name = g_strdup (thread_name),
+    .start_time = now,
+    .end_time = is_milestone ? now : -1,
+    .is_milestone = is_milestone,
+  };
+
+  g_mutex_lock (&self->lock);
+  g_array_append_val (self->stages, stage);
+  int id = (int) self->stages->len - 1;
+  if (is_milestone)
+    write_to_file (self);
+  g_mutex_unlock (&self->lock);
+
+  return id;
+}
+
+/**
+ * Marks the beginning of a stage in the current
+ * thread.
+ *
+ * @return The stage ID to pass to
+ *   startup_trace_end_stage().
+ */
+int
+startup_trace_begin_stage (
+  StartupTrace * self,
+  const char *   name)
+{
+  g_message ("startup stage '%s' started", name);
+
+  return add_stage (self, name, false);
+}
+
+/**
+ * Marks the end of the given stage, logs its
+ * duration and updates the trace file.
+ */
+void
+startup_trace_end_stage (
+  StartupTrace * self,
+  int            stage_id)
+{
+  gint64 now =
+    g_get_monotonic_time () - self->start_time;
+
+  g_mutex_lock (&self->lock);
+  if (stage_id < 0
+      || stage_id >= (int) self->stages->len)
+    {
+      g_mutex_unlock (&self->lock);
+      g_return_if_reached ();
+    }
+  StartupTraceStage * stage =
+    &g_array_index (
+      self->stages, StartupTraceStage, stage_id);
+  stage->end_time = now;
+  g_message (
+    "startup stage '%s' finished in %.3f ms "
+    "(at %.3f ms)",
+    stage->name,
+    (double) (now - stage->start_time) / 1000.0,
+    (double) now / 1000.0);
+  write_to_file (self);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Records a milestone (eg, "ready for project")
+ * at the current time.
+ */
+void
+startup_trace_add_milestone (
+  StartupTrace * self,
+  const char *   name)
+{
+  int id = add_stage (self, name, true);
+
+  g_mutex_lock (&self->lock);
+  StartupTraceStage * stage =
+    &g_array_index (
+      self->stages, StartupTraceStage, id);
+  g_message (
+    "startup milestone '%s' reached at %.3f ms",
+    name, (double) stage->start_time / 1000.0);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Returns the trace as a newly allocated JSON
+ * string.
+ */
+char *
+startup_trace_to_json (
+  StartupTrace * self)
+{
+  g_mutex_lock (&self->lock);
+  char * ret = to_json (self);
+  g_mutex_unlock (&self->lock);
+
+  return ret;
+}
+
+void
+startup_trace_free (
+  StartupTrace * self)
+{
+  for (guint i = 0; i < self->stages->len; i++)
+    {
+      StartupTraceStage * stage =
+        &g_array_index (
+          self->stages, StartupTraceStage, i);
+      g_free (stage->name);
+      g_free (stage->thread_name);
+    }
+  g_array_free (self->stages, true);
+  g_free (self->file_path);
+  g_mutex_clear (&self->lock);
+
+  object_zero_and_free (self);
+}
@@ -26,6 +26,7 @@
 
 #include "actions/actions.h"
 #include "actions/undo_manager.h"
+#include "audio/audio_analyzer.h"
 #include "audio/engine.h"
 #include "audio/router.h"
 #include "audio/quantize_options.h"
@@ -43,6 +44,7 @@
 #include "settings/settings.h"
 #include "utils/arrays.h"
 #include "utils/cairo.h"
+#include "utils/cpu_affinity.h"
 #include "utils/curl.h"
 #include "utils/env.h"
 #include "utils/gtk.h"
@@ -708,6 +710,8 @@ zrythm_free (
     self->plugin_manager);
   object_free_w_func_and_null (
     event_manager_free, self->event_manager);
+  object_free_w_func_and_null (
+    audio_analyzer_free, self->audio_analyzer);
   object_free_w_func_and_null (
     file_manager_free, self->file_manager);
 
@@ -756,13 +760,23 @@ zrythm_new (
   self->testing = testing;
   self->use_optimized_dsp = optimized_dsp;
   self->settings = settings_new ();
+
+  /* pin the main thread before any helper threads
+   * are created so that they inherit its
+   * affinity */
+  cpu_affinity_pin_current_thread_from_setting (
+    "housekeeping-cpus", "main thread");
+
   self->object_utils = object_utils_new ();
   self->recording_manager =
     recording_manager_new ();
   self->plugin_manager = plugin_manager_new ();
   self->symap = symap_new ();
   self->error_domain_symap = symap_new ();
-  self->file_manager = file_manager_new ();
+  /* with a UI, the files are loaded in the
+   * background during startup */
+  self->file_manager = file_manager_new (!have_ui);
+  self->audio_analyzer = audio_analyzer_new ();
   self->cairo_caches = z_cairo_caches_new ();
 
   if (have_ui)
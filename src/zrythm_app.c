@@ -63,6 +63,7 @@
 #ifdef HAVE_GUILE
 #include "guile/guile.h"
 #include "guile/project_generator.h"
+#include "guile/project_renderer.h"
 #endif
 #include "gui/accel.h"
 #include "gui/backend/file_manager.h"
@@ -89,6 +90,7 @@
 #include "utils/math.h"
 #include "utils/object_pool.h"
 #include "utils/objects.h"
+#include "utils/startup_trace.h"
 #include "utils/string.h"
 #include "utils/symap.h"
 #include "utils/ui.h"
@@ -445,6 +447,52 @@ static void on_load_project (
     NULL);
 }
 
+/**
+ * Called in the GTK thread when a background
+ * startup stage finished.
+ */
+static void
+on_background_stage_finished (
+  void * stage_id)
+{
+  startup_trace_end_stage (
+    zrythm_app->startup_trace,
+    GPOINTER_TO_INT (stage_id));
+}
+
+/**
+ * Scans the plugins needed to open a project and
+ * starts scanning the rest in the background.
+ */
+static void
+begin_scan_plugins (
+  ZrythmApp * self)
+{
+  int stage =
+    startup_trace_begin_stage (
+      self->startup_trace, "lv2-plugin-scan");
+  int bg_stage =
+    startup_trace_begin_stage (
+      self->startup_trace,
+      "plugin-scan");
+  plugin_manager_begin_scan_plugins (
+    ZRYTHM->plugin_manager, 0.7, &ZRYTHM->progress,
+    on_background_stage_finished,
+    GINT_TO_POINTER (bg_stage));
+  startup_trace_end_stage (
+    self->startup_trace, stage);
+}
+
+/**
+ * Initializes the services needed to open a
+ * project.
+ *
+ * Only the work needed for that is done here.
+ * Plugins other than LV2 are scanned and the
+ * files of the file browser are loaded in the
+ * background, and their views are refreshed as
+ * results arrive.
+ */
 static void *
 init_thread (
   gpointer data)
@@ -452,6 +500,7 @@ init_thread (
   g_message ("init thread starting...");
 
   ZrythmApp * self = ZRYTHM_APP (data);
+  StartupTrace * trace = self->startup_trace;
 
   zrythm_app_set_progress_status (
     self, _("Initializing settings"), 0.0);
@@ -465,14 +514,25 @@ init_thread (
     PROGRAM_NAME);
   zrythm_app_set_progress_status (
     self, msg, 0.01);
+  int stage =
+    startup_trace_begin_stage (trace, "directories");
   zrythm_init_user_dirs_and_files (ZRYTHM);
   init_recent_projects ();
+  startup_trace_end_stage (trace, stage);
+  startup_trace_set_file_path (trace, NULL);
+
+  stage =
+    startup_trace_begin_stage (trace, "templates");
   zrythm_init_templates (ZRYTHM);
+  startup_trace_end_stage (trace, stage);
 
   /* init log */
   zrythm_app_set_progress_status (
     self, _("Initializing logging system"), 0.02);
+  stage =
+    startup_trace_begin_stage (trace, "logging");
   log_init_with_file (LOG, NULL);
+  startup_trace_end_stage (trace, stage);
 
 #if defined (_WOE32) || defined (__APPLE__)
   g_warning (
@@ -482,22 +542,32 @@ init_thread (
 
   zrythm_app_set_progress_status (
     self, _("Initializing caches"), 0.05);
+  stage =
+    startup_trace_begin_stage (trace, "ui-caches");
   self->ui_caches = ui_caches_new ();
+  startup_trace_end_stage (trace, stage);
 
+  /* load the files of the file browser in the
+   * background */
   zrythm_app_set_progress_status (
     self, _("Initializing file manager"), 0.15);
-  file_manager_load_files (FILE_MANAGER);
+  stage =
+    startup_trace_begin_stage (
+      trace, "file-browser-files");
+  file_manager_begin_load_files (
+    FILE_MANAGER, on_background_stage_finished,
+    GINT_TO_POINTER (stage));
 
   if (!g_settings_get_boolean (
          S_GENERAL, "first-run"))
     {
       zrythm_app_set_progress_status (
         self, _("Scanning plugins"), 0.4);
-      plugin_manager_scan_plugins (
-        ZRYTHM->plugin_manager, 0.7,
-        &ZRYTHM->progress);
+      begin_scan_plugins (self);
     }
 
+  startup_trace_add_milestone (
+    trace, "ready-for-project");
   self->init_finished = true;
 
   g_message ("done");
@@ -520,6 +590,9 @@ idle_func (
     {
       log_init_writer_idle (LOG, 3);
 
+      startup_trace_add_milestone (
+        self->startup_trace, "prompt-for-project");
+
       g_action_group_activate_action (
         G_ACTION_GROUP (self),
         "prompt_for_project", NULL);
@@ -542,9 +615,7 @@ scan_plugins_after_first_run_thread (
 
   ZrythmApp * self = ZRYTHM_APP (data);
 
-  plugin_manager_scan_plugins (
-    ZRYTHM->plugin_manager,
-    0.7, &ZRYTHM->progress);
+  begin_scan_plugins (self);
 
   self->init_finished = true;
 
@@ -1056,6 +1127,8 @@ zrythm_app_startup (
 
   ZrythmApp * self = ZRYTHM_APP (app);
 
+  self->startup_trace = startup_trace_new ();
+
   /* init localization, using system locale if
    * first run */
   GSettings * prefs =
@@ -1441,6 +1514,8 @@ zrythm_app_startup (
 
   /* start initialization in another thread */
   zix_sem_init (&self->progress_status_lock, 1);
+  startup_trace_add_milestone (
+    self->startup_trace, "splash-shown");
   self->init_thread =
     g_thread_new (
       "init_thread", (GThreadFunc) init_thread,
@@ -1725,6 +1800,56 @@ gen_project (
 #endif
 }
 
+/**
+ * Loads the given project without a UI and renders
+ * it to the output file, or runs the given render
+ * script on it.
+ */
+static bool
+render_project (
+  ZrythmApp *  self,
+  const char * prj_path,
+  const char * script_path)
+{
+  if (!script_path)
+    {
+      verify_output_exists (self);
+    }
+  verify_file_exists (prj_path);
+#ifdef HAVE_GUILE
+  /* render offline with the dummy backends unless
+   * overridden */
+  if (!self->audio_backend)
+    {
+      self->audio_backend = g_strdup ("none");
+    }
+  if (!self->midi_backend)
+    {
+      self->midi_backend = g_strdup ("none");
+    }
+
+  ZRYTHM =
+    zrythm_new (NULL, false, false, true);
+  zrythm_init_user_dirs_and_files (ZRYTHM);
+  zrythm_init_templates (ZRYTHM);
+  log_init_with_file (LOG, NULL);
+  guile_init (self->argc, self->argv);
+
+  plugin_manager_scan_plugins (
+    ZRYTHM->plugin_manager, 0.7, &ZRYTHM->progress);
+
+  int res =
+    guile_project_renderer_render_from_file (
+      prj_path, script_path, self->output_file);
+  exit (res);
+#else
+  fprintf (
+    stderr,
+    _("libguile is required for this option\n"));
+  exit (EXIT_FAILURE);
+#endif
+}
+
 static bool
 reset_to_factory (void)
 {
@@ -1780,6 +1905,18 @@ on_handle_local_options (
         opts, "gen-project", "^ay", &filepath);
       gen_project (self, filepath);
     }
+  else if (g_variant_dict_contains (
+             opts, "render"))
+    {
+      char * filepath = NULL;
+      g_variant_dict_lookup (
+        opts, "render", "^ay", &filepath);
+      char * script_path = NULL;
+      g_variant_dict_lookup (
+        opts, "render-script", "^ay",
+        &script_path);
+      render_project (self, filepath, script_path);
+    }
   else if (g_variant_dict_contains (
              opts, "reset-to-factory"))
     {
@@ -1902,6 +2039,18 @@ add_option_entries (
         G_OPTION_ARG_FILENAME, NULL,
         _("Generate a project from SCRIPT-FILE"),
         "SCRIPT-FILE" },
+      { "render", 0,
+        G_OPTION_FLAG_NONE,
+        G_OPTION_ARG_FILENAME, NULL,
+        _("Render PROJECT-FILE offline without a "
+        "UI"),
+        "PROJECT-FILE" },
+      { "render-script", 0,
+        G_OPTION_FLAG_NONE,
+        G_OPTION_ARG_FILENAME, NULL,
+        _("Script to run on the project passed to "
+        "--render instead of rendering the song"),
+        "SCRIPT-FILE" },
       { "pretty", 0, G_OPTION_FLAG_NONE,
         G_OPTION_ARG_NONE, &self->pretty_print,
         _("Print output in user-friendly way"),
@@ -1963,6 +2112,7 @@ add_option_entries (
     _("Examples:\n"
     "  --zpj-to-yaml a.zpj > b.yaml        Convert a a.zpj to YAML and save to b.yaml\n"
     "  --gen-project a.scm -o myproject    Generate myproject from a.scm\n"
+    "  --render a.zpj -o a.flac            Render a.zpj to a.flac\n"
     "  -p --pretty                         Pretty-print current settings\n\n"
     "Please report issues to %s\n"),
     ISSUE_TRACKER_URL);
@@ -2032,6 +2182,8 @@ finalize (
 
   object_free_w_func_and_null (
     ui_caches_free, self->ui_caches);
+  object_free_w_func_and_null (
+    startup_trace_free, self->startup_trace);
 
   /* init curl */
   curl_global_cleanup ();
@@ -3398,6 +3398,174 @@ test_delete_midi_notes ()
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_midi_note_bulk_edits ()
+{
+  test_helper_zrythm_init ();
+
+  Track * midi_track =
+    track_create_empty_with_action (
+      TRACK_TYPE_MIDI, NULL);
+
+  /* create region */
+  Position start, end;
+  position_set_to_bar (&start, 1);
+  position_set_to_bar (&end, 6);
+  ZRegion * r =
+    midi_region_new (
+      &start, &end,
+      track_get_name_hash (midi_track),
+      0, 0);
+  track_add_region (
+    midi_track, r, NULL, 0, F_GEN_NAME,
+    F_NO_PUBLISH_EVENTS);
+  arranger_object_select (
+    (ArrangerObject *) r, F_SELECT, F_NO_APPEND,
+    F_NO_PUBLISH_EVENTS);
+  arranger_selections_action_perform_create (
+    (ArrangerSelections *) TL_SELECTIONS, NULL);
+
+  /* create 4 MIDI notes slightly off the grid */
+  for (int i = 0; i < 4; i++)
+    {
+      position_set_to_bar (&start, 1 + i);
+      position_add_ticks (&start, 10);
+      position_set_to_bar (&end, 2 + i);
+      MidiNote * mn =
+        midi_note_new (
+          &r->id, &start, &end, 45 + i, 90);
+      midi_region_add_midi_note (
+        r, mn, F_NO_PUBLISH_EVENTS);
+    }
+  for (int i = 0; i < r->num_midi_notes; i++)
+    {
+      arranger_object_select (
+        (ArrangerObject *) r->midi_notes[i],
+        F_SELECT, F_APPEND, F_NO_PUBLISH_EVENTS);
+    }
+  arranger_selections_action_perform_create (
+    (ArrangerSelections *) MA_SELECTIONS, NULL);
+
+  double lengths[4];
+  for (int i = 0; i < 4; i++)
+    {
+      ArrangerObject * obj =
+        (ArrangerObject *) r->midi_notes[i];
+      lengths[i] =
+        obj->end_pos.ticks - obj->pos.ticks;
+    }
+
+  /* staccato halves the lengths */
+  guint content_version = r->content_version;
+  arranger_selections_action_perform_edit_midi_function (
+    (ArrangerSelections *) MA_SELECTIONS,
+    MIDI_FUNCTION_STACCATO, NULL);
+  g_assert_cmpuint (
+    r->content_version, !=, content_version);
+  UndoableAction * ua =
+    undo_manager_get_last_action (UNDO_MANAGER);
+  g_assert_nonnull (
+    ((ArrangerSelectionsAction *) ua)->notes_after);
+  g_assert_null (
+    ((ArrangerSelectionsAction *) ua)->sel);
+  for (int i = 0; i < 4; i++)
+    {
+      ArrangerObject * obj =
+        (ArrangerObject *) r->midi_notes[i];
+      g_assert_cmpfloat_with_epsilon (
+        obj->end_pos.ticks - obj->pos.ticks,
+        lengths[i] / 2.0, 0.0001);
+    }
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  for (int i = 0; i < 4; i++)
+    {
+      ArrangerObject * obj =
+        (ArrangerObject *) r->midi_notes[i];
+      g_assert_cmpfloat_with_epsilon (
+        obj->end_pos.ticks - obj->pos.ticks,
+        lengths[i], 0.0001);
+    }
+  undo_manager_redo (UNDO_MANAGER, NULL);
+  undo_manager_undo (UNDO_MANAGER, NULL);
+
+  /* flip vertically */
+  arranger_selections_action_perform_edit_midi_function (
+    (ArrangerSelections *) MA_SELECTIONS,
+    MIDI_FUNCTION_FLIP_VERTICAL, NULL);
+  for (int i = 0; i < 4; i++)
+    {
+      g_assert_cmpuint (
+        r->midi_notes[i]->val, ==, 48 - i);
+    }
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  for (int i = 0; i < 4; i++)
+    {
+      g_assert_cmpuint (
+        r->midi_notes[i]->val, ==, 45 + i);
+    }
+
+  /* flam is not supported and must not add an
+   * undoable action */
+  ua = undo_manager_get_last_action (UNDO_MANAGER);
+  GError * err = NULL;
+  bool ret =
+    arranger_selections_action_perform_edit_midi_function (
+      (ArrangerSelections *) MA_SELECTIONS,
+      MIDI_FUNCTION_FLAM, &err);
+  g_assert_false (ret);
+  g_assert_nonnull (err);
+  g_error_free (err);
+  g_assert_true (
+    undo_manager_get_last_action (UNDO_MANAGER)
+    == ua);
+
+  /* quantize the starts back to the bars */
+  QuantizeOptions * opts =
+    quantize_options_clone (
+      QUANTIZE_OPTIONS_EDITOR);
+  opts->note_length = NOTE_LENGTH_BAR;
+  opts->note_type = NOTE_TYPE_NORMAL;
+  opts->amount = 100;
+  opts->swing = 0;
+  opts->rand_ticks = 0;
+  opts->adj_start = true;
+  opts->adj_end = false;
+  quantize_options_update_quantize_points (opts);
+  content_version = r->content_version;
+  arranger_selections_action_perform_quantize (
+    (ArrangerSelections *) MA_SELECTIONS, opts,
+    NULL);
+  g_assert_cmpuint (
+    r->content_version, !=, content_version);
+  for (int i = 0; i < 4; i++)
+    {
+      ArrangerObject * obj =
+        (ArrangerObject *) r->midi_notes[i];
+      position_set_to_bar (&start, 1 + i);
+      g_assert_cmpfloat_with_epsilon (
+        obj->pos.ticks, start.ticks, 0.0001);
+      g_assert_cmpfloat_with_epsilon (
+        obj->end_pos.ticks - obj->pos.ticks,
+        lengths[i], 0.0001);
+    }
+  content_version = r->content_version;
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpuint (
+    r->content_version, !=, content_version);
+  for (int i = 0; i < 4; i++)
+    {
+      ArrangerObject * obj =
+        (ArrangerObject *) r->midi_notes[i];
+      position_set_to_bar (&start, 1 + i);
+      position_add_ticks (&start, 10);
+      g_assert_cmpfloat_with_epsilon (
+        obj->pos.ticks, start.ticks, 0.0001);
+    }
+  quantize_options_free (opts);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -3405,6 +3573,9 @@ main (int argc, char *argv[])
 
 #define TEST_PREFIX "/actions/arranger_selections/"
 
+  g_test_add_func (
+    TEST_PREFIX "test midi note bulk edits",
+    (GTestFunc) test_midi_note_bulk_edits);
   g_test_add_func (
     TEST_PREFIX "test delete midi notes",
     (GTestFunc) test_delete_midi_notes);
@@ -3231,6 +3231,71 @@ test_copy_after_uninstalling_plugin (void)
 #endif
 }
 
+static void
+test_batch_track_creation (void)
+{
+  test_helper_zrythm_init ();
+
+  char * uris[4] = { NULL, NULL, NULL, NULL };
+  for (int i = 0; i < 3; i++)
+    {
+      char * filepath =
+        g_build_filename (
+          TESTS_SRCDIR, "test.wav", NULL);
+      uris[i] =
+        g_filename_to_uri (filepath, NULL, NULL);
+      g_free (filepath);
+    }
+
+  int num_tracks_before = TRACKLIST->num_tracks;
+  int num_rebuilds_before =
+    ROUTER->num_graph_rebuilds;
+
+  /* dropping multiple files creates a track per
+   * file in one batch */
+  tracklist_handle_file_drop (
+    TRACKLIST, uris, NULL, NULL, NULL, PLAYHEAD,
+    true);
+  g_assert_false (
+    tracklist_is_batching (TRACKLIST));
+  g_assert_false (TRACKLIST->batch_recalc_graph);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==,
+    num_tracks_before + 3);
+  g_assert_cmpint (
+    ROUTER->num_graph_rebuilds, ==,
+    num_rebuilds_before + 1);
+
+  /* undo/redo them as one action */
+  UndoableAction * ua =
+    undo_manager_get_last_action (UNDO_MANAGER);
+  g_assert_cmpint (ua->num_actions, ==, 3);
+  num_rebuilds_before = ROUTER->num_graph_rebuilds;
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==, num_tracks_before);
+  g_assert_false (
+    tracklist_is_batching (TRACKLIST));
+  g_assert_cmpint (
+    ROUTER->num_graph_rebuilds, ==,
+    num_rebuilds_before + 1);
+  num_rebuilds_before = ROUTER->num_graph_rebuilds;
+  undo_manager_redo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==,
+    num_tracks_before + 3);
+  g_assert_cmpint (
+    ROUTER->num_graph_rebuilds, ==,
+    num_rebuilds_before + 1);
+
+  for (int i = 0; i < 3; i++)
+    {
+      g_free (uris[i]);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -3328,6 +3393,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test no visible tracks after track deletion",
     (GTestFunc) test_no_visible_tracks_after_track_deletion);
+  g_test_add_func (
+    TEST_PREFIX "test batch track creation",
+    (GTestFunc) test_batch_track_creation);
 
   return g_test_run ();
 }
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <math.h>
+
+#include "audio/audio_analyzer.h"
+#include "audio/audio_region.h"
+#include "audio/clip.h"
+#include "audio/engine.h"
+#include "audio/pool.h"
+#include "audio/tracklist.h"
+#include "audio/transport.h"
+#include "project.h"
+#include "utils/file.h"
+#include "utils/flags.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+#include <locale.h>
+
+/**
+ * Creates a stereo clip with 1 second of sine,
+ * 1 second of silence and 1 second of sine.
+ */
+static AudioClip *
+create_test_clip (void)
+{
+  long sr = (long) AUDIO_ENGINE->sample_rate;
+  long nframes = sr * 3;
+  float * frames =
+    object_new_n ((size_t) nframes * 2, float);
+  for (long i = 0; i < nframes; i++)
+    {
+      if (i >= sr && i < sr * 2)
+        continue;
+
+      float val =
+        0.5f *
+        sinf (
+          2.f * (float) M_PI * 440.f * (float) i /
+          (float) sr);
+      frames[i * 2] = val;
+      frames[i * 2 + 1] = val;
+    }
+  AudioClip * clip =
+    audio_clip_new_from_float_array (
+      frames, nframes, 2, BIT_DEPTH_32,
+      "analysis test");
+  free (frames);
+
+  return clip;
+}
+
+static void
+test_analyze_frames ()
+{
+  test_helper_zrythm_init ();
+
+  AudioClip * clip = create_test_clip ();
+  long sr = (long) AUDIO_ENGINE->sample_rate;
+  AudioAnalysis * analysis =
+    audio_analysis_new_from_frames (
+      clip->ch_frames, clip->channels,
+      (size_t) clip->num_frames, clip->samplerate,
+      NULL);
+  g_assert_nonnull (analysis);
+
+  g_assert_cmpfloat_with_epsilon (
+    analysis->peak, 0.5f, 0.01f);
+  /* 2/3 of the clip is a sine with RMS
+   * 0.5 / sqrt (2) */
+  g_assert_cmpfloat_with_epsilon (
+    analysis->rms,
+    0.5f / sqrtf (2.f) * sqrtf (2.f / 3.f), 0.01f);
+  g_assert_cmpfloat (
+    analysis->lufs, >, AUDIO_ANALYSIS_MIN_LUFS);
+  g_assert_cmpfloat (analysis->lufs, <, 0.f);
+
+  /* the silent second is found */
+  g_assert_cmpint (
+    analysis->num_silence_ranges, ==, 1);
+  g_assert_cmpint (
+    labs (analysis->silence_ranges[0] - sr), <,
+    1024);
+  g_assert_cmpint (
+    labs (analysis->silence_ranges[1] - sr * 2), <,
+    1024);
+
+  /* onsets at the start of each sine */
+  g_assert_cmpint (analysis->num_onsets, ==, 2);
+  g_assert_cmpint (analysis->onsets[0], ==, 0);
+  g_assert_cmpint (
+    labs (analysis->onsets[1] - sr * 2), <, 1024);
+
+  /* cancelling stops early */
+  volatile gint cancelled = 1;
+  g_assert_null (
+    audio_analysis_new_from_frames (
+      clip->ch_frames, clip->channels,
+      (size_t) clip->num_frames, clip->samplerate,
+      &cancelled));
+
+  audio_analysis_free (analysis);
+  audio_clip_free (clip);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_cache ()
+{
+  test_helper_zrythm_init ();
+
+  AudioClip * clip = create_test_clip ();
+  g_assert_null (
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip));
+
+  audio_analyzer_queue (
+    AUDIO_ANALYZER, clip, NULL, NULL);
+  audio_analyzer_wait (AUDIO_ANALYZER);
+
+  AudioAnalysis * analysis =
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip);
+  g_assert_nonnull (analysis);
+  float lufs = analysis->lufs;
+  int num_onsets = analysis->num_onsets;
+  audio_analysis_free (analysis);
+
+  /* check that the result was saved in the
+   * project and can be loaded by another
+   * analyzer */
+  char * hash = audio_analyzer_get_clip_hash (clip);
+  char * dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_ANALYSIS, F_NOT_BACKUP);
+  char * basename = g_strdup_printf ("%s.ini", hash);
+  char * path =
+    g_build_filename (dir, basename, NULL);
+  g_assert_true (file_exists (path));
+  g_free (path);
+  g_free (basename);
+  g_free (dir);
+  g_free (hash);
+
+  AudioAnalyzer * analyzer = audio_analyzer_new ();
+  analysis =
+    audio_analyzer_get_cached (analyzer, clip);
+  g_assert_nonnull (analysis);
+  g_assert_cmpfloat_with_epsilon (
+    analysis->lufs, lufs, 0.0001f);
+  g_assert_cmpint (
+    analysis->num_onsets, ==, num_onsets);
+  audio_analysis_free (analysis);
+  audio_analyzer_free (analyzer);
+
+  /* a result for another sample rate is not
+   * returned and is replaced after analyzing
+   * again */
+  int samplerate = clip->samplerate;
+  clip->samplerate = samplerate * 2;
+  g_assert_null (
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip));
+  audio_analyzer_queue (
+    AUDIO_ANALYZER, clip, NULL, NULL);
+  audio_analyzer_wait (AUDIO_ANALYZER);
+  analysis =
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip);
+  g_assert_nonnull (analysis);
+  g_assert_cmpint (
+    analysis->samplerate, ==, samplerate * 2);
+  audio_analysis_free (analysis);
+  clip->samplerate = samplerate;
+
+  audio_clip_free (clip);
+
+  test_helper_zrythm_cleanup ();
+}
+
+/**
+ * Drops the test file and returns the clip of the
+ * created region.
+ */
+static AudioClip *
+drop_test_file (void)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  char * uris[2] = {
+    g_filename_to_uri (filepath, NULL, NULL),
+    NULL };
+  g_free (filepath);
+
+  tracklist_handle_file_drop (
+    TRACKLIST, uris, NULL, NULL, NULL, PLAYHEAD,
+    true);
+  g_free (uris[0]);
+
+  Track * track =
+    tracklist_get_last_track (
+      TRACKLIST, TRACKLIST_PIN_OPTION_BOTH, false);
+  g_assert_cmpint (
+    track->lanes[0]->num_regions, ==, 1);
+  return
+    audio_region_get_clip (
+      track->lanes[0]->regions[0]);
+}
+
+static void
+test_analyze_imports ()
+{
+  test_helper_zrythm_init ();
+
+  /* not analyzed when testing by default */
+  g_assert_false (AUDIO_ANALYZER->analyze_imports);
+  int num_clips_before = AUDIO_POOL->num_clips;
+  AudioClip * clip = drop_test_file ();
+  g_assert_cmpint (
+    AUDIO_POOL->num_clips, ==,
+    num_clips_before + 1);
+  audio_analyzer_wait (AUDIO_ANALYZER);
+  g_assert_null (
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip));
+
+  /* opt in */
+  AUDIO_ANALYZER->analyze_imports = true;
+  clip = drop_test_file ();
+  audio_analyzer_wait (AUDIO_ANALYZER);
+  AudioAnalysis * analysis =
+    audio_analyzer_get_cached (
+      AUDIO_ANALYZER, clip);
+  g_assert_nonnull (analysis);
+  audio_analysis_free (analysis);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/audio_analyzer/"
+
+  g_test_add_func (
+    TEST_PREFIX "test analyze frames",
+    (GTestFunc) test_analyze_frames);
+  g_test_add_func (
+    TEST_PREFIX "test cache",
+    (GTestFunc) test_cache);
+  g_test_add_func (
+    TEST_PREFIX "test analyze imports",
+    (GTestFunc) test_analyze_imports);
+
+  return g_test_run ();
+}
@@ -222,6 +222,106 @@ test_detect_bpm (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_clip_peaks (void)
+{
+  test_helper_zrythm_init ();
+
+  Position pos;
+  position_set_to_bar (&pos, 2);
+
+  /* create audio track with region */
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR,
+      "test_start_with_signal.mp3", NULL);
+  SupportedFile * file =
+    supported_file_new_from_path (filepath);
+  int num_tracks_before = TRACKLIST->num_tracks;
+  Track * track =
+    track_create_with_action (
+      TRACK_TYPE_AUDIO, NULL, file, &pos,
+      num_tracks_before, 1, NULL);
+  supported_file_free (file);
+
+  ZRegion * r = track->lanes[0]->regions[0];
+  AudioClip * clip = audio_region_get_clip (r);
+  g_assert_cmpuint (
+    clip->num_peaks, ==,
+    (size_t)
+    (clip->num_frames +
+       AUDIO_CLIP_PEAK_BLOCK_SIZE - 1) /
+      AUDIO_CLIP_PEAK_BLOCK_SIZE);
+
+  /* check that ranges spanning partial and whole
+   * blocks match a full scan */
+  long ranges[][2] = {
+    { 0, 1 },
+    { 3, AUDIO_CLIP_PEAK_BLOCK_SIZE * 3 + 17 },
+    { AUDIO_CLIP_PEAK_BLOCK_SIZE,
+      AUDIO_CLIP_PEAK_BLOCK_SIZE * 5 },
+    { clip->num_frames - 300,
+      clip->num_frames + 300 },
+  };
+  for (size_t i = 0; i < G_N_ELEMENTS (ranges);
+       i++)
+    {
+      long start = ranges[i][0];
+      long end = ranges[i][1];
+      float min, max;
+      audio_clip_get_min_max (
+        clip, start, end, &min, &max);
+
+      float expected_min = 0.f, expected_max = 0.f;
+      for (long j = MAX (start, 0);
+           j < MIN (end, clip->num_frames); j++)
+        {
+          for (unsigned int k = 0;
+               k < clip->channels; k++)
+            {
+              float val =
+                clip->frames[
+                  j * (long) clip->channels +
+                  (long) k];
+              expected_min = MIN (expected_min, val);
+              expected_max = MAX (expected_max, val);
+            }
+        }
+      g_assert_cmpfloat_with_epsilon (
+        min, expected_min, 0.00001f);
+      g_assert_cmpfloat_with_epsilon (
+        max, expected_max, 0.00001f);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_clip_peaks_from_wav (void)
+{
+  test_helper_zrythm_init ();
+
+  /* WAV files are decoded by streaming */
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  AudioClip * clip =
+    audio_clip_new_from_file (filepath);
+  g_free (filepath);
+
+  g_assert_cmpint (clip->num_frames, >, 0);
+  g_assert_cmpuint (
+    clip->num_peaks, ==,
+    (size_t)
+    (clip->num_frames +
+       AUDIO_CLIP_PEAK_BLOCK_SIZE - 1) /
+      AUDIO_CLIP_PEAK_BLOCK_SIZE);
+
+  audio_clip_free (clip);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -241,6 +341,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test detect bpm",
     (GTestFunc) test_detect_bpm);
+  g_test_add_func (
+    TEST_PREFIX "test clip peaks",
+    (GTestFunc) test_clip_peaks);
+  g_test_add_func (
+    TEST_PREFIX "test clip peaks from wav",
+    (GTestFunc) test_clip_peaks_from_wav);
 
   return g_test_run ();
 }
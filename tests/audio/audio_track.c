@@ -91,7 +91,8 @@ test_fill_when_region_starts_on_loop_end ()
     .local_offset = 0,
     .nframes = (nframes_t) nframes, };
   track_fill_events (
-    track, &time_nfo, NULL, ports);
+    track, &time_nfo, NULL, ports,
+    NULL, 0);
   for (int j = 0; j < nframes; j++)
     {
       g_assert_cmpfloat_with_epsilon (
@@ -107,7 +108,8 @@ test_fill_when_region_starts_on_loop_end ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = (nframes_t) nframes;
   track_fill_events (
-    track, &time_nfo, NULL, ports);
+    track, &time_nfo, NULL, ports,
+    NULL, 0);
   for (int j = 0; j < nframes; j++)
     {
       g_assert_true (
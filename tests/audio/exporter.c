@@ -84,7 +84,7 @@ test_export_wav ()
           char * filename =
             g_strdup_printf ("test_wav%d.wav", i);
 
-          ExportSettings settings;
+          ExportSettings settings = {};
           settings.progress_info.has_error = false;
           settings.progress_info.cancelled = false;
           settings.format = AUDIO_FORMAT_WAV;
@@ -204,8 +204,7 @@ bounce_region (
     TL_SELECTIONS, NULL);
 
   /* bounce it */
-  ExportSettings settings;
-  memset (&settings, 0, sizeof (ExportSettings));
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_REGIONS;
   export_settings_set_bounce_defaults (
     &settings, NULL, region->name);
@@ -295,8 +294,7 @@ test_mixdown_midi_routed_to_instrument_track ()
     PORT_CONNECTIONS_MGR, ins_track, NULL);
 
   /* bounce it */
-  ExportSettings settings;
-  memset (&settings, 0, sizeof (ExportSettings));
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_FULL;
   export_settings_set_bounce_defaults (
     &settings, NULL, __func__);
@@ -386,8 +384,7 @@ test_bounce_region_with_first_note (void)
     region->base.loop_start_pos.frames);
 
   /* bounce it */
-  ExportSettings settings;
-  memset (&settings, 0, sizeof (ExportSettings));
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_REGIONS;
   export_settings_set_bounce_defaults (
     &settings, NULL, region->name);
@@ -469,8 +466,7 @@ _test_bounce_midi_track_routed_to_instrument_track (
     PORT_CONNECTIONS_MGR, ins_track, NULL);
 
   /* bounce it */
-  ExportSettings settings;
-  memset (&settings, 0, sizeof (ExportSettings));
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_TRACKS;
   export_settings_set_bounce_defaults (
     &settings, NULL, __func__);
@@ -582,8 +578,7 @@ _test_bounce_instrument_track (
     port->control, 0.5f, 0.00001f);
 
   /* bounce it */
-  ExportSettings settings;
-  memset (&settings, 0, sizeof (ExportSettings));
+  ExportSettings settings = {};
   settings.mode = EXPORT_MODE_TRACKS;
   export_settings_set_bounce_defaults (
     &settings, NULL, __func__);
@@ -721,6 +716,87 @@ _test_bounce_instrument_track (
 #endif
 }
 
+static void
+on_export_progress (
+  ExportSettings * settings,
+  void *           user_data)
+{
+  int * num_calls = (int *) user_data;
+  (*num_calls)++;
+}
+
+static void
+test_export_with_block_length (void)
+{
+  test_helper_zrythm_init ();
+
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file =
+    supported_file_new_from_path (filepath);
+  track_create_with_action (
+    TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD,
+    TRACKLIST->num_tracks, 1, NULL);
+
+  int num_calls = 0;
+  ExportSettings settings = {};
+  settings.format =
+    exporter_get_audio_format_from_extension (
+      "WAV");
+  g_assert_cmpint (
+    settings.format, ==, AUDIO_FORMAT_WAV);
+  settings.artist = g_strdup ("");
+  settings.title = g_strdup ("");
+  settings.genre = g_strdup ("");
+  settings.depth = BIT_DEPTH_16;
+  settings.time_range = TIME_RANGE_LOOP;
+  settings.mode = EXPORT_MODE_FULL;
+  tracklist_mark_all_tracks_for_bounce (
+    TRACKLIST, F_NO_BOUNCE);
+  settings.block_length = 64;
+  settings.progress_cb = on_export_progress;
+  settings.progress_cb_user_data = &num_calls;
+  char * exports_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_EXPORTS, false);
+  settings.file_uri =
+    g_build_filename (
+      exports_dir, "test_block_length.wav", NULL);
+  int ret = exporter_export (&settings);
+  g_assert_cmpint (ret, ==, 0);
+
+  /* one call per block of at most 64 frames */
+  nframes_t loop_frames =
+    (nframes_t)
+    (TRANSPORT->loop_end_pos.frames -
+       TRANSPORT->loop_start_pos.frames);
+  g_assert_cmpint (
+    num_calls, >=, (int) (loop_frames / 64));
+  g_assert_cmpfloat_with_epsilon (
+    settings.progress_info.progress, 1.0, 0.0001);
+
+  z_chromaprint_check_fingerprint_similarity (
+    filepath, settings.file_uri, 83, 6);
+
+  io_remove (settings.file_uri);
+  export_settings_free_members (&settings);
+  g_free (exports_dir);
+  g_free (filepath);
+
+  g_assert_cmpint (
+    exporter_get_audio_format_from_extension (
+      "flac"), ==, AUDIO_FORMAT_FLAC);
+  g_assert_cmpint (
+    exporter_get_audio_format_from_extension (
+      "opus"), ==, AUDIO_FORMAT_OGG_OPUS);
+  g_assert_cmpint (
+    exporter_get_audio_format_from_extension (
+      "xyz"), ==, NUM_AUDIO_FORMATS);
+
+  test_helper_zrythm_cleanup ();
+}
+
 static void
 test_bounce_instrument_track (void)
 {
@@ -744,6 +820,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test export wav",
     (GTestFunc) test_export_wav);
+  g_test_add_func (
+    TEST_PREFIX "test export with block length",
+    (GTestFunc) test_export_with_block_length);
   g_test_add_func (
     TEST_PREFIX "test bounce instrument track",
     (GTestFunc) test_bounce_instrument_track);
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "actions/mixer_selections_action.h"
+#include "audio/engine.h"
+#include "audio/graph.h"
+#include "audio/graph_buffer_pool.h"
+#include "audio/meter.h"
+#include "audio/router.h"
+#include "plugins/plugin.h"
+#include "project.h"
+#include "settings/plugin_settings.h"
+#include "zrythm.h"
+
+#include "tests/helpers/plugin_manager.h"
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+static void
+test_adaptive_thread_count ()
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  Graph * graph = ROUTER->graph;
+  g_assert_true (graph->measure_parallelism);
+
+  int num_cycles =
+    GRAPH_THREAD_SHRINK_DELAY_CYCLES * 2 + 1;
+  for (int i = 0; i < num_cycles; i++)
+    {
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+
+  GraphThreadStats stats;
+  graph_get_thread_stats (graph, &stats);
+  g_message (
+    "parallelism %f, %d/%d active threads",
+    (double) stats.parallelism,
+    stats.num_active_threads, stats.num_threads);
+  g_assert_cmpint (stats.critical_path_ns, >, 0);
+  g_assert_cmpint (
+    stats.work_ns, >=, stats.critical_path_ns);
+  g_assert_cmpfloat (stats.parallelism, >=, 1.f);
+  g_assert_cmpint (
+    stats.num_active_threads, >=, 0);
+  g_assert_cmpint (
+    stats.num_active_threads, <=,
+    stats.num_threads);
+
+  /* the graph keeps working with parked threads
+   * and after waking all of them up */
+  g_atomic_int_set (
+    &graph->num_active_threads, 0);
+  for (int i = 0; i < 8; i++)
+    {
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_pooled_port_buffers ()
+{
+  test_helper_zrythm_init ();
+
+  /* create a track with 2 plugins in series */
+  int track_pos =
+    test_plugin_manager_create_tracks_from_plugin (
+      EG_AMP_BUNDLE_URI, EG_AMP_URI, false, false,
+      1);
+  Track * track = TRACKLIST->tracks[track_pos];
+  PluginSetting * setting =
+    test_plugin_manager_get_plugin_setting (
+      EG_AMP_BUNDLE_URI, EG_AMP_URI, false);
+  bool ret =
+    mixer_selections_action_perform_create (
+      PLUGIN_SLOT_INSERT,
+      track_get_name_hash (track), 1, setting, 1,
+      NULL);
+  g_assert_true (ret);
+  plugin_setting_free (setting);
+
+  /* the input of the first plugin is dead by the
+   * time the second plugin's input is written */
+  GraphBufferPool * pool = ROUTER->graph->buffer_pool;
+  g_assert_nonnull (pool);
+  g_assert_cmpint (pool->num_ports, >=, 2);
+  g_assert_cmpint (pool->num_bufs, >=, 1);
+
+  Plugin * pl = track->channel->inserts[1];
+  Port * in_port = pl->in_ports[0];
+  for (int i = 0; i < pl->num_in_ports; i++)
+    {
+      if (pl->in_ports[i]->id.type == TYPE_AUDIO)
+        {
+          in_port = pl->in_ports[i];
+          break;
+        }
+    }
+  g_assert_nonnull (in_port->own_buf);
+  g_assert_true (in_port->buf != in_port->own_buf);
+  g_assert_true (in_port->buffer_pool == pool);
+  g_assert_true (
+    pool->ports[in_port->buffer_pool_idx] ==
+      in_port);
+
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+  for (int i = 0; i < 8; i++)
+    {
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+
+  /* metered ports use their own buffer */
+  int pool_idx = in_port->buffer_pool_idx;
+  Meter * meter = meter_new_for_port (in_port);
+  g_assert_null (in_port->own_buf);
+  g_assert_null (in_port->buffer_pool);
+  g_assert_null (pool->ports[pool_idx]);
+  meter_free (meter);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/graph/"
+
+  g_test_add_func (
+    TEST_PREFIX "test adaptive thread count",
+    (GTestFunc) test_adaptive_thread_count);
+  g_test_add_func (
+    TEST_PREFIX "test pooled port buffers",
+    (GTestFunc) test_pooled_port_buffers);
+
+  return g_test_run ();
+}
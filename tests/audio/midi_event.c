@@ -21,7 +21,9 @@
 
 #include <stdlib.h>
 
+#include "audio/engine.h"
 #include "audio/midi_event.h"
+#include "project.h"
 
 #include "tests/helpers/zrythm.h"
 
@@ -53,6 +55,48 @@ test_add_note_ons (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_input_frame_offset (void)
+{
+  test_helper_zrythm_init ();
+
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  /* a 1000 usec period */
+  nframes_t nframes =
+    AUDIO_ENGINE->sample_rate / 1000;
+  AUDIO_ENGINE->timestamp_start = 10000;
+  AUDIO_ENGINE->timestamp_end = 11000;
+  gint64 period_start =
+    engine_get_previous_period_start (
+      AUDIO_ENGINE);
+  g_assert_cmpint (period_start, ==, 9000);
+
+  /* events keep their offset in the period they
+   * arrived in */
+  g_assert_cmpuint (
+    engine_get_input_frame_offset (
+      AUDIO_ENGINE, period_start, 9000, nframes),
+    ==, 0);
+  g_assert_cmpuint (
+    engine_get_input_frame_offset (
+      AUDIO_ENGINE, period_start, 9500, nframes),
+    ==, nframes / 2);
+
+  /* early and late events are clamped */
+  g_assert_cmpuint (
+    engine_get_input_frame_offset (
+      AUDIO_ENGINE, period_start, 8000, nframes),
+    ==, 0);
+  g_assert_cmpuint (
+    engine_get_input_frame_offset (
+      AUDIO_ENGINE, period_start, 12000, nframes),
+    ==, nframes - 1);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -63,6 +107,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test add note ons",
     (GTestFunc) test_add_note_ons);
+  g_test_add_func (
+    TEST_PREFIX "test input frame offset",
+    (GTestFunc) test_input_frame_offset);
 
   return g_test_run ();
 }
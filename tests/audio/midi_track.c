@@ -129,7 +129,8 @@ test_fill_midi_events ()
     .local_offset = 0,
     .nframes = BUFFER_SIZE, };
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   ev = &events->queued_events[0];
@@ -154,7 +155,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 1;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -170,7 +172,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 1;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   midi_events_clear (events, F_QUEUED);
@@ -187,7 +190,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -206,7 +210,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -225,7 +230,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
   ev = &events->queued_events[0];
@@ -260,7 +266,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   ev = &events->queued_events[0];
@@ -289,7 +296,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   ev = &events->queued_events[0];
@@ -314,7 +322,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
   ev = &events->queued_events[0];
@@ -371,7 +380,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 512;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -423,7 +433,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 2000;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
   ev = &events->queued_events[0];
@@ -481,7 +492,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
   position_add_ticks (
@@ -502,7 +514,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -520,7 +533,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 0);
 
@@ -538,7 +552,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   ev = &events->queued_events[0];
@@ -560,7 +575,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
   ev = &events->queued_events[0];
@@ -614,7 +630,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   g_assert_cmpint (
     events->num_queued_events, ==, 3);
   ev = &events->queued_events[0];
@@ -659,7 +676,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   midi_events_print (events, F_QUEUED);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
@@ -706,7 +724,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = BUFFER_SIZE;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   midi_events_print (events, F_QUEUED);
   g_assert_cmpint (
     events->num_queued_events, ==, 1);
@@ -746,7 +765,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 30;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   midi_events_print (events, F_QUEUED);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
@@ -766,7 +786,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 10;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   ev = &events->queued_events[0];
   g_assert_cmpuint (
     ev->type, ==, MIDI_EVENT_TYPE_NOTE_ON);
@@ -804,7 +825,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 50;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   midi_events_print (events, F_QUEUED);
   g_assert_cmpint (
     events->num_queued_events, ==, 2);
@@ -848,7 +870,8 @@ test_fill_midi_events ()
   time_nfo.local_offset = 0;
   time_nfo.nframes = 50;
   track_fill_events (
-    track, &time_nfo, events, NULL);
+    track, &time_nfo, events, NULL,
+    NULL, 0);
   midi_events_print (events, F_QUEUED);
   g_assert_cmpint (
     events->num_queued_events, ==, 3);
@@ -869,6 +892,99 @@ test_fill_midi_events ()
   test_helper_zrythm_cleanup ();
 }
 
+/**
+ * Fills the events of each lane separately (as
+ * done by the lanes' graph nodes) and checks that
+ * the merged events match the events filled
+ * serially.
+ */
+static void
+test_fill_midi_events_from_parallel_lanes ()
+{
+  test_helper_zrythm_init ();
+
+  TrackFixture _fixture;
+  TrackFixture * fixture =&_fixture;
+  fixture_set_up (fixture);
+
+  Track * track = fixture->midi_track;
+  MidiEvents * events = fixture->events;
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+
+  /* add a region with a note in each lane */
+  const int num_lanes = 4;
+  Position start_pos, end_pos;
+  position_init (&start_pos);
+  position_set_to_bar (&end_pos, 3);
+  for (int i = 0; i < num_lanes; i++)
+    {
+      ZRegion * r =
+        midi_region_new (
+          &start_pos, &end_pos,
+          track_get_name_hash (track), i, 0);
+      MidiNote * mn =
+        midi_note_new (
+          &r->id, &start_pos, &end_pos,
+          (midi_byte_t) (40 + i), 90);
+      midi_region_add_midi_note (r, mn, 0);
+      track_add_region (
+        track, r, NULL, i, F_GEN_NAME,
+        F_NO_PUBLISH_EVENTS);
+    }
+  g_assert_cmpint (track->num_lanes, >, num_lanes);
+
+  /* fill serially */
+  EngineProcessTimeInfo time_nfo = {
+    .g_start_frames = 0,
+    .local_offset = 0,
+    .nframes = BUFFER_SIZE, };
+  track->num_lanes_in_graph = 0;
+  track_fill_events (
+    track, &time_nfo, events, NULL,
+    NULL, 0);
+  g_assert_cmpint (
+    events->num_queued_events, ==, num_lanes);
+
+  /* fill each lane separately and merge */
+  MidiEvents * merged_events = midi_events_new ();
+  for (int i = 0; i < track->num_lanes; i++)
+    {
+      TrackLane * lane = track->lanes[i];
+      track_lane_allocate_bufs (lane);
+      midi_events_clear (
+        lane->midi_events, F_QUEUED);
+      track_fill_lane_events (
+        track, i, &time_nfo, NULL);
+    }
+  track->num_lanes_in_graph = track->num_lanes;
+  track_fill_events (
+    track, &time_nfo, merged_events, NULL,
+    NULL, 0);
+  track->num_lanes_in_graph = 0;
+
+  g_assert_cmpint (
+    merged_events->num_queued_events, ==,
+    events->num_queued_events);
+  for (int i = 0; i < events->num_queued_events;
+       i++)
+    {
+      g_assert_true (
+        midi_events_are_equal (
+          &events->queued_events[i],
+          &merged_events->queued_events[i]));
+    }
+
+  midi_events_free (merged_events);
+  midi_events_free (events);
+
+  test_helper_zrythm_cleanup ();
+}
+
 #ifdef HAVE_HELM
 static void
 test_fill_midi_events_from_engine ()
@@ -956,6 +1072,10 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test fill midi events",
     (GTestFunc) test_fill_midi_events);
+  g_test_add_func (
+    TEST_PREFIX
+    "test fill midi events from parallel lanes",
+    (GTestFunc) test_fill_midi_events_from_parallel_lanes);
 #ifdef HAVE_HELM
   g_test_add_func (
     TEST_PREFIX "test fill midi events from engine",
@@ -20,12 +20,20 @@
 #include "zrythm-test-config.h"
 
 #include "actions/tracklist_selections.h"
+#include "audio/control_port.h"
+#include "audio/fader.h"
+#include "audio/master_track.h"
 #include "audio/midi_region.h"
+#include "audio/modulation_matrix.h"
+#include "audio/modulator_track.h"
+#include "audio/port_connections_manager.h"
 #include "audio/region.h"
+#include "audio/router.h"
 #include "audio/transport.h"
 #include "project.h"
 #include "utils/flags.h"
 #include "utils/io.h"
+#include "utils/math.h"
 #include "zrythm.h"
 
 #include "tests/helpers/project.h"
@@ -203,6 +211,155 @@ test_get_hash (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_control_port_change_batch (void)
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  Fader * fader = P_MASTER_TRACK->channel->fader;
+  Port * amp = fader->amp;
+  Port * balance = fader->balance;
+
+  /* changes to the same port are coalesced */
+  ControlPortChangeBatch * batch =
+    control_port_change_batch_new ();
+  control_port_change_batch_add_port_val (
+    batch, amp, 0.2f, false);
+  control_port_change_batch_add_port_val (
+    batch, balance, 0.3f, false);
+  control_port_change_batch_add_port_val (
+    batch, amp, 0.4f, false);
+  g_assert_cmpint (batch->header.num_changes, ==, 2);
+  g_assert_true (
+    router_queue_control_port_changes (
+      ROUTER, batch));
+
+  /* not applied until the next cycle */
+  g_assert_false (
+    math_floats_equal (amp->control, 0.4f));
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  g_assert_cmpfloat_with_epsilon (
+    amp->control, 0.4f, FLT_EPSILON);
+  g_assert_cmpfloat_with_epsilon (
+    balance->control, 0.3f, FLT_EPSILON);
+
+  /* overflowing the queue drops changes and
+   * accounts for them */
+  int num_dropped_before =
+    ROUTER->num_dropped_ctrl_port_changes;
+  float last_queued_val = 0.f;
+  for (int i = 0; i < 100000; i++)
+    {
+      ControlPortChange change = { 0 };
+      control_port_change_set_port (&change, amp);
+      change.real_val = (float) (i % 100) / 100.f;
+      if (!router_queue_control_port_change (
+             ROUTER, &change))
+        break;
+
+      last_queued_val = change.real_val;
+    }
+  g_assert_cmpint (
+    ROUTER->num_dropped_ctrl_port_changes, ==,
+    num_dropped_before + 1);
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  g_assert_cmpfloat_with_epsilon (
+    amp->control, last_queued_val, FLT_EPSILON);
+
+  /* changes for ports that were removed after
+   * being queued are dropped */
+  float amp_val = amp->control;
+  ControlPortChange change = { 0 };
+  control_port_change_set_port (&change, amp);
+  change.port_id.track_name_hash++;
+  change.real_val = amp_val > 0.5f ? 0.1f : 0.9f;
+  g_assert_true (
+    router_queue_control_port_change (
+      ROUTER, &change));
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  g_assert_cmpfloat_with_epsilon (
+    amp->control, amp_val, FLT_EPSILON);
+
+  control_port_change_batch_free (batch);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_modulation_matrix (void)
+{
+  test_helper_zrythm_init ();
+
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  /* route the first macro to the master balance */
+  ModulatorMacroProcessor * macro =
+    P_MODULATOR_TRACK->modulator_macros[0];
+  Port * balance =
+    P_MASTER_TRACK->channel->fader->balance;
+  port_set_control_value (
+    macro->macro, 1.f, F_NOT_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
+  port_connections_manager_ensure_connect (
+    PORT_CONNECTIONS_MGR, &macro->cv_out->id,
+    &balance->id, 0.5f, F_NOT_LOCKED, F_ENABLE);
+  router_recalc_graph (ROUTER, F_NOT_SOFT);
+  g_assert_nonnull (ROUTER->graph->mod_matrix);
+  g_assert_cmpint (
+    ROUTER->graph->mod_matrix->num_dests, ==, 1);
+  g_assert_cmpint (
+    ROUTER->graph->mod_matrix->num_routes, ==, 1);
+
+  float base_value = balance->base_value;
+  float cv_val = macro->cv_out->maxf;
+  float expected =
+    CLAMP (
+      base_value +
+        (balance->maxf - balance->minf) * 0.5f *
+        cv_val * 0.5f,
+      balance->minf, balance->maxf);
+
+  /* the modulation is calculated at the end of
+   * the cycle and applied on the next one */
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  g_assert_cmpfloat_with_epsilon (
+    balance->control, expected, 0.0001f);
+  g_assert_cmpfloat_with_epsilon (
+    balance->base_value, base_value, FLT_EPSILON);
+
+  /* disconnecting removes the route */
+  port_connections_manager_ensure_disconnect (
+    PORT_CONNECTIONS_MGR, &macro->cv_out->id,
+    &balance->id);
+  router_recalc_graph (ROUTER, F_NOT_SOFT);
+  g_assert_cmpint (
+    ROUTER->graph->mod_matrix->num_dests, ==, 0);
+
+  /* the port goes back to its base value */
+  g_assert_cmpfloat_with_epsilon (
+    balance->modulation_offset, 0.f, FLT_EPSILON);
+  g_assert_cmpfloat_with_epsilon (
+    balance->control, base_value, FLT_EPSILON);
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  g_assert_cmpfloat_with_epsilon (
+    balance->control, base_value, FLT_EPSILON);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -213,6 +370,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test get hash",
     (GTestFunc) test_get_hash);
+  g_test_add_func (
+    TEST_PREFIX "test control port change batch",
+    (GTestFunc) test_control_port_change_batch);
+  g_test_add_func (
+    TEST_PREFIX "test modulation matrix",
+    (GTestFunc) test_modulation_matrix);
 #if 0
   g_test_add_func (
     TEST_PREFIX "test port disconnect",
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "audio/engine.h"
+#include "audio/graph.h"
+#include "audio/prerenderer.h"
+#include "audio/router.h"
+#include "audio/transport.h"
+#include "plugins/plugin.h"
+#include "project.h"
+#include "zrythm.h"
+
+#include "tests/helpers/plugin_manager.h"
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+static void
+process_cycles (
+  int num_cycles)
+{
+  for (int i = 0; i < num_cycles; i++)
+    {
+      /* give the rendering thread time to catch
+       * up */
+      g_usleep (2000);
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+}
+
+static void
+test_render_ahead ()
+{
+  test_helper_zrythm_init ();
+
+  int track_pos =
+    test_plugin_manager_create_tracks_from_plugin (
+      EG_AMP_BUNDLE_URI, EG_AMP_URI, false, false,
+      1);
+  Track * track = TRACKLIST->tracks[track_pos];
+
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  AUDIO_ENGINE->anticipative_rendering = true;
+  router_recalc_graph (ROUTER, false);
+
+  Prerenderer * prerenderer =
+    ROUTER->graph->prerenderer;
+  g_assert_nonnull (prerenderer);
+  PrerenderTrack * pt = track->prerender;
+  g_assert_nonnull (pt);
+  g_assert_cmpint (pt->num_nodes, >, 0);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), ==,
+    PRERENDER_TRACK_STATE_LIVE);
+
+  /* stays live while stopped */
+  process_cycles (PRERENDERER_HOLD_CYCLES + 1);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), ==,
+    PRERENDER_TRACK_STATE_LIVE);
+
+  /* rendered ahead while rolling */
+  transport_request_roll (TRANSPORT);
+  process_cycles (PRERENDERER_HOLD_CYCLES + 16);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), !=,
+    PRERENDER_TRACK_STATE_LIVE);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->read_idx), >, 0);
+
+  /* the handover never silences the track */
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->num_underruns), ==, 0);
+
+  /* goes back to live processing when the user
+   * changes a parameter */
+  Plugin * pl = track->channel->inserts[0];
+  g_assert_nonnull (pl);
+  Port * port = NULL;
+  for (int i = 0; i < pl->num_in_ports; i++)
+    {
+      if (pl->in_ports[i]->id.type == TYPE_CONTROL)
+        {
+          port = pl->in_ports[i];
+          break;
+        }
+    }
+  g_assert_nonnull (port);
+  port_set_control_value (
+    port, port->control > 0.5f ? 0.f : 1.f, true,
+    false);
+  process_cycles (4);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), ==,
+    PRERENDER_TRACK_STATE_LIVE);
+
+  /* and is handed back to the prerenderer */
+  process_cycles (PRERENDERER_HOLD_CYCLES + 16);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), !=,
+    PRERENDER_TRACK_STATE_LIVE);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->num_underruns), ==, 0);
+
+  transport_request_pause (TRANSPORT);
+  process_cycles (4);
+  g_assert_cmpint (
+    g_atomic_int_get (&pt->state), ==,
+    PRERENDER_TRACK_STATE_LIVE);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/prerenderer/"
+
+  g_test_add_func (
+    TEST_PREFIX "test render ahead",
+    (GTestFunc) test_render_ahead);
+
+  return g_test_run ();
+}
@@ -20,8 +20,10 @@
 #include "zrythm-test-config.h"
 
 #include "actions/tracklist_selections.h"
+#include "audio/midi_note.h"
 #include "audio/midi_region.h"
 #include "audio/region.h"
+#include "audio/region_index.h"
 #include "audio/transport.h"
 #include "project.h"
 #include "utils/flags.h"
@@ -234,6 +236,216 @@ test_timeline_frames_to_local (void)
   g_assert_cmpint (localp, ==, 13000);
 }
 
+static int
+count_hits_in_index (
+  const RegionIndex * index,
+  RegionIndexCursor * cursor,
+  long                start,
+  long                end)
+{
+  int lo, hi;
+  region_index_get_candidates (
+    index, cursor, start, end, &lo, &hi);
+  int num_hits = 0;
+  for (int i = lo; i < hi; i++)
+    {
+      if (region_is_hit_by_range (
+            index->regions[i], start, end, true))
+        num_hits++;
+    }
+  return num_hits;
+}
+
+static void
+test_region_index (void)
+{
+  RegionFixture _fixture;
+  RegionFixture * fixture =
+    &_fixture;
+  fixture_set_up (fixture);
+
+  /* overlapping regions, not sorted by start */
+  const int bars[][2] = {
+    { 5, 9 }, { 1, 3 }, { 2, 12 }, { 7, 8 },
+    { 3, 4 }, { 10, 11 } };
+  const int num_regions = G_N_ELEMENTS (bars);
+  ZRegion * regions[num_regions];
+  for (int i = 0; i < num_regions; i++)
+    {
+      Position start_pos, end_pos;
+      position_set_to_bar (&start_pos, bars[i][0]);
+      position_set_to_bar (&end_pos, bars[i][1]);
+      regions[i] =
+        midi_region_new (
+          &start_pos, &end_pos, 0, 0, i);
+    }
+
+  RegionIndex index;
+  memset (&index, 0, sizeof (RegionIndex));
+  g_assert_false (region_index_acquire (&index));
+  region_index_rebuild (
+    &index, regions, num_regions);
+  g_assert_true (region_index_acquire (&index));
+
+  /* compare against a linear scan while moving
+   * forward, as during playback */
+  RegionIndexCursor cursor;
+  memset (&cursor, 0, sizeof (RegionIndexCursor));
+  Position end_pos;
+  position_set_to_bar (&end_pos, 13);
+  const long step = 4000;
+  for (long start = 0; start < end_pos.frames;
+       start += step)
+    {
+      long end = start + step;
+      int expected = 0;
+      for (int i = 0; i < num_regions; i++)
+        {
+          if (region_is_hit_by_range (
+                regions[i], start, end, true))
+            expected++;
+        }
+      g_assert_cmpint (
+        count_hits_in_index (
+          &index, &cursor, start, end),
+        ==, expected);
+      g_assert_cmpint (
+        count_hits_in_index (
+          &index, NULL, start, end),
+        ==, expected);
+    }
+
+  /* jump back */
+  Position pos;
+  position_set_to_bar (&pos, 2);
+  g_assert_cmpint (
+    count_hits_in_index (
+      &index, &cursor, pos.frames, pos.frames),
+    ==, 2);
+
+  /* region ending last that starts before bar
+   * 6 */
+  position_set_to_bar (&pos, 6);
+  g_assert_true (
+    region_index_get_latest_ending_before (
+      &index, pos.frames) == regions[2]);
+  position_set_to_bar (&pos, 1);
+  g_assert_true (
+    region_index_get_latest_ending_before (
+      &index, pos.frames - 1) == NULL);
+  region_index_release (&index);
+
+  /* another index (eg, of another lane) */
+  RegionIndex other_index;
+  memset (&other_index, 0, sizeof (RegionIndex));
+  region_index_rebuild (
+    &other_index, regions, 2);
+
+  /* moving a region makes the owner's index
+   * unusable until it is refreshed, without
+   * affecting other indices */
+  position_set_to_bar (&pos, 20);
+  arranger_object_set_position (
+    (ArrangerObject *) regions[5], &pos,
+    ARRANGER_OBJECT_POSITION_TYPE_END,
+    F_NO_VALIDATE);
+  region_index_mark_positions_changed (&index);
+  g_assert_false (region_index_acquire (&index));
+  g_assert_true (
+    region_index_acquire (&other_index));
+
+  /* a cursor for another index is not reused */
+  g_assert_cmpint (
+    count_hits_in_index (
+      &other_index, &cursor, pos.frames,
+      pos.frames),
+    ==, 0);
+  region_index_release (&other_index);
+
+  region_index_refresh (
+    &index, regions, num_regions);
+  g_assert_true (region_index_acquire (&index));
+  position_set_to_bar (&pos, 15);
+  g_assert_cmpint (
+    count_hits_in_index (
+      &index, &cursor, pos.frames, pos.frames),
+    ==, 1);
+  region_index_release (&index);
+
+  region_index_free_members (&index);
+  region_index_free_members (&other_index);
+  for (int i = 0; i < num_regions; i++)
+    {
+      arranger_object_free (
+        (ArrangerObject *) regions[i]);
+    }
+}
+
+static void
+test_content_version (void)
+{
+  track_create_empty_with_action (
+    TRACK_TYPE_MIDI, NULL);
+  Track * track =
+    TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+
+  Position pos, end_pos;
+  position_init (&pos);
+  position_set_to_bar (&end_pos, 4);
+  ZRegion * region =
+    midi_region_new (
+      &pos, &end_pos,
+      track_get_name_hash (track), 0, 0);
+  track_add_region (
+    track, region, NULL, 0, F_GEN_NAME,
+    F_NO_PUBLISH_EVENTS);
+
+  /* adding a note changes the contents */
+  guint version = region->content_version;
+  position_set_to_bar (&end_pos, 2);
+  MidiNote * mn =
+    midi_note_new (
+      &region->id, &pos, &end_pos, 60,
+      VELOCITY_DEFAULT);
+  midi_region_add_midi_note (
+    region, mn, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpuint (
+    region->content_version, !=, version);
+
+  /* changing a clone doesn't */
+  version = region->content_version;
+  MidiNote * clone =
+    (MidiNote *)
+    arranger_object_clone ((ArrangerObject *) mn);
+  midi_note_set_val (clone, 62);
+  g_assert_cmpuint (
+    region->content_version, ==, version);
+  arranger_object_free ((ArrangerObject *) clone);
+
+  /* changing the note does */
+  midi_note_set_val (mn, 62);
+  g_assert_cmpuint (
+    region->content_version, !=, version);
+  version = region->content_version;
+  position_set_to_bar (&pos, 3);
+  arranger_object_set_position (
+    (ArrangerObject *) mn, &pos,
+    ARRANGER_OBJECT_POSITION_TYPE_END,
+    F_NO_VALIDATE);
+  g_assert_cmpuint (
+    region->content_version, !=, version);
+
+  /* moving the region doesn't */
+  version = region->content_version;
+  position_set_to_bar (&pos, 2);
+  arranger_object_set_position (
+    (ArrangerObject *) region, &pos,
+    ARRANGER_OBJECT_POSITION_TYPE_START,
+    F_NO_VALIDATE);
+  g_assert_cmpuint (
+    region->content_version, ==, version);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -255,6 +467,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test_timeline_frames_to_local",
     (GTestFunc) test_timeline_frames_to_local);
+  g_test_add_func (
+    TEST_PREFIX "test region index",
+    (GTestFunc) test_region_index);
+  g_test_add_func (
+    TEST_PREFIX "test content version",
+    (GTestFunc) test_content_version);
 
   return g_test_run ();
 }
@@ -62,13 +62,13 @@ test_process_master ()
     .local_offset = 0,
     .nframes = local_offset, };
   track_processor_process (
-    P_MASTER_TRACK->processor, &time_nfo);
+    P_MASTER_TRACK->processor, &time_nfo, NULL, 0);
   time_nfo.g_start_frames = local_offset;
   time_nfo.local_offset = local_offset;
   time_nfo.nframes =
     AUDIO_ENGINE->block_length - local_offset;
   track_processor_process (
-    P_MASTER_TRACK->processor, &time_nfo);
+    P_MASTER_TRACK->processor, &time_nfo, NULL, 0);
 
   for (nframes_t i = 0;
        i < AUDIO_ENGINE->block_length;
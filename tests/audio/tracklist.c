@@ -21,9 +21,13 @@
 
 #include <math.h>
 
+#include "actions/undo_manager.h"
+#include "audio/audio_region.h"
 #include "audio/automation_region.h"
+#include "audio/pool.h"
 #include "audio/tracklist.h"
 #include "project.h"
+#include "utils/file.h"
 #include "utils/flags.h"
 #include "zrythm.h"
 
@@ -119,6 +123,125 @@ test_swap_with_automation_regions ()
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_drop_multiple_files ()
+{
+  test_helper_zrythm_init ();
+
+  const char * filenames[] = {
+    "test.wav", "test_start_with_signal.mp3", };
+  char * uris[3] = { NULL, NULL, NULL };
+  for (int i = 0; i < 2; i++)
+    {
+      char * filepath =
+        g_build_filename (
+          TESTS_SRCDIR, filenames[i], NULL);
+      uris[i] =
+        g_filename_to_uri (filepath, NULL, NULL);
+      g_free (filepath);
+    }
+
+  int num_tracks_before = TRACKLIST->num_tracks;
+  int num_clips_before = AUDIO_POOL->num_clips;
+  tracklist_handle_file_drop (
+    TRACKLIST, uris, NULL, NULL, NULL, PLAYHEAD,
+    true);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==,
+    num_tracks_before + 2);
+  g_assert_cmpint (
+    AUDIO_POOL->num_clips, ==,
+    num_clips_before + 2);
+
+  /* check that the clips were moved to the
+   * pool */
+  for (int i = 0; i < 2; i++)
+    {
+      Track * track =
+        TRACKLIST->tracks[num_tracks_before + i];
+      g_assert_cmpint (
+        track->type, ==, TRACK_TYPE_AUDIO);
+      g_assert_cmpint (
+        track->lanes[0]->num_regions, ==, 1);
+      AudioClip * clip =
+        audio_region_get_clip (
+          track->lanes[0]->regions[0]);
+      g_assert_nonnull (clip);
+      char * path =
+        audio_clip_get_path_in_pool (
+          clip, F_NOT_BACKUP);
+      g_assert_true (file_exists (path));
+      g_free (path);
+    }
+
+  /* check that the temporary files were not
+   * left behind */
+  char * tmp_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_IMPORT_TMP,
+      F_NOT_BACKUP);
+  g_assert_false (file_exists (tmp_dir));
+  g_free (tmp_dir);
+
+  /* the whole drop is undone at once */
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==, num_tracks_before);
+  undo_manager_redo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==,
+    num_tracks_before + 2);
+
+  test_project_save_and_reload ();
+
+  g_free (uris[0]);
+  g_free (uris[1]);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_reject_invalid_drop ()
+{
+  test_helper_zrythm_init ();
+
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  char * uris[3] = { NULL, NULL, NULL };
+  uris[0] = g_filename_to_uri (filepath, NULL, NULL);
+  uris[1] = g_filename_to_uri (filepath, NULL, NULL);
+  g_free (filepath);
+
+  Track * track =
+    track_create_empty_with_action (
+      TRACK_TYPE_AUDIO, NULL);
+  int num_tracks_before = TRACKLIST->num_tracks;
+  int num_clips_before = AUDIO_POOL->num_clips;
+  int undo_top_before =
+    UNDO_MANAGER->undo_stack->stack->top;
+
+  /* only 1 file can be dropped on an existing
+   * track */
+  tracklist_handle_file_drop (
+    TRACKLIST, uris, NULL, track, NULL, PLAYHEAD,
+    true);
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==, num_tracks_before);
+  g_assert_cmpint (
+    AUDIO_POOL->num_clips, ==, num_clips_before);
+  g_assert_cmpint (
+    track->lanes[0]->num_regions, ==, 0);
+  g_assert_cmpint (
+    UNDO_MANAGER->undo_stack->stack->top, ==,
+    undo_top_before);
+
+  g_free (uris[0]);
+  g_free (uris[1]);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -131,6 +254,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test swap with automation regions",
     (GTestFunc) test_swap_with_automation_regions);
+  g_test_add_func (
+    TEST_PREFIX "test drop multiple files",
+    (GTestFunc) test_drop_multiple_files);
+  g_test_add_func (
+    TEST_PREFIX "test reject invalid drop",
+    (GTestFunc) test_reject_invalid_drop);
 
   return g_test_run ();
 }
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <math.h>
+
+#include "audio/clip.h"
+#include "audio/encoder.h"
+#include "audio/engine.h"
+#include "utils/audio.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+/** Length of the generated file in seconds. */
+#define FILE_LENGTH_SECONDS 600
+
+#define NUM_CHANNELS 2
+
+/**
+ * Writes a long sine wave file at the given sample
+ * rate and returns its path.
+ */
+static char *
+write_long_file (
+  const char * dir,
+  uint32_t     samplerate)
+{
+  long nframes =
+    (long) samplerate * FILE_LENGTH_SECONDS;
+  float * frames =
+    object_new_n (
+      (size_t) nframes * NUM_CHANNELS, float);
+  for (long i = 0; i < nframes; i++)
+    {
+      float val =
+        0.5f *
+        sinf (
+          2.f * (float) M_PI * 440.f * (float) i /
+          (float) samplerate);
+      for (int j = 0; j < NUM_CHANNELS; j++)
+        {
+          frames[i * NUM_CHANNELS + j] = val;
+        }
+    }
+
+  char * basename =
+    g_strdup_printf ("long_%u.wav", samplerate);
+  char * filepath =
+    g_build_filename (dir, basename, NULL);
+  g_free (basename);
+  int ret =
+    audio_write_raw_file (
+      frames, 0, nframes, samplerate, false,
+      BIT_DEPTH_24, NUM_CHANNELS, filepath);
+  g_assert_cmpint (ret, ==, 0);
+  free (frames);
+
+  return filepath;
+}
+
+/**
+ * Decodes the file the old way (whole file at
+ * once) and returns the number of frames.
+ */
+static long
+decode_whole_file (
+  const char * filepath)
+{
+  AudioEncoder * enc =
+    audio_encoder_new_from_file (filepath);
+  audio_encoder_decode (
+    enc, (int) AUDIO_ENGINE->sample_rate, false);
+  long num_frames = (long) enc->num_out_frames;
+
+  /* the clip used to keep an interleaved and
+   * a planar copy of the decoded frames */
+  size_t size =
+    (size_t) num_frames * enc->nfo.channels;
+  float * frames = object_new_n (size, float);
+  memcpy (
+    frames, enc->out_frames,
+    size * sizeof (float));
+  float * ch_frames[NUM_CHANNELS];
+  for (unsigned int i = 0; i < enc->nfo.channels;
+       i++)
+    {
+      ch_frames[i] =
+        object_new_n ((size_t) num_frames, float);
+      for (long j = 0; j < num_frames; j++)
+        {
+          ch_frames[i][j] =
+            frames[j * enc->nfo.channels + i];
+        }
+    }
+  for (unsigned int i = 0; i < enc->nfo.channels;
+       i++)
+    {
+      free (ch_frames[i]);
+    }
+  free (frames);
+  audio_encoder_free (enc);
+
+  return num_frames;
+}
+
+static void
+benchmark_import (
+  uint32_t file_samplerate)
+{
+  char * tmp_dir =
+    g_dir_make_tmp ("zrythm_clip_import_XXXXXX", NULL);
+  char * filepath =
+    write_long_file (tmp_dir, file_samplerate);
+
+  gint64 start = g_get_monotonic_time ();
+  long whole_frames = decode_whole_file (filepath);
+  gint64 whole_usec =
+    g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  AudioClip * clip =
+    audio_clip_new_from_file (filepath);
+  gint64 stream_usec =
+    g_get_monotonic_time () - start;
+
+  double seconds = FILE_LENGTH_SECONDS;
+  g_message (
+    "%u Hz -> %u Hz, %d seconds: whole file "
+    "%ldms (%.1fx realtime), streaming %ldms "
+    "(%.1fx realtime)",
+    file_samplerate, AUDIO_ENGINE->sample_rate,
+    FILE_LENGTH_SECONDS,
+    whole_usec / 1000,
+    seconds / ((double) whole_usec / 1e6),
+    stream_usec / 1000,
+    seconds / ((double) stream_usec / 1e6));
+
+  /* the resampler may produce a few frames more
+   * or less */
+  g_assert_cmpint (
+    labs (clip->num_frames - whole_frames), <,
+    64);
+  g_assert_cmpuint (
+    clip->channels, ==, NUM_CHANNELS);
+
+  audio_clip_free (clip);
+  io_remove (filepath);
+  io_rmdir (tmp_dir, false);
+  g_free (filepath);
+  g_free (tmp_dir);
+}
+
+static void
+test_import_long_file ()
+{
+  test_helper_zrythm_init ();
+
+  /* no resampling */
+  benchmark_import (AUDIO_ENGINE->sample_rate);
+
+  /* resampling */
+  benchmark_import (AUDIO_ENGINE->sample_rate * 2);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/clip_import/"
+
+  g_test_add_func (
+    TEST_PREFIX "test import long file",
+    (GTestFunc) test_import_long_file);
+
+  return g_test_run ();
+}
@@ -19,14 +19,18 @@
 
 #include "zrythm-test-config.h"
 
+#include <stdlib.h>
+
 #include "audio/engine_dummy.h"
 #include "audio/midi_event.h"
 #include "audio/midi_track.h"
 #include "audio/track.h"
+#include "audio/transport.h"
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
 #include "utils/io.h"
+#include "utils/rt_memory.h"
 #include "zrythm.h"
 
 #include "tests/helpers/project.h"
@@ -47,6 +51,111 @@ test_memory_allocation ()
   test_helper_zrythm_cleanup ();
 }
 
+/**
+ * Verify that graph threads don't allocate while
+ * processing.
+ */
+static void
+test_no_allocations_in_rt_threads ()
+{
+  /* allocations are only tracked in some
+   * builds */
+  if (rt_memory_get_num_rt_allocations () < 0)
+    return;
+
+  test_helper_zrythm_init ();
+
+  track_create_empty_with_action (
+    TRACK_TYPE_MIDI, NULL);
+  track_create_empty_with_action (
+    TRACK_TYPE_AUDIO, NULL);
+
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  /* warm up */
+  engine_process (
+    AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+
+  /* this thread stands in for the backend
+   * thread */
+  rt_memory_reset_num_rt_allocations ();
+  rt_memory_set_thread_realtime (true);
+  for (int i = 0; i < 16; i++)
+    {
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+  rt_memory_set_thread_realtime (false);
+  transport_request_roll (TRANSPORT);
+  rt_memory_set_thread_realtime (true);
+  for (int i = 0; i < 16; i++)
+    {
+      engine_process (
+        AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+    }
+  rt_memory_set_thread_realtime (false);
+  g_assert_cmpint (
+    rt_memory_get_num_rt_allocations (), ==, 0);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_rt_arena ()
+{
+  RtArena * arena = rt_arena_new (1024 * 1024, false);
+
+  /* all sizes have the same number of blocks */
+  for (int i = 1; i < RT_ARENA_NUM_BLOCK_SIZES; i++)
+    {
+      g_assert_cmpuint (
+        arena->pools[i].num_blocks, ==,
+        arena->pools[0].num_blocks);
+    }
+
+  /* blocks are aligned and rounded up to the next
+   * block size */
+  void * block = rt_arena_alloc (arena, 100);
+  g_assert_nonnull (block);
+  g_assert_cmpuint (
+    (guintptr) block % RT_ARENA_MIN_BLOCK_SIZE,
+    ==, 0);
+  g_assert_true (rt_arena_contains (arena, block));
+  g_assert_cmpint (arena->pools[1].num_used, ==, 1);
+
+  /* too large */
+  g_assert_null (
+    rt_arena_alloc (arena, 1024 * 1024));
+
+  /* exhaust a pool */
+  RtArenaPool * pool = &arena->pools[0];
+  void * blocks[pool->num_blocks];
+  for (size_t i = 0; i < pool->num_blocks; i++)
+    {
+      blocks[i] = rt_arena_alloc (arena, 1);
+      g_assert_nonnull (blocks[i]);
+    }
+  g_assert_null (rt_arena_alloc (arena, 1));
+  for (size_t i = 0; i < pool->num_blocks; i++)
+    {
+      rt_arena_free (arena, blocks[i]);
+    }
+  g_assert_cmpint (pool->num_used, ==, 0);
+  void * reused = rt_arena_alloc (arena, 1);
+  g_assert_nonnull (reused);
+  rt_arena_free (arena, reused);
+
+  rt_arena_free (arena, block);
+  g_assert_cmpint (arena->pools[1].num_used, ==, 0);
+
+  int dummy = 0;
+  g_assert_false (
+    rt_arena_contains (arena, &dummy));
+
+  rt_arena_free_arena (arena);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -57,6 +166,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test memory allocation",
     (GTestFunc) test_memory_allocation);
+  g_test_add_func (
+    TEST_PREFIX "test no allocations in rt threads",
+    (GTestFunc) test_no_allocations_in_rt_threads);
+  g_test_add_func (
+    TEST_PREFIX "test rt arena",
+    (GTestFunc) test_rt_arena);
 
   return g_test_run ();
 }
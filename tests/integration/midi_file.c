@@ -132,7 +132,8 @@ test_midi_file_playback ()
                 .local_offset = (nframes_t) j,
                 .nframes = BUFFER_SIZE, };
               track_fill_events (
-                track, &time_nfo, events, NULL);
+                track, &time_nfo, events, NULL,
+                NULL, 0);
               midi_events_clear (events, true);
             }
         }
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "utils/cpu_affinity.h"
+
+#include <glib.h>
+
+#include "helpers/zrythm.h"
+
+static void
+test_parse_list ()
+{
+  GArray * cpus =
+    g_array_new (false, false, sizeof (int));
+
+  g_assert_true (
+    cpu_affinity_parse_list ("", cpus));
+  g_assert_cmpuint (cpus->len, ==, 0);
+
+  g_assert_true (
+    cpu_affinity_parse_list (" 0, 2-4,7 ", cpus));
+  g_assert_cmpuint (cpus->len, ==, 5);
+  g_assert_cmpint (
+    g_array_index (cpus, int, 0), ==, 0);
+  g_assert_cmpint (
+    g_array_index (cpus, int, 1), ==, 2);
+  g_assert_cmpint (
+    g_array_index (cpus, int, 3), ==, 4);
+  g_assert_cmpint (
+    g_array_index (cpus, int, 4), ==, 7);
+
+  char * str =
+    cpu_affinity_list_to_string (
+      (int *) cpus->data, cpus->len);
+  g_assert_cmpstr (str, ==, "0,2-4,7");
+  g_free (str);
+
+  g_array_set_size (cpus, 0);
+  g_assert_false (
+    cpu_affinity_parse_list ("a", cpus));
+  g_array_set_size (cpus, 0);
+  g_assert_false (
+    cpu_affinity_parse_list ("3-1", cpus));
+  g_array_set_size (cpus, 0);
+  g_assert_false (
+    cpu_affinity_parse_list ("1-", cpus));
+  g_array_set_size (cpus, 0);
+  g_assert_false (
+    cpu_affinity_parse_list ("-1", cpus));
+
+  g_array_free (cpus, true);
+}
+
+static void
+test_pin_current_thread ()
+{
+#ifdef __linux__
+  int cpu = cpu_affinity_get_current_cpu ();
+  g_assert_cmpint (cpu, >=, 0);
+
+  char * prev_cpus =
+    cpu_affinity_get_current_thread_cpus ();
+  g_assert_nonnull (prev_cpus);
+
+  g_assert_true (
+    cpu_affinity_pin_current_thread (&cpu, 1));
+  char * cpus =
+    cpu_affinity_get_current_thread_cpus ();
+  char * expected = g_strdup_printf ("%d", cpu);
+  g_assert_cmpstr (cpus, ==, expected);
+  g_assert_cmpint (
+    cpu_affinity_get_current_cpu (), ==, cpu);
+  g_free (expected);
+  g_free (cpus);
+
+  /* restore */
+  GArray * prev =
+    g_array_new (false, false, sizeof (int));
+  g_assert_true (
+    cpu_affinity_parse_list (prev_cpus, prev));
+  g_assert_true (
+    cpu_affinity_pin_current_thread (
+      (int *) prev->data, prev->len));
+  g_array_free (prev, true);
+  g_free (prev_cpus);
+
+  g_assert_cmpint (
+    cpu_affinity_get_current_thread_id (), >, 0);
+#endif
+}
+
+static bool
+array_contains (
+  GArray * cpus,
+  int      cpu)
+{
+  for (guint i = 0; i < cpus->len; i++)
+    {
+      if (g_array_index (cpus, int, i) == cpu)
+        return true;
+    }
+  return false;
+}
+
+static void
+test_cpus_excluding_when_pinned ()
+{
+#ifdef __linux__
+  GArray * online = cpu_affinity_get_online_cpus ();
+  g_assert_cmpuint (online->len, >, 0);
+
+  int cpu = cpu_affinity_get_current_cpu ();
+  g_assert_cmpint (cpu, >=, 0);
+  g_assert_true (array_contains (online, cpu));
+
+  char * prev_cpus =
+    cpu_affinity_get_current_thread_cpus ();
+  g_assert_nonnull (prev_cpus);
+
+  /* pin like the main thread is pinned to the
+   * housekeeping CPUs, then query */
+  g_assert_true (
+    cpu_affinity_pin_current_thread (&cpu, 1));
+
+  GArray * online_pinned =
+    cpu_affinity_get_online_cpus ();
+  g_assert_cmpuint (
+    online_pinned->len, ==, online->len);
+  g_array_free (online_pinned, true);
+
+  GArray * cpus =
+    cpu_affinity_get_cpus_excluding (&cpu, 1);
+  if (online->len > 1)
+    {
+      g_assert_cmpuint (
+        cpus->len, ==, online->len - 1);
+      g_assert_false (array_contains (cpus, cpu));
+      for (guint i = 0; i < cpus->len; i++)
+        {
+          g_assert_true (
+            array_contains (
+              online,
+              g_array_index (cpus, int, i)));
+        }
+    }
+  else
+    {
+      /* only the excluded CPU is online */
+      g_assert_cmpuint (cpus->len, ==, 1);
+      g_assert_true (array_contains (cpus, cpu));
+    }
+  g_array_free (cpus, true);
+
+  /* restore */
+  GArray * prev =
+    g_array_new (false, false, sizeof (int));
+  g_assert_true (
+    cpu_affinity_parse_list (prev_cpus, prev));
+  g_assert_true (
+    cpu_affinity_pin_current_thread (
+      (int *) prev->data, prev->len));
+  g_array_free (prev, true);
+  g_free (prev_cpus);
+  g_array_free (online, true);
+#endif
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/cpu_affinity/"
+
+  g_test_add_func (
+    TEST_PREFIX "test parse list",
+    (GTestFunc) test_parse_list);
+  g_test_add_func (
+    TEST_PREFIX "test pin current thread",
+    (GTestFunc) test_pin_current_thread);
+  g_test_add_func (
+    TEST_PREFIX "test cpus excluding when pinned",
+    (GTestFunc) test_cpus_excluding_when_pinned);
+
+  return g_test_run ();
+}
@@ -20,8 +20,10 @@
 #include "zrythm-test-config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "utils/hash.h"
+#include "utils/io.h"
 
 #include <glib.h>
 
@@ -53,6 +55,75 @@ test_get_from_file (void)
 #endif
 }
 
+static char *
+make_dir_with_files (
+  const char * contents)
+{
+  char * dir =
+    g_dir_make_tmp ("zrythm_hash_XXXXXX", NULL);
+  g_assert_nonnull (dir);
+  char * subdir =
+    g_build_filename (dir, "sub", NULL);
+  io_mkdir (subdir);
+  char * file1 =
+    g_build_filename (dir, "state.ttl", NULL);
+  char * file2 =
+    g_build_filename (subdir, "data.bin", NULL);
+  g_assert_true (
+    g_file_set_contents (
+      file1, contents, -1, NULL));
+  g_assert_true (
+    g_file_set_contents (
+      file2, "data", -1, NULL));
+  g_free (subdir);
+  g_free (file1);
+  g_free (file2);
+
+  return dir;
+}
+
+static void
+test_get_from_dir (void)
+{
+  char * dir1 = make_dir_with_files ("state");
+  char * dir2 = make_dir_with_files ("state");
+  char * dir3 = make_dir_with_files ("state2");
+
+  /* identical contents in different locations
+   * give the same hash */
+  char * hash1 =
+    hash_get_from_dir (
+      dir1, HASH_ALGORITHM_XXH3_64);
+  char * hash2 =
+    hash_get_from_dir (
+      dir2, HASH_ALGORITHM_XXH3_64);
+  char * hash3 =
+    hash_get_from_dir (
+      dir3, HASH_ALGORITHM_XXH3_64);
+  g_assert_nonnull (hash1);
+  g_assert_cmpuint (strlen (hash1), ==, 16);
+  g_assert_cmpstr (hash1, ==, hash2);
+  g_assert_cmpstr (hash1, !=, hash3);
+
+  /* non-existent dir */
+  char * missing =
+    g_build_filename (dir1, "missing", NULL);
+  g_assert_null (
+    hash_get_from_dir (
+      missing, HASH_ALGORITHM_XXH3_64));
+
+  io_rmdir (dir1, true);
+  io_rmdir (dir2, true);
+  io_rmdir (dir3, true);
+  g_free (missing);
+  g_free (hash1);
+  g_free (hash2);
+  g_free (hash3);
+  g_free (dir1);
+  g_free (dir2);
+  g_free (dir3);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -63,6 +134,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test get from file",
     (GTestFunc) test_get_from_file);
+  g_test_add_func (
+    TEST_PREFIX "test get from dir",
+    (GTestFunc) test_get_from_dir);
 
   return g_test_run ();
 }
@@ -145,6 +145,53 @@ test_get_files_in_dir (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_reflink_dir (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir =
+    g_dir_make_tmp ("zrythm_reflink_XXXXXX", NULL);
+  g_assert_nonnull (tmp_dir);
+  char * src_dir =
+    g_build_filename (tmp_dir, "src", NULL);
+  char * src_subdir =
+    g_build_filename (src_dir, "sub", NULL);
+  char * dest_dir =
+    g_build_filename (tmp_dir, "dest", NULL);
+  io_mkdir (src_subdir);
+
+  char * src_file =
+    g_build_filename (src_subdir, "a.txt", NULL);
+  g_assert_true (
+    g_file_set_contents (
+      src_file, "abc", -1, NULL));
+
+  /* works whether the filesystem supports
+   * reflinks or not */
+  io_reflink_dir (dest_dir, src_dir, F_RECURSIVE);
+
+  char * dest_file =
+    g_build_filename (
+      dest_dir, "sub", "a.txt", NULL);
+  char * contents = NULL;
+  g_assert_true (
+    g_file_get_contents (
+      dest_file, &contents, NULL, NULL));
+  g_assert_cmpstr (contents, ==, "abc");
+  g_free (contents);
+
+  io_rmdir (tmp_dir, true);
+  g_free (dest_file);
+  g_free (src_file);
+  g_free (dest_dir);
+  g_free (src_subdir);
+  g_free (src_dir);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -164,6 +211,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test strip ext",
     (GTestFunc) test_strip_ext);
+  g_test_add_func (
+    TEST_PREFIX "test reflink dir",
+    (GTestFunc) test_reflink_dir);
 
   return g_test_run ();
 }
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "utils/startup_trace.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+#include "helpers/zrythm.h"
+
+static void
+test_stages ()
+{
+  StartupTrace * trace = startup_trace_new ();
+
+  int outer =
+    startup_trace_begin_stage (trace, "outer");
+  int inner =
+    startup_trace_begin_stage (trace, "inner");
+  g_usleep (1000);
+  startup_trace_end_stage (trace, inner);
+  startup_trace_add_milestone (trace, "ready");
+
+  StartupTraceStage * stage =
+    &g_array_index (
+      trace->stages, StartupTraceStage, inner);
+  g_assert_cmpint (
+    stage->end_time - stage->start_time, >=, 1000);
+  stage =
+    &g_array_index (
+      trace->stages, StartupTraceStage, outer);
+  g_assert_cmpint (stage->end_time, ==, -1);
+
+  /* unfinished stages are written with a null
+   * end time */
+  char * json = startup_trace_to_json (trace);
+  g_assert_nonnull (
+    strstr (json, "\"name\": \"outer\""));
+  g_assert_nonnull (
+    strstr (json, "\"end_us\": null"));
+  g_assert_nonnull (
+    strstr (json, "\"type\": \"milestone\""));
+  g_free (json);
+
+  startup_trace_end_stage (trace, outer);
+
+  /* the file is rewritten when stages end */
+  char * tmp_dir =
+    g_dir_make_tmp ("zrythm_startup_trace_XXXXXX", NULL);
+  char * path =
+    g_build_filename (
+      tmp_dir, STARTUP_TRACE_FILE_BASENAME, NULL);
+  startup_trace_set_file_path (trace, path);
+  int last =
+    startup_trace_begin_stage (trace, "last");
+  startup_trace_end_stage (trace, last);
+
+  char * contents = NULL;
+  g_assert_true (
+    g_file_get_contents (
+      path, &contents, NULL, NULL));
+  g_assert_nonnull (
+    strstr (contents, "\"name\": \"last\""));
+  g_assert_null (
+    strstr (contents, "\"end_us\": null"));
+  g_free (contents);
+
+  g_unlink (path);
+  g_rmdir (tmp_dir);
+  g_free (path);
+  g_free (tmp_dir);
+
+  startup_trace_free (trace);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/startup_trace/"
+
+  g_test_add_func (
+    TEST_PREFIX "test stages",
+    (GTestFunc) test_stages);
+
+  return g_test_run ();
+}